@@ -16,6 +16,7 @@
 #define ISEN_BOUNDARY_H
 
 #include <Isen/Common.h>
+#include <Isen/Field.h>
 #include <array>
 
 ISEN_NAMESPACE_BEGIN
@@ -35,11 +36,74 @@ struct Boundary
         phi.block(nx + nb, 0, nb, phi.cols()) = phi.block(nb, 0, nb, phi.cols());
     }
 
+    /// @brief Make the field periodic (see Boundary::periodic), level by level on the raw data.
+    template <class T>
+    static void periodic(Field<T>& phi, int nx, int nb) noexcept
+    {
+        assert(phi.rows() == (nx + 2 * nb));
+        for(int k = 0; k < phi.cols(); ++k)
+            periodicLevel(phi.data() + k * phi.ld(), nx, nb);
+    }
+
+    /// @brief Make a single level of a field periodic.
+    ///
+    /// @c phi points to the first element of a contiguous level of 'nx + 2*nb' elements (see Boundary::periodic).
+    template <class T>
+    static void periodicLevel(T* phi, int nx, int nb) noexcept
+    {
+        for(int i = 0; i < nb; ++i)
+            phi[i] = phi[nx + i];
+        for(int i = 0; i < nb; ++i)
+            phi[nx + nb + i] = phi[nb + i];
+    }
+
+    /// @brief Relax a single level of a field towards the boundary values @c phi1 and @c phi2
+    ///
+    /// @c phi points to the first element of a contiguous level of 'nx + 2*nb' elements (see Boundary::relax).
+    template <class T>
+    static void relaxLevel(T* phi, int nx, int nb, T phi1, T phi2) noexcept
+    {
+        const int n = 2 * nb + nx;
+
+        for(int i = 0; i < RelaxWidth; ++i)
+        {
+            phi[i] = relaxPoint(phi[i], phi1, i);
+            phi[n - 1 - i] = relaxPoint(phi[n - 1 - i], phi2, i);
+        }
+    }
+
+    /// Number of points relaxed at each end of the domain (see Boundary::relax)
+    static constexpr int RelaxWidth = 8;
+
+    /// @brief Relax the value @c phi of the point at distance @c i (< RelaxWidth) from the end of the domain towards
+    /// the boundary value @c phibnd
+    template <class T>
+    static T relaxPoint(T phi, T phibnd, int i) noexcept
+    {
+        constexpr std::array<T, RelaxWidth> rel{{T(1.0), T(0.99), T(0.95), T(0.8), T(0.5), T(0.2), T(0.05), T(0.01)}};
+        return phibnd * rel[i] + phi * (1 - rel[i]);
+    }
+
+    /// @brief Relax the boundaries of the field (see Boundary::relax), level by level on the raw data.
+    ///
+    /// The boundary values @c phi1 and @c phi2 are indexed by the level (e.g VectorX<T> or a pointer).
+    template <class T, class Boundary1, class Boundary2>
+    static void relax(Field<T>& phi, int nx, int nb, const Boundary1& phi1, const Boundary2& phi2) noexcept
+    {
+        assert(phi.rows() == (nx + 2 * nb));
+        for(int k = 0; k < phi.cols(); ++k)
+            relaxLevel(phi.data() + k * phi.ld(), nx, nb, phi1[k], phi2[k]);
+    }
+
     /// Relax of boundary conditions.
     template <class Derived>
-    static void
-    relax(Eigen::MatrixBase<Derived>& phi, int nx, int nb, const VectorXf& phi1, const VectorXf& phi2) noexcept
+    static void relax(Eigen::MatrixBase<Derived>& phi,
+                      int nx,
+                      int nb,
+                      const VectorX<typename Derived::Scalar>& phi1,
+                      const VectorX<typename Derived::Scalar>& phi2) noexcept
     {
+        using T = typename Derived::Scalar;
         assert(phi.rows() == (nx + 2 * nb));
 
         // Relaxation is done over nr grid points
@@ -47,7 +111,7 @@ struct Boundary
         const int n = 2 * nb + nx;
 
         // Initialize relaxation array
-        constexpr std::array<double, nr> rel{{1.0, 0.99, 0.95, 0.8, 0.5, 0.2, 0.05, 0.01}};
+        constexpr std::array<T, nr> rel{{T(1.0), T(0.99), T(0.95), T(0.8), T(0.5), T(0.2), T(0.05), T(0.01)}};
 
         if(phi.cols() == 1)
         {
@@ -0,0 +1,286 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_CHECKPOINT_H
+#define ISEN_CHECKPOINT_H
+
+#include <Isen/Common.h>
+#include <Isen/Field.h>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Snapshot of the complete state of a simulation
+///
+/// A checkpoint is a collection of named records (fields, vectors and scalars) together with the NameList of the
+/// simulation. It holds everything that is required to continue the time loop, i.e all time levels of the prognostic
+/// fields, the diagnostic fields, the boundary values, the state of the TimeControl and the output produced so far (see
+/// Solver::restart). The values are stored verbatim, a restarted simulation is therefore bitwise identical to the
+/// uninterrupted one.
+///
+/// The file format is a native binary format (not portable across architectures):
+///
+///   "ISENCKPT" | version (uint32) | number of records (uint32) | records ...
+///
+/// where each record consists of the length of the name (uint32), the name, the type of the elements (uint32), the
+/// number of rows and columns (uint64) and the raw column-major elements.
+class Checkpoint
+{
+public:
+    /// Type of the elements of a record
+    enum Type : std::uint32_t
+    {
+        Char = 0,
+        Int,
+        Float,
+        Double
+    };
+
+    /// Empty checkpoint
+    Checkpoint() = default;
+
+    /// @brief Read the checkpoint @c filename
+    ///
+    /// @throw IsenException if the file can't be read or is not a checkpoint
+    explicit Checkpoint(const std::string& filename) { read(filename); }
+
+    /// @brief Write the checkpoint to @c filename
+    ///
+    /// The checkpoint is written to a temporary file first which then replaces @c filename, an existing checkpoint is
+    /// therefore never left in an incomplete state.
+    ///
+    /// @throw IsenException if the file can't be written
+    void write(const std::string& filename) const;
+
+    /// @brief Read the checkpoint @c filename (replaces all records)
+    ///
+    /// @throw IsenException if the file can't be read or is not a checkpoint
+    void read(const std::string& filename);
+
+    /// Store a copy of the NameList
+    void setNameList(const NameList& namelist);
+
+    /// @brief Get a copy of the stored NameList
+    ///
+    /// @throw IsenException if the checkpoint has no NameList
+    std::shared_ptr<NameList> getNameList() const;
+
+    /// Check if the checkpoint has a record @c name
+    bool has(const std::string& name) const { return records_.count(name) != 0; }
+
+    //------------------------------------------------------------
+    // Store records
+    //------------------------------------------------------------
+
+    /// Store a copy of the field @c field
+    template <class T>
+    void add(const std::string& name, const Field<T>& field)
+    {
+        add(name, field.data(), field.rows(), field.cols(), field.ld());
+    }
+
+    /// Store a copy of the vector or matrix @c mat
+    template <class T>
+    void add(const std::string& name, const MatrixX<T>& mat)
+    {
+        add(name, mat.data(), mat.rows(), mat.cols(), mat.rows());
+    }
+
+    /// Store a copy of the vector @c vec
+    template <class T>
+    void add(const std::string& name, const VectorX<T>& vec)
+    {
+        add(name, vec.data(), vec.rows(), 1, vec.rows());
+    }
+
+    /// Store a copy of the vector @c vec
+    template <class T>
+    void add(const std::string& name, const std::vector<T>& vec)
+    {
+        add(name, vec.data(), static_cast<int>(vec.size()), 1, static_cast<int>(vec.size()));
+    }
+
+    /// Store the scalar @c value
+    template <class T>
+    void add(const std::string& name, T value)
+    {
+        add(name, &value, 1, 1, 1);
+    }
+
+    /// Store a copy of the column-major @c rows x @c cols elements of @c data with leading dimension @c ld
+    template <class T>
+    void add(const std::string& name, const T* data, int rows, int cols, int ld)
+    {
+        Record& record = records_[name];
+        record.type = TypeOf<T>::value;
+        record.rows = rows;
+        record.cols = cols;
+        record.data.resize(std::size_t(rows) * cols * sizeof(T));
+        for(int k = 0; k < cols && rows > 0; ++k)
+            std::memcpy(record.data.data() + std::size_t(k) * rows * sizeof(T), data + std::size_t(k) * ld,
+                        rows * sizeof(T));
+    }
+
+    //------------------------------------------------------------
+    // Load records
+    //------------------------------------------------------------
+
+    /// @brief Copy the record @c name into the field @c field
+    ///
+    /// @throw IsenException if there is no such record or if its type or size doesn't match the field
+    template <class T>
+    void get(const std::string& name, Field<T>& field) const
+    {
+        get(name, field.data(), field.rows(), field.cols(), field.ld());
+    }
+
+    /// @brief Copy the record @c name into the vector or matrix @c mat (resized if necessary)
+    ///
+    /// @throw IsenException if there is no such record or if its type doesn't match
+    template <class T>
+    void get(const std::string& name, MatrixX<T>& mat) const
+    {
+        const Record& record = find(name, TypeOf<T>::value);
+        mat.resize(record.rows, record.cols);
+        get(name, mat.data(), mat.rows(), mat.cols(), mat.rows());
+    }
+
+    /// @brief Copy the record @c name into the vector @c vec (resized if necessary)
+    ///
+    /// @throw IsenException if there is no such record or if its type doesn't match
+    template <class T>
+    void get(const std::string& name, VectorX<T>& vec) const
+    {
+        const Record& record = find(name, TypeOf<T>::value);
+        vec.resize(record.rows * record.cols);
+        get(name, vec.data(), record.rows, record.cols, record.rows);
+    }
+
+    /// @brief Copy the record @c name into the vector @c vec (resized if necessary)
+    ///
+    /// @throw IsenException if there is no such record or if its type doesn't match
+    template <class T>
+    void get(const std::string& name, std::vector<T>& vec) const
+    {
+        const Record& record = find(name, TypeOf<T>::value);
+        vec.resize(record.rows * record.cols);
+        get(name, vec.data(), record.rows, record.cols, record.rows);
+    }
+
+    /// @brief Get the scalar record @c name
+    ///
+    /// @throw IsenException if there is no such record or if its type or size doesn't match
+    template <class T>
+    T get(const std::string& name) const
+    {
+        T value;
+        get(name, &value, 1, 1, 1);
+        return value;
+    }
+
+    /// @brief Copy the record @c name into the column-major @c rows x @c cols elements of @c data with leading
+    /// dimension @c ld
+    ///
+    /// @throw IsenException if there is no such record or if its type or size doesn't match
+    template <class T>
+    void get(const std::string& name, T* data, int rows, int cols, int ld) const
+    {
+        const Record& record = find(name, TypeOf<T>::value);
+        if(record.rows != rows || record.cols != cols)
+            throw IsenException("checkpoint: record '%s' has %i x %i elements (expected %i x %i)", name, record.rows,
+                                record.cols, rows, cols);
+
+        for(int k = 0; k < cols && rows > 0; ++k)
+            std::memcpy(data + std::size_t(k) * ld, record.data.data() + std::size_t(k) * rows * sizeof(T),
+                        rows * sizeof(T));
+    }
+
+private:
+    template <class T>
+    struct TypeOf;
+
+    struct Record
+    {
+        Type type;
+        int rows;
+        int cols;
+        std::vector<char> data;
+    };
+
+    /// Find the record @c name and check its type
+    const Record& find(const std::string& name, Type type) const;
+
+    std::map<std::string, Record> records_;
+};
+
+template <>
+struct Checkpoint::TypeOf<char>
+{
+    static constexpr Type value = Char;
+};
+
+template <>
+struct Checkpoint::TypeOf<int>
+{
+    static constexpr Type value = Int;
+};
+
+template <>
+struct Checkpoint::TypeOf<float>
+{
+    static constexpr Type value = Float;
+};
+
+template <>
+struct Checkpoint::TypeOf<double>
+{
+    static constexpr Type value = Double;
+};
+
+/// @brief Write checkpoints in a background thread
+///
+/// The solver only takes the snapshot (see Solver::saveState), the time loop continues while the checkpoint is
+/// written. At most one checkpoint is in flight: Writing the next one waits for the completion of the previous one.
+class CheckpointWriter
+{
+public:
+    CheckpointWriter() = default;
+
+    /// Wait for the checkpoint in flight (errors are logged)
+    ~CheckpointWriter();
+
+    /// @brief Write @c checkpoint to @c filename in the background
+    ///
+    /// @throw IsenException if writing the previous checkpoint failed
+    void write(std::shared_ptr<const Checkpoint> checkpoint, const std::string& filename);
+
+    /// @brief Wait for the checkpoint in flight
+    ///
+    /// @throw IsenException if writing the checkpoint failed
+    void wait();
+
+private:
+    std::thread thread_;
+    std::exception_ptr exception_;
+};
+
+ISEN_NAMESPACE_END
+
+#endif
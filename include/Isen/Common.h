@@ -67,6 +67,7 @@ struct NameList;
 class Output;
 class Solver;
 class Parser;
+class Checkpoint;
 
 ISEN_NAMESPACE_END
 
@@ -0,0 +1,82 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_COMPRESSION_H
+#define ISEN_COMPRESSION_H
+
+#include <Isen/Common.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+ISEN_NAMESPACE_BEGIN
+
+/// Lossless codecs of the chunked archive (see OutputStore)
+enum class CompressionCodec : std::uint32_t
+{
+    None = 0, ///< Byte shuffle only
+    Zlib,     ///< Byte shuffle and zlib (requires ISEN_ZLIB)
+    Lz4,      ///< Byte shuffle and LZ4 (requires ISEN_LZ4)
+    Zstd      ///< Byte shuffle and Zstandard (requires ISEN_ZSTD)
+};
+
+/// @brief Lossless compression of blocks of values (e.g double precision values or quantized integers)
+///
+/// The bytes of the values are shuffled before compression (the first bytes of all values, then the second bytes, ...),
+/// which places the slowly varying sign and exponent bytes next to each other and greatly improves the ratio of the
+/// general purpose codecs.
+class Compression
+{
+public:
+    /// Check if the codec was compiled in
+    static bool isAvailable(CompressionCodec codec) noexcept;
+
+    /// @brief Parse the name of a codec ("none", "zlib", "lz4", "zstd" or "auto" for the fastest available codec)
+    ///
+    /// @throw IsenException if the codec is unknown or not available
+    static CompressionCodec fromString(const std::string& name);
+
+    /// Name of the codec
+    static const char* toString(CompressionCodec codec) noexcept;
+
+    /// @brief Compress the @c n values of @c typeSize bytes of @c data into @c out (resized)
+    ///
+    /// @throw IsenException if the codec is not available or fails
+    static void compress(CompressionCodec codec, const void* data, std::size_t n, std::size_t typeSize,
+                         std::vector<char>& out);
+
+    /// @brief Decompress @c size bytes of @c src into the @c n values of @c typeSize bytes of @c data
+    ///
+    /// @throw IsenException if the codec is not available or the data is corrupted
+    static void decompress(CompressionCodec codec, const char* src, std::size_t size, void* data, std::size_t n,
+                           std::size_t typeSize);
+
+    /// Compress the @c n values of @c data into @c out (resized)
+    template <class T>
+    static void compress(CompressionCodec codec, const T* data, std::size_t n, std::vector<char>& out)
+    {
+        compress(codec, static_cast<const void*>(data), n, sizeof(T), out);
+    }
+
+    /// Decompress @c size bytes of @c src into the @c n values of @c data
+    template <class T>
+    static void decompress(CompressionCodec codec, const char* src, std::size_t size, T* data, std::size_t n)
+    {
+        decompress(codec, src, size, static_cast<void*>(data), n, sizeof(T));
+    }
+};
+
+ISEN_NAMESPACE_END
+
+#endif
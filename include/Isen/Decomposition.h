@@ -0,0 +1,151 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_DECOMPOSITION_H
+#define ISEN_DECOMPOSITION_H
+
+#include <Isen/Common.h>
+#include <Isen/Field.h>
+
+#ifdef ISEN_MPI
+
+#include <mpi.h>
+#include <vector>
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Decomposition of the x-domain over the ranks of an MPI communicator
+///
+/// The interior points 'nb, ..., nx + nb - 1' of the unstaggered fields are split into contiguous slabs, rank r owns
+/// the points [Decomposition::begin, Decomposition::begin + Decomposition::nxLocal). The staggered fields (velocity)
+/// are split at the same points, the last rank additionally owns the last staggered point 'nx + nb'. The first and
+/// the last rank also own the boundary points of the global fields.
+///
+/// A local field holds the points of its rank surrounded by halos of 'nb' points, i.e 'nxLocal + 2 * nb' rows
+/// (unstaggered) or 'nxLocal + 2 * nb + 1' rows (staggered). The local row j corresponds to the global row
+/// 'begin - nb + j'. On all but the last rank the last staggered point belongs to the halo.
+///
+/// The halo exchange generalizes the boundary conditions of the Solver:
+///  - periodic: the halos at the ends of the domain are exchanged periodically, the result is the same as
+///    Boundary::periodic of the global field (the staggered fields have a period of 'nx + 1').
+///  - relaxation: the halos at the ends of the domain are not touched, Decomposition::relax computes the same result
+///    as Boundary::relax of the global field for the owned points.
+class Decomposition
+{
+public:
+    /// Staggering of a field in x
+    enum Grid
+    {
+        Unstaggered = 0, ///< nx + 2 * nb points (e.g sigma)
+        Staggered        ///< nx + 2 * nb + 1 points (e.g u)
+    };
+
+    /// @brief Decompose the domain of @c nx points (with @c nb boundary points) over the ranks of @c comm
+    ///
+    /// @throw IsenException if a rank would get less than '2 * nb' points
+    Decomposition(int nx, int nb, bool periodic, MPI_Comm comm = MPI_COMM_WORLD);
+
+    /// Wait for outstanding halo exchanges
+    ~Decomposition();
+
+    /// Rank of the calling process
+    int rank() const noexcept { return rank_; }
+
+    /// Number of ranks
+    int size() const noexcept { return size_; }
+
+    /// First global (unstaggered) point owned by the calling rank
+    int begin() const noexcept { return begin_[rank_]; }
+
+    /// Number of interior points owned by the calling rank
+    int nxLocal() const noexcept { return nxLocal_[rank_]; }
+
+    /// Number of rows of the local fields
+    int rows(Grid grid) const noexcept { return nxLocal() + 2 * nb_ + (grid == Staggered); }
+
+    /// Copy the rows of the local field @c local from the global field @c global
+    void scatter(const FieldXf& global, FieldXf& local, Grid grid) const noexcept;
+
+    /// Copy the rows of the local vector @c local from the global vector @c global
+    void scatter(const VectorXf& global, VectorXf& local) const;
+
+    /// @brief Assemble the global field @c global from the owned points of the local fields of all ranks
+    ///
+    /// The global field is assembled on all ranks if @c all is true and only on the first rank otherwise.
+    void gather(const FieldXf& local, FieldXf& global, Grid grid, bool all);
+
+    /// @brief Start the exchange of the halos of @c phi (non-blocking)
+    ///
+    /// Several fields can be exchanged at the same time, the exchange is completed by Decomposition::exchangeEnd. All
+    /// ranks have to start the exchanges of their fields in the same order.
+    void exchangeBegin(FieldXf& phi, Grid grid);
+
+    /// Wait for the completion of the halo exchanges started by Decomposition::exchangeBegin
+    void exchangeEnd();
+
+    /// Relax the owned points of @c phi towards the boundary values @c phi1 and @c phi2 (see Boundary::relax)
+    void relax(FieldXf& phi, Grid grid, const VectorXf& phi1, const VectorXf& phi2) const noexcept;
+
+    /// Maximum of @c value over all ranks
+    double allreduceMax(double value) const;
+
+    /// Sum of @c value over all ranks
+    double allreduceSum(double value) const;
+
+private:
+    /// First and last (exclusive) local row owned by @c rank
+    void ownedRows(int rank, Grid grid, int& first, int& last) const noexcept;
+
+    /// Halo message of a field
+    struct Message
+    {
+        double* data;               ///< Field
+        int ld;                     ///< Leading dimension of the field
+        int cols;                   ///< Number of levels of the field
+        int row;                    ///< First row (sent or received)
+        int count;                  ///< Number of rows (sent or received)
+        std::vector<double> buffer; ///< Packed rows
+    };
+
+    /// Pack the rows of @c msg into its buffer
+    static void pack(Message& msg) noexcept;
+
+    /// Unpack the buffer of @c msg into the rows of the field
+    static void unpack(const Message& msg) noexcept;
+
+    MPI_Comm comm_;
+    int rank_;
+    int size_;
+    int nx_;
+    int nb_;
+    bool periodic_;
+
+    int left_;  ///< Left neighbour (MPI_PROC_NULL at the end of a non-periodic domain)
+    int right_; ///< Right neighbour (MPI_PROC_NULL at the end of a non-periodic domain)
+
+    std::vector<int> begin_;
+    std::vector<int> nxLocal_;
+
+    // Pending halo exchange (the messages are reused by the next exchanges)
+    int numFields_;
+    std::vector<Message> sends_;
+    std::vector<Message> recvs_;
+    std::vector<MPI_Request> requests_;
+};
+
+ISEN_NAMESPACE_END
+
+#endif
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_DEVIATION_H
+#define ISEN_DEVIATION_H
+
+#include <Isen/Common.h>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+ISEN_NAMESPACE_BEGIN
+
+class Solver;
+
+/// @brief Deviation of a field of a Solver from the same field of a reference Solver
+struct Deviation
+{
+    /// Name of the field
+    std::string name;
+
+    /// Maximum absolute deviation
+    double maxAbs;
+
+    /// Maximum absolute deviation relative to the maximum absolute value of the reference field
+    double maxRel;
+
+    /// Root mean square deviation
+    double rms;
+
+    /// @brief Compute the deviation of the final fields of @c solver from those of @c reference
+    ///
+    /// Both solvers have to be run with the same NameList. Fields which were not allocated (e.g the moisture variables
+    /// of a dry simulation) are skipped.
+    static std::vector<Deviation> compute(const Solver& solver, const Solver& reference);
+
+    /// Print the deviations as a table
+    static void print(std::ostream& out, const std::vector<Deviation>& deviations);
+};
+
+ISEN_NAMESPACE_END
+
+#endif
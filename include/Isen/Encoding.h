@@ -0,0 +1,74 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_ENCODING_H
+#define ISEN_ENCODING_H
+
+#include <Isen/Common.h>
+#include <Isen/Compression.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+ISEN_NAMESPACE_BEGIN
+
+/// Encodings of the fields of the chunked archive (see OutputStore)
+enum class EncodingMode : std::uint32_t
+{
+    Lossless = 0, ///< Exact values
+    Float32,      ///< Rounded to single precision
+    Float16,      ///< Rounded to half precision
+    Fixed,        ///< Quantized to multiples of twice the error bound
+    Delta,        ///< Quantized, differences of successive frames
+    Transform     ///< Quantized, decorrelated in blocks of 4 x 4 grid points (ZFP-style lifting)
+};
+
+/// @brief Error-bounded lossy encoding of chunks of (time, x, z) values
+///
+/// The encoded values are compressed losslessly (see Compression). The quantized encodings (Fixed, Delta and
+/// Transform) round each value to the nearest multiple of twice the error bound, the integers are then either stored
+/// directly, as difference to the previous frame or transformed by a reversible integer lifting scheme in blocks of
+/// 4 x 4 grid points (the decorrelating transform of ZFP). Delta and Transform are lossless on the integers, i.e the
+/// error never accumulates. Every chunk is verified while encoding: If a value can't be represented within the bound
+/// (e.g it is not finite or out of range), the chunk is stored losslessly.
+class Encoding
+{
+public:
+    /// @brief Parse the name of an encoding ("lossless", "float32", "float16", "fixed", "delta" or "transform")
+    ///
+    /// @throw IsenException if the encoding is unknown
+    static EncodingMode fromString(const std::string& name);
+
+    /// Name of the encoding
+    static const char* toString(EncodingMode mode) noexcept;
+
+    /// @brief Encode the chunk @c data of @c numFrames times @c rows times @c cols values and compress it into @c out
+    ///
+    /// Each value is reconstructed within the absolute error @c bound (a bound of zero selects the lossless encoding).
+    ///
+    /// @return Encoding of the chunk, EncodingMode::Lossless if the chunk couldn't be encoded within the bound
+    /// @throw IsenException if the codec is not available or fails
+    static EncodingMode encode(CompressionCodec codec, EncodingMode mode, double bound, const double* data,
+                               std::size_t numFrames, std::size_t rows, std::size_t cols, std::vector<char>& out);
+
+    /// @brief Decompress and decode @c size bytes of @c src into the chunk @c data (see Encoding::encode)
+    ///
+    /// @throw IsenException if the codec is not available or the data is corrupted
+    static void decode(CompressionCodec codec, EncodingMode mode, double bound, const char* src, std::size_t size,
+                       double* data, std::size_t numFrames, std::size_t rows, std::size_t cols);
+};
+
+ISEN_NAMESPACE_END
+
+#endif
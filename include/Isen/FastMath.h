@@ -0,0 +1,298 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_FAST_MATH_H
+#define ISEN_FAST_MATH_H
+
+#include <Isen/Common.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Accuracy tiers of the transcendental functions (see NameList::imath)
+///
+/// The bounds are the maximal relative errors of pow(x, y) for 0 < y < 1 (e.g the Exner function and the terminal
+/// velocity of rain) as checked in Test_Solver.cpp. The errors of exp10 grow with the magnitude of the argument. All
+/// tiers except Exact are vectorized by the compiler if AVX2 is enabled (e.g ISEN_NATIVE).
+enum class MathTier
+{
+    Exact = 0,  ///< C++ standard library
+    Polynomial, ///< Range reduction and polynomials, branch free (1e-14 in double, 2e-6 in single precision)
+    Table       ///< Table lookup with linear interpolation (2e-7 in double, 2e-6 in single precision)
+};
+
+/// @brief Conversion of the tiers
+struct FastMath
+{
+    /// @brief Convert NameList::imath to a tier
+    ///
+    /// @throw IsenException if @c imath is not a valid tier
+    static MathTier toTier(int imath)
+    {
+        if(imath < 0 || imath > 2)
+            throw IsenException("invalid math tier '%i' (imath has to be 0, 1 or 2)", imath);
+        return static_cast<MathTier>(imath);
+    }
+
+    /// Convert to string ("exact", "polynomial" or "table")
+    static const char* toString(MathTier tier) noexcept
+    {
+        switch(tier)
+        {
+            case MathTier::Polynomial:
+                return "polynomial";
+            case MathTier::Table:
+                return "table";
+            default:
+                return "exact";
+        }
+    }
+};
+
+namespace internal
+{
+
+/// Layout of the IEEE-754 floating point types
+template <class T>
+struct FloatTraits;
+
+template <>
+struct FloatTraits<double>
+{
+    using UInt = std::uint64_t;
+    static constexpr int MantissaBits = 52;
+    static constexpr int Bias = 1023;
+
+    /// Number of terms of the series of MathPolynomial
+    static constexpr int LogTerms = 10;
+    static constexpr int ExpTerms = 13;
+};
+
+template <>
+struct FloatTraits<float>
+{
+    using UInt = std::uint32_t;
+    static constexpr int MantissaBits = 23;
+    static constexpr int Bias = 127;
+
+    static constexpr int LogTerms = 5;
+    static constexpr int ExpTerms = 7;
+};
+
+/// Reinterpret the bits of @c from (the compilers turn this into a register move)
+template <class To, class From>
+inline To bitCast(From from) noexcept
+{
+    static_assert(sizeof(To) == sizeof(From), "size mismatch");
+    To to;
+    std::memcpy(&to, &from, sizeof(To));
+    return to;
+}
+
+/// @brief Split the positive, normal number @c x into x = 2^e * m with m in [1, 2) or, if @c Centered, in
+/// [sqrt(1/2), sqrt(2))
+///
+/// Only integer arithmetic is used: the compilers don't if-convert floating point selects (-ftrapping-math) and the
+/// exponent is extracted from the upper 32 bits as the conversion of 64-bit integers is not vectorizable before
+/// AVX-512.
+template <bool Centered, class T>
+inline T splitExponent(T x, T& e) noexcept
+{
+    using Traits = FloatTraits<T>;
+    using UInt = typename Traits::UInt;
+    constexpr int upperShift = 8 * sizeof(T) - 32;
+    constexpr UInt one = UInt(Traits::Bias) << Traits::MantissaBits;
+
+    const UInt bits = bitCast<UInt>(x);
+    const std::uint32_t upper = static_cast<std::uint32_t>(bits >> upperShift);
+    const std::int32_t exponent = static_cast<std::int32_t>(upper >> (Traits::MantissaBits - upperShift)) - Traits::Bias;
+
+    UInt mantissa = (bits & (one - 1)) | one;
+    if(Centered)
+    {
+        const UInt halve = UInt(mantissa > bitCast<UInt>(T(1.4142135623730951)));
+        mantissa -= halve << Traits::MantissaBits;
+        e = T(exponent + static_cast<std::int32_t>(halve));
+    }
+    else
+        e = T(exponent);
+
+    return bitCast<T>(mantissa);
+}
+
+/// @c value if @c x > 0 and 0 otherwise (see splitExponent)
+template <class T>
+inline T selectPositive(T x, T value) noexcept
+{
+    using UInt = typename FloatTraits<T>::UInt;
+    using SInt = typename std::make_signed<UInt>::type;
+    const UInt mask = UInt(0) - UInt(bitCast<SInt>(x) > 0);
+    return bitCast<T>(bitCast<UInt>(value) & mask);
+}
+
+/// Round to the nearest integer without calling into libm (|x| has to be below 2^(MantissaBits - 1))
+template <class T>
+inline T roundNearest(T x) noexcept
+{
+    constexpr T shifter = T(1.5) * T(typename FloatTraits<T>::UInt(1) << FloatTraits<T>::MantissaBits);
+    return (x + shifter) - shifter;
+}
+
+/// Compute 2^n for an integral @c n within the range of normal numbers
+template <class T>
+inline T scaleExponent(T n) noexcept
+{
+    using Traits = FloatTraits<T>;
+    using UInt = typename Traits::UInt;
+    return bitCast<T>(UInt(static_cast<std::int32_t>(n) + Traits::Bias) << Traits::MantissaBits);
+}
+
+} // namespace internal
+
+//
+// Math policies
+//
+// The policies provide pow(x, y) for x >= 0 and y > 0, exp10(x) and log10(x) for x > 0 and are passed by value to the
+// functions templated on the accuracy (e.g MeteoUtils::eswat1). The policies other than MathExact don't handle
+// infinities, NaNs and denormals, i.e the results of pow and exp10 have to be normal numbers. There is no clamping of
+// the arguments as the compilers don't vectorize it (see internal::splitExponent).
+//
+
+/// @brief C++ standard library
+template <class T>
+struct MathExact
+{
+    T pow(T x, T y) const noexcept { return std::pow(x, y); }
+    T exp10(T x) const noexcept { return std::pow(T(10), x); }
+    T log10(T x) const noexcept { return std::log10(x); }
+};
+
+/// @brief Range reduction and truncated series evaluated with Horner's scheme
+///
+/// log2: x = 2^e * m with m in [sqrt(1/2), sqrt(2)) and ln(m) = 2 * atanh(s) with s = (m - 1) / (m + 1), |s| < 0.172.
+/// exp2: x = n + f with |f| <= 1/2 and 2^f = exp(f * ln(2)). The number of terms of both series is chosen such that
+/// the truncation error is below the rounding error of @c T (see internal::FloatTraits). All functions are branch free
+/// and thus vectorizable by the compiler.
+template <class T>
+struct MathPolynomial
+{
+    using Traits = internal::FloatTraits<T>;
+
+    T log2(T x) const noexcept
+    {
+        T e;
+        const T m = internal::splitExponent<true>(x, e);
+        const T s = (m - T(1)) / (m + T(1));
+        const T s2 = s * s;
+
+        T p = T(1) / T(2 * Traits::LogTerms + 1);
+        for(int n = Traits::LogTerms - 1; n >= 0; --n)
+            p = p * s2 + T(1) / T(2 * n + 1);
+
+        return e + T(2 * 1.4426950408889634) * s * p;
+    }
+
+    T exp2(T x) const noexcept
+    {
+        const T n = internal::roundNearest(x);
+        const T r = (x - n) * T(0.6931471805599453);
+
+        T p = T(1);
+        for(int k = Traits::ExpTerms; k >= 1; --k)
+            p = T(1) + p * r * (T(1) / T(k));
+
+        return p * internal::scaleExponent(n);
+    }
+
+    T pow(T x, T y) const noexcept { return internal::selectPositive(x, exp2(y * log2(x))); }
+    T exp10(T x) const noexcept { return exp2(x * T(3.3219280948873623)); }
+    T log10(T x) const noexcept { return log2(x) * T(0.30102999566398120); }
+};
+
+/// @brief Table lookup with linear interpolation
+///
+/// log2: x = 2^e * m with m in [1, 2), log2(m) is interpolated in a table indexed by the leading Bits of the mantissa.
+/// exp2: x = n + f with |f| <= 1/2, 2^f is interpolated in a table of Size intervals. The interpolation errors are
+/// bounded by h^2 / 8 * max|f''| with h = 2^-Bits, i.e 1.8e-7 (absolute) for log2 and 6e-8 (relative) for exp2. The
+/// lookups are vectorizable with gather instructions (AVX2).
+///
+/// The tables are computed once and shared by all threads.
+template <class T>
+class MathTable
+{
+public:
+    /// Number of intervals of the tables
+    static constexpr int Bits = 10;
+    static constexpr int Size = 1 << Bits;
+
+    MathTable() noexcept : log2_(tables().log2), exp2_(tables().exp2) {}
+
+    T log2(T x) const noexcept
+    {
+        T e;
+        const T f = (internal::splitExponent<false>(x, e) - T(1)) * T(Size);
+        const int j = static_cast<int>(f);
+        const T w = f - T(j);
+
+        return e + log2_[j] + w * (log2_[j + 1] - log2_[j]);
+    }
+
+    T exp2(T x) const noexcept
+    {
+        const T n = internal::roundNearest(x);
+        const T f = (x - n + T(0.5)) * T(Size);
+        const int j = static_cast<int>(f);
+        const T w = f - T(j);
+
+        return (exp2_[j] + w * (exp2_[j + 1] - exp2_[j])) * internal::scaleExponent(n);
+    }
+
+    T pow(T x, T y) const noexcept { return internal::selectPositive(x, exp2(y * log2(x))); }
+    T exp10(T x) const noexcept { return exp2(x * T(3.3219280948873623)); }
+    T log10(T x) const noexcept { return log2(x) * T(0.30102999566398120); }
+
+private:
+    struct Tables
+    {
+        // One additional entry each, f = Size is reached for |f| = 1/2
+        T log2[Size + 2];
+        T exp2[Size + 2];
+
+        Tables() noexcept
+        {
+            for(int j = 0; j <= Size + 1; ++j)
+            {
+                log2[j] = T(std::log2(1.0 + double(j) / Size));
+                exp2[j] = T(std::exp2(double(j) / Size - 0.5));
+            }
+        }
+    };
+
+    static const Tables& tables() noexcept
+    {
+        static const Tables t;
+        return t;
+    }
+
+    const T* log2_;
+    const T* exp2_;
+};
+
+ISEN_NAMESPACE_END
+
+#endif
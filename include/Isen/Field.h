@@ -0,0 +1,220 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_FIELD_H
+#define ISEN_FIELD_H
+
+#include <Isen/Common.h>
+#include <Isen/Type.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#ifdef ISEN_PLATFORM_WINDOWS
+#include <malloc.h>
+#endif
+
+ISEN_NAMESPACE_BEGIN
+
+/// Eigen3 view of a ColMajor field with a leading dimension (outer stride) larger than the number of rows
+template <class T>
+using FieldMap = Eigen::Map<MatrixX<T>, Eigen::Unaligned, Eigen::OuterStride<>>;
+
+/// @brief Two-dimensional field with a padded and aligned leading dimension
+///
+/// The element (i, k) is stored at @c data()[k * ld() + i]. Every level (column) starts at a multiple of
+/// Field::Alignment bytes, hence vector loads at the start of a level are aligned and no peel loop is required. The
+/// leading dimension is an odd number of cache lines: a power-of-two stride (e.g nxb = 256) would map the same point
+/// of all levels to a few cache sets only.
+///
+/// The field is an Eigen::Map of its own buffer and can be used like an Eigen matrix of size rows() x cols() (element
+/// access, blocks and expressions ignore the padding). In contrast to Eigen::Matrix, Field::swap exchanges the buffers
+/// and allocating a field does not touch the memory (see Numa::allocate). A field can also be a non-owning view of a
+/// level-padded block of a larger allocation (see TracerField).
+template <class T>
+class Field : public FieldMap<T>
+{
+public:
+    using Base = FieldMap<T>;
+
+    /// Alignment of the levels in bytes (one cache line, the width of an AVX-512 register)
+    static constexpr int Alignment = 64;
+
+    /// Number of elements per cache line (the leading dimension is a multiple thereof)
+    static constexpr int Lanes = Alignment / sizeof(T);
+
+    /// Leading dimension of a field with @c rows rows
+    static int leadingDimension(int rows) noexcept
+    {
+        if(rows <= 0)
+            return 0;
+        const int lines = (rows + Lanes - 1) / Lanes;
+        return (lines | 1) * Lanes;
+    }
+
+    /// Empty field
+    Field() noexcept
+        : Base(nullptr, 0, 0, Eigen::OuterStride<>(0)), buffer_(nullptr), capacity_(0), ld_(0), owner_(true)
+    {}
+
+    /// @brief Uninitialized field of size @c rows x @c cols (see Field::resize)
+    ///
+    /// @throw std::bad_alloc if out of memory
+    Field(int rows, int cols, int ld = -1) : Field() { resize(rows, cols, ld); }
+
+    /// @brief Non-owning view of size @c rows x @c cols of the memory @c data with leading dimension @c ld
+    ///
+    /// The memory has to be aligned to Field::Alignment and has to outlive the view.
+    Field(T* data, int rows, int cols, int ld) noexcept : Field()
+    {
+        assert(ld >= rows && reinterpret_cast<std::uintptr_t>(data) % Alignment == 0);
+        buffer_ = data;
+        capacity_ = std::size_t(ld) * cols;
+        ld_ = ld;
+        owner_ = false;
+        remap(rows, cols);
+    }
+
+    /// Copy the field (the copy of a view owns its memory)
+    Field(const Field& other) : Field() { *this = other; }
+    Field(Field&& other) noexcept : Field() { swap(other); }
+
+    ~Field()
+    {
+        if(owner_)
+            deallocate(buffer_);
+    }
+
+    /// Copy the field (including the leading dimension)
+    Field& operator=(const Field& other)
+    {
+        if(this != &other)
+        {
+            resize(other.rows(), other.cols(), other.ld());
+            std::copy(other.buffer_, other.buffer_ + other.capacity_, buffer_);
+        }
+        return *this;
+    }
+
+    Field& operator=(Field&& other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    /// Assign an Eigen expression of the same size
+    template <class OtherDerived>
+    Field& operator=(const Eigen::DenseBase<OtherDerived>& other)
+    {
+        Base::operator=(other);
+        return *this;
+    }
+
+    /// @brief Resize the field to @c rows x @c cols with leading dimension @c ld (Field::leadingDimension if negative)
+    ///
+    /// The content is undefined after the call (the buffer is kept if the size of the buffer does not change). A view
+    /// which has to change the size of its buffer allocates its own memory.
+    ///
+    /// @throw std::bad_alloc if out of memory
+    void resize(int rows, int cols, int ld = -1)
+    {
+        ld = ld < 0 ? leadingDimension(rows) : ld;
+        assert(ld >= rows);
+
+        const std::size_t capacity = std::size_t(ld) * cols;
+        if(capacity != capacity_)
+        {
+            if(owner_)
+                deallocate(buffer_);
+            buffer_ = nullptr;
+            capacity_ = 0;
+            owner_ = true;
+
+            buffer_ = allocate(capacity);
+            capacity_ = capacity;
+        }
+
+        ld_ = ld;
+        remap(rows, cols);
+    }
+
+    /// Exchange the buffers of the two fields in O(1) (hides the element-wise Eigen::DenseBase::swap)
+    void swap(Field& other) noexcept
+    {
+        std::swap(buffer_, other.buffer_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(ld_, other.ld_);
+        std::swap(owner_, other.owner_);
+
+        const Eigen::Index rows = this->rows(), cols = this->cols();
+        remap(other.rows(), other.cols());
+        other.remap(rows, cols);
+    }
+
+    /// Leading dimension (distance of two levels in elements)
+    int ld() const noexcept { return ld_; }
+
+    /// Number of allocated elements (ld() * cols())
+    std::size_t capacity() const noexcept { return capacity_; }
+
+    /// Check if the field owns its memory (i.e it is not a view)
+    bool isOwner() const noexcept { return owner_; }
+
+private:
+    /// Point the Eigen::Map to the buffer (see "Changing the mapped array" in the documentation of Eigen::Map)
+    void remap(Eigen::Index rows, Eigen::Index cols) noexcept
+    {
+        new(static_cast<Base*>(this)) Base(buffer_, rows, cols, Eigen::OuterStride<>(ld_));
+    }
+
+    static T* allocate(std::size_t size)
+    {
+        if(size == 0)
+            return nullptr;
+
+        void* ptr = nullptr;
+#ifdef ISEN_PLATFORM_WINDOWS
+        ptr = _aligned_malloc(size * sizeof(T), Alignment);
+#else
+        if(posix_memalign(&ptr, Alignment, size * sizeof(T)) != 0)
+            ptr = nullptr;
+#endif
+        if(!ptr)
+            throw std::bad_alloc();
+        return static_cast<T*>(ptr);
+    }
+
+    static void deallocate(T* ptr) noexcept
+    {
+#ifdef ISEN_PLATFORM_WINDOWS
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+
+private:
+    T* buffer_;
+    std::size_t capacity_;
+    int ld_;
+    bool owner_;
+};
+
+/// Field in double precision
+using FieldXf = Field<double>;
+
+ISEN_NAMESPACE_END
+
+#endif
@@ -16,20 +16,35 @@
 #define ISEN_KESSLER_H
 
 #include <Isen/Common.h>
+#include <Isen/FastMath.h>
+#include <Isen/Field.h>
 #include <Isen/NameList.h>
 
 ISEN_NAMESPACE_BEGIN
 
 /// @brief Kessler Parametrization
 ///
-/// Kessler (1969) Microphysics Scheme
-class Kessler
+/// Kessler (1969) Microphysics Scheme. All computations are carried out in the scalar type @c T while the internal
+/// scratch arrays are stored in the scalar type @c S (the implementation is instantiated for double, float and
+/// double with float storage).
+template <class T, class S = T>
+class KesslerT
 {
 public:
-    /// Initialize temporaries
-    Kessler(std::shared_ptr<NameList> namelist);
+    /// Fields in the precision of the scheme
+    using MatrixXf = Field<T>;
+    using VectorXf = VectorX<T>;
 
-    /// Apply the Kessler microphysic scheme
+    /// Scratch arrays in the storage precision of the scheme
+    using ScratchMatrix = Field<S>;
+    using ScratchVector = VectorX<S>;
+
+    /// @brief Initialize temporaries
+    ///
+    /// @throw IsenException if out of memory or NameList::imath is invalid
+    KesslerT(std::shared_ptr<NameList> namelist);
+
+    /// Apply the Kessler microphysic scheme (opens its own parallel region)
     void apply(
         // Output
         MatrixXf& temp,
@@ -49,36 +64,104 @@ public:
         const MatrixXf& exn,
         const MatrixXf& zhtnow) noexcept;
 
+    /// Set the time step of the leapfrog scheme [s] (NameList::dt by default, see TimeControl)
+    void setTimeStep(double dt) noexcept { dt_ = dt; }
+
+    /// @brief Apply the Kessler microphysic scheme with the calling team of threads
+    ///
+    /// Has to be called by all threads of an enclosing parallel region (the loops are orphaned worksharing
+    /// constructs); outside of a parallel region the scheme runs serially. The output is complete once the call
+    /// returns. See KesslerT::apply for the arguments.
+    void applyTeam(
+        // Output
+        MatrixXf& temp,
+        MatrixXf& qvnew,
+        MatrixXf& qcnew,
+        MatrixXf& qrnew,
+        VectorXf& tot_prec,
+        VectorXf& prec,
+
+        // Input
+        const VectorXf& th0,
+        const MatrixXf& prs,
+        const MatrixXf& snow,
+        const MatrixXf& qvnow,
+        const MatrixXf& qcnow,
+        const MatrixXf& qrnow,
+        const MatrixXf& exn,
+        const MatrixXf& zhtnow) noexcept;
+
 private:
+    /// Implementation of applyTeam with the transcendental functions of @c math (see FastMath.h)
+    template <class Math>
+    void applyTeam(
+        const Math& math,
+
+        // Output
+        MatrixXf& temp,
+        MatrixXf& qvnew,
+        MatrixXf& qcnew,
+        MatrixXf& qrnew,
+        VectorXf& tot_prec,
+        VectorXf& prec,
+
+        // Input
+        const VectorXf& th0,
+        const MatrixXf& prs,
+        const MatrixXf& snow,
+        const MatrixXf& qvnow,
+        const MatrixXf& qcnow,
+        const MatrixXf& qrnow,
+        const MatrixXf& exn,
+        const MatrixXf& zhtnow) noexcept;
+
     std::shared_ptr<NameList> namelist_;
 
+    // Accuracy of the transcendental functions
+    MathTier tier_;
+
+    // Time step of the leapfrog scheme
+    double dt_;
+
+    // Reduction variables shared by the team
+    double nfalld_;
+    double nfalldNew_;
+    int kMax_;
+
     // Internal variables
-    MatrixXf rho_;
-    MatrixXf qcprod_;
-
-    MatrixXf qrr_;
-    MatrixXf vt_fact_;
-    MatrixXf vt_;
-
-    MatrixXf rdzw_;
-    MatrixXf crmax_;
-
-    VectorXf ppt_;
-    MatrixXf zw_;
-    VectorXf k_max_value_per_col_;
-
-    MatrixXf qrprod_;
-    MatrixXf pressure_;
-    MatrixXf gam_;
-    MatrixXf es_;
-    MatrixXf qvs_;
-    MatrixXf diff_;
-    MatrixXf produc_;
-    MatrixXf ern_;
-
-    MatrixXf production_;
+    ScratchMatrix rho_;
+    ScratchMatrix qcprod_;
+
+    ScratchMatrix qrr_;
+    ScratchMatrix vt_fact_;
+    ScratchMatrix vt_;
+
+    ScratchMatrix rdzw_;
+    ScratchMatrix crmax_;
+
+    ScratchVector ppt_;
+    ScratchMatrix zw_;
+    ScratchVector k_max_value_per_col_;
+
+    ScratchMatrix qrprod_;
+    ScratchMatrix pressure_;
+    ScratchMatrix gam_;
+    ScratchMatrix es_;
+    ScratchMatrix qvs_;
+    ScratchMatrix diff_;
+    ScratchMatrix produc_;
+    ScratchMatrix ern_;
+
+    ScratchMatrix production_;
 };
 
+extern template class KesslerT<double>;
+extern template class KesslerT<float>;
+extern template class KesslerT<double, float>;
+
+/// Kessler scheme in double precision
+using Kessler = KesslerT<double>;
+
 /// This is a convenience macro to declare local aliases of the NameList class inside any Kessler method
 #define KESSLER_DECLARE_ALL_ALIASES ISEN_NAMELIST_DECLARE_ALIAS(namelist_)
 
@@ -0,0 +1,157 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_KESSLER_COLUMN_H
+#define ISEN_KESSLER_COLUMN_H
+
+#include <Isen/Common.h>
+#include <Isen/FastMath.h>
+#include <Isen/Field.h>
+#include <Isen/Kessler.h>
+#include <Isen/NameList.h>
+#include <vector>
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Column-fused Kessler Parametrization
+///
+/// Computes the same results as KesslerT (bitwise) but processes blocks of BlockWidth adjacent columns from start to
+/// finish instead of sweeping about 30 times over the whole grid. Only a column of density, inverse layer thickness and
+/// rain flux per thread is kept as scratch memory, all other intermediate values are recomputed on the fly or held in
+/// registers. Between the sedimentation sub-steps the rain water is kept in @c qrnew and the terminal velocity in
+/// @c temp (both are overwritten by the final sweep).
+///
+/// The sub-steps are coupled through the maximal sedimentation Courant number of the whole grid, hence a sweep over
+/// all columns is carried out per sub-step, separated by a single barrier. The intermediate values are rounded to the
+/// storage type @c S exactly like the scratch arrays of KesslerT.
+///
+/// With NameList::sediment_col, each column is instead split into the number of sub-steps required by its own Courant
+/// number and the sedimentation of columns without rain is skipped altogether. The results then differ from KesslerT
+/// unless all raining columns require the same number of sub-steps.
+template <class T, class S = T>
+class KesslerColumnT
+{
+public:
+    /// Fields in the precision of the scheme
+    using MatrixXf = Field<T>;
+    using VectorXf = VectorX<T>;
+
+    /// Columns in the storage precision of the scheme
+    using ScratchVector = VectorX<S>;
+
+    /// Number of adjacent columns processed at once (one cache line of @c T)
+    static constexpr int BlockWidth = Field<T>::Lanes;
+
+    /// @brief Initialize the column scratch of each thread
+    ///
+    /// @throw IsenException if out of memory or NameList::imath is invalid
+    KesslerColumnT(std::shared_ptr<NameList> namelist);
+
+    /// Apply the Kessler microphysic scheme (opens its own parallel region)
+    void apply(
+        // Output
+        MatrixXf& temp,
+        MatrixXf& qvnew,
+        MatrixXf& qcnew,
+        MatrixXf& qrnew,
+        VectorXf& tot_prec,
+        VectorXf& prec,
+
+        // Input
+        const VectorXf& th0,
+        const MatrixXf& prs,
+        const MatrixXf& snow,
+        const MatrixXf& qvnow,
+        const MatrixXf& qcnow,
+        const MatrixXf& qrnow,
+        const MatrixXf& exn,
+        const MatrixXf& zhtnow) noexcept;
+
+    /// Set the time step of the leapfrog scheme [s] (NameList::dt by default, see TimeControl)
+    void setTimeStep(double dt) noexcept { dt_ = dt; }
+
+    /// @brief Apply the Kessler microphysic scheme with the calling team of threads
+    ///
+    /// Has to be called by all threads of an enclosing parallel region; outside of a parallel region the scheme runs
+    /// serially. The output is complete once the call returns. See KesslerColumnT::apply for the arguments.
+    void applyTeam(
+        // Output
+        MatrixXf& temp,
+        MatrixXf& qvnew,
+        MatrixXf& qcnew,
+        MatrixXf& qrnew,
+        VectorXf& tot_prec,
+        VectorXf& prec,
+
+        // Input
+        const VectorXf& th0,
+        const MatrixXf& prs,
+        const MatrixXf& snow,
+        const MatrixXf& qvnow,
+        const MatrixXf& qcnow,
+        const MatrixXf& qrnow,
+        const MatrixXf& exn,
+        const MatrixXf& zhtnow) noexcept;
+
+private:
+    /// Implementation of applyTeam with the transcendental functions of @c math (see FastMath.h)
+    template <class Math>
+    void applyTeam(
+        const Math& math,
+
+        // Output
+        MatrixXf& temp,
+        MatrixXf& qvnew,
+        MatrixXf& qcnew,
+        MatrixXf& qrnew,
+        VectorXf& tot_prec,
+        VectorXf& prec,
+
+        // Input
+        const VectorXf& th0,
+        const MatrixXf& prs,
+        const MatrixXf& snow,
+        const MatrixXf& qvnow,
+        const MatrixXf& qcnow,
+        const MatrixXf& qrnow,
+        const MatrixXf& exn,
+        const MatrixXf& zhtnow) noexcept;
+
+    std::shared_ptr<NameList> namelist_;
+
+    // Accuracy of the transcendental functions
+    MathTier tier_;
+
+    // Time step of the leapfrog scheme
+    double dt_;
+
+    // Column scratch of each thread (density, inverse layer thickness and rain flux of a block of columns or, with
+    // NameList::sediment_col, additionally rain water and terminal velocity of a single column)
+    std::vector<ScratchVector> columns_;
+
+    // Maximal number of sedimentation sub-steps of each thread (two slots per thread, used alternately by consecutive
+    // reductions such that a slot is never written while it may still be read)
+    std::vector<double> nfall_;
+};
+
+extern template class KesslerColumnT<double>;
+extern template class KesslerColumnT<float>;
+extern template class KesslerColumnT<double, float>;
+
+/// Column-fused Kessler scheme in double precision
+using KesslerColumn = KesslerColumnT<double>;
+
+ISEN_NAMESPACE_END
+
+#endif
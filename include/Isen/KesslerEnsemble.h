@@ -0,0 +1,134 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_KESSLER_ENSEMBLE_H
+#define ISEN_KESSLER_ENSEMBLE_H
+
+#include <Isen/Common.h>
+#include <Isen/FastMath.h>
+#include <Isen/Field.h>
+#include <Isen/NameList.h>
+#include <vector>
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Kessler Parametrization of an ensemble
+///
+/// Computes the same results as KesslerT (bitwise) for every member of an ensemble whose fields are stored interleaved
+/// with the member index innermost (see SolverEnsemble). The members may differ in NameList::vt_mult,
+/// NameList::autoconv_th and NameList::autoconv_mult, these parameters are expanded to rows of a level such that all
+/// loops run over the contiguous points of a level (of all members) and are vectorizable as those of KesslerT. The
+/// number of sedimentation sub-steps is determined per member (i.e by the maximal Courant number of the member's grid as
+/// in KesslerT), members which completed their sub-steps take sub-steps of length zero.
+class KesslerEnsemble
+{
+public:
+    /// @brief Initialize temporaries for the members given by their @c namelists
+    ///
+    /// @throw IsenException if out of memory or NameList::imath is invalid
+    KesslerEnsemble(const std::vector<std::shared_ptr<NameList>>& namelists);
+
+    /// Set the time step of the leapfrog scheme [s] (NameList::dt by default, see TimeControl)
+    void setTimeStep(double dt) noexcept { dt_ = dt; }
+
+    /// @brief Apply the Kessler microphysic scheme with the calling team of threads
+    ///
+    /// All fields are interleaved (i.e the rows of a field are @c nxb * size of the ensemble and the leading dimension is
+    /// the one of SolverEnsemble), the profile @c th0 holds the profiles of all members interleaved. Has to be called by
+    /// all threads of an enclosing parallel region. The output is complete once the call returns. See KesslerT::apply
+    /// for the arguments.
+    void applyTeam(
+        // Output
+        FieldXf& temp,
+        FieldXf& qvnew,
+        FieldXf& qcnew,
+        FieldXf& qrnew,
+        VectorXf& tot_prec,
+        VectorXf& prec,
+
+        // Input
+        const VectorXf& th0,
+        const FieldXf& prs,
+        const FieldXf& snow,
+        const FieldXf& qvnow,
+        const FieldXf& qcnow,
+        const FieldXf& qrnow,
+        const FieldXf& exn,
+        const FieldXf& zhtnow) noexcept;
+
+private:
+    /// Implementation of applyTeam with the transcendental functions of @c math (see FastMath.h)
+    template <class Math>
+    void applyTeam(
+        const Math& math,
+
+        // Output
+        FieldXf& temp,
+        FieldXf& qvnew,
+        FieldXf& qcnew,
+        FieldXf& qrnew,
+        VectorXf& tot_prec,
+        VectorXf& prec,
+
+        // Input
+        const VectorXf& th0,
+        const FieldXf& prs,
+        const FieldXf& snow,
+        const FieldXf& qvnow,
+        const FieldXf& qcnow,
+        const FieldXf& qrnow,
+        const FieldXf& exn,
+        const FieldXf& zhtnow) noexcept;
+
+    /// Reduce the thread-local maximal Courant numbers @c local of the members into @c crmax_ and wait for all threads
+    /// of the team
+    void teamReduceCourant(const std::vector<double>& local) noexcept;
+
+    std::shared_ptr<NameList> namelist_;
+
+    // Number of members
+    int size_;
+
+    // Accuracy of the transcendental functions
+    MathTier tier_;
+
+    // Time step of the leapfrog scheme
+    double dt_;
+
+    // Parameters of the members expanded to a level, i.e element i * size + m holds the parameter of member m
+    VectorXf vtFactRow_;
+    VectorXf c1Row_;
+    VectorXf c2Row_;
+
+    // State of the sedimentation of each member (shared by the team)
+    std::vector<int> nfall_;
+    std::vector<double> crmax_;
+    std::vector<double> dtfall_;
+    std::vector<double> timeSediment_;
+    VectorXf dtfallRow_;
+    VectorXf timeSedimentRow_;
+    std::vector<char> lastStepRow_; ///< 1 where the member takes its last (or no more) sub-step
+
+    // Internal variables (interleaved)
+    FieldXf rho_;
+    FieldXf qcprod_;
+    FieldXf vtFact_;
+    FieldXf vt_;
+    FieldXf rdzw_;
+    FieldXf zw_;
+};
+
+ISEN_NAMESPACE_END
+
+#endif
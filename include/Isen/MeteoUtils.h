@@ -16,6 +16,7 @@
 #define ISEN_METEO_UTILS_H
 
 #include <Isen/Common.h>
+#include <Isen/FastMath.h>
 #include <cmath>
 
 ISEN_NAMESPACE_BEGIN
@@ -64,23 +65,26 @@ struct MeteoUtils
     ///
     /// Using Goff-Gratch formulation which is based on exact integration of Clausius-Clapeyron equation.
     ///
-    /// @param T    Temperature [K]
-    static inline double eswat1(double T) noexcept
+    /// @param T    Temperature [K] (the computation is carried out in the precision of @c Scalar)
+    /// @param math Policy of the transcendental functions (see FastMath.h)
+    template <class Scalar, class Math = MathExact<Scalar>>
+    static inline Scalar eswat1(Scalar T, const Math& math = Math()) noexcept
     {
         // Define local constants
-        constexpr double C1 = 7.90298;
-        constexpr double C2 = 5.02808;
-        constexpr double C3 = 1.3816e-7;
-        constexpr double C4 = 11.344;
-        constexpr double C5 = 8.1328e-3;
-        constexpr double C6 = 3.49149;
+        constexpr Scalar C1 = 7.90298;
+        constexpr Scalar C2 = 5.02808;
+        constexpr Scalar C3 = 1.3816e-7;
+        constexpr Scalar C4 = 11.344;
+        constexpr Scalar C5 = 8.1328e-3;
+        constexpr Scalar C6 = 3.49149;
+        constexpr Scalar one = 1.0;
 
-        double rmixv = 373.16 / T;
+        Scalar rmixv = Scalar(373.16) / T;
 
-        double ES = -C1 * (rmixv - 1.0) + C2 * std::log10(rmixv) - C3 * (std::pow(10, C4 * (1.0 - 1.0 / rmixv)) - 1.0)
-                    + C5 * (std::pow(10, -C6 * (rmixv - 1.0)) - 1.0);
+        Scalar ES = -C1 * (rmixv - one) + C2 * math.log10(rmixv) - C3 * (math.exp10(C4 * (one - one / rmixv)) - one)
+                    + C5 * (math.exp10(-C6 * (rmixv - one)) - one);
 
-        return (1013.246 * std::pow(10, ES));
+        return (Scalar(1013.246) * math.exp10(ES));
     }
 };
 
@@ -49,6 +49,43 @@ struct NameList
     int iout = 360;
     /// Write initial field
     bool iiniout = true;
+    /// Write a checkpoint '<run_name>.ckpt' every icheckpoint-th time-step (0 = never, see Solver::restart)
+    int icheckpoint = 0;
+    /// Codec of the chunked archive: none, zlib, lz4, zstd or auto (see Compression)
+    std::string compression = "auto";
+    /// Output steps per chunk of the chunked archive
+    int chunk_nt = 8;
+    /// Grid points in x-direction per chunk of the chunked archive
+    int chunk_nx = 64;
+    /// Encoding of the fields with an error bound in the chunked archive: lossless, float32, float16, fixed, delta or
+    /// transform (see Encoding)
+    std::string encoding = "lossless";
+    /// Absolute error bounds of the fields in the chunked archive (0 = lossless, see encoding)
+    double tol_z = 0.0;
+    double tol_u = 0.0;
+    double tol_s = 0.0;
+    double tol_prec = 0.0;
+    double tol_tot_prec = 0.0;
+    double tol_qv = 0.0;
+    double tol_qc = 0.0;
+    double tol_qr = 0.0;
+    double tol_nr = 0.0;
+    double tol_nc = 0.0;
+    double tol_dthetadt = 0.0;
+    /// Fields written to the output separated by ':' or ',' (e.g 'u:s:qv'), 'all' writes every field
+    std::string out_fields = "all";
+    /// First grid point in x-direction of the output window
+    int out_xmin = 0;
+    /// Last grid point (exclusive) in x-direction of the output window (0 = nx)
+    int out_xmax = 0;
+    /// First level of the output window
+    int out_zmin = 0;
+    /// Last level (exclusive) of the output window (0 = nz, the height z includes the upper interface out_zmax)
+    int out_zmax = 0;
+    /// Write every out_xstride-th grid point in x-direction of the output window
+    int out_xstride = 1;
+    /// Write every out_zstride-th level of the output window
+    int out_zstride = 1;
 
     //-------------------------------------------------
     // Domain size
@@ -68,6 +105,16 @@ struct NameList
     double dt = 10;
     /// Horizontal diffusion coefficient
     double diff = 0.02;
+    /// Adapt the time step to the CFL condition (dt is the initial time step)
+    bool iadapt = false;
+    /// Target CFL number of the adaptive time step
+    double cfl_target = 0.7;
+    /// Maximal growth of the adaptive time step per time step
+    double dt_grow = 1.1;
+    /// Maximal shrink of the adaptive time step per time step
+    double dt_shrink = 0.5;
+    /// Upper bound of the adaptive time step [s] (0 = unbounded)
+    double dt_max = 0;
 
     //-------------------------------------------------
     // Topography
@@ -150,6 +197,19 @@ struct NameList
     double autoconv_mult = 1.0;
     /// Switch to turn on / off sedimentation
     bool sediment_on = true;
+    /// Adapt the number of sedimentation sub-steps to each column instead of the whole grid (cpu solvers)
+    bool sediment_col = false;
+
+    //-------------------------------------------------
+    // Solver options
+    //-------------------------------------------------
+
+    /// Temporal block depth of the blocked solver (time steps advanced per tile)
+    int tblock = 4;
+    /// Store the old time levels and the Kessler scratch arrays in single precision (cpu solver)
+    bool imixprec = false;
+    /// Accuracy of pow, exp10 and log10 in SolverCpu and Kessler (0 = exact, 1 = polynomial, 2 = table lookup)
+    int imath = 0;
 
     //-------------------------------------------------
     // Computed input parameters
@@ -220,7 +280,7 @@ struct NameList
 
     /// Serialize the NameList (used by Output)
     template <class Archive>
-    void serialize(Archive& ar, const unsigned int /* version */)
+    void serialize(Archive& ar, const unsigned int version)
     {
         ar& BOOST_SERIALIZATION_NVP(run_name);
         ar& BOOST_SERIALIZATION_NVP(iout);
@@ -266,13 +326,81 @@ struct NameList
         ar& BOOST_SERIALIZATION_NVP(nz1);
         ar& BOOST_SERIALIZATION_NVP(nxb);
         ar& BOOST_SERIALIZATION_NVP(nxb1);
+
+        if(version >= 1)
+        {
+            ar& BOOST_SERIALIZATION_NVP(tblock);
+        }
+
+        if(version >= 2)
+        {
+            ar& BOOST_SERIALIZATION_NVP(imixprec);
+        }
+
+        if(version >= 3)
+        {
+            ar& BOOST_SERIALIZATION_NVP(imath);
+        }
+
+        if(version >= 4)
+        {
+            ar& BOOST_SERIALIZATION_NVP(sediment_col);
+        }
+
+        if(version >= 5)
+        {
+            ar& BOOST_SERIALIZATION_NVP(iadapt);
+            ar& BOOST_SERIALIZATION_NVP(cfl_target);
+            ar& BOOST_SERIALIZATION_NVP(dt_grow);
+            ar& BOOST_SERIALIZATION_NVP(dt_shrink);
+            ar& BOOST_SERIALIZATION_NVP(dt_max);
+        }
+
+        if(version >= 6)
+        {
+            ar& BOOST_SERIALIZATION_NVP(icheckpoint);
+        }
+
+        if(version >= 7)
+        {
+            ar& BOOST_SERIALIZATION_NVP(compression);
+            ar& BOOST_SERIALIZATION_NVP(chunk_nt);
+            ar& BOOST_SERIALIZATION_NVP(chunk_nx);
+        }
+
+        if(version >= 8)
+        {
+            ar& BOOST_SERIALIZATION_NVP(encoding);
+            ar& BOOST_SERIALIZATION_NVP(tol_z);
+            ar& BOOST_SERIALIZATION_NVP(tol_u);
+            ar& BOOST_SERIALIZATION_NVP(tol_s);
+            ar& BOOST_SERIALIZATION_NVP(tol_prec);
+            ar& BOOST_SERIALIZATION_NVP(tol_tot_prec);
+            ar& BOOST_SERIALIZATION_NVP(tol_qv);
+            ar& BOOST_SERIALIZATION_NVP(tol_qc);
+            ar& BOOST_SERIALIZATION_NVP(tol_qr);
+            ar& BOOST_SERIALIZATION_NVP(tol_nr);
+            ar& BOOST_SERIALIZATION_NVP(tol_nc);
+            ar& BOOST_SERIALIZATION_NVP(tol_dthetadt);
+        }
+
+        if(version >= 9)
+        {
+            ar& BOOST_SERIALIZATION_NVP(out_fields);
+            ar& BOOST_SERIALIZATION_NVP(out_xmin);
+            ar& BOOST_SERIALIZATION_NVP(out_xmax);
+            ar& BOOST_SERIALIZATION_NVP(out_zmin);
+            ar& BOOST_SERIALIZATION_NVP(out_zmax);
+            ar& BOOST_SERIALIZATION_NVP(out_xstride);
+            ar& BOOST_SERIALIZATION_NVP(out_zstride);
+        }
     }
 };
 
 ISEN_NAMESPACE_END
 
 // Current version of NameList
-BOOST_CLASS_VERSION(Isen::NameList, 0);
+BOOST_CLASS_VERSION(Isen::NameList, 9);
 
 /// This is a convenience macro to declare local aliases of the NameList class
 #define ISEN_NAMELIST_DECLARE_ALIAS(namelist)                                                                          \
@@ -282,6 +410,52 @@ BOOST_CLASS_VERSION(Isen::NameList, 0);
     (void) iout;                                                                                                       \
     const auto iiniout ISEN_UNUSED = namelist->iiniout;                                                                \
     (void) iiniout;                                                                                                    \
+    const auto icheckpoint ISEN_UNUSED = namelist->icheckpoint;                                                        \
+    (void) icheckpoint;                                                                                                \
+    const auto compression ISEN_UNUSED = namelist->compression;                                                        \
+    (void) compression;                                                                                                \
+    const auto chunk_nt ISEN_UNUSED = namelist->chunk_nt;                                                              \
+    (void) chunk_nt;                                                                                                   \
+    const auto chunk_nx ISEN_UNUSED = namelist->chunk_nx;                                                              \
+    (void) chunk_nx;                                                                                                   \
+    const auto encoding ISEN_UNUSED = namelist->encoding;                                                              \
+    (void) encoding;                                                                                                   \
+    const auto tol_z ISEN_UNUSED = namelist->tol_z;                                                                    \
+    (void) tol_z;                                                                                                      \
+    const auto tol_u ISEN_UNUSED = namelist->tol_u;                                                                    \
+    (void) tol_u;                                                                                                      \
+    const auto tol_s ISEN_UNUSED = namelist->tol_s;                                                                    \
+    (void) tol_s;                                                                                                      \
+    const auto tol_prec ISEN_UNUSED = namelist->tol_prec;                                                              \
+    (void) tol_prec;                                                                                                   \
+    const auto tol_tot_prec ISEN_UNUSED = namelist->tol_tot_prec;                                                      \
+    (void) tol_tot_prec;                                                                                               \
+    const auto tol_qv ISEN_UNUSED = namelist->tol_qv;                                                                  \
+    (void) tol_qv;                                                                                                     \
+    const auto tol_qc ISEN_UNUSED = namelist->tol_qc;                                                                  \
+    (void) tol_qc;                                                                                                     \
+    const auto tol_qr ISEN_UNUSED = namelist->tol_qr;                                                                  \
+    (void) tol_qr;                                                                                                     \
+    const auto tol_nr ISEN_UNUSED = namelist->tol_nr;                                                                  \
+    (void) tol_nr;                                                                                                     \
+    const auto tol_nc ISEN_UNUSED = namelist->tol_nc;                                                                  \
+    (void) tol_nc;                                                                                                     \
+    const auto tol_dthetadt ISEN_UNUSED = namelist->tol_dthetadt;                                                      \
+    (void) tol_dthetadt;                                                                                               \
+    const auto out_fields ISEN_UNUSED = namelist->out_fields;                                                          \
+    (void) out_fields;                                                                                                 \
+    const auto out_xmin ISEN_UNUSED = namelist->out_xmin;                                                              \
+    (void) out_xmin;                                                                                                   \
+    const auto out_xmax ISEN_UNUSED = namelist->out_xmax;                                                              \
+    (void) out_xmax;                                                                                                   \
+    const auto out_zmin ISEN_UNUSED = namelist->out_zmin;                                                              \
+    (void) out_zmin;                                                                                                   \
+    const auto out_zmax ISEN_UNUSED = namelist->out_zmax;                                                              \
+    (void) out_zmax;                                                                                                   \
+    const auto out_xstride ISEN_UNUSED = namelist->out_xstride;                                                        \
+    (void) out_xstride;                                                                                                \
+    const auto out_zstride ISEN_UNUSED = namelist->out_zstride;                                                        \
+    (void) out_zstride;                                                                                                \
     const auto xl ISEN_UNUSED = namelist->xl;                                                                          \
     (void) xl;                                                                                                         \
     const auto nx ISEN_UNUSED = namelist->nx;                                                                          \
@@ -298,6 +472,16 @@ BOOST_CLASS_VERSION(Isen::NameList, 0);
     (void) dt;                                                                                                         \
     const auto diff ISEN_UNUSED = namelist->diff;                                                                      \
     (void) diff;                                                                                                       \
+    const auto iadapt ISEN_UNUSED = namelist->iadapt;                                                                  \
+    (void) iadapt;                                                                                                     \
+    const auto cfl_target ISEN_UNUSED = namelist->cfl_target;                                                          \
+    (void) cfl_target;                                                                                                 \
+    const auto dt_grow ISEN_UNUSED = namelist->dt_grow;                                                                \
+    (void) dt_grow;                                                                                                    \
+    const auto dt_shrink ISEN_UNUSED = namelist->dt_shrink;                                                            \
+    (void) dt_shrink;                                                                                                  \
+    const auto dt_max ISEN_UNUSED = namelist->dt_max;                                                                  \
+    (void) dt_max;                                                                                                     \
     const auto topomx ISEN_UNUSED = namelist->topomx;                                                                  \
     (void) topomx;                                                                                                     \
     const auto topowd ISEN_UNUSED = namelist->topowd;                                                                  \
@@ -350,6 +534,14 @@ BOOST_CLASS_VERSION(Isen::NameList, 0);
     (void) autoconv_mult;                                                                                              \
     const auto sediment_on ISEN_UNUSED = namelist->sediment_on;                                                        \
     (void) sediment_on;                                                                                                \
+    const auto sediment_col ISEN_UNUSED = namelist->sediment_col;                                                      \
+    (void) sediment_col;                                                                                               \
+    const auto tblock ISEN_UNUSED = namelist->tblock;                                                                  \
+    (void) tblock;                                                                                                     \
+    const auto imixprec ISEN_UNUSED = namelist->imixprec;                                                              \
+    (void) imixprec;                                                                                                   \
+    const auto imath ISEN_UNUSED = namelist->imath;                                                                    \
+    (void) imath;                                                                                                      \
     const auto dth ISEN_UNUSED = namelist->dth;                                                                        \
     (void) dth;                                                                                                        \
     const auto nts ISEN_UNUSED = namelist->nts;                                                                        \
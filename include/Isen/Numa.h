@@ -0,0 +1,117 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_NUMA_H
+#define ISEN_NUMA_H
+
+#include <Isen/Common.h>
+#include <Isen/Field.h>
+#include <Isen/Tracer.h>
+#include <Isen/Type.h>
+#include <string>
+
+ISEN_NAMESPACE_BEGIN
+
+/// Placement policies of the memory pages of the fields
+enum class NumaPolicy
+{
+    FirstTouch = 0, ///< Pages are placed on the node of the thread which initializes them first
+    Interleave,     ///< Pages are distributed round-robin over all nodes (requires libnuma)
+    Bind            ///< Pages are bound to the node of the allocating thread (requires libnuma)
+};
+
+/// @brief NUMA aware allocation of the fields
+///
+/// The fields are zero initialized in parallel with the same partitioning of the vertical levels as the kernels of
+/// SolverCpu (static schedule over k), hence with the default first-touch policy of the operating system each thread
+/// works on the pages residing on its own node. This requires the threads to be bound to the cores (e.g
+/// OMP_PROC_BIND=close and OMP_PLACES=cores), otherwise they may migrate away from their pages.
+///
+/// If Isen has been compiled with libnuma (ISEN_NUMA), the pages can instead be interleaved over all nodes or bound to
+/// the node of the allocating thread (e.g when running one process per socket).
+class Numa
+{
+public:
+    /// Get the placement policy used for new allocations
+    static NumaPolicy getPolicy() noexcept;
+
+    /// @brief Set the placement policy used for new allocations
+    ///
+    /// @throw IsenException if the policy is not available (see Numa::isAvailable)
+    static void setPolicy(NumaPolicy policy);
+
+    /// Check if the policy is available (FirstTouch is always available)
+    static bool isAvailable(NumaPolicy policy) noexcept;
+
+    /// Number of NUMA nodes of the system (1 if unknown)
+    static int numNodes() noexcept;
+
+    /// @brief Allocate a zero initialized matrix of size @c rows x @c cols according to the placement policy
+    ///
+    /// @throw std::bad_alloc if out of memory
+    template <class T>
+    static void allocate(MatrixX<T>& mat, int rows, int cols);
+
+    /// @brief Allocate a zero initialized field of size @c rows x @c cols with leading dimension @c ld (see
+    /// Field::resize) according to the placement policy
+    ///
+    /// The padding of the levels is zero initialized as well.
+    ///
+    /// @throw std::bad_alloc if out of memory
+    template <class T>
+    static void allocate(Field<T>& field, int rows, int cols, int ld = -1);
+
+    /// @brief Allocate @c numTracers zero initialized tracers of size @c rows x @c cols with leading dimension @c ld
+    /// (see TracerField::resize) according to the placement policy
+    ///
+    /// A level is touched first by the same thread for all tracers.
+    ///
+    /// @throw std::bad_alloc if out of memory
+    template <class T>
+    static void allocate(TracerField<T>& tracers, int numTracers, int rows, int cols, int ld = -1);
+
+    /// @brief Describe the placement of the memory range [ptr, ptr + bytes)
+    ///
+    /// The string contains the policy, the fraction of the pages residing on each node (if known) and the binding of
+    /// the OpenMP threads, e.g "first-touch, 2 nodes (50% node 0, 50% node 1), threads bound (close)".
+    static std::string describe(const void* ptr, std::size_t bytes);
+
+    /// Convert to string ("first-touch", "interleave" or "bind")
+    static const char* toString(NumaPolicy policy) noexcept;
+
+    /// @brief Convert from string
+    ///
+    /// @throw IsenException if the string is not a valid policy
+    static NumaPolicy fromString(const std::string& str);
+};
+
+/// @brief Apply the placement policy of Numa to all allocations of the calling thread within the current scope
+///
+/// This has no effect for the FirstTouch policy or if Isen has been compiled without libnuma.
+class NumaScope
+{
+public:
+    NumaScope() noexcept;
+    ~NumaScope();
+
+    NumaScope(const NumaScope&) = delete;
+    NumaScope& operator=(const NumaScope&) = delete;
+
+private:
+    bool active_;
+};
+
+ISEN_NAMESPACE_END
+
+#endif
@@ -16,13 +16,19 @@
 #define ISEN_OUTPUT_H
 
 #include <Isen/Common.h>
+#include <Isen/Field.h>
 #include <Isen/NameList.h>
+#include <Isen/OutputMap.h>
+#include <Isen/OutputStore.h>
+#include <Isen/OutputStream.h>
 #include <boost/serialization/access.hpp>
 #include <boost/serialization/nvp.hpp>
 #include <boost/serialization/shared_ptr.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/version.hpp>
 #include <boost/shared_ptr.hpp>
+#include <exception>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -95,10 +101,20 @@ public:
         Unknown = 0,
         Text,
         Xml,
-        Binary
+        Binary,
+        Stream, ///< Frames are appended to the file during the simulation (see OutputStream)
+        Mapped, ///< Memory-mapped archive with a frame index, read lazily (see OutputMap)
+        Chunked ///< Compressed chunks written during the simulation, read lazily (see OutputStore)
     };
 
-    /// Initialize output engine (ReadWrite Mode)
+    /// @brief Initialize output engine (ReadWrite Mode)
+    ///
+    /// Only the fields of NameList::out_fields within the output window (see OutputWindow) are stored, buffers are
+    /// allocated for these fields only. With the Stream and Chunked archive, the frames are not kept in memory but handed to a background writer
+    /// which appends them to the output file (see OutputStream and OutputStore). The file is created at the first
+    /// output step.
+    ///
+    /// @throw IsenException if a selected field is unknown or not available or the output window is invalid
     Output(std::shared_ptr<NameList> namelist, ArchiveType archiveType = Text);
 
     /// Initialize output engine (ReadOnly Mode)
@@ -106,21 +122,96 @@ public:
 
     /// @brief Append current fields to the output fields.
     ///
+    /// The fields are copied in tiles of columns by OpenMP tasks. If called by a single thread of a parallel region
+    /// (e.g the master thread of SolverCpu::run), the tasks are executed by the threads of the team waiting at the next
+    /// barrier, otherwise by a team of its own.
+    ///
     /// The Output needs to be initalized in ReadWrite mode
     void makeOutput(const Solver* solver) noexcept;
 
+    /// Look up the fields of the solver again at the next output step (e.g after the solver changed the precision of
+    /// its fields, see SolverCpuF32)
+    void resetCopies() noexcept { copySolver_ = nullptr; }
+
     /// @brief Open the output archive and serialize the fields.
     ///
     /// This will produce an output file named after NameList::run_name (if the file exists already a timestemp will be
-    /// appended), optionally you can directly pass a filename. The simulation will be serialized to an archive and can
-    /// be retrived using Output::read().
+    /// appended) or the file set by Output::setFilename, optionally you can directly pass a filename. The simulation
+    /// will be serialized to an archive and can be retrived using Output::read(). If the frames were streamed, the
+    /// outstanding frames are written and the file is closed.
+    ///
+    /// @throw IsenException if the frames were streamed to a file other than @c filename
     void write(std::string filename = "");
 
+    /// @brief Set the output file (e.g reserved by the caller for concurrent simulations with the same run_name)
+    ///
+    /// Has to be called before the simulation, the stream and chunked archives are written to @c filename directly.
+    void setFilename(const std::string& filename) { filename_ = filename; }
+
+    /// @brief File extension of the archive type (including the dot)
+    ///
+    /// @throw IsenException if the archive type is unknown
+    static std::string extension(ArchiveType archiveType);
+
     /// @brief Read the input archive and deserialize the fields.
     ///
-    /// After this operation the fields will be available via the getter methods
+    /// After this operation the fields will be available via the getter methods. A stream archive can be read while
+    /// the simulation is still running (only the complete frames are read). Mapped and chunked archives are not read
+    /// at all: The frames are accessed on demand (see Output::frame), the getter methods copy the field on first access.
     void read(const std::string& filename);
 
+    /// Number of frames
+    int numFrames() const;
+
+    /// @brief Time of frame @c n
+    ///
+    /// @throw IsenException if the frame is out of range
+    double time(int n) const;
+
+    /// Check if the field @c name (e.g "z" or "qv") is part of the output
+    bool has(const std::string& name) const;
+
+    /// Columns of the frames (see OutputWindow)
+    int frameNx() const;
+
+    /// @brief Levels of the frames of the field @c name (zero for fields without levels, e.g "prec")
+    ///
+    /// @throw IsenException if there is no such field
+    int frameNz(const std::string& name) const;
+
+    /// @brief Elements per frame of the field @c name (e.g "z" or "qv")
+    ///
+    /// @throw IsenException if there is no such field
+    std::size_t frameSize(const std::string& name) const;
+
+    /// @brief Guaranteed absolute error of the field @c name (non-zero if it was read from a lossy chunked archive)
+    ///
+    /// @throw IsenException if there is no such field
+    double errorBound(const std::string& name) const;
+
+    /// @brief Elements of the field @c name at frame @c n (the x-direction varies slowest)
+    ///
+    /// Frames of a mapped archive point into the mapped file, i.e only the pages of the frame are read. Frames of a
+    /// chunked archive are decompressed chunk by chunk, the pointer is valid until the next call.
+    ///
+    /// @throw IsenException if there is no such field or if the frame is out of range
+    const double* frame(const std::string& name, int n) const;
+
+    /// @brief Store the output produced so far in @c checkpoint (see Solver::restart)
+    ///
+    /// Streamed frames are flushed, the checkpoint refers to the file and its current size.
+    void saveState(Checkpoint& checkpoint) const;
+
+    /// @brief Restore the output produced so far from @c checkpoint
+    ///
+    /// Streamed output is truncated to the size at the checkpoint and continued.
+    ///
+    /// @throw IsenException if the checkpoint holds no output or if it was streamed and this output isn't (or vice versa)
+    void loadState(const Checkpoint& checkpoint);
+
+    /// Neither keep nor write any frames (e.g on the ranks of an MPI simulation which don't write the output)
+    void discardFrames();
+
     /// Access NameList (ReadOnly)
     const NameList* getNameList() const { return namelist_.get(); }
 
@@ -131,48 +222,124 @@ public:
     ArchiveType getArchiveType() const { return archiveType_; }
 
 private:
+    /// Field of a frame: name, buffer of all frames, number of elements per frame and error bound of the encoding
+    struct FrameField
+    {
+        const char* name;
+        std::vector<double>* data;
+        std::size_t size;
+        double bound;
+        const char* source; ///< Field of the solver (nullptr if the field is not filled by Output::makeOutput)
+        int levels;         ///< Levels per column (zero for fields without levels)
+    };
+
+    /// Source of a field of a frame in the solver (see Output::makeOutput)
+    struct FrameCopy
+    {
+        const FieldXf* mat;           ///< Field with levels of the solver (nullptr if the field has no levels)
+        const VectorXf* vec;          ///< Field without levels of the solver (nullptr if the field has levels)
+        const Field<float>* matF32;   ///< Single precision field with levels (see Solver::getMatF32)
+        const VectorX<float>* vecF32; ///< Single precision field without levels (see Solver::getVecF32)
+        bool staggered;               ///< Averaged to the cell centers
+
+        /// Field with levels (in double or single precision)
+        bool hasLevels() const noexcept { return mat || matF32; }
+
+        /// Field without levels (in double or single precision)
+        bool hasVector() const noexcept { return vec || vecF32; }
+    };
+
+    /// @brief Selected fields of a frame of the NameList (in the order of the stream archive, the time is not included)
+    ///
+    /// If @c all is true, the unselected fields are included as well.
+    std::vector<FrameField> frameFields(bool all = false) const;
+
+    /// Look up the fields of the solver copied by Output::makeOutput (the fields are swapped in place, the pointers
+    /// thus remain valid for the lifetime of the solver)
+    void resolveCopies(const Solver* solver);
+
+    /// Layout of the frames of the stream and chunked archive
+    OutputLayout streamLayout() const;
+
+    /// Buffer of all frames of the field @c name (copied from the mapped or chunked archive on first access)
+    const std::vector<double>& load(const char* name, std::vector<double>& data) const;
+
+    /// Copy all fields from the mapped or chunked archive
+    void loadAll() const;
+
+    /// Write all frames in memory as mapped archive
+    void writeMapped(const std::string& filename);
+
+    /// Name of the output file: the file set by Output::setFilename or NameList::run_name and the extension (with a
+    /// timestemp if the file exists already)
+    std::string makeFilename() const;
+
+    /// @brief Create the writer of the stream or chunked archive
+    ///
+    /// If @c offset is non-zero, the existing file is truncated and continued at frame @c frame.
+    std::shared_ptr<OutputSink> openSink(const std::string& filename, std::uint64_t offset = 0, int frame = 0) const;
+
+    /// Frame buffer of the stream writer (opens the stream on first use), nullptr if the stream failed
+    double* acquireStreamFrame() noexcept;
+
+    /// Write all frames in memory as stream or chunked archive
+    void writeStream(const std::string& filename);
+
+    /// Read the complete frames of the stream archive
+    void readStream(const std::string& filename);
+
     ArchiveType archiveType_;
     boost::shared_ptr<NameList> namelist_;
+    std::string filename_; ///< Output file set by Output::setFilename (empty if named by Output::makeFilename)
+
+    int curIt_;                               ///< Output step
+    mutable internal::OutputData outputData_; ///< Store the actual data (filled lazily from the source)
+    std::shared_ptr<OutputSource> source_;    ///< Mapped or chunked archive
+
+    const Solver* copySolver_;       ///< Solver of the resolved copies
+    std::vector<FrameCopy> copies_; ///< Sources of the fields of Output::frameFields (see Output::resolveCopies)
 
-    int curIt_;                       ///< Output step
-    internal::OutputData outputData_; ///< Store the actual data
+    bool streaming_;                     ///< Frames are streamed instead of kept in memory
+    bool discard_;                       ///< Frames are neither kept nor written
+    std::shared_ptr<OutputSink> stream_; ///< Writer of the streamed frames (opened at the first frame)
+    std::exception_ptr streamError_;     ///< Error of the stream (rethrown by Output::write)
 
 public:
     /// Height in z-coordinates
-    const std::vector<double>& z() const { return outputData_.z; }
+    const std::vector<double>& z() const { return load("z", outputData_.z); }
 
     /// Horizontal velocity
-    const std::vector<double>& u() const { return outputData_.u; }
+    const std::vector<double>& u() const { return load("u", outputData_.u); }
 
     /// Isentropic density
-    const std::vector<double>& s() const { return outputData_.s; }
+    const std::vector<double>& s() const { return load("s", outputData_.s); }
 
     /// Time vector
-    const std::vector<double>& t() const { return outputData_.t; }
+    const std::vector<double>& t() const { return load("t", outputData_.t); }
 
     /// Precipitation
-    const std::vector<double>& prec() const { return outputData_.prec; }
+    const std::vector<double>& prec() const { return load("prec", outputData_.prec); }
 
     /// Accumulated precipitation
-    const std::vector<double>& tot_prec() const { return outputData_.tot_prec; }
+    const std::vector<double>& tot_prec() const { return load("tot_prec", outputData_.tot_prec); }
 
     /// Specific humidity
-    const std::vector<double>& qv() const { return outputData_.qv; }
+    const std::vector<double>& qv() const { return load("qv", outputData_.qv); }
 
     /// Specific cloud water content
-    const std::vector<double>& qc() const { return outputData_.qc; }
+    const std::vector<double>& qc() const { return load("qc", outputData_.qc); }
 
     /// Specific rain water content
-    const std::vector<double>& qr() const { return outputData_.qr; }
+    const std::vector<double>& qr() const { return load("qr", outputData_.qr); }
 
     /// Rain-droplet number density
-    const std::vector<double>& nr() const { return outputData_.nr; }
+    const std::vector<double>& nr() const { return load("nr", outputData_.nr); }
 
     /// Cloud droplet number density
-    const std::vector<double>& nc() const { return outputData_.nc; }
+    const std::vector<double>& nc() const { return load("nc", outputData_.nc); }
 
     /// Latent heating
-    const std::vector<double>& dthetadt() const { return outputData_.dthetadt; }
+    const std::vector<double>& dthetadt() const { return load("dthetadt", outputData_.dthetadt); }
 };
 
 ISEN_NAMESPACE_END
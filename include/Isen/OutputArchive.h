@@ -0,0 +1,135 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_OUTPUT_ARCHIVE_H
+#define ISEN_OUTPUT_ARCHIVE_H
+
+#include <Isen/Common.h>
+#include <Isen/NameList.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+ISEN_NAMESPACE_BEGIN
+
+/// Name and number of elements per frame of each field of an archive
+using OutputLayout = std::vector<std::pair<std::string, std::size_t>>;
+
+/// @brief Grid points of the output (see NameList::out_xmin, NameList::out_zmin and the strides)
+///
+/// The window covers the columns [xmin, xmax) and the levels [zmin, zmax) of the domain (without halo), of which every
+/// xstride-th column and zstride-th level is written. The height z, which lives on the interfaces, additionally
+/// includes the upper interface zmax.
+struct OutputWindow
+{
+    int xmin, xmax, xstride;
+    int zmin, zmax, zstride;
+
+    /// Window of the NameList (a zero upper bound selects the whole domain)
+    explicit OutputWindow(const NameList& namelist) noexcept
+        : xmin(namelist.out_xmin), xmax(namelist.out_xmax > 0 ? namelist.out_xmax : namelist.nx),
+          xstride(namelist.out_xstride), zmin(namelist.out_zmin),
+          zmax(namelist.out_zmax > 0 ? namelist.out_zmax : namelist.nz), zstride(namelist.out_zstride)
+    {
+    }
+
+    /// Check if the window lies within the domain and the strides are positive
+    bool valid(const NameList& namelist) const noexcept
+    {
+        return xstride > 0 && zstride > 0 && 0 <= xmin && xmin < xmax && xmax <= namelist.nx && 0 <= zmin
+               && zmin < zmax && zmax <= namelist.nz;
+    }
+
+    /// Columns of the output
+    int nx() const noexcept { return (xmax - xmin + xstride - 1) / xstride; }
+
+    /// Levels of the output
+    int nz() const noexcept { return (zmax - zmin + zstride - 1) / zstride; }
+
+    /// Interfaces of the output (the levels and the upper interface zmax)
+    int nz1() const noexcept { return (zmax - zmin) / zstride + 1; }
+};
+
+/// @brief Archive which receives the frames during the simulation (see OutputStream and OutputStore)
+///
+/// A frame is the time followed by the elements of the fields in the order of the layout.
+class OutputSink
+{
+public:
+    virtual ~OutputSink() {}
+
+    /// Get an empty frame buffer, blocks while all buffers are in flight
+    virtual double* acquire() = 0;
+
+    /// Queue the acquired frame buffer for writing
+    virtual void submit() = 0;
+
+    /// @brief Wait until all queued frames have been written, the file can be truncated to OutputSink::size afterwards
+    ///
+    /// @throw IsenException if writing a frame failed
+    virtual void flush() = 0;
+
+    /// @brief Write the outstanding frames and close the file
+    ///
+    /// @throw IsenException if writing a frame failed
+    virtual void close() = 0;
+
+    /// Name of the file
+    virtual const std::string& filename() const noexcept = 0;
+
+    /// Size of the file in bytes (all queued frames are included after OutputSink::flush)
+    virtual std::uint64_t size() const noexcept = 0;
+};
+
+/// @brief Archive whose frames are read on demand (see OutputMap and OutputStoreReader)
+class OutputSource
+{
+public:
+    virtual ~OutputSource() {}
+
+    /// Get a copy of the NameList
+    virtual std::shared_ptr<NameList> getNameList() const = 0;
+
+    /// Number of frames
+    virtual int numFrames() const = 0;
+
+    /// @brief Time of frame @c n
+    ///
+    /// @throw IsenException if the frame is out of range
+    virtual double time(int n) const = 0;
+
+    /// Check if the archive has the field @c name
+    virtual bool has(const std::string& name) const = 0;
+
+    /// @brief Elements per frame of the field @c name
+    ///
+    /// @throw IsenException if there is no such field
+    virtual std::size_t size(const std::string& name) const = 0;
+
+    /// Guaranteed absolute error bound of the field @c name (zero if it is stored losslessly)
+    virtual double bound(const std::string& /* name */) const { return 0.0; }
+
+    /// @brief Elements of the field @c name at frame @c n
+    ///
+    /// The pointer is valid until the next call to OutputSource::frame or OutputSource::time.
+    ///
+    /// @throw IsenException if there is no such field or if the frame is out of range
+    virtual const double* frame(const std::string& name, int n) const = 0;
+};
+
+ISEN_NAMESPACE_END
+
+#endif
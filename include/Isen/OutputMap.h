@@ -0,0 +1,100 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_OUTPUT_MAP_H
+#define ISEN_OUTPUT_MAP_H
+
+#include <Isen/Common.h>
+#include <Isen/OutputArchive.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Memory-mapped archive (see Output::Mapped)
+///
+/// The archive is mapped into memory instead of being deserialized, a single frame of a field is therefore available
+/// without reading the rest of the file. The file layout is (little-endian):
+///
+///   header (64 bytes):   "ISENIMAP" | version (uint32) | number of fields (uint32) | number of frames (uint64) |
+///                        size of a frame in bytes (uint64) | offset and size of the NameList (uint64) |
+///                        offset of the field table (uint64) | offset of the frame index (uint64)
+///   field table:         per field the name (char[32]), the elements per frame (uint64) and the offset of the block
+///                        within the frame in bytes (uint64)
+///   NameList:            binary boost archive
+///   frame index:         offset of each frame in bytes (uint64)
+///   frames:              time (double) and the contiguous block of each field (double)
+///
+/// Frames and blocks are aligned to 64 bytes. Mapped archives are only supported on little-endian hosts.
+class OutputMap : public OutputSource
+{
+public:
+    using Layout = OutputLayout;
+
+    /// @brief Map the archive @c filename
+    ///
+    /// @throw IsenException if the file can't be mapped or is not a mapped archive
+    explicit OutputMap(const std::string& filename);
+
+    /// Unmap the archive
+    ~OutputMap();
+
+    OutputMap(const OutputMap&) = delete;
+    OutputMap& operator=(const OutputMap&) = delete;
+
+    /// @brief Write a mapped archive of @c t.size() frames
+    ///
+    /// The frames of field @c f are contiguous in @c data[f] (in the order of @c layout), a nullptr is written as zeros.
+    ///
+    /// @throw IsenException if the file can't be written
+    static void write(const std::string& filename, const NameList& namelist, const Layout& layout,
+                      const std::vector<double>& t, const std::vector<const double*>& data);
+
+    /// Layout of the frames
+    const Layout& layout() const noexcept { return layout_; }
+
+    virtual std::shared_ptr<NameList> getNameList() const override;
+    virtual int numFrames() const override { return static_cast<int>(index_.size()); }
+    virtual double time(int n) const override;
+    virtual bool has(const std::string& name) const override { return fieldIndex(name) >= 0; }
+    virtual std::size_t size(const std::string& name) const override;
+
+    /// Elements of the field @c name at frame @c n (points into the mapped file, valid for the lifetime of the map)
+    virtual const double* frame(const std::string& name, int n) const override;
+
+private:
+    void unmap() noexcept;
+    int fieldIndex(const std::string& name) const noexcept;
+    const char* frameData(int n) const;
+
+    std::string filename_;
+    const char* data_;
+    std::size_t size_;
+#ifdef ISEN_PLATFORM_WINDOWS
+    void* file_;
+    void* mapping_;
+#endif
+
+    Layout layout_;
+    std::vector<std::uint64_t> offsets_; ///< Offset of the block of each field within a frame
+    std::vector<std::uint64_t> index_;   ///< Offset of each frame
+    std::uint64_t namelistOffset_;
+    std::uint64_t namelistSize_;
+};
+
+ISEN_NAMESPACE_END
+
+#endif
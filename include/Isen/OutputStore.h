@@ -0,0 +1,207 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_OUTPUT_STORE_H
+#define ISEN_OUTPUT_STORE_H
+
+#include <Isen/Common.h>
+#include <Isen/Compression.h>
+#include <Isen/Encoding.h>
+#include <Isen/OutputArchive.h>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <thread>
+
+ISEN_NAMESPACE_BEGIN
+
+namespace internal
+{
+
+/// Field of a chunked archive: a frame consists of @c rows (x) times @c cols (z) elements
+struct StoreField
+{
+    std::string name;
+    std::size_t rows;
+    std::size_t cols;
+    EncodingMode encoding; ///< Encoding of the chunks (see Encoding)
+    double bound;          ///< Absolute error bound of the encoding
+};
+
+/// Chunk of a field in a chunked archive: frames [frame, frame + numFrames) and rows [row, row + numRows)
+struct StoreChunk
+{
+    std::uint32_t field;
+    std::uint32_t frame;
+    std::uint32_t numFrames;
+    std::uint32_t row;
+    std::uint32_t numRows;
+    std::uint32_t encoding; ///< Encoding of the chunk (lossless if the field's encoding exceeded the bound)
+    std::uint64_t offset; ///< Offset of the compressed data
+    std::uint64_t size;   ///< Size of the compressed data
+};
+}
+
+/// @brief Chunked and compressed archive written during the simulation (see Output::Chunked)
+///
+/// Each field is stored in chunks of NameList::chunk_nt frames times NameList::chunk_nx columns (spanning all levels),
+/// optionally encoded within an absolute error bound (see Encoding) and compressed losslessly (see Compression). The
+/// frames of a chunk are collected in one of two buffers, once a buffer is complete its chunks are compressed by a
+/// pool of worker threads and appended to the file while the next buffer is filled. The time is stored as field "t".
+///
+/// The file layout is (native byte order):
+///
+///   "ISENCHNK" | version (uint32) | codec (uint32) | size of the NameList (uint64) | NameList (binary boost archive) |
+///   number of fields (uint32) | fields: length of the name (uint32), name, rows and columns (uint64), encoding
+///   (uint32) and error bound (double) |
+///   chunks: "CHNK" and the chunk (see internal::StoreChunk, without the offset), compressed data |
+///   index (written on close): all chunks (internal::StoreChunk), number of chunks (uint64), offset of the index
+///   (uint64), "ISENCEND"
+///
+/// An archive without index (e.g of a running simulation) is read by scanning the chunks.
+class OutputStore : public OutputSink
+{
+public:
+    /// @brief Create the file @c filename and write the header
+    ///
+    /// The fields of the layout with a positive error bound in @c bounds are stored with the encoding @c encoding,
+    /// all others losslessly. If @c offset is non-zero, the existing file is truncated to @c offset bytes and the
+    /// chunks are appended instead, starting at frame @c frame (the index is rebuilt from the existing chunks). By
+    /// default one worker thread per hardware thread is used.
+    ///
+    /// @throw IsenException if the file can't be written
+    OutputStore(const std::string& filename, const NameList& namelist, const OutputLayout& layout,
+                CompressionCodec codec, int chunkFrames, int chunkColumns,
+                EncodingMode encoding = EncodingMode::Lossless, const std::vector<double>& bounds = std::vector<double>(),
+                int numThreads = 0, std::uint64_t offset = 0, int frame = 0);
+
+    /// Write the outstanding frames and close the file (errors are logged)
+    ~OutputStore();
+
+    virtual double* acquire() override;
+    virtual void submit() override;
+
+    /// Compress the collected frames (even if less than a chunk) and wait until all chunks have been written
+    virtual void flush() override;
+    virtual void close() override;
+    virtual const std::string& filename() const noexcept override { return filename_; }
+    virtual std::uint64_t size() const noexcept override { return size_; }
+
+private:
+    /// Frames of a chunk in time
+    struct Buffer
+    {
+        std::vector<double> data;
+        int frame = 0;     ///< First frame
+        int numFrames = 0; ///< Collected frames
+        int pending = 0;   ///< Chunks which are not written yet
+        bool sealed = false; ///< Handed to the workers
+    };
+
+    struct Task
+    {
+        int buffer;
+        int field;
+        int row;
+    };
+
+    /// Hand the buffer to the workers (requires the lock)
+    void seal(int b);
+
+    /// Main loop of the worker threads
+    void work();
+
+    std::FILE* file_;
+    std::string filename_;
+    std::uint64_t size_;
+    CompressionCodec codec_;
+    int chunkFrames_;
+    int chunkRows_;
+    std::vector<internal::StoreField> fields_;
+    std::vector<std::size_t> offsets_; ///< Offset of the fields within a frame
+    std::size_t frameSize_;
+
+    Buffer buffers_[2];
+    int current_; ///< Buffer which collects the frames
+    int frame_;   ///< Next frame
+    std::deque<Task> tasks_;
+    std::vector<internal::StoreChunk> index_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool stop_;
+    std::exception_ptr exception_;
+    std::vector<std::thread> workers_;
+};
+
+/// @brief Reader of the chunked archive (see OutputStore)
+///
+/// Only the chunks of the requested frames are read and decompressed, the chunks of the last accessed time span of
+/// each field are cached. The reader is not thread-safe.
+class OutputStoreReader : public OutputSource
+{
+public:
+    /// @brief Open the archive @c filename and read its index
+    ///
+    /// @throw IsenException if the file can't be read or is not a chunked archive
+    explicit OutputStoreReader(const std::string& filename);
+
+    ~OutputStoreReader();
+
+    OutputStoreReader(const OutputStoreReader&) = delete;
+    OutputStoreReader& operator=(const OutputStoreReader&) = delete;
+
+    /// Codec of the archive
+    CompressionCodec codec() const noexcept { return codec_; }
+
+    /// All chunks of the archive
+    const std::vector<internal::StoreChunk>& chunks() const noexcept { return index_; }
+
+    virtual std::shared_ptr<NameList> getNameList() const override;
+    virtual int numFrames() const override { return numFrames_; }
+    virtual double time(int n) const override;
+    virtual bool has(const std::string& name) const override { return fieldIndex(name) >= 0; }
+    virtual std::size_t size(const std::string& name) const override;
+    virtual double bound(const std::string& name) const override;
+    virtual const double* frame(const std::string& name, int n) const override;
+
+private:
+    /// Decompressed chunks of a field covering the frames [frame, frame + numFrames)
+    struct Cache
+    {
+        int frame = -1;
+        int numFrames = 0;
+        std::vector<double> data;
+    };
+
+    int fieldIndex(const std::string& name) const noexcept;
+    const double* load(int field, int n) const;
+
+    std::FILE* file_;
+    std::string filename_;
+    CompressionCodec codec_;
+    std::string namelist_;
+    std::vector<internal::StoreField> fields_;
+    std::vector<internal::StoreChunk> index_;
+    std::vector<std::map<int, std::vector<std::size_t>>> chunks_; ///< Chunks of each field by their first frame
+    int numFrames_;
+    mutable std::vector<Cache> cache_;
+};
+
+ISEN_NAMESPACE_END
+
+#endif
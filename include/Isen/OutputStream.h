@@ -0,0 +1,101 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_OUTPUT_STREAM_H
+#define ISEN_OUTPUT_STREAM_H
+
+#include <Isen/Common.h>
+#include <Isen/OutputArchive.h>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Append-only writer of the stream archive (see Output::Stream) running in a background thread
+///
+/// The simulation fills a frame buffer (see OutputStream::acquire) and hands it to the writer thread (see
+/// OutputStream::submit), which appends it to the file. Only a fixed number of frame buffers exists, the memory is
+/// therefore bounded by a few frames independent of the number of output steps.
+///
+/// The file layout is (native byte order):
+///
+///   "ISENSTRM" | version (uint32) | size of the NameList (uint64) | NameList (binary boost archive) |
+///   number of fields (uint32) | fields: length of the name (uint32), name, elements per frame (uint64) |
+///   frames: time (double), the elements of every field (double) in the order of the header
+///
+/// All frames have the same size and are flushed as a whole, a reader takes the complete frames only. The file can
+/// therefore be read while the simulation is still running (see Output::read).
+class OutputStream : public OutputSink
+{
+public:
+    using Layout = OutputLayout;
+
+    /// @brief Create the file @c filename and write the header
+    ///
+    /// If @c offset is non-zero, the existing file is truncated to @c offset bytes and the frames are appended instead
+    /// (the header is kept).
+    ///
+    /// @throw IsenException if the file can't be written
+    OutputStream(const std::string& filename, const NameList& namelist, const Layout& layout, int numBuffers = 3,
+                 std::uint64_t offset = 0);
+
+    /// Write the outstanding frames and close the file (errors are logged)
+    ~OutputStream();
+
+    virtual double* acquire() override;
+    virtual void submit() override;
+    virtual void flush() override;
+    virtual void close() override;
+    virtual const std::string& filename() const noexcept override { return filename_; }
+    virtual std::uint64_t size() const noexcept override { return size_; }
+
+    /// @brief Read the header of the stream archive @c file
+    ///
+    /// Returns the size of the header in bytes, the file is positioned at the first frame.
+    ///
+    /// @throw IsenException if the file is not a stream archive
+    static std::uint64_t readHeader(std::FILE* file, NameList& namelist, Layout& layout);
+
+private:
+    /// Main loop of the writer thread
+    void writeLoop();
+
+    std::FILE* file_;
+    std::string filename_;
+    std::size_t frameSize_;
+    std::uint64_t size_;
+
+    std::vector<std::vector<double>> buffers_;
+    std::deque<int> free_;  ///< Buffers available to OutputStream::acquire
+    std::deque<int> queue_; ///< Buffers waiting to be written (the front is being written)
+    int acquired_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool stop_;
+    std::exception_ptr exception_;
+    std::thread thread_;
+};
+
+ISEN_NAMESPACE_END
+
+#endif
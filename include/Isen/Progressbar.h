@@ -36,6 +36,9 @@ public:
     /// Progressbar::advance is larger than Progressbar::IntervalMs.
     void advance();
 
+    /// Advance the progressbar step by step until @c step is reached (see Progressbar::advance)
+    void advanceTo(int step);
+
     /// Pause drawing of the progressbar by resetting the cursor position
     void pause() const;
 
@@ -130,6 +130,111 @@ public:
     }
     double get_autoconv_mult() const noexcept { return namelist_->autoconv_mult; }
 
+    void set_cfl_target(double value) const noexcept
+    {
+        namelist_->cfl_target = value;
+        namelist_->update();
+    }
+    double get_cfl_target() const noexcept { return namelist_->cfl_target; }
+
+    void set_dt_grow(double value) const noexcept
+    {
+        namelist_->dt_grow = value;
+        namelist_->update();
+    }
+    double get_dt_grow() const noexcept { return namelist_->dt_grow; }
+
+    void set_dt_shrink(double value) const noexcept
+    {
+        namelist_->dt_shrink = value;
+        namelist_->update();
+    }
+    double get_dt_shrink() const noexcept { return namelist_->dt_shrink; }
+
+    void set_dt_max(double value) const noexcept
+    {
+        namelist_->dt_max = value;
+        namelist_->update();
+    }
+    double get_dt_max() const noexcept { return namelist_->dt_max; }
+
+    void set_tol_z(double value) const noexcept
+    {
+        namelist_->tol_z = value;
+        namelist_->update();
+    }
+    double get_tol_z() const noexcept { return namelist_->tol_z; }
+
+    void set_tol_u(double value) const noexcept
+    {
+        namelist_->tol_u = value;
+        namelist_->update();
+    }
+    double get_tol_u() const noexcept { return namelist_->tol_u; }
+
+    void set_tol_s(double value) const noexcept
+    {
+        namelist_->tol_s = value;
+        namelist_->update();
+    }
+    double get_tol_s() const noexcept { return namelist_->tol_s; }
+
+    void set_tol_prec(double value) const noexcept
+    {
+        namelist_->tol_prec = value;
+        namelist_->update();
+    }
+    double get_tol_prec() const noexcept { return namelist_->tol_prec; }
+
+    void set_tol_tot_prec(double value) const noexcept
+    {
+        namelist_->tol_tot_prec = value;
+        namelist_->update();
+    }
+    double get_tol_tot_prec() const noexcept { return namelist_->tol_tot_prec; }
+
+    void set_tol_qv(double value) const noexcept
+    {
+        namelist_->tol_qv = value;
+        namelist_->update();
+    }
+    double get_tol_qv() const noexcept { return namelist_->tol_qv; }
+
+    void set_tol_qc(double value) const noexcept
+    {
+        namelist_->tol_qc = value;
+        namelist_->update();
+    }
+    double get_tol_qc() const noexcept { return namelist_->tol_qc; }
+
+    void set_tol_qr(double value) const noexcept
+    {
+        namelist_->tol_qr = value;
+        namelist_->update();
+    }
+    double get_tol_qr() const noexcept { return namelist_->tol_qr; }
+
+    void set_tol_nr(double value) const noexcept
+    {
+        namelist_->tol_nr = value;
+        namelist_->update();
+    }
+    double get_tol_nr() const noexcept { return namelist_->tol_nr; }
+
+    void set_tol_nc(double value) const noexcept
+    {
+        namelist_->tol_nc = value;
+        namelist_->update();
+    }
+    double get_tol_nc() const noexcept { return namelist_->tol_nc; }
+
+    void set_tol_dthetadt(double value) const noexcept
+    {
+        namelist_->tol_dthetadt = value;
+        namelist_->update();
+    }
+    double get_tol_dthetadt() const noexcept { return namelist_->tol_dthetadt; }
+
     //-------------------------------------------------
     // Integer point getter/setters
     //-------------------------------------------------
@@ -140,6 +245,69 @@ public:
     }
     int get_iout() const noexcept { return namelist_->iout; }
 
+    void set_icheckpoint(int value) const noexcept
+    {
+        namelist_->icheckpoint = value;
+        namelist_->update();
+    }
+    int get_icheckpoint() const noexcept { return namelist_->icheckpoint; }
+
+    void set_chunk_nt(int value) const noexcept
+    {
+        namelist_->chunk_nt = value;
+        namelist_->update();
+    }
+    int get_chunk_nt() const noexcept { return namelist_->chunk_nt; }
+
+    void set_chunk_nx(int value) const noexcept
+    {
+        namelist_->chunk_nx = value;
+        namelist_->update();
+    }
+    int get_chunk_nx() const noexcept { return namelist_->chunk_nx; }
+
+    void set_out_xmin(int value) const noexcept
+    {
+        namelist_->out_xmin = value;
+        namelist_->update();
+    }
+    int get_out_xmin() const noexcept { return namelist_->out_xmin; }
+
+    void set_out_xmax(int value) const noexcept
+    {
+        namelist_->out_xmax = value;
+        namelist_->update();
+    }
+    int get_out_xmax() const noexcept { return namelist_->out_xmax; }
+
+    void set_out_zmin(int value) const noexcept
+    {
+        namelist_->out_zmin = value;
+        namelist_->update();
+    }
+    int get_out_zmin() const noexcept { return namelist_->out_zmin; }
+
+    void set_out_zmax(int value) const noexcept
+    {
+        namelist_->out_zmax = value;
+        namelist_->update();
+    }
+    int get_out_zmax() const noexcept { return namelist_->out_zmax; }
+
+    void set_out_xstride(int value) const noexcept
+    {
+        namelist_->out_xstride = value;
+        namelist_->update();
+    }
+    int get_out_xstride() const noexcept { return namelist_->out_xstride; }
+
+    void set_out_zstride(int value) const noexcept
+    {
+        namelist_->out_zstride = value;
+        namelist_->update();
+    }
+    int get_out_zstride() const noexcept { return namelist_->out_zstride; }
+
     void set_xl(int value) const noexcept
     {
         namelist_->xl = value;
@@ -217,6 +385,20 @@ public:
     }
     int get_imicrophys() const noexcept { return namelist_->imicrophys; }
 
+    void set_tblock(int value) const noexcept
+    {
+        namelist_->tblock = value;
+        namelist_->update();
+    }
+    int get_tblock() const noexcept { return namelist_->tblock; }
+
+    void set_imath(int value) const noexcept
+    {
+        namelist_->imath = value;
+        namelist_->update();
+    }
+    int get_imath() const noexcept { return namelist_->imath; }
+
     //-------------------------------------------------
     // Boolean point getter/setters
     //-------------------------------------------------
@@ -290,6 +472,27 @@ public:
     }
     bool get_sediment_on() const noexcept { return namelist_->sediment_on; }
 
+    void set_imixprec(bool value) const noexcept
+    {
+        namelist_->imixprec = value;
+        namelist_->update();
+    }
+    bool get_imixprec() const noexcept { return namelist_->imixprec; }
+
+    void set_sediment_col(bool value) const noexcept
+    {
+        namelist_->sediment_col = value;
+        namelist_->update();
+    }
+    bool get_sediment_col() const noexcept { return namelist_->sediment_col; }
+
+    void set_iadapt(bool value) const noexcept
+    {
+        namelist_->iadapt = value;
+        namelist_->update();
+    }
+    bool get_iadapt() const noexcept { return namelist_->iadapt; }
+
     //-------------------------------------------------
     // String point getter/setters
     //-------------------------------------------------
@@ -299,6 +502,27 @@ public:
         namelist_->update();
     }
     std::string get_run_name() const noexcept { return namelist_->run_name; }
+
+    void set_compression(std::string value) const noexcept
+    {
+        namelist_->compression = value;
+        namelist_->update();
+    }
+    std::string get_compression() const noexcept { return namelist_->compression; }
+
+    void set_encoding(std::string value) const noexcept
+    {
+        namelist_->encoding = value;
+        namelist_->update();
+    }
+    std::string get_encoding() const noexcept { return namelist_->encoding; }
+
+    void set_out_fields(std::string value) const noexcept
+    {
+        namelist_->out_fields = value;
+        namelist_->update();
+    }
+    std::string get_out_fields() const noexcept { return namelist_->out_fields; }
 };
 
 ISEN_NAMESPACE_END
@@ -44,136 +44,70 @@ public:
     /// Read Output from file
     void read(const char* file);
 
+    /// Number of frames
+    int numFrames() const;
+
+    /// Time of frame @c n
+    double time(int n) const;
+
+    /// Guaranteed absolute error of the field @c name
+    double errorBound(const char* name) const;
+
+    /// @brief Field @c name at frame @c n
+    ///
+    /// Only this frame is copied (and read from a mapped archive).
+    boost::python::object frame(const char* name, int n) const;
+
 private:
+    /// @brief All frames of the field @c name (frames times columns [times levels])
+    ///
+    /// @throw IsenException if the field is not part of the output
+    boost::python::object field(const char* name, const std::vector<double>& (Output::*getter)() const) const;
+
     std::shared_ptr<NameList> namelist_;
     std::shared_ptr<Output> output_;
 
 public:
     /// Height in z-coordinates
-    boost::python::object z() const
-    {
-        if(!output_)
-            throw IsenException("Output: not initialized");
-        return internal::toNumpyArrayImpl(output_->z().data(), namelist_->nout, namelist_->nx, namelist_->nz1);
-    }
+    boost::python::object z() const { return field("z", &Output::z); }
 
     /// Horizontal velocity
-    boost::python::object u() const
-    {
-        if(!output_)
-            throw IsenException("Output: not initialized");
-        return internal::toNumpyArrayImpl(output_->u().data(), namelist_->nout, namelist_->nx, namelist_->nz);
-    }
+    boost::python::object u() const { return field("u", &Output::u); }
 
     /// Isentropic density
-    boost::python::object s() const
-    {
-        if(!output_)
-            throw IsenException("Output: not initialized");
-        return internal::toNumpyArrayImpl(output_->s().data(), namelist_->nout, namelist_->nx, namelist_->nz);
-    }
+    boost::python::object s() const { return field("s", &Output::s); }
 
     /// Time vector
     boost::python::object t() const
     {
         if(!output_)
             throw IsenException("Output: not initialized");
-        return internal::toNumpyArrayImpl(output_->t().data(), namelist_->nout);
+        return internal::toNumpyArrayImpl(output_->t().data(), output_->numFrames());
     }
-    /// Precipitation
-    boost::python::object prec() const
-    {
-        if(!output_)
-            throw IsenException("Output: not initialized");
 
-        if(!namelist_->imoist)
-            throw IsenException("Output: prec is not available");
-        return internal::toNumpyArrayImpl(output_->prec().data(), namelist_->nout, namelist_->nx);
-    }
+    /// Precipitation
+    boost::python::object prec() const { return field("prec", &Output::prec); }
 
     /// Accumulated precipitation
-    boost::python::object tot_prec() const
-    {
-        if(!output_)
-            throw IsenException("Output: not initialized");
-
-        if(!namelist_->imoist)
-            throw IsenException("Output: tot_prec is not available");
-
-        return internal::toNumpyArrayImpl(output_->tot_prec().data(), namelist_->nout, namelist_->nx);
-    }
+    boost::python::object tot_prec() const { return field("tot_prec", &Output::tot_prec); }
 
     /// Specific humidity
-    boost::python::object qv() const
-    {
-        if(!output_)
-            throw IsenException("Output: not initialized");
-
-        if(!namelist_->imoist)
-            throw IsenException("Output: qv is not available");
-
-        return internal::toNumpyArrayImpl(output_->qv().data(), namelist_->nout, namelist_->nx, namelist_->nz);
-    }
+    boost::python::object qv() const { return field("qv", &Output::qv); }
 
     /// Specific cloud water content
-    boost::python::object qc() const
-    {
-        if(!output_)
-            throw IsenException("Output: not initialized");
-
-        if(!namelist_->imoist)
-            throw IsenException("Output: qc is not available");
-
-        return internal::toNumpyArrayImpl(output_->qc().data(), namelist_->nout, namelist_->nx, namelist_->nz);
-    }
+    boost::python::object qc() const { return field("qc", &Output::qc); }
 
     /// Specific rain water content
-    boost::python::object qr() const
-    {
-        if(!output_)
-            throw IsenException("Output: not initialized");
-
-        if(!namelist_->imoist)
-            throw IsenException("Output: qr is not available");
-
-        return internal::toNumpyArrayImpl(output_->qr().data(), namelist_->nout, namelist_->nx, namelist_->nz);
-    }
+    boost::python::object qr() const { return field("qr", &Output::qr); }
 
     /// Rain-droplet number density
-    boost::python::object nr() const
-    {
-        if(!output_)
-            throw IsenException("Output: not initialized");
-
-        if(!namelist_->imoist && namelist_->imicrophys != 2)
-            throw IsenException("Output: nr is not available");
-
-        return internal::toNumpyArrayImpl(output_->nr().data(), namelist_->nout, namelist_->nx, namelist_->nz);
-    }
+    boost::python::object nr() const { return field("nr", &Output::nr); }
 
     /// Cloud droplet number density
-    boost::python::object nc() const
-    {
-        if(!output_)
-            throw IsenException("Output: not initialized");
-
-        if(!namelist_->imoist && namelist_->imicrophys != 2)
-            throw IsenException("Output: nc is not available");
-
-        return internal::toNumpyArrayImpl(output_->nc().data(), namelist_->nout, namelist_->nx, namelist_->nz);
-    }
+    boost::python::object nc() const { return field("nc", &Output::nc); }
 
     /// Latent heating
-    boost::python::object dthetadt() const
-    {
-        if(!output_)
-            throw IsenException("Output: not initialized");
-
-        if(!namelist_->imoist && namelist_->idthdt)
-            throw IsenException("Output: dthetadt is not available");
-
-        return internal::toNumpyArrayImpl(output_->dthetadt().data(), namelist_->nout, namelist_->nx, namelist_->nz);
-    }
+    boost::python::object dthetadt() const { return field("dthetadt", &Output::dthetadt); }
 };
 
 ISEN_NAMESPACE_END
@@ -40,6 +40,9 @@ public:
     /// Initialize simulation with a NameList
     void initWithNameList(PyNameList namelist);
 
+    /// Initialize simulation with the state and the NameList of a checkpoint (see Solver::restart)
+    void restart(const char* filename);
+
     /// Run simulation
     void run();
 
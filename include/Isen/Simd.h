@@ -0,0 +1,70 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_SIMD_H
+#define ISEN_SIMD_H
+
+#include <Isen/Common.h>
+#include <string>
+
+ISEN_NAMESPACE_BEGIN
+
+/// Instruction sets of the hand vectorized kernels (ordered by vector width)
+enum class SimdInstructionSet
+{
+    Scalar = 0, ///< Plain C++ kernels (vectorized by the compiler for the baseline architecture)
+    SSE42,      ///< 128-bit SSE4.2
+    AVX2,       ///< 256-bit AVX2
+    AVX512      ///< 512-bit AVX-512F
+};
+
+/// @brief Runtime selection of the SIMD instruction set
+///
+/// Isen is built for the baseline architecture of the target (no @c -march=native), the kernels of SolverCpu are
+/// additionally compiled for each instruction set supported by the compiler. The widest instruction set supported by
+/// the CPU and the operating system is selected at startup via CPUID, hence a single binary runs at full vector width
+/// on every x86 node. All instruction sets produce bitwise identical results (unless the scalar kernels are compiled
+/// with floating-point contraction, e.g. with ISEN_NATIVE).
+class Simd
+{
+public:
+    /// Detect the widest instruction set supported by the CPU (CPUID) which has been compiled
+    static SimdInstructionSet detect() noexcept;
+
+    /// Get the instruction set used by the kernels
+    static SimdInstructionSet get() noexcept;
+
+    /// @brief Set the instruction set used by the kernels (must not be called while a Solver is running)
+    ///
+    /// @throw IsenException if the instruction set is not available (see Simd::isAvailable)
+    static void set(SimdInstructionSet isa);
+
+    /// Check if the instruction set has been compiled and is supported by the CPU
+    static bool isAvailable(SimdInstructionSet isa) noexcept;
+
+    /// Check if the kernels have been compiled for the given instruction set
+    static bool isCompiled(SimdInstructionSet isa) noexcept;
+
+    /// Convert to string ("scalar", "sse4.2", "avx2" or "avx512")
+    static const char* toString(SimdInstructionSet isa) noexcept;
+
+    /// @brief Convert from string
+    ///
+    /// @throw IsenException if the string is not a valid instruction set
+    static SimdInstructionSet fromString(const std::string& str);
+};
+
+ISEN_NAMESPACE_END
+
+#endif
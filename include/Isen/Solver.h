@@ -1,270 +1,312 @@
-/**
- *                       _________ _______   __
- *                      /  _/ ___// ____/ | / /
- *                      / / \__ \/ __/ /  |/ /
- *                    _/ / ___/ / /___/ /|  /
- *                   /___//____/_____/_/ |_/
- *
- *  Isentropic model - ETH Zurich
- *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
- *
- *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
- */
-
-#pragma once
-#ifndef ISEN_SOLVER_H
-#define ISEN_SOLVER_H
-
-#include <Isen/Common.h>
-#include <Isen/NameList.h>
-#include <Isen/Output.h>
-#include <Isen/Kessler.h>
-#include <map>
-
-ISEN_NAMESPACE_BEGIN
-
-/// @brief Refrence implementation of all Solvers
-class Solver
-{
-public:
-    /// @brief Allocate memory 
-    ///
-    /// @throw IsenException if out of memory
-    Solver(const std::shared_ptr<NameList>& namelist, Output::ArchiveType archiveType = Output::ArchiveType::Text);
-
-    /// Free all memory
-    virtual ~Solver() {}
-
-    /// @brief Initialize the simulation
-    ///
-    /// Generates initial conditions for isentropic density (sigma) and velocity (u), initializes the boundaries and
-    /// generates the topography.
-    virtual void init() noexcept;
-
-    /// Run the simulation
-    virtual void run();
-
-    /// @brief Write simulation to output file
-    ///
-    /// If no filename is provided, NameList::run_name is being used.
-    virtual void write(std::string filename = "");
-
-    /// Compute CFL condition
-    virtual double computeCFL() const noexcept;
-
-    //------------------------------------------------------------
-    // Diffusion
-    //------------------------------------------------------------
-
-    /// Horizontal diffusion
-    virtual void horizontalDiffusion() noexcept;
-    
-    //------------------------------------------------------------
-    // Geometric height 
-    //------------------------------------------------------------
-    
-    /// Calculate geometric height 
-    virtual void geometricHeight() noexcept;
-    
-    //------------------------------------------------------------
-    // Boundary
-    //------------------------------------------------------------
-
-    /// Exchange boundaries for periodicity of prognostic fields
-    virtual void applyPeriodicBoundary() noexcept;
-
-    /// Relaxation of prognostic fields
-    virtual void applyRelaxationBoundary() noexcept;
-
-    /// Clip negative values of moisture variables
-    virtual void clipMoisture() noexcept;
-
-    //------------------------------------------------------------
-    // Diagnostic
-    //------------------------------------------------------------
-
-    /// Diagnostic computation of Montgomery
-    virtual void diagMontgomery() noexcept;
-
-    /// Diagnostic computation of pressure
-    virtual void diagPressure() noexcept;
-
-    //------------------------------------------------------------
-    // Prognostic
-    //------------------------------------------------------------
-
-    /// Prognostic step for isentropic mass density
-    virtual void progIsendens() noexcept;
-
-    /// Prognostic step for momentum
-    virtual void progVelocity() noexcept;
-
-    /// Prognostic step for hydrometeors
-    virtual void progMoisture() noexcept;
-
-    /// Prognostic step for number densities
-    virtual void progNumdens() noexcept;
-
-    //------------------------------------------------------------
-    // Getter
-    //------------------------------------------------------------
-
-    /// Access the output
-    std::shared_ptr<Output> getOutput() const { return output_; }
-
-    /// Get matrix by @name
-    const MatrixXf& getMat(std::string name) const;
-
-    /// Get vector by @name
-    const VectorXf& getVec(std::string name) const;
-    
-    /// Get matrix or vector by @name and return an Eigen::Map of the data 
-    Eigen::Map<MatrixXf> getField(std::string name) const;
-
-protected:
-    std::shared_ptr<NameList> namelist_;
-    std::shared_ptr<Output> output_;
-
-    std::map<std::string, MatrixXf*> matMap_;
-    std::map<std::string, VectorXf*> vecMap_;
-
-    //-------------------------------------------------
-    // Parametrizations
-    //-------------------------------------------------
-    std::shared_ptr<Kessler> kessler_;
-
-    //-------------------------------------------------
-    // Define physical fields
-    //-------------------------------------------------
-
-    /// Topography
-    VectorXf topo_;
-
-    /// Height in z-coordinates
-    MatrixXf zhtold_;
-    MatrixXf zhtnow_;
-
-    /// Horizontal velocity
-    MatrixXf uold_;
-    MatrixXf unow_;
-    MatrixXf unew_;
-
-    /// Isentropic density
-    MatrixXf sold_;
-    MatrixXf snow_;
-    MatrixXf snew_;
-
-    /// Montgomery potential
-    MatrixXf mtg_;
-    MatrixXf mtgnew_;
-    VectorXf mtg0_;
-
-    /// Exner function
-    MatrixXf exn_;
-    VectorXf exn0_;
-
-    /// Pressure
-    MatrixXf prs_;
-    VectorXf prs0_;
-
-    /// Height-dependent diffusion coefficient
-    VectorXf tau_;
-
-    /// Upstream profile for theta 
-    VectorXf th0_;
-
-    /// Precipitation
-    VectorXf prec_;
-
-    /// Accumulated precipitation
-    VectorXf tot_prec_;
-
-    /// Water vapor
-    MatrixXf qvold_;
-    MatrixXf qvnow_;
-    MatrixXf qvnew_;
-
-    /// Specific cloud water content
-    MatrixXf qcold_;
-    MatrixXf qcnow_;
-    MatrixXf qcnew_;
-
-    /// Specific rain water content
-    MatrixXf qrold_;
-    MatrixXf qrnow_;
-    MatrixXf qrnew_;
-
-    /// Temperature
-    MatrixXf temp_;
-
-    /// Rain-droplet number density
-    MatrixXf nrold_;
-    MatrixXf nrnow_;
-    MatrixXf nrnew_;
-
-    /// Cloud-droplet number density
-    MatrixXf ncold_;
-    MatrixXf ncnow_;
-    MatrixXf ncnew_;
-
-    /// Latent heating
-    MatrixXf dthetadt_;
-
-    //-------------------------------------------------
-    // Define fields at lateral boundaries
-    //  1 denotes the leftern boundary
-    //  2 denotes the rightern boundary
-    //-------------------------------------------------
-
-    /// Topography boundaries  
-    VectorXf tbnd1_;
-    VectorXf tbnd2_;
-
-    /// Isentropic density boundaries
-    VectorXf sbnd1_;
-    VectorXf sbnd2_;
-
-    /// Horizontal velocity boundaries
-    VectorXf ubnd1_;
-    VectorXf ubnd2_;
-
-    /// Specific humidity boundaries
-    VectorXf qvbnd1_;
-    VectorXf qvbnd2_;
-
-    /// Specific cloud water content boundaries
-    VectorXf qcbnd1_;
-    VectorXf qcbnd2_;
-
-    /// Specific rain water content boundaries
-    VectorXf qrbnd1_;
-    VectorXf qrbnd2_;
-
-    /// Latent heating boundaries
-    VectorXf dthetadtbnd1_;
-    VectorXf dthetadtbnd2_;
-
-    /// Rain-droplet number density boundaries
-    VectorXf nrbnd1_;
-    VectorXf nrbnd2_;
-
-    /// Cloud-droplet number density boundaries
-    VectorXf ncbnd1_;
-    VectorXf ncbnd2_;
-
-    //-------------------------------------------------
-    // Define scalar fields
-    //-------------------------------------------------
-    double dtdx_;
-    double topofact_;
-
-    /// Be verbose?
-    bool verbose_;
-};
-
-/// This is a convenience macro to declare local aliases of the NameList class inside any Solver method
-#define SOLVER_DECLARE_ALL_ALIASES ISEN_NAMELIST_DECLARE_ALIAS(namelist_)
-
-ISEN_NAMESPACE_END
-
-#endif
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_SOLVER_H
+#define ISEN_SOLVER_H
+
+#include <Isen/Checkpoint.h>
+#include <Isen/Common.h>
+#include <Isen/Field.h>
+#include <Isen/NameList.h>
+#include <Isen/Output.h>
+#include <Isen/Kessler.h>
+#include <Isen/SolverFields.h>
+#include <Isen/TimeControl.h>
+#include <Isen/Tracer.h>
+#include <map>
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Health metrics of the prognostic fields at the end of a time step (see Solver::checkHealth)
+struct StepHealth
+{
+    double umax;  ///< Maximum of |u| [m/s]
+    double mass;  ///< Total isentropic mass per unit length, i.e the sum of sigma * dx * dth [kg/m] (NaN if unknown)
+    bool finite;  ///< True if neither u nor sigma contain NaN or Inf values
+};
+
+/// @brief Refrence implementation of all Solvers
+///
+/// The fields advanced by the time loop are stored in double precision (see SolverFields).
+class Solver : protected SolverFields<double>
+{
+public:
+    /// @brief Allocate memory 
+    ///
+    /// @throw IsenException if out of memory
+    Solver(const std::shared_ptr<NameList>& namelist, Output::ArchiveType archiveType = Output::ArchiveType::Text);
+
+    /// Free all memory
+    virtual ~Solver() {}
+
+    /// @brief Initialize the simulation
+    ///
+    /// Generates initial conditions for isentropic density (sigma) and velocity (u), initializes the boundaries and
+    /// generates the topography.
+    virtual void init() noexcept;
+
+    /// Run the simulation
+    virtual void run();
+
+    /// @brief Continue the simulation from @c checkpoint
+    ///
+    /// Restores the complete state of the simulation (see Solver::saveState), the next call to Solver::run continues
+    /// the time loop after the time step of the checkpoint. The results are bitwise identical to the uninterrupted
+    /// simulation. The solver has to be initialized with the NameList of the checkpoint (see Checkpoint::getNameList).
+    ///
+    /// @throw IsenException if the checkpoint doesn't match the solver (e.g a different domain size)
+    void restart(const Checkpoint& checkpoint);
+
+    /// @brief Write simulation to output file
+    ///
+    /// If no filename is provided, NameList::run_name is being used (see Solver::setOutputFilename).
+    virtual void write(std::string filename = "");
+
+    /// @brief Set the output file of the simulation (see Output::setFilename)
+    ///
+    /// Has to be called before Solver::run, the streamed frames are written to @c filename directly. The checkpoints
+    /// are named after @c filename as well (with the extension '.ckpt').
+    void setOutputFilename(const std::string& filename);
+
+    /// Compute CFL condition
+    virtual double computeCFL() const noexcept;
+
+    /// @brief Advance all prognostic fields by one time step
+    ///
+    /// This includes the exchange of the boundaries, the horizontal diffusion and the clipping of the moisture
+    /// variables. On return the old, now and new fields have been rotated.
+    virtual void prognosticStep() noexcept;
+
+    //------------------------------------------------------------
+    // Diffusion
+    //------------------------------------------------------------
+
+    /// Horizontal diffusion
+    virtual void horizontalDiffusion() noexcept;
+    
+    //------------------------------------------------------------
+    // Geometric height 
+    //------------------------------------------------------------
+    
+    /// Calculate geometric height 
+    virtual void geometricHeight() noexcept;
+    
+    //------------------------------------------------------------
+    // Boundary
+    //------------------------------------------------------------
+
+    /// Exchange boundaries for periodicity of prognostic fields
+    virtual void applyPeriodicBoundary() noexcept;
+
+    /// Relaxation of prognostic fields
+    virtual void applyRelaxationBoundary() noexcept;
+
+    /// Clip negative values of moisture variables
+    virtual void clipMoisture() noexcept;
+
+    //------------------------------------------------------------
+    // Diagnostic
+    //------------------------------------------------------------
+
+    /// Diagnostic computation of Montgomery
+    virtual void diagMontgomery() noexcept;
+
+    /// Diagnostic computation of pressure
+    virtual void diagPressure() noexcept;
+
+    //------------------------------------------------------------
+    // Prognostic
+    //------------------------------------------------------------
+
+    /// Prognostic step for isentropic mass density
+    virtual void progIsendens() noexcept;
+
+    /// Prognostic step for momentum
+    virtual void progVelocity() noexcept;
+
+    /// Prognostic step for hydrometeors
+    virtual void progMoisture() noexcept;
+
+    /// Prognostic step for number densities
+    virtual void progNumdens() noexcept;
+
+    //------------------------------------------------------------
+    // Microphysics
+    //------------------------------------------------------------
+
+    /// Apply the microphysics scheme (NameList::imicrophys) to the moisture variables
+    virtual void microphysics() noexcept;
+
+    //------------------------------------------------------------
+    // Getter
+    //------------------------------------------------------------
+
+    /// Access the output
+    std::shared_ptr<Output> getOutput() const { return output_; }
+
+    /// Get matrix by @name
+    const FieldXf& getMat(std::string name) const;
+
+    /// Get vector by @name
+    const VectorXf& getVec(std::string name) const;
+    
+    /// Get matrix or vector by @name and return an Eigen::Map of the data 
+    FieldMap<double> getField(std::string name) const;
+
+    /// @brief Get the single precision matrix @c name of a Solver running the time loop in single precision
+    ///
+    /// Returns nullptr if the matrix is stored in double precision (see Solver::getMat), which is always the case
+    /// except for SolverCpuF32 while it is running.
+    virtual const Field<float>* getMatF32(const std::string& name) const { return nullptr; }
+
+    /// Get the single precision vector @c name (see Solver::getMatF32)
+    virtual const VectorX<float>* getVecF32(const std::string& name) const { return nullptr; }
+
+    /// Health metrics of the last time step
+    const StepHealth& getHealth() const { return health_; }
+
+protected:
+    /// @brief Check (and optionally print) the CFL condition of the current time step given the maximum velocity
+    ///
+    /// A warning is issued if the CFL condition is violated, NaN values terminate the simulation.
+    void checkCFL(double umax);
+
+    /// @brief Check (and optionally print) the health metrics of the current time step
+    ///
+    /// Same as Solver::checkCFL, but NaN and Inf values of u and sigma are detected through @c health.finite. The
+    /// metrics are kept until the next time step (see Solver::getHealth). If @c report is false, nothing is printed
+    /// but the simulation is still terminated on NaN values (e.g on all but the first rank of SolverMpi).
+    void checkHealth(const StepHealth& health, bool report = true);
+
+    /// @brief Extrapolate the old time level of the prognostic fields after a change of the time step
+    ///
+    /// The old time level is moved linearly along the trajectory from the current time level such that it lies @c ratio
+    /// times the previous time step in the past (see TimeControl::oldLevelRatio).
+    virtual void rescaleOldTimeLevel(double ratio) noexcept;
+
+    /// Set the time step of the microphysics (see TimeControl)
+    virtual void setTimeStep(double dt) noexcept;
+
+    /// Exchange the boundaries of the velocity and the isentropic density of @c fields only (see
+    /// Solver::applyPeriodicBoundary)
+    template <class T>
+    void applyPeriodicBoundaryDynamics(SolverFields<T>& fields) const noexcept;
+
+    /// Relax the velocity and the isentropic density of @c fields only (see Solver::applyRelaxationBoundary)
+    template <class T>
+    void applyRelaxationBoundaryDynamics(SolverFields<T>& fields) const noexcept;
+
+    //------------------------------------------------------------
+    // Checkpoint/restart
+    //------------------------------------------------------------
+
+    /// @brief Store the complete state of the simulation in @c checkpoint
+    ///
+    /// This includes all fields (every time level), the boundary values, the health metrics of the last time step and
+    /// the output produced so far.
+    virtual void saveState(Checkpoint& checkpoint) const;
+
+    /// @brief Restore the state stored by Solver::saveState
+    ///
+    /// @throw IsenException if the checkpoint doesn't match the solver
+    virtual void loadState(const Checkpoint& checkpoint);
+
+    /// Time step control of the time loop (continues the time steps of the checkpoint after Solver::restart)
+    TimeControl startTimeControl();
+
+    /// Check if a checkpoint is due at the end of the current time step (see NameList::icheckpoint)
+    bool isCheckpointStep(const TimeControl& timeControl) const noexcept;
+
+    /// @brief Write a checkpoint of the current time step to '<run_name>.ckpt' (see Solver::setOutputFilename) in the
+    /// background
+    ///
+    /// @throw IsenException if writing the previous checkpoint failed
+    void makeCheckpoint(const TimeControl& timeControl);
+
+    /// @brief Wait for the checkpoint in flight
+    ///
+    /// @throw IsenException if writing the checkpoint failed
+    void finishCheckpoint();
+
+protected:
+    std::shared_ptr<NameList> namelist_;
+    std::shared_ptr<Output> output_;
+
+    std::map<std::string, FieldXf*> matMap_;
+    std::map<std::string, VectorXf*> vecMap_;
+
+    //-------------------------------------------------
+    // Parametrizations
+    //-------------------------------------------------
+    std::shared_ptr<Kessler> kessler_;
+
+    //-------------------------------------------------
+    // Define physical fields (in addition to SolverFields)
+    //-------------------------------------------------
+
+    /// Montgomery potential
+    FieldXf mtgnew_;
+    VectorXf mtg0_;
+
+    /// Exner function
+    VectorXf exn0_;
+
+    /// Pressure
+    VectorXf prs0_;
+
+    /// Latent heating
+    FieldXf dthetadt_;
+
+    //-------------------------------------------------
+    // Define fields at lateral boundaries
+    //  1 denotes the leftern boundary
+    //  2 denotes the rightern boundary
+    //-------------------------------------------------
+
+    /// Topography boundaries  
+    VectorXf tbnd1_;
+    VectorXf tbnd2_;
+
+    /// Latent heating boundaries
+    VectorXf dthetadtbnd1_;
+    VectorXf dthetadtbnd2_;
+
+    //-------------------------------------------------
+    // Define scalar fields
+    //-------------------------------------------------
+    double dtdx_;
+    double topofact_;
+
+    /// Health metrics of the last time step
+    StepHealth health_;
+
+    /// Be verbose?
+    bool verbose_;
+
+    /// Time step control of a restarted simulation (see Solver::restart)
+    std::shared_ptr<TimeControl> restartTimeControl_;
+
+    /// Background writer of the checkpoints
+    std::shared_ptr<CheckpointWriter> checkpointWriter_;
+
+    /// File of the checkpoints (empty if named after NameList::run_name)
+    std::string checkpointFilename_;
+};
+
+/// This is a convenience macro to declare local aliases of the NameList class inside any Solver method
+#define SOLVER_DECLARE_ALL_ALIASES ISEN_NAMELIST_DECLARE_ALIAS(namelist_)
+
+ISEN_NAMESPACE_END
+
+#endif
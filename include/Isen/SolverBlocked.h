@@ -0,0 +1,72 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_SOLVER_BLOCKED_H
+#define ISEN_SOLVER_BLOCKED_H
+
+#include <Isen/Common.h>
+#include <Isen/SolverCpu.h>
+#include <vector>
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Multi threaded CPU version with temporal blocking of the dry dynamics
+///
+/// The periodic x-domain is split into tiles. Each tile, together with a halo of width 'R * NameList::tblock', is
+/// copied into a thread-local buffer and advanced by NameList::tblock time steps (prognostic step, diffusion,
+/// pressure, Montgomery potential and geometric height) while it resides in cache. The valid region shrinks by R
+/// points on each side per time step (trapezoidal tiling) and only the interior of the tile is written back. The
+/// halos are computed redundantly by the neighbouring tiles.
+///
+/// Moist, relaxation boundary, adaptive time step or checkpointed (see NameList::icheckpoint) simulations fall back to
+/// the SolverCpu implementation.
+class SolverBlocked : public SolverCpu
+{
+public:
+    using Base = SolverCpu;
+
+    /// @brief Allocate memory
+    ///
+    /// @throw IsenException if out of memory
+    SolverBlocked(std::shared_ptr<NameList> namelist, Output::ArchiveType archiveType = Output::ArchiveType::Text);
+
+    /// Run the simulation
+    virtual void run() override;
+
+    /// Free all memory
+    virtual ~SolverBlocked() {}
+
+private:
+    /// Per time step parameters of a temporal block
+    struct StepInfo
+    {
+        double dtdx;     ///< dt / dx (halved in the first time step)
+        double topofact; ///< Growth factor of the topography
+        double umax;     ///< Maximum velocity at the end of the time step
+    };
+
+    /// Advance the dry dynamics of all tiles by @c steps.size() time steps
+    void advanceBlock(std::vector<StepInfo>& steps, int tileWidth);
+
+    /// Fields of the next temporal block (the fields of the current block are read by the halos of all tiles)
+    FieldXf soldNext_;
+    FieldXf snowNext_;
+    FieldXf uoldNext_;
+    FieldXf unowNext_;
+    FieldXf mtgNext_;
+};
+
+ISEN_NAMESPACE_END
+
+#endif
@@ -16,7 +16,10 @@
 #define ISEN_SOLVER_OPT_H
 
 #include <Isen/Common.h>
+#include <Isen/FastMath.h>
+#include <Isen/KesslerColumn.h>
 #include <Isen/Solver.h>
+#include <Isen/SolverCpuSimd.h>
 
 ISEN_NAMESPACE_BEGIN
 
@@ -28,9 +31,15 @@ public:
 
     /// @brief Allocate memory 
     ///
-    /// @throw IsenException if out of memory
+    /// @throw IsenException if out of memory or NameList::imath is invalid
     SolverCpu(std::shared_ptr<NameList> namelist, Output::ArchiveType archiveType = Output::ArchiveType::Text);
 
+    /// @brief Run the simulation within a single parallel region spanning the whole time loop
+    ///
+    /// The kernels are called directly (bypassing the virtual member functions), derived classes which override
+    /// parts of the time step have to override this function as well (e.g. forward to Solver::run).
+    virtual void run() override;
+
     //------------------------------------------------------------
     // Diffusion
     //------------------------------------------------------------
@@ -74,9 +83,52 @@ public:
     
     /// Prognostic step for hydrometeors
     virtual void progMoisture() noexcept override;
+
+    //------------------------------------------------------------
+    // Microphysics
+    //------------------------------------------------------------
+
+    /// Apply the column-fused Kessler scheme
+    virtual void microphysics() noexcept override;
     
     /// Free all memory
     virtual ~SolverCpu() {}
+
+protected:
+    /// Extrapolate the old time level (see Solver::rescaleOldTimeLevel)
+    virtual void rescaleOldTimeLevel(double ratio) noexcept override;
+
+    /// Set the time step of the column-fused Kessler scheme
+    virtual void setTimeStep(double dt) noexcept override;
+
+    /// @brief Time loop of SolverCpu::run advancing @c fields, which are stored in the scalar type @c T
+    ///
+    /// @c kessler is the Kessler scheme of the scalar type @c T (nullptr if NameList::imicrophys != 1).
+    template <class T>
+    void runTimeLoop(SolverFields<T>& fields, KesslerColumnT<T>* kessler);
+
+    /// Implementation of SolverCpu::rescaleOldTimeLevel on @c fields with the calling team of threads (see
+    /// SolverCpuKernel.h)
+    template <class T>
+    void rescaleOldTimeLevelTeam(SolverFields<T>& fields, double ratio) noexcept;
+
+    /// @brief Fold the velocity at the boundary points into @c reduction
+    ///
+    /// The diffusion only reduces the points it writes, this adds the remaining points considered by
+    /// Solver::computeCFL. Has to be called after the boundaries have been exchanged.
+    template <class T>
+    static void reduceVelocityBoundary(FieldReduction<T>& reduction, const Field<T>& u, int nx, int nb) noexcept;
+
+    /// Convert the reduction of a time step to its health metrics (@c dxdth is the area of a grid cell)
+    template <class T>
+    static StepHealth toStepHealth(const FieldReduction<T>& reduction, double dxdth) noexcept;
+
+protected:
+    /// Accuracy of the Exner function (NameList::imath)
+    MathTier mathTier_;
+
+    /// Kessler scheme (replaces the one of the Solver)
+    std::shared_ptr<KesslerColumn> kesslerColumn_;
 };
 
 ISEN_NAMESPACE_END
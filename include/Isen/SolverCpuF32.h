@@ -0,0 +1,92 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_SOLVER_CPU_F32_H
+#define ISEN_SOLVER_CPU_F32_H
+
+#include <Isen/Common.h>
+#include <Isen/KesslerColumn.h>
+#include <Isen/SolverCpu.h>
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Multi threaded CPU version in single precision
+///
+/// The simulation is initialized in double precision (see Solver::init). At the beginning of the time loop all fields
+/// of the time loop (see SolverFields) are converted to float, releasing the double precision fields, and the time loop
+/// of SolverCpu (dry dynamics and Kessler microphysics) is run on the single precision fields. Output and checkpoints
+/// read the single precision fields directly (see Solver::getMatF32). The fields are converted back to double
+/// precision at the end of the simulation, hence all getters of the Solver return the single precision results.
+class SolverCpuF32 : public SolverCpu
+{
+public:
+    using Base = SolverCpu;
+
+    /// @brief Allocate memory
+    ///
+    /// @throw IsenException if out of memory
+    SolverCpuF32(std::shared_ptr<NameList> namelist, Output::ArchiveType archiveType = Output::ArchiveType::Text);
+
+    /// @brief Run the simulation
+    ///
+    /// @throw IsenException if out of memory
+    virtual void run() override;
+
+    /// Get the single precision matrix @c name while the time loop is running (see Solver::getMatF32)
+    virtual const Field<float>* getMatF32(const std::string& name) const override;
+
+    /// Get the single precision vector @c name while the time loop is running (see Solver::getVecF32)
+    virtual const VectorX<float>* getVecF32(const std::string& name) const override;
+
+    /// Free all memory
+    virtual ~SolverCpuF32() {}
+
+protected:
+    /// Set the time step of the single precision Kessler scheme
+    virtual void setTimeStep(double dt) noexcept override;
+
+    /// Write the single precision fields to the checkpoint if the time loop is running
+    virtual void saveState(Checkpoint& checkpoint) const override;
+
+    /// Restore the fields from the checkpoint, the time loop continues in single precision
+    virtual void loadState(const Checkpoint& checkpoint) override;
+
+private:
+    /// @brief Convert the fields of the time loop to single precision and release the double precision fields
+    ///
+    /// @throw IsenException if out of memory
+    void toSinglePrecision();
+
+    /// @brief Convert the fields of the time loop back to double precision and release the single precision fields
+    ///
+    /// @throw IsenException if out of memory
+    void toDoublePrecision();
+
+private:
+    /// Fields of the time loop in single precision (allocated while the time loop is running)
+    SolverFields<float> fieldsF32_;
+
+    /// Getter maps of the single precision fields (see SolverFields::registerFields)
+    std::map<std::string, Field<float>*> matMapF32_;
+    std::map<std::string, VectorX<float>*> vecMapF32_;
+
+    std::shared_ptr<KesslerColumnT<float>> kesslerF32_;
+
+    /// Are the fields of the time loop stored in single precision?
+    bool singlePrecision_;
+};
+
+ISEN_NAMESPACE_END
+
+#endif
@@ -0,0 +1,313 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_SOLVER_CPU_KERNEL_H
+#define ISEN_SOLVER_CPU_KERNEL_H
+
+#include <Isen/Common.h>
+#include <Isen/FastMath.h>
+#include <Isen/SolverCpuSimd.h>
+
+ISEN_NAMESPACE_BEGIN
+
+//
+// Kernels of SolverCpu operating on the raw (ColMajor) data of the fields. The kernels are templated on the scalar type
+// of the fields and instantiated for double (SolverCpu) and float (SolverCpuF32).
+//
+// All fields passed to a kernel share the leading dimension 'ld' (see Field), i.e the element (i, k) of both the
+// staggered and the unstaggered fields is located at 'k * ld + i'. The fields have to be aligned to Field::Alignment
+// and 'ld' has to be a multiple of Field<T>::Lanes, as the vectorized kernels use aligned loads at the start of the
+// levels (see SolverCpuSimdImpl.h).
+//
+// The moisture tracers are passed as a single base pointer per time level (see TracerField): tracer 't' of 'ntr' is
+// located at an offset of 't * stride' elements.
+//
+// The kernels do not open a parallel region. They consist of orphaned work-sharing loops without a trailing barrier
+// ('omp for nowait'), i.e they have to be called by all threads of the enclosing parallel region and the caller has to
+// synchronize ('omp barrier') before the results are read by other threads. Outside of a parallel region the kernels
+// are executed by the calling thread alone.
+//
+
+/// @brief Horizontal diffusion of the velocity, the isentropic density and 'ntr' tracers
+///
+/// If 'reduction' is not a nullptr, the maximum of |unew|, the sum of snew and the finiteness check of both are folded
+/// into it while the diffused rows are still in the cache (see FieldReduction).
+template <class T>
+void kernel_horizontalDiffusion(const int nx,
+                                const int nz,
+                                const int nb,
+                                const int ld,
+                                const int ntr,
+                                const int stride,
+                                T* ISEN_RESTRICT unew,
+                                T* ISEN_RESTRICT snew,
+                                T* ISEN_RESTRICT qnew,
+                                const T* ISEN_RESTRICT unow,
+                                const T* ISEN_RESTRICT snow,
+                                const T* ISEN_RESTRICT qnow,
+                                const T* ISEN_RESTRICT tau,
+                                FieldReduction<T>* reduction = nullptr);
+
+template <class T>
+void kernel_clipMoisture(const int nx,
+                         const int nz,
+                         const int nb,
+                         const int ld,
+                         const int ntr,
+                         const int stride,
+                         T* ISEN_RESTRICT qnow);
+
+template <class T>
+void kernel_geometricHeight(const int nx,
+                            const int nz,
+                            const int nb,
+                            const int ld,
+                            T* ISEN_RESTRICT zhtnow,
+                            const T* ISEN_RESTRICT topo,
+                            const T* ISEN_RESTRICT th0,
+                            const T* ISEN_RESTRICT exn,
+                            const T* ISEN_RESTRICT prs,
+                            const T topofact,
+                            const T rcpg05);
+
+template <class T>
+void kernel_diagMontgomery_Exner(const int nx,
+                                 const int nz,
+                                 const int nb,
+                                 const int ld,
+                                 T* ISEN_RESTRICT exn,
+                                 const T* ISEN_RESTRICT prs,
+                                 const double cp,
+                                 const double pref,
+                                 const double rdcp,
+                                 const MathTier tier);
+
+template <class T>
+void kernel_diagMontgomery_Montgomery(const int nx,
+                                      const int nz,
+                                      const int nb,
+                                      const int ld,
+                                      T* ISEN_RESTRICT mtg,
+                                      const T* ISEN_RESTRICT topo,
+                                      const T* ISEN_RESTRICT exn,
+                                      const T th0,
+                                      const T cp,
+                                      const T dth,
+                                      const T gtopofact);
+
+template <class T>
+void kernel_diagPressure(const int nxb,
+                         const int nz,
+                         const int ld,
+                         T* ISEN_RESTRICT prs,
+                         const T* ISEN_RESTRICT snow,
+                         const T gdth,
+                         const T prs0);
+
+/// Maximum width of the column chunks of kernel_diagColumn in cache lines
+constexpr int DiagColumnChunk = 8;
+
+/// @brief Pressure, Exner function, Montgomery potential and geometric height in a single pass per column
+///
+/// Equivalent to kernel_diagPressure, kernel_diagMontgomery_Exner, kernel_diagMontgomery_Montgomery and
+/// kernel_geometricHeight (bitwise identical results). The columns are partitioned into chunks of whole cache lines
+/// and each chunk is integrated downwards (pressure) and upwards (Exner, Montgomery and height) while it resides in
+/// cache. As the columns are independent, the levels don't need to be synchronized.
+template <class T>
+void kernel_diagColumn(const int nx,
+                       const int nz,
+                       const int nb,
+                       const int ld,
+                       T* ISEN_RESTRICT prs,
+                       T* ISEN_RESTRICT exn,
+                       T* ISEN_RESTRICT mtg,
+                       T* ISEN_RESTRICT zhtnow,
+                       const T* ISEN_RESTRICT snow,
+                       const T* ISEN_RESTRICT topo,
+                       const T* ISEN_RESTRICT th0,
+                       const T gdth,
+                       const T prs0,
+                       const double cp,
+                       const double pref,
+                       const double rdcp,
+                       const T dth,
+                       const T gtopofact,
+                       const T topofact,
+                       const T rcpg05,
+                       const MathTier tier);
+
+/// Exner function fac * prs^rdcp of the elements [begin, end) with the transcendental functions of @c tier
+template <class T>
+void exnerRange(const MathTier tier,
+                const int begin,
+                const int end,
+                T* ISEN_RESTRICT exn,
+                const T* ISEN_RESTRICT prs,
+                const T fac,
+                const T rdcp);
+
+template <class T>
+void kernel_progIsendens(const int nx,
+                         const int nz,
+                         const int nb,
+                         const int ld,
+                         T* ISEN_RESTRICT snew,
+                         const T* ISEN_RESTRICT snow,
+                         const T* ISEN_RESTRICT sold,
+                         const T* ISEN_RESTRICT unow,
+                         const T dtdx05);
+
+template <class T>
+void kernel_progMoisture(const int nx,
+                         const int nz,
+                         const int nb,
+                         const int ld,
+                         const int ntr,
+                         const int stride,
+                         T* ISEN_RESTRICT qnew,
+                         const T* ISEN_RESTRICT qnow,
+                         const T* ISEN_RESTRICT qold,
+                         const T* ISEN_RESTRICT unow,
+                         const T dtdx05);
+
+/// @brief Complete prognostic step of all tracers (advection, boundaries, diffusion and clipping) in a single pass
+///
+/// The steps only couple the points of a level horizontally, hence each level of all tracers is advanced by a single
+/// thread while it resides in the cache. This is equivalent to (see Solver::prognosticStep)
+///
+///  1. qnew = progMoisture(qnow, qold), then relax qnew towards 'qbnd1'/'qbnd2' (or make it periodic if 'qbnd1' is
+///     a nullptr)
+///  2. qold = horizontalDiffusion(qnew), make qold periodic (unless relaxed) and clip it
+///
+/// i.e after swapping 'qold' and 'qnow' the time levels are rotated as in Solver::prognosticStep. The boundary values of
+/// tracer 't' at level 'k' are 'qbnd[t * nz + k]'.
+template <class T>
+void kernel_progTracers(const int nx,
+                        const int nz,
+                        const int nb,
+                        const int ld,
+                        const int ntr,
+                        const int stride,
+                        T* ISEN_RESTRICT qold,
+                        const T* ISEN_RESTRICT qnow,
+                        T* ISEN_RESTRICT qnew,
+                        const T* ISEN_RESTRICT unow,
+                        const T* ISEN_RESTRICT tau,
+                        const T* ISEN_RESTRICT qbnd1,
+                        const T* ISEN_RESTRICT qbnd2,
+                        const T dtdx05);
+
+template <class T>
+void kernel_progVelocity(const int nx,
+                         const int nz,
+                         const int nb,
+                         const int ld,
+                         T* ISEN_RESTRICT unew,
+                         const T* ISEN_RESTRICT unow,
+                         const T* ISEN_RESTRICT uold,
+                         const T* ISEN_RESTRICT mtg,
+                         const T dtdx);
+
+//
+// Kernels of SolverEnsemble operating on the interleaved fields of 'M' members: the element (i, k) of member 'm' is
+// located at 'k * ld + i * M + m', a stencil neighbour in x is thus 'M' elements away. The profiles, the boundary
+// values and the scalars of the members are interleaved the same way, e.g the diffusion coefficient of member 'm' at
+// level 'k' is 'tau[k * M + m]'. The arithmetic of each member is the one of Solver.
+//
+
+/// @brief Complete prognostic step of the velocity, the isentropic density and 'ntr' tracers of all members in a
+/// single pass per level
+///
+/// The counterpart of kernel_progTracers for all prognostic fields: the new time level is written into the 'new'
+/// fields and relaxed towards the boundary values (or made periodic if 'sbnd1' is a nullptr), the diffused new time
+/// level is written into the 'old' fields, made periodic (unless relaxed) and the tracers are clipped. The tracers are
+/// only diffused if 'diffuseTracers' is true. 'sel' is 1 where 'tau' is positive and 0 otherwise. After swapping the
+/// 'old' and 'now' fields the time levels are rotated as in Solver::prognosticStep. The boundary values of tracer 't'
+/// at level 'k' are 'qbnd[(t * nz + k) * M + m]'.
+template <class T>
+void kernel_progEnsemble(const int nx,
+                         const int nz,
+                         const int nb,
+                         const int M,
+                         const int ld,
+                         const int ntr,
+                         const int stride,
+                         T* ISEN_RESTRICT uold,
+                         const T* ISEN_RESTRICT unow,
+                         T* ISEN_RESTRICT unew,
+                         T* ISEN_RESTRICT sold,
+                         const T* ISEN_RESTRICT snow,
+                         T* ISEN_RESTRICT snew,
+                         T* ISEN_RESTRICT qold,
+                         const T* ISEN_RESTRICT qnow,
+                         T* ISEN_RESTRICT qnew,
+                         const T* ISEN_RESTRICT mtg,
+                         const T* ISEN_RESTRICT tau,
+                         const T* ISEN_RESTRICT sel,
+                         const T* ISEN_RESTRICT ubnd1,
+                         const T* ISEN_RESTRICT ubnd2,
+                         const T* ISEN_RESTRICT sbnd1,
+                         const T* ISEN_RESTRICT sbnd2,
+                         const T* ISEN_RESTRICT qbnd1,
+                         const T* ISEN_RESTRICT qbnd2,
+                         const bool diffuseTracers,
+                         const T dtdx);
+
+/// @brief Pressure of the columns [begin, end) of all members (downward integration from the top value of the
+/// profiles 'prs0')
+///
+/// Like exnerRange, the column kernels of the ensemble don't contain a work-sharing loop, the caller distributes the
+/// columns and computes the Exner function in between (see SolverEnsemble::run).
+template <class T>
+void kernel_diagPressureEnsemble(const int begin,
+                                 const int end,
+                                 const int nz,
+                                 const int M,
+                                 const int ld,
+                                 T* ISEN_RESTRICT prs,
+                                 const T* ISEN_RESTRICT snow,
+                                 const T* ISEN_RESTRICT prs0,
+                                 const T gdth);
+
+/// @brief Montgomery potential and geometric height of the columns [begin, end) of all members (upward integration)
+///
+/// The health metrics of the columns are accumulated per member: the maximum of |unow| into 'umax', the sum of snow
+/// over the interior points into 'smass' and the finiteness check of both into 'check' (see FieldReduction).
+template <class T>
+void kernel_geometricHeightEnsemble(const int begin,
+                                    const int end,
+                                    const int nx,
+                                    const int nz,
+                                    const int nb,
+                                    const int M,
+                                    const int ld,
+                                    T* ISEN_RESTRICT mtg,
+                                    T* ISEN_RESTRICT zhtnow,
+                                    const T* ISEN_RESTRICT exn,
+                                    const T* ISEN_RESTRICT prs,
+                                    const T* ISEN_RESTRICT unow,
+                                    const T* ISEN_RESTRICT snow,
+                                    const T* ISEN_RESTRICT topo,
+                                    const T* ISEN_RESTRICT th0,
+                                    const T* ISEN_RESTRICT topofact,
+                                    const T g,
+                                    const T dth,
+                                    const T rcpg05,
+                                    T* ISEN_RESTRICT umax,
+                                    T* ISEN_RESTRICT smass,
+                                    T* ISEN_RESTRICT check);
+
+ISEN_NAMESPACE_END
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_SOLVER_CPU_MIXED_H
+#define ISEN_SOLVER_CPU_MIXED_H
+
+#include <Isen/Common.h>
+#include <Isen/KesslerColumn.h>
+#include <Isen/SolverCpu.h>
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Multi threaded CPU version with mixed precision storage (NameList::imixprec)
+///
+/// The old time levels of the prognostic fields (isentropic density, velocity and moisture) and the scratch arrays of
+/// the Kessler scheme are stored in single precision, all arithmetic is carried out in double precision. The current
+/// and new time levels as well as all diagnostic fields (pressure, Exner function, Montgomery potential and height),
+/// which are computed by vertical cumulative sums, remain in double precision.
+///
+/// The double precision old time levels of the Solver are released after the initialization, i.e the fields "uold",
+/// "sold", "qvold", "qcold" and "qrold" are empty.
+///
+/// Compared to SolverCpu on test/data/namelist.m (see 'isen --verify'), the maximal relative deviation is 1.1e-5 for
+/// the precipitation and below 6e-6 for all other fields (e.g 1e-3 m for the geometric height and 1e-2 Pa for the
+/// pressure). With relaxed boundaries the deviations are of the same size.
+class SolverCpuMixed : public SolverCpu
+{
+public:
+    using Base = SolverCpu;
+
+    /// @brief Allocate memory
+    ///
+    /// @throw IsenException if out of memory
+    SolverCpuMixed(std::shared_ptr<NameList> namelist, Output::ArchiveType archiveType = Output::ArchiveType::Text);
+
+    /// Initialize the simulation and convert the old time levels to single precision
+    virtual void init() noexcept override;
+
+    /// Run the time loop of Solver (the mixed precision steps open their own parallel regions)
+    virtual void run() override { Solver::run(); }
+
+    /// Advance all prognostic fields by one time step in a single pass
+    virtual void prognosticStep() noexcept override;
+
+    /// Apply the Kessler scheme with single precision scratch arrays
+    virtual void microphysics() noexcept override;
+
+    /// Free all memory
+    virtual ~SolverCpuMixed() {}
+
+protected:
+    /// Extrapolate the single precision old time levels (see Solver::rescaleOldTimeLevel)
+    virtual void rescaleOldTimeLevel(double ratio) noexcept override;
+
+    /// Set the time step of the mixed precision Kessler scheme
+    virtual void setTimeStep(double dt) noexcept override;
+
+    /// Store the state of the simulation including the single precision old time levels
+    virtual void saveState(Checkpoint& checkpoint) const override;
+
+    /// Restore the state of the simulation including the single precision old time levels
+    virtual void loadState(const Checkpoint& checkpoint) override;
+
+private:
+    std::shared_ptr<KesslerColumnT<double, float>> kesslerMixed_;
+
+    /// Old time levels in single precision
+    Field<float> uoldF32_;
+    Field<float> soldF32_;
+    TracerField<float> qoldF32_;
+};
+
+ISEN_NAMESPACE_END
+
+#endif
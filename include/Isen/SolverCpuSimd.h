@@ -0,0 +1,108 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_SOLVER_CPU_SIMD_H
+#define ISEN_SOLVER_CPU_SIMD_H
+
+// This header is included by the translation units compiled for a specific instruction set and must therefore not
+// pull in any inline code (Eigen, Boost or the standard library), as the linker is free to pick any of the (differently
+// compiled) copies of an inline function.
+#include <Isen/Config.h>
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Reductions over the velocity and the isentropic density computed as a by-product of the diffusion
+///
+/// The kernels fold their partial results into the reduction passed by the calling thread, the caller combines the
+/// reductions of the threads (see SolverCpu::run). Only the points written by the kernel are taken into account.
+template <class T>
+struct FieldReduction
+{
+    T umax;  ///< Maximum of |u|
+    T smass; ///< Sum of sigma
+    T check; ///< Sum of x - x over u and sigma, i.e NaN if any value is not finite and zero otherwise
+
+    /// Reset to the neutral element
+    void reset() noexcept { umax = smass = check = T(0); }
+};
+
+/// @brief Table of the vectorizable kernels of SolverCpu and SolverEnsemble (see SolverCpuKernel.h for the signatures)
+///
+/// The Exner function (std::pow) is not part of the table and always uses the scalar kernel.
+template <class T>
+struct SolverCpuKernels
+{
+    void (*horizontalDiffusion)(const int nx, const int nz, const int nb, const int ld, const int ntr, const int stride,
+                                T* unew, T* snew, T* qnew, const T* unow, const T* snow, const T* qnow, const T* tau,
+                                FieldReduction<T>* reduction);
+
+    void (*clipMoisture)(const int nx, const int nz, const int nb, const int ld, const int ntr, const int stride,
+                         T* qnow);
+
+    void (*geometricHeight)(const int nx, const int nz, const int nb, const int ld, T* zhtnow, const T* topo,
+                            const T* th0, const T* exn, const T* prs, const T topofact, const T rcpg05);
+
+    void (*diagMontgomery_Montgomery)(const int nx, const int nz, const int nb, const int ld, T* mtg, const T* topo,
+                                      const T* exn, const T th0, const T cp, const T dth, const T gtopofact);
+
+    void (*diagPressure)(const int nxb, const int nz, const int ld, T* prs, const T* snow, const T gdth, const T prs0);
+
+    void (*progIsendens)(const int nx, const int nz, const int nb, const int ld, T* snew, const T* snow, const T* sold,
+                         const T* unow, const T dtdx05);
+
+    void (*progMoisture)(const int nx, const int nz, const int nb, const int ld, const int ntr, const int stride,
+                         T* qnew, const T* qnow, const T* qold, const T* unow, const T dtdx05);
+
+    void (*progTracers)(const int nx, const int nz, const int nb, const int ld, const int ntr, const int stride,
+                        T* qold, const T* qnow, T* qnew, const T* unow, const T* tau, const T* qbnd1, const T* qbnd2,
+                        const T dtdx05);
+
+    void (*progVelocity)(const int nx, const int nz, const int nb, const int ld, T* unew, const T* unow, const T* uold,
+                         const T* mtg, const T dtdx);
+
+    void (*progEnsemble)(const int nx, const int nz, const int nb, const int M, const int ld, const int ntr,
+                         const int stride, T* uold, const T* unow, T* unew, T* sold, const T* snow, T* snew, T* qold,
+                         const T* qnow, T* qnew, const T* mtg, const T* tau, const T* sel, const T* ubnd1,
+                         const T* ubnd2, const T* sbnd1, const T* sbnd2, const T* qbnd1, const T* qbnd2,
+                         const bool diffuseTracers, const T dtdx);
+
+    void (*diagPressureEnsemble)(const int begin, const int end, const int nz, const int M, const int ld, T* prs,
+                                 const T* snow, const T* prs0, const T gdth);
+
+    void (*geometricHeightEnsemble)(const int begin, const int end, const int nx, const int nz, const int nb,
+                                    const int M, const int ld, T* mtg, T* zhtnow, const T* exn, const T* prs,
+                                    const T* unow, const T* snow, const T* topo, const T* th0, const T* topofact,
+                                    const T g, const T dth, const T rcpg05, T* umax, T* smass, T* check);
+};
+
+/// Kernels of the instruction set selected by Simd (instantiated for double and float)
+template <class T>
+const SolverCpuKernels<T>& solverCpuKernels() noexcept;
+
+//
+// Kernels of the individual instruction sets (nullptr if the instruction set has not been compiled)
+//
+
+template <class T>
+const SolverCpuKernels<T>* solverCpuKernelsSSE42() noexcept;
+
+template <class T>
+const SolverCpuKernels<T>* solverCpuKernelsAVX2() noexcept;
+
+template <class T>
+const SolverCpuKernels<T>* solverCpuKernelsAVX512() noexcept;
+
+ISEN_NAMESPACE_END
+
+#endif
@@ -0,0 +1,1046 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+//
+// Vectorized kernels of SolverCpu and SolverEnsemble, generic in the vector type.
+//
+// This file is included by the translation units SolverCpuSimd<ISA>.cpp which are compiled for a specific instruction
+// set. Before including this file, the translation unit has to define the macro ISEN_SIMD_NAMESPACE (a namespace unique
+// to the instruction set) and, within Isen::ISEN_SIMD_NAMESPACE, the specializations Vec<double> and Vec<float> with
+// the following interface:
+//
+//  - static constexpr int Width                  Number of lanes
+//  - Vec(T value)                                Broadcast a scalar to all lanes
+//  - static Vec load(const T* ptr)               Unaligned load
+//  - void store(T* ptr) const                    Unaligned store
+//  - static Vec loadAligned(const T* ptr)        Aligned load (ptr is aligned to the vector width)
+//  - void storeAligned(T* ptr) const             Aligned store
+//  - operator+, operator-, operator*, operator/  Lane-wise arithmetic
+//  - clipNegative(Vec)                           Lane-wise 'v < 0 ? 0 : v'
+//  - abs(Vec)                                    Lane-wise |v|
+//  - max(Vec a, Vec b)                           Lane-wise 'a > b ? a : b'
+//
+// The kernels evaluate every expression in the same order as the scalar kernels in SolverCpu.cpp (and the translation
+// units are compiled without floating-point contraction), the results are thus bitwise identical for all instruction
+// sets. The remainder of each row, which does not fill an entire vector, is processed with Scal<T>.
+//
+// The levels of the fields start at an aligned address and the leading dimension is a multiple of the vector width
+// (see Field), hence the kernels iterating over entire levels use aligned loads and stores without a peel loop. The
+// kernels which only read and write fields (and no one-dimensional arrays like the topography) additionally process
+// the padding of the levels instead of a scalar remainder. The stencils of the prognostic kernels and the diffusion
+// start at 'nb' and access their neighbours at an offset of one, their loads therefore remain unaligned.
+//
+// Like the scalar kernels, the kernels only contain orphaned work-sharing loops without a trailing barrier (see
+// SolverCpuKernel.h).
+//
+
+#ifndef ISEN_SIMD_NAMESPACE
+#error "ISEN_SIMD_NAMESPACE has to be defined before including SolverCpuSimdImpl.h"
+#endif
+
+#include <Isen/SolverCpuSimd.h>
+
+ISEN_NAMESPACE_BEGIN
+
+namespace ISEN_SIMD_NAMESPACE
+{
+
+/// Single lane vector with the interface of Vec (used for the remainder of the rows)
+template <class T>
+struct Scal
+{
+    static constexpr int Width = 1;
+
+    T v;
+
+    ISEN_INLINE Scal(T value) : v(value) {}
+
+    static ISEN_INLINE Scal load(const T* ptr) { return Scal(*ptr); }
+    ISEN_INLINE void store(T* ptr) const { *ptr = v; }
+    static ISEN_INLINE Scal loadAligned(const T* ptr) { return Scal(*ptr); }
+    ISEN_INLINE void storeAligned(T* ptr) const { *ptr = v; }
+
+    friend ISEN_INLINE Scal operator+(Scal a, Scal b) { return Scal(a.v + b.v); }
+    friend ISEN_INLINE Scal operator-(Scal a, Scal b) { return Scal(a.v - b.v); }
+    friend ISEN_INLINE Scal operator*(Scal a, Scal b) { return Scal(a.v * b.v); }
+    friend ISEN_INLINE Scal operator/(Scal a, Scal b) { return Scal(a.v / b.v); }
+    friend ISEN_INLINE Scal clipNegative(Scal a) { return Scal(a.v < T(0) ? T(0) : a.v); }
+    friend ISEN_INLINE Scal abs(Scal a) { return Scal(a.v > T(0) ? a.v : T(0) - a.v); }
+    friend ISEN_INLINE Scal max(Scal a, Scal b) { return Scal(a.v > b.v ? a.v : b.v); }
+};
+
+/// First index of the remainder of [begin, end) which does not fill an entire vector of type @c V
+template <class V>
+ISEN_INLINE int vectorEnd(const int begin, const int end)
+{
+    return end - (end - begin) % V::Width;
+}
+
+/// End of the level [0, end) rounded up to entire vectors of type @c V (at most the leading dimension of the field)
+template <class V>
+ISEN_INLINE int paddedEnd(const int end)
+{
+    return (end + V::Width - 1) / V::Width * V::Width;
+}
+
+/// Make the level periodic (same as Boundary::periodicLevel, which must not be included here)
+template <class T>
+ISEN_INLINE void periodicLevel(T* phi, const int nx, const int nb)
+{
+    for(int i = 0; i < nb; ++i)
+        phi[i] = phi[nx + i];
+    for(int i = 0; i < nb; ++i)
+        phi[nx + nb + i] = phi[nb + i];
+}
+
+/// Relax the level towards @c phi1 and @c phi2 (same as Boundary::relaxLevel, which must not be included here)
+template <class T>
+ISEN_INLINE void relaxLevel(T* phi, const int nx, const int nb, const T phi1, const T phi2)
+{
+    constexpr int nr = 8;
+    const int n = 2 * nb + nx;
+    const T rel[nr] = {T(1.0), T(0.99), T(0.95), T(0.8), T(0.5), T(0.2), T(0.05), T(0.01)};
+
+    for(int i = 0; i < nr; ++i)
+    {
+        phi[i] = phi1 * rel[i] + phi[i] * (1 - rel[i]);
+        phi[n - 1 - i] = phi2 * rel[i] + phi[n - 1 - i] * (1 - rel[i]);
+    }
+}
+
+// -------------------------------------------------- horizontalDiffusion ----------------------------------------------
+/// Lane-wise partial results of FieldReduction, one set for the vectors and one for the remainder of the rows
+template <class T>
+struct LaneReduction
+{
+    Vec<T> umax = Vec<T>(T(0)), smass = Vec<T>(T(0)), check = Vec<T>(T(0));
+    Scal<T> umaxScal = Scal<T>(T(0)), smassScal = Scal<T>(T(0)), checkScal = Scal<T>(T(0));
+
+    ISEN_INLINE void velocity(Vec<T> u)
+    {
+        umax = max(umax, abs(u));
+        check = check + (u - u);
+    }
+    ISEN_INLINE void velocity(Scal<T> u)
+    {
+        umaxScal = max(umaxScal, abs(u));
+        checkScal = checkScal + (u - u);
+    }
+    ISEN_INLINE void density(Vec<T> s)
+    {
+        smass = smass + s;
+        check = check + (s - s);
+    }
+    ISEN_INLINE void density(Scal<T> s)
+    {
+        smassScal = smassScal + s;
+        checkScal = checkScal + (s - s);
+    }
+
+    /// Fold the lanes into @c reduction
+    ISEN_INLINE void fold(FieldReduction<T>* reduction) const
+    {
+        T lanes[3][Vec<T>::Width];
+        umax.store(lanes[0]);
+        smass.store(lanes[1]);
+        check.store(lanes[2]);
+
+        Scal<T> u = umaxScal, s = smassScal, c = checkScal;
+        for(int l = 0; l < Vec<T>::Width; ++l)
+        {
+            u = max(u, Scal<T>(lanes[0][l]));
+            s = s + Scal<T>(lanes[1][l]);
+            c = c + Scal<T>(lanes[2][l]);
+        }
+
+        reduction->umax = max(Scal<T>(reduction->umax), u).v;
+        reduction->smass += s.v;
+        reduction->check += c.v;
+    }
+};
+
+/// Rows without reduction
+struct NoReduction
+{
+    template <class V>
+    ISEN_INLINE void operator()(V) const
+    {
+    }
+};
+
+/// Accumulate the diffused velocity into a LaneReduction
+template <class T>
+struct VelocityReduction
+{
+    LaneReduction<T>& lanes;
+
+    template <class V>
+    ISEN_INLINE void operator()(V u) const
+    {
+        lanes.velocity(u);
+    }
+};
+
+/// Accumulate the diffused isentropic density into a LaneReduction
+template <class T>
+struct DensityReduction
+{
+    LaneReduction<T>& lanes;
+
+    template <class V>
+    ISEN_INLINE void operator()(V s) const
+    {
+        lanes.density(s);
+    }
+};
+
+template <class V, class T>
+ISEN_INLINE V diffuseAt(const int i, T* ISEN_RESTRICT qnew, const T* ISEN_RESTRICT qnow, const V tau025)
+{
+    V q = V::load(qnow + i) + tau025 * (V::load(qnow + i - 1) - V(T(2)) * V::load(qnow + i) + V::load(qnow + i + 1));
+    q.store(qnew + i);
+    return q;
+}
+
+/// Diffuse (or copy if @c diffuse is false) the row [begin, end) and pass the stored values to @c reduce
+template <class T, class Reduce = NoReduction>
+ISEN_INLINE void diffuseRow(const int begin, const int end, T* ISEN_RESTRICT qnew, const T* ISEN_RESTRICT qnow,
+                            const bool diffuse, const T tau025, Reduce reduce = Reduce())
+{
+    using V = Vec<T>;
+    const int iv = vectorEnd<V>(begin, end);
+
+    if(diffuse)
+    {
+        for(int i = begin; i < iv; i += V::Width)
+            reduce(diffuseAt<V>(i, qnew, qnow, V(tau025)));
+        for(int i = iv; i < end; ++i)
+            reduce(diffuseAt<Scal<T>>(i, qnew, qnow, Scal<T>(tau025)));
+    }
+    else
+    {
+        for(int i = begin; i < iv; i += V::Width)
+        {
+            V q = V::load(qnow + i);
+            q.store(qnew + i);
+            reduce(q);
+        }
+        for(int i = iv; i < end; ++i)
+        {
+            qnew[i] = qnow[i];
+            reduce(Scal<T>(qnow[i]));
+        }
+    }
+}
+
+template <class T>
+ISEN_NO_INLINE void kernel_horizontalDiffusion(const int nx,
+                                               const int nz,
+                                               const int nb,
+                                               const int ld,
+                                               const int ntr,
+                                               const int stride,
+                                               T* ISEN_RESTRICT unew,
+                                               T* ISEN_RESTRICT snew,
+                                               T* ISEN_RESTRICT qnew,
+                                               const T* ISEN_RESTRICT unow,
+                                               const T* ISEN_RESTRICT snow,
+                                               const T* ISEN_RESTRICT qnow,
+                                               const T* ISEN_RESTRICT tau,
+                                               FieldReduction<T>* reduction)
+{
+    const int nxnb = nx + nb;
+    const int nxnb1 = nx + nb + 1;
+
+    LaneReduction<T> lanes;
+
+#pragma omp for nowait
+    for(int k = 0; k < nz; ++k)
+    {
+        const T tau025 = T(0.25) * tau[k];
+        const bool diffuse = tau[k] > 0.0;
+
+        if(reduction)
+        {
+            diffuseRow(nb, nxnb1, unew + k * ld, unow + k * ld, diffuse, tau025, VelocityReduction<T>{lanes});
+            diffuseRow(nb, nxnb, snew + k * ld, snow + k * ld, diffuse, tau025, DensityReduction<T>{lanes});
+        }
+        else
+        {
+            diffuseRow(nb, nxnb1, unew + k * ld, unow + k * ld, diffuse, tau025);
+            diffuseRow(nb, nxnb, snew + k * ld, snow + k * ld, diffuse, tau025);
+        }
+
+        for(int t = 0; t < ntr; ++t)
+            diffuseRow(nb, nxnb, qnew + t * stride + k * ld, qnow + t * stride + k * ld, diffuse, tau025);
+    }
+
+    if(reduction)
+        lanes.fold(reduction);
+}
+
+// -------------------------------------------------- clipMoisture -----------------------------------------------------
+/// Clip the level [0, end) including its padding (see paddedEnd)
+template <class T>
+ISEN_INLINE void clipLevel(const int end, T* ISEN_RESTRICT qnow)
+{
+    using V = Vec<T>;
+    const int iend = paddedEnd<V>(end);
+
+    for(int i = 0; i < iend; i += V::Width)
+        clipNegative(V::loadAligned(qnow + i)).storeAligned(qnow + i);
+}
+
+template <class T>
+ISEN_NO_INLINE void kernel_clipMoisture(const int nx,
+                                        const int nz,
+                                        const int nb,
+                                        const int ld,
+                                        const int ntr,
+                                        const int stride,
+                                        T* ISEN_RESTRICT qnow)
+{
+    // The padding of the levels is clipped as well
+#pragma omp for nowait
+    for(int k = 0; k < nz; ++k)
+        for(int t = 0; t < ntr; ++t)
+            clipLevel(nx + 2 * nb, qnow + t * stride + k * ld);
+}
+
+// -------------------------------------------------- geometricHeight --------------------------------------------------
+template <class V, class T>
+ISEN_INLINE void geometricHeightAt(const int i,
+                                   const int k,
+                                   const int ld,
+                                   T* ISEN_RESTRICT zhtnow,
+                                   const T* ISEN_RESTRICT topo,
+                                   const T* ISEN_RESTRICT th0,
+                                   const T* ISEN_RESTRICT exn,
+                                   const T* ISEN_RESTRICT prs,
+                                   const T topofact,
+                                   const T rcpg05)
+{
+    if(k == 0)
+    {
+        (V::load(topo + i) * V(topofact)).storeAligned(zhtnow + i);
+        return;
+    }
+
+    const int c = k * ld + i;
+    const int m = (k - 1) * ld + i;
+
+    V th0exn = V(th0[k - 1]) * V::loadAligned(exn + m) + V(th0[k]) * V::loadAligned(exn + c);
+    V prs_delta = (V::loadAligned(prs + c) - V::loadAligned(prs + m))
+                  / (V(T(0.5)) * (V::loadAligned(prs + c) + V::loadAligned(prs + m)));
+    (V::loadAligned(zhtnow + m) - V(rcpg05) * th0exn * prs_delta).storeAligned(zhtnow + c);
+}
+
+template <class T>
+ISEN_NO_INLINE void kernel_geometricHeight(const int nx,
+                                           const int nz,
+                                           const int nb,
+                                           const int ld,
+                                           T* ISEN_RESTRICT zhtnow,
+                                           const T* ISEN_RESTRICT topo,
+                                           const T* ISEN_RESTRICT th0,
+                                           const T* ISEN_RESTRICT exn,
+                                           const T* ISEN_RESTRICT prs,
+                                           const T topofact,
+                                           const T rcpg05)
+{
+    using V = Vec<T>;
+    const int nxb = nx + 2 * nb;
+    const int nz1 = nz + 1;
+
+    // Each column only depends on itself. The static schedule assigns the same vectors (the last one may be a partial
+    // vector processed with scalars, as the topography is not padded) to the same thread in every level, hence the
+    // levels don't need to be synchronized.
+    for(int k = 0; k < nz1; ++k)
+    {
+#pragma omp for schedule(static) nowait
+        for(int i = 0; i < nxb; i += V::Width)
+        {
+            if(i + V::Width <= nxb)
+                geometricHeightAt<V>(i, k, ld, zhtnow, topo, th0, exn, prs, topofact, rcpg05);
+            else
+                for(int j = i; j < nxb; ++j)
+                    geometricHeightAt<Scal<T>>(j, k, ld, zhtnow, topo, th0, exn, prs, topofact, rcpg05);
+        }
+    }
+}
+
+// -------------------------------------------------- diagMontgomery ---------------------------------------------------
+template <class V, class T>
+ISEN_INLINE void montgomeryAt(const int i,
+                              const int k,
+                              const int ld,
+                              T* ISEN_RESTRICT mtg,
+                              const T* ISEN_RESTRICT topo,
+                              const T* ISEN_RESTRICT exn,
+                              const T th0dth05,
+                              const T dth,
+                              const T gtopofact)
+{
+    if(k == 0)
+        (V(gtopofact) * V::load(topo + i) + V(th0dth05) * V::loadAligned(exn + i)).storeAligned(mtg + i);
+    else
+        (V::loadAligned(mtg + (k - 1) * ld + i) + V(dth) * V::loadAligned(exn + k * ld + i))
+            .storeAligned(mtg + k * ld + i);
+}
+
+template <class T>
+ISEN_NO_INLINE void kernel_diagMontgomery_Montgomery(const int nx,
+                                                     const int nz,
+                                                     const int nb,
+                                                     const int ld,
+                                                     T* ISEN_RESTRICT mtg,
+                                                     const T* ISEN_RESTRICT topo,
+                                                     const T* ISEN_RESTRICT exn,
+                                                     const T th0,
+                                                     const T cp,
+                                                     const T dth,
+                                                     const T gtopofact)
+{
+    using V = Vec<T>;
+    const int nxb = nx + 2 * nb;
+    const T th0dth05 = dth * T(0.5) + th0;
+
+    // See kernel_geometricHeight
+    for(int k = 0; k < nz; ++k)
+    {
+#pragma omp for schedule(static) nowait
+        for(int i = 0; i < nxb; i += V::Width)
+        {
+            if(i + V::Width <= nxb)
+                montgomeryAt<V>(i, k, ld, mtg, topo, exn, th0dth05, dth, gtopofact);
+            else
+                for(int j = i; j < nxb; ++j)
+                    montgomeryAt<Scal<T>>(j, k, ld, mtg, topo, exn, th0dth05, dth, gtopofact);
+        }
+    }
+}
+
+// -------------------------------------------------- diagPressure -----------------------------------------------------
+template <class T>
+ISEN_NO_INLINE void kernel_diagPressure(const int nxb,
+                                        const int nz,
+                                        const int ld,
+                                        T* ISEN_RESTRICT prs,
+                                        const T* ISEN_RESTRICT snow,
+                                        const T gdth,
+                                        const T prs0)
+{
+    using V = Vec<T>;
+    const int iend = paddedEnd<V>(nxb);
+
+    // See kernel_geometricHeight (the padding of the levels is integrated as well)
+#pragma omp for schedule(static) nowait
+    for(int i = 0; i < iend; i += V::Width)
+        V(prs0).storeAligned(prs + nz * ld + i);
+
+    for(int k = nz - 1; k >= 0; --k)
+    {
+#pragma omp for schedule(static) nowait
+        for(int i = 0; i < iend; i += V::Width)
+            (V::loadAligned(prs + (k + 1) * ld + i) + V(gdth) * V::loadAligned(snow + k * ld + i))
+                .storeAligned(prs + k * ld + i);
+    }
+}
+
+// -------------------------------------------------- progIsendens -----------------------------------------------------
+template <class V, class T>
+ISEN_INLINE void progIsendensAt(const int i,
+                                T* ISEN_RESTRICT snew,
+                                const T* ISEN_RESTRICT snow,
+                                const T* ISEN_RESTRICT sold,
+                                const T* ISEN_RESTRICT unow,
+                                const V dtdx05)
+{
+    V snow_iplus1 = V::load(snow + i + 1) * (V::load(unow + i + 2) + V::load(unow + i + 1));
+    V snow_iminus1 = V::load(snow + i - 1) * (V::load(unow + i) + V::load(unow + i - 1));
+    (V::load(sold + i) - dtdx05 * (snow_iplus1 - snow_iminus1)).store(snew + i);
+}
+
+template <class T>
+ISEN_NO_INLINE void kernel_progIsendens(const int nx,
+                                        const int nz,
+                                        const int nb,
+                                        const int ld,
+                                        T* ISEN_RESTRICT snew,
+                                        const T* ISEN_RESTRICT snow,
+                                        const T* ISEN_RESTRICT sold,
+                                        const T* ISEN_RESTRICT unow,
+                                        const T dtdx05)
+{
+    using V = Vec<T>;
+    const int nxnb = nx + nb;
+    const int iv = vectorEnd<V>(nb, nxnb);
+
+#pragma omp for nowait
+    for(int k = 0; k < nz; ++k)
+    {
+        T* snew_k = snew + k * ld;
+        const T* snow_k = snow + k * ld;
+        const T* sold_k = sold + k * ld;
+        const T* unow_k = unow + k * ld;
+
+        for(int i = nb; i < iv; i += V::Width)
+            progIsendensAt<V>(i, snew_k, snow_k, sold_k, unow_k, V(dtdx05));
+        for(int i = iv; i < nxnb; ++i)
+            progIsendensAt<Scal<T>>(i, snew_k, snow_k, sold_k, unow_k, Scal<T>(dtdx05));
+    }
+}
+
+// -------------------------------------------------- progMoisture -----------------------------------------------------
+/// Advect all tracers at the points [i, i + V::Width), the velocity is loaded once for all tracers
+template <class V, class T>
+ISEN_INLINE void progMoistureAt(const int i,
+                                const int ntr,
+                                const int stride,
+                                T* ISEN_RESTRICT qnew,
+                                const T* ISEN_RESTRICT qnow,
+                                const T* ISEN_RESTRICT qold,
+                                const T* ISEN_RESTRICT unow,
+                                const V dtdx05)
+{
+    const V flux = dtdx05 * (V::load(unow + i) + V::load(unow + i + 1));
+    for(int t = 0; t < ntr; ++t)
+    {
+        const int c = t * stride + i;
+        (V::load(qold + c) - flux * (V::load(qnow + c + 1) - V::load(qnow + c - 1))).store(qnew + c);
+    }
+}
+
+/// Advect the level of all tracers (@c qnew, @c qnow, @c qold and @c unow point to the level)
+template <class T>
+ISEN_INLINE void progMoistureLevel(const int nb,
+                                   const int nxnb,
+                                   const int ntr,
+                                   const int stride,
+                                   T* ISEN_RESTRICT qnew,
+                                   const T* ISEN_RESTRICT qnow,
+                                   const T* ISEN_RESTRICT qold,
+                                   const T* ISEN_RESTRICT unow,
+                                   const T dtdx05)
+{
+    using V = Vec<T>;
+    const int iv = vectorEnd<V>(nb, nxnb);
+
+    for(int i = nb; i < iv; i += V::Width)
+        progMoistureAt<V>(i, ntr, stride, qnew, qnow, qold, unow, V(dtdx05));
+    for(int i = iv; i < nxnb; ++i)
+        progMoistureAt<Scal<T>>(i, ntr, stride, qnew, qnow, qold, unow, Scal<T>(dtdx05));
+}
+
+template <class T>
+ISEN_NO_INLINE void kernel_progMoisture(const int nx,
+                                        const int nz,
+                                        const int nb,
+                                        const int ld,
+                                        const int ntr,
+                                        const int stride,
+                                        T* ISEN_RESTRICT qnew,
+                                        const T* ISEN_RESTRICT qnow,
+                                        const T* ISEN_RESTRICT qold,
+                                        const T* ISEN_RESTRICT unow,
+                                        const T dtdx05)
+{
+#pragma omp for nowait
+    for(int k = 0; k < nz; ++k)
+        progMoistureLevel(nb, nx + nb, ntr, stride, qnew + k * ld, qnow + k * ld, qold + k * ld, unow + k * ld,
+                          dtdx05);
+}
+
+// -------------------------------------------------- progTracers ------------------------------------------------------
+template <class T>
+ISEN_NO_INLINE void kernel_progTracers(const int nx,
+                                       const int nz,
+                                       const int nb,
+                                       const int ld,
+                                       const int ntr,
+                                       const int stride,
+                                       T* ISEN_RESTRICT qold,
+                                       const T* ISEN_RESTRICT qnow,
+                                       T* ISEN_RESTRICT qnew,
+                                       const T* ISEN_RESTRICT unow,
+                                       const T* ISEN_RESTRICT tau,
+                                       const T* ISEN_RESTRICT qbnd1,
+                                       const T* ISEN_RESTRICT qbnd2,
+                                       const T dtdx05)
+{
+    const int nxnb = nx + nb;
+
+#pragma omp for nowait
+    for(int k = 0; k < nz; ++k)
+    {
+        const T tau025 = T(0.25) * tau[k];
+        const bool diffuse = tau[k] > 0.0;
+
+        progMoistureLevel(nb, nxnb, ntr, stride, qnew + k * ld, qnow + k * ld, qold + k * ld, unow + k * ld, dtdx05);
+
+        // Boundaries, diffusion and clipping while the level of the tracer is in the cache
+        for(int t = 0; t < ntr; ++t)
+        {
+            T* qnew_k = qnew + t * stride + k * ld;
+            T* qold_k = qold + t * stride + k * ld;
+
+            if(qbnd1)
+                relaxLevel(qnew_k, nx, nb, qbnd1[t * nz + k], qbnd2[t * nz + k]);
+            else
+                periodicLevel(qnew_k, nx, nb);
+
+            diffuseRow(nb, nxnb, qold_k, qnew_k, diffuse, tau025);
+
+            if(!qbnd1)
+                periodicLevel(qold_k, nx, nb);
+
+            clipLevel(nx + 2 * nb, qold_k);
+        }
+    }
+}
+
+// -------------------------------------------------- progVelocity -----------------------------------------------------
+template <class V, class T>
+ISEN_INLINE void progVelocityAt(const int i,
+                                T* ISEN_RESTRICT unew,
+                                const T* ISEN_RESTRICT unow,
+                                const T* ISEN_RESTRICT uold,
+                                const T* ISEN_RESTRICT mtg,
+                                const V dtdx,
+                                const V dtdx2)
+{
+    V unow_delta = V::load(unow + i) * (V::load(unow + i + 1) - V::load(unow + i - 1));
+    V mtg_dtdx2 = dtdx2 * (V::load(mtg + i) - V::load(mtg + i - 1));
+    (V::load(uold + i) - dtdx * unow_delta - mtg_dtdx2).store(unew + i);
+}
+
+template <class T>
+ISEN_NO_INLINE void kernel_progVelocity(const int nx,
+                                        const int nz,
+                                        const int nb,
+                                        const int ld,
+                                        T* ISEN_RESTRICT unew,
+                                        const T* ISEN_RESTRICT unow,
+                                        const T* ISEN_RESTRICT uold,
+                                        const T* ISEN_RESTRICT mtg,
+                                        const T dtdx)
+{
+    using V = Vec<T>;
+    const int nx1nb = nx + nb + 1;
+    const int iv = vectorEnd<V>(nb, nx1nb);
+
+    const T dtdx2 = 2 * dtdx;
+
+#pragma omp for nowait
+    for(int k = 0; k < nz; ++k)
+    {
+        T* unew_k = unew + k * ld;
+        const T* unow_k = unow + k * ld;
+        const T* uold_k = uold + k * ld;
+        const T* mtg_k = mtg + k * ld;
+
+        for(int i = nb; i < iv; i += V::Width)
+            progVelocityAt<V>(i, unew_k, unow_k, uold_k, mtg_k, V(dtdx), V(dtdx2));
+        for(int i = iv; i < nx1nb; ++i)
+            progVelocityAt<Scal<T>>(i, unew_k, unow_k, uold_k, mtg_k, Scal<T>(dtdx), Scal<T>(dtdx2));
+    }
+}
+
+// -------------------------------------------------- progEnsemble -----------------------------------------------------
+template <class V, class T>
+ISEN_INLINE void progIsendensEnsembleAt(const int j,
+                                        const int M,
+                                        T* ISEN_RESTRICT snew,
+                                        const T* ISEN_RESTRICT snow,
+                                        const T* ISEN_RESTRICT sold,
+                                        const T* ISEN_RESTRICT unow,
+                                        const V dtdx05)
+{
+    V snow_iplus1 = V::load(snow + j + M) * (V::load(unow + j + 2 * M) + V::load(unow + j + M));
+    V snow_iminus1 = V::load(snow + j - M) * (V::load(unow + j) + V::load(unow + j - M));
+    (V::load(sold + j) - dtdx05 * (snow_iplus1 - snow_iminus1)).store(snew + j);
+}
+
+/// Advect all tracers at the points [j, j + V::Width), the velocity is loaded once for all tracers
+template <class V, class T>
+ISEN_INLINE void progMoistureEnsembleAt(const int j,
+                                        const int M,
+                                        const int ntr,
+                                        const int stride,
+                                        T* ISEN_RESTRICT qnew,
+                                        const T* ISEN_RESTRICT qnow,
+                                        const T* ISEN_RESTRICT qold,
+                                        const T* ISEN_RESTRICT unow,
+                                        const V dtdx05)
+{
+    const V flux = dtdx05 * (V::load(unow + j) + V::load(unow + j + M));
+    for(int t = 0; t < ntr; ++t)
+    {
+        const int c = t * stride + j;
+        (V::load(qold + c) - flux * (V::load(qnow + c + M) - V::load(qnow + c - M))).store(qnew + c);
+    }
+}
+
+template <class V, class T>
+ISEN_INLINE void progVelocityEnsembleAt(const int j,
+                                        const int M,
+                                        T* ISEN_RESTRICT unew,
+                                        const T* ISEN_RESTRICT unow,
+                                        const T* ISEN_RESTRICT uold,
+                                        const T* ISEN_RESTRICT mtg,
+                                        const V dtdx,
+                                        const V dtdx2)
+{
+    V unow_delta = dtdx * V::load(unow + j) * (V::load(unow + j + M) - V::load(unow + j - M));
+    V mtg_dtdx2 = dtdx2 * (V::load(mtg + j) - V::load(mtg + j - M));
+    (V::load(uold + j) - unow_delta - mtg_dtdx2).store(unew + j);
+}
+
+/// Relax a level of all members towards their boundary values @c phi1 and @c phi2 (see relaxLevel)
+template <class T>
+ISEN_INLINE void relaxLevelEnsemble(T* phi, const int nx, const int nb, const int M, const T* phi1, const T* phi2)
+{
+    constexpr int nr = 8;
+    const int n = 2 * nb + nx;
+    const T rel[nr] = {T(1.0), T(0.99), T(0.95), T(0.8), T(0.5), T(0.2), T(0.05), T(0.01)};
+
+    for(int i = 0; i < nr; ++i)
+        for(int m = 0; m < M; ++m)
+        {
+            phi[i * M + m] = phi1[m] * rel[i] + phi[i * M + m] * (1 - rel[i]);
+            phi[(n - 1 - i) * M + m] = phi2[m] * rel[i] + phi[(n - 1 - i) * M + m] * (1 - rel[i]);
+        }
+}
+
+/// Diffuse the members [m, m + V::Width) of a point with their diffusion coefficients (@c sel is 1 where @c tau is
+/// positive and 0 otherwise)
+template <class V, class T>
+ISEN_INLINE void diffuseEnsembleAt(const int m,
+                                   T* ISEN_RESTRICT out,
+                                   const T* ISEN_RESTRICT left,
+                                   const T* ISEN_RESTRICT center,
+                                   const T* ISEN_RESTRICT right,
+                                   const T* ISEN_RESTRICT tau,
+                                   const T* ISEN_RESTRICT sel)
+{
+    const V c = V::load(center + m);
+    const V s = V::load(sel + m);
+    V phi = c + V(T(0.25)) * V::load(tau + m) * (V::load(left + m) - V(T(2)) * c + V::load(right + m));
+    (s * phi + (V(T(1)) - s) * c).store(out + m);
+}
+
+/// Diffuse the points [begin, end) of a level of all members
+template <class T>
+ISEN_INLINE void diffuseLevelEnsemble(const int begin,
+                                      const int end,
+                                      const int M,
+                                      T* ISEN_RESTRICT phinew,
+                                      const T* ISEN_RESTRICT phinow,
+                                      const T* ISEN_RESTRICT tau,
+                                      const T* ISEN_RESTRICT sel)
+{
+    using V = Vec<T>;
+    const int mv = vectorEnd<V>(0, M);
+
+    for(int i = begin; i < end; ++i)
+    {
+        const T* left = phinow + (i - 1) * M;
+        const T* center = phinow + i * M;
+        const T* right = phinow + (i + 1) * M;
+        T* out = phinew + i * M;
+
+        for(int m = 0; m < mv; m += V::Width)
+            diffuseEnsembleAt<V>(m, out, left, center, right, tau, sel);
+        for(int m = mv; m < M; ++m)
+            diffuseEnsembleAt<Scal<T>>(m, out, left, center, right, tau, sel);
+    }
+}
+
+template <class T>
+ISEN_NO_INLINE void kernel_progEnsemble(const int nx,
+                                        const int nz,
+                                        const int nb,
+                                        const int M,
+                                        const int ld,
+                                        const int ntr,
+                                        const int stride,
+                                        T* ISEN_RESTRICT uold,
+                                        const T* ISEN_RESTRICT unow,
+                                        T* ISEN_RESTRICT unew,
+                                        T* ISEN_RESTRICT sold,
+                                        const T* ISEN_RESTRICT snow,
+                                        T* ISEN_RESTRICT snew,
+                                        T* ISEN_RESTRICT qold,
+                                        const T* ISEN_RESTRICT qnow,
+                                        T* ISEN_RESTRICT qnew,
+                                        const T* ISEN_RESTRICT mtg,
+                                        const T* ISEN_RESTRICT tau,
+                                        const T* ISEN_RESTRICT sel,
+                                        const T* ISEN_RESTRICT ubnd1,
+                                        const T* ISEN_RESTRICT ubnd2,
+                                        const T* ISEN_RESTRICT sbnd1,
+                                        const T* ISEN_RESTRICT sbnd2,
+                                        const T* ISEN_RESTRICT qbnd1,
+                                        const T* ISEN_RESTRICT qbnd2,
+                                        const bool diffuseTracers,
+                                        const T dtdx)
+{
+    using V = Vec<T>;
+    const int nxb = nx + 2 * nb;
+    const int nxnb = nx + nb;
+    const int nxnb1 = nx + nb + 1;
+
+    // The members of all interior points of a level are contiguous
+    const int begin = nb * M;
+    const int end = nxnb * M;
+    const int end1 = nxnb1 * M;
+    const int jv = vectorEnd<V>(begin, end);
+    const int jv1 = vectorEnd<V>(begin, end1);
+
+    const T dtdx05 = T(0.5) * dtdx;
+    const T dtdx2 = 2 * dtdx;
+
+#pragma omp for nowait
+    for(int k = 0; k < nz; ++k)
+    {
+        const int o = k * ld;
+        const T* tauk = tau + k * M;
+        const T* selk = sel + k * M;
+
+        // Advection
+        for(int j = o + begin; j < o + jv; j += V::Width)
+            progIsendensEnsembleAt<V>(j, M, snew, snow, sold, unow, V(dtdx05));
+        for(int j = o + jv; j < o + end; ++j)
+            progIsendensEnsembleAt<Scal<T>>(j, M, snew, snow, sold, unow, Scal<T>(dtdx05));
+
+        for(int j = o + begin; j < o + jv; j += V::Width)
+            progMoistureEnsembleAt<V>(j, M, ntr, stride, qnew, qnow, qold, unow, V(dtdx05));
+        for(int j = o + jv; j < o + end; ++j)
+            progMoistureEnsembleAt<Scal<T>>(j, M, ntr, stride, qnew, qnow, qold, unow, Scal<T>(dtdx05));
+
+        for(int j = o + begin; j < o + jv1; j += V::Width)
+            progVelocityEnsembleAt<V>(j, M, unew, unow, uold, mtg, V(dtdx), V(dtdx2));
+        for(int j = o + jv1; j < o + end1; ++j)
+            progVelocityEnsembleAt<Scal<T>>(j, M, unew, unow, uold, mtg, Scal<T>(dtdx), Scal<T>(dtdx2));
+
+        // Boundaries, diffusion and clipping while the level is in the cache
+        if(sbnd1)
+        {
+            relaxLevelEnsemble(unew + o, nx + 1, nb, M, ubnd1 + k * M, ubnd2 + k * M);
+            relaxLevelEnsemble(snew + o, nx, nb, M, sbnd1 + k * M, sbnd2 + k * M);
+        }
+        else
+        {
+            periodicLevel(unew + o, (nx + 1) * M, nb * M);
+            periodicLevel(snew + o, nx * M, nb * M);
+        }
+
+        diffuseLevelEnsemble(nb, nxnb1, M, uold + o, unew + o, tauk, selk);
+        diffuseLevelEnsemble(nb, nxnb, M, sold + o, snew + o, tauk, selk);
+
+        if(!sbnd1)
+        {
+            periodicLevel(uold + o, (nx + 1) * M, nb * M);
+            periodicLevel(sold + o, nx * M, nb * M);
+        }
+
+        for(int t = 0; t < ntr; ++t)
+        {
+            T* qnew_k = qnew + t * stride + o;
+            T* qold_k = qold + t * stride + o;
+
+            if(sbnd1)
+                relaxLevelEnsemble(qnew_k, nx, nb, M, qbnd1 + (t * nz + k) * M, qbnd2 + (t * nz + k) * M);
+            else
+                periodicLevel(qnew_k, nx * M, nb * M);
+
+            if(diffuseTracers)
+                diffuseLevelEnsemble(nb, nxnb, M, qold_k, qnew_k, tauk, selk);
+            else
+                diffuseRow(begin, end, qold_k, qnew_k, false, T(0));
+
+            if(!sbnd1)
+                periodicLevel(qold_k, nx * M, nb * M);
+
+            clipLevel(nxb * M, qold_k);
+        }
+    }
+}
+
+// -------------------------------------------------- diagEnsemble -----------------------------------------------------
+template <class V, class T>
+ISEN_INLINE void diagPressureEnsembleAt(const int j,
+                                        const int ld,
+                                        T* ISEN_RESTRICT prs,
+                                        const T* ISEN_RESTRICT snow,
+                                        const V gdth)
+{
+    (V::load(prs + j + ld) + gdth * V::load(snow + j)).store(prs + j);
+}
+
+template <class T>
+ISEN_NO_INLINE void kernel_diagPressureEnsemble(const int begin,
+                                                const int end,
+                                                const int nz,
+                                                const int M,
+                                                const int ld,
+                                                T* ISEN_RESTRICT prs,
+                                                const T* ISEN_RESTRICT snow,
+                                                const T* ISEN_RESTRICT prs0,
+                                                const T gdth)
+{
+    using V = Vec<T>;
+    const int mv = vectorEnd<V>(0, M);
+    const int jv = vectorEnd<V>(begin * M, end * M);
+
+    for(int i = begin; i < end; ++i)
+    {
+        T* prs_i = prs + nz * ld + i * M;
+        for(int m = 0; m < mv; m += V::Width)
+            V::load(prs0 + nz * M + m).store(prs_i + m);
+        for(int m = mv; m < M; ++m)
+            prs_i[m] = prs0[nz * M + m];
+    }
+
+    // The columns [begin, end) of a level are contiguous
+    for(int k = nz - 1; k >= 0; --k)
+    {
+        for(int j = k * ld + begin * M; j < k * ld + jv; j += V::Width)
+            diagPressureEnsembleAt<V>(j, ld, prs, snow, V(gdth));
+        for(int j = k * ld + jv; j < k * ld + end * M; ++j)
+            diagPressureEnsembleAt<Scal<T>>(j, ld, prs, snow, Scal<T>(gdth));
+    }
+}
+
+/// Montgomery potential, geometric height and health metrics of the members [m, m + V::Width) of the column @c c0
+template <class V, class T>
+ISEN_INLINE void geometricHeightEnsembleAt(const int c0,
+                                           const int m,
+                                           const int nz,
+                                           const int M,
+                                           const int ld,
+                                           const bool interior,
+                                           T* ISEN_RESTRICT mtg,
+                                           T* ISEN_RESTRICT zhtnow,
+                                           const T* ISEN_RESTRICT exn,
+                                           const T* ISEN_RESTRICT prs,
+                                           const T* ISEN_RESTRICT unow,
+                                           const T* ISEN_RESTRICT snow,
+                                           const T* ISEN_RESTRICT topo,
+                                           const T* ISEN_RESTRICT th0,
+                                           const T* ISEN_RESTRICT topofact,
+                                           const T g,
+                                           const T dth,
+                                           const T rcpg05,
+                                           T* ISEN_RESTRICT umax,
+                                           T* ISEN_RESTRICT smass,
+                                           T* ISEN_RESTRICT check)
+{
+    const int c = c0 + m;
+    const V gtopofact = V(g) * V::load(topofact + m);
+
+    (gtopofact * V::load(topo + c) + V::load(th0 + m) * V::load(exn + c) + V(dth * T(0.5)) * V::load(exn + c))
+        .store(mtg + c);
+    (V::load(topo + c) * V::load(topofact + m)).store(zhtnow + c);
+
+    for(int k = 1; k < nz + 1; ++k)
+    {
+        const int ck = k * ld + c;
+
+        if(k < nz)
+            (V::load(mtg + ck - ld) + V(dth) * V::load(exn + ck)).store(mtg + ck);
+
+        V th0exn = V::load(th0 + (k - 1) * M + m) * V::load(exn + ck - ld)
+                   + V::load(th0 + k * M + m) * V::load(exn + ck);
+        V prs_delta = (V::load(prs + ck) - V::load(prs + ck - ld))
+                      / (V(T(0.5)) * (V::load(prs + ck) + V::load(prs + ck - ld)));
+        (V::load(zhtnow + ck - ld) - V(rcpg05) * th0exn * prs_delta).store(zhtnow + ck);
+    }
+
+    // Health metrics (only the interior points contribute to the mass)
+    V umax_m = V::load(umax + m), smass_m = V::load(smass + m), check_m = V::load(check + m);
+    for(int k = 0; k < nz; ++k)
+    {
+        const V u = V::load(unow + k * ld + c);
+        const V s = V::load(snow + k * ld + c);
+        umax_m = max(umax_m, abs(u));
+        smass_m = smass_m + (interior ? s : V(T(0)));
+        check_m = check_m + ((u - u) + (s - s));
+    }
+    umax_m.store(umax + m);
+    smass_m.store(smass + m);
+    check_m.store(check + m);
+}
+
+template <class T>
+ISEN_NO_INLINE void kernel_geometricHeightEnsemble(const int begin,
+                                                   const int end,
+                                                   const int nx,
+                                                   const int nz,
+                                                   const int nb,
+                                                   const int M,
+                                                   const int ld,
+                                                   T* ISEN_RESTRICT mtg,
+                                                   T* ISEN_RESTRICT zhtnow,
+                                                   const T* ISEN_RESTRICT exn,
+                                                   const T* ISEN_RESTRICT prs,
+                                                   const T* ISEN_RESTRICT unow,
+                                                   const T* ISEN_RESTRICT snow,
+                                                   const T* ISEN_RESTRICT topo,
+                                                   const T* ISEN_RESTRICT th0,
+                                                   const T* ISEN_RESTRICT topofact,
+                                                   const T g,
+                                                   const T dth,
+                                                   const T rcpg05,
+                                                   T* ISEN_RESTRICT umax,
+                                                   T* ISEN_RESTRICT smass,
+                                                   T* ISEN_RESTRICT check)
+{
+    using V = Vec<T>;
+    const int mv = vectorEnd<V>(0, M);
+
+    for(int i = begin; i < end; ++i)
+    {
+        const bool interior = i >= nb && i < nx + nb;
+
+        for(int m = 0; m < mv; m += V::Width)
+            geometricHeightEnsembleAt<V>(i * M, m, nz, M, ld, interior, mtg, zhtnow, exn, prs, unow, snow, topo, th0,
+                                         topofact, g, dth, rcpg05, umax, smass, check);
+        for(int m = mv; m < M; ++m)
+            geometricHeightEnsembleAt<Scal<T>>(i * M, m, nz, M, ld, interior, mtg, zhtnow, exn, prs, unow, snow, topo,
+                                               th0, topofact, g, dth, rcpg05, umax, smass, check);
+    }
+}
+
+// -------------------------------------------------- kernel table -----------------------------------------------------
+template <class T>
+const SolverCpuKernels<T>* kernelTable() noexcept
+{
+    static const SolverCpuKernels<T> table = {&kernel_horizontalDiffusion<T>,
+                                              &kernel_clipMoisture<T>,
+                                              &kernel_geometricHeight<T>,
+                                              &kernel_diagMontgomery_Montgomery<T>,
+                                              &kernel_diagPressure<T>,
+                                              &kernel_progIsendens<T>,
+                                              &kernel_progMoisture<T>,
+                                              &kernel_progTracers<T>,
+                                              &kernel_progVelocity<T>,
+                                              &kernel_progEnsemble<T>,
+                                              &kernel_diagPressureEnsemble<T>,
+                                              &kernel_geometricHeightEnsemble<T>};
+    return &table;
+}
+
+} // namespace ISEN_SIMD_NAMESPACE
+
+ISEN_NAMESPACE_END
@@ -0,0 +1,159 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_SOLVER_ENSEMBLE_H
+#define ISEN_SOLVER_ENSEMBLE_H
+
+#include <Isen/Common.h>
+#include <Isen/Field.h>
+#include <Isen/KesslerEnsemble.h>
+#include <Isen/NameList.h>
+#include <Isen/Output.h>
+#include <Isen/Solver.h>
+#include <Isen/Tracer.h>
+#include <vector>
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Ensemble of simulations advanced together
+///
+/// The members share the grid, the time stepping and the physics switches of their NameLists but may differ in all
+/// physical parameters, e.g the initial atmosphere (NameList::u00, NameList::bv00, ...), the topography
+/// (NameList::topomx, ...), the diffusion (NameList::diff, ...) and the parameters of the Kessler scheme
+/// (NameList::vt_mult, NameList::autoconv_th, ...).
+///
+/// The fields of all members are stored interleaved with the member index innermost: the value of member @c m at the
+/// grid point (i, k) is the element (i * size() + m, k) of a Field, the profiles are interleaved the same way. Every
+/// kernel thus processes all members of a grid point with contiguous (vectorizable) loads and the loop and index
+/// overhead is shared by the members. The kernels are dispatched to the instruction set of the CPU (see
+/// SolverCpuKernels), the time loop is a single parallel region as in SolverCpu and the arithmetic of each member is
+/// identical to the reference implementation Solver (the moisture tracers are diffused with NameList::imoist_diff
+/// only).
+///
+/// Each member is a Solver of its own which creates the initial conditions and holds the output. The fields of its grid
+/// only exist while it is initialized, while its output is written and once it is accessed (see
+/// SolverEnsemble::getMember), the ensemble thus holds a single copy of the state of all members.
+class SolverEnsemble
+{
+public:
+    /// @brief Allocate memory for the members given by their @c namelists
+    ///
+    /// Members with the same NameList::run_name are distinguished by appending their index to the name.
+    ///
+    /// @throw IsenException if out of memory, @c namelists is empty or the members don't share the grid and the time
+    ///        stepping
+    SolverEnsemble(const std::vector<std::shared_ptr<NameList>>& namelists,
+                   Output::ArchiveType archiveType = Output::ArchiveType::Text);
+
+    /// Free all memory
+    ~SolverEnsemble();
+
+    /// @brief Initialize the simulation of all members (see Solver::init)
+    ///
+    /// @throw IsenException if out of memory
+    void init();
+
+    /// Run the simulation of all members
+    void run();
+
+    /// Write the simulation of each member to its own output file (see Solver::write)
+    void write();
+
+    /// Number of members
+    int size() const noexcept { return size_; }
+
+    /// @brief Access member @c m
+    ///
+    /// The fields of the member are allocated (if necessary) and copied from the interleaved fields on every access.
+    ///
+    /// @throw IsenException if there is no member @c m or out of memory
+    const Solver& getMember(int m) const;
+
+private:
+    class Member;
+
+    /// Copy the state of member @c m into the interleaved fields
+    void gatherMember(int m) noexcept;
+
+    /// Copy the interleaved fields back to member @c m (the fields of the member have to be allocated)
+    void scatterMember(int m) const noexcept;
+
+    /// Check (and optionally print) the health metrics of all members (see Solver::checkHealth)
+    void checkHealth(const std::vector<StepHealth>& health);
+
+    int size_;
+    std::shared_ptr<NameList> namelist_;
+    std::vector<std::shared_ptr<Member>> members_;
+
+    //-------------------------------------------------
+    // Parametrizations
+    //-------------------------------------------------
+    std::shared_ptr<KesslerEnsemble> kessler_;
+
+    //-------------------------------------------------
+    // Interleaved fields (see Solver)
+    //-------------------------------------------------
+    VectorXf topo_;
+
+    FieldXf zhtold_;
+    FieldXf zhtnow_;
+
+    FieldXf uold_;
+    FieldXf unow_;
+    FieldXf unew_;
+
+    FieldXf sold_;
+    FieldXf snow_;
+    FieldXf snew_;
+
+    FieldXf mtg_;
+    FieldXf exn_;
+    FieldXf prs_;
+    VectorXf prs0_;
+
+    VectorXf tau_;
+    VectorXf tauSel_; ///< 1 where tau_ is positive and 0 otherwise
+    VectorXf th0_;
+
+    VectorXf prec_;
+    VectorXf tot_prec_;
+
+    TracerXf qold_;
+    TracerXf qnow_;
+    TracerXf qnew_;
+
+    FieldXf temp_;
+
+    VectorXf sbnd1_;
+    VectorXf sbnd2_;
+    VectorXf ubnd1_;
+    VectorXf ubnd2_;
+    MatrixXf qbnd1_;
+    MatrixXf qbnd2_;
+
+    //-------------------------------------------------
+    // Scalars of the members
+    //-------------------------------------------------
+    VectorXf topotim_;
+    VectorXf topofact_;
+
+    double dtdx_;
+
+    /// Leading dimension of all interleaved fields
+    int ld_;
+};
+
+ISEN_NAMESPACE_END
+
+#endif
@@ -18,7 +18,12 @@
 #include <Isen/Common.h>
 #include <Isen/Output.h>
 #include <Isen/Solver.h>
+#include <Isen/SolverBlocked.h>
 #include <Isen/SolverCpu.h>
+#include <Isen/SolverCpuF32.h>
+#include <Isen/SolverCpuMixed.h>
+#include <Isen/SolverFused.h>
+#include <Isen/SolverMpi.h>
 #include <string>
 
 ISEN_NAMESPACE_BEGIN
@@ -28,7 +33,8 @@ struct SolverFactory
 {
     /// @brief Create the Solver instance given by @c name
     ///
-    /// @param name         Name of the Solver. If the name is empty, the refrence implementation will be used.
+    /// @param name         Name of the Solver. If the name is empty, the refrence implementation will be used. The
+    ///                     cpu implementation uses mixed precision storage if NameList::imixprec is set.
     /// @param namelist     NameList containing the simulation variables.
     /// @param archiveType  Archive used for serializing the output [default: Output::ArchiveType::Text].
     ///
@@ -39,8 +45,23 @@ struct SolverFactory
     {
         if(name.empty() || name == "ref")
             return std::make_shared<Solver>(namelist, archiveType);
+        else if(name == "cpu-mixed" || (name == "cpu" && namelist->imixprec))
+            return std::make_shared<SolverCpuMixed>(namelist, archiveType);
         else if(name == "cpu")
             return std::make_shared<SolverCpu>(namelist, archiveType);
+        else if(name == "cpu-f32")
+            return std::make_shared<SolverCpuF32>(namelist, archiveType);
+        else if(name == "fused")
+            return std::make_shared<SolverFused>(namelist, archiveType);
+        else if(name == "blocked")
+            return std::make_shared<SolverBlocked>(namelist, archiveType);
+#ifdef ISEN_MPI
+        else if(name == "mpi")
+            return std::make_shared<SolverMpi>(namelist, archiveType);
+#else
+        else if(name == "mpi")
+            throw IsenException("Solver 'mpi' is not available (compile with ISEN_MPI)");
+#endif
         else
             throw IsenException("invalid Solver name '%s'", name);
     }
@@ -0,0 +1,110 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_SOLVER_FIELDS_H
+#define ISEN_SOLVER_FIELDS_H
+
+#include <Isen/Common.h>
+#include <Isen/Field.h>
+#include <Isen/Tracer.h>
+#include <map>
+#include <string>
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Fields advanced by the time loop, stored in the scalar type @c T
+///
+/// The Solver stores these fields in double precision, SolverCpuF32 runs the time loop of SolverCpu on a single
+/// precision instance (see SolverCpu::runTimeLoop).
+template <class T>
+struct SolverFields
+{
+    /// Topography
+    VectorX<T> topo_;
+
+    /// Height in z-coordinates
+    Field<T> zhtold_;
+    Field<T> zhtnow_;
+
+    /// Horizontal velocity
+    Field<T> uold_;
+    Field<T> unow_;
+    Field<T> unew_;
+
+    /// Isentropic density
+    Field<T> sold_;
+    Field<T> snow_;
+    Field<T> snew_;
+
+    /// Montgomery potential
+    Field<T> mtg_;
+
+    /// Exner function
+    Field<T> exn_;
+
+    /// Pressure
+    Field<T> prs_;
+
+    /// Height-dependent diffusion coefficient
+    VectorX<T> tau_;
+
+    /// Upstream profile for theta
+    VectorX<T> th0_;
+
+    /// Precipitation
+    VectorX<T> prec_;
+
+    /// Accumulated precipitation
+    VectorX<T> tot_prec_;
+
+    /// Moisture tracers: water vapor, specific cloud and rain water content and, for the two-moment scheme, the
+    /// cloud- and rain-droplet number densities (see Tracer::Index)
+    TracerField<T> qold_;
+    TracerField<T> qnow_;
+    TracerField<T> qnew_;
+
+    /// Temperature
+    Field<T> temp_;
+
+    /// Isentropic density boundaries (1 denotes the leftern, 2 the rightern boundary)
+    VectorX<T> sbnd1_;
+    VectorX<T> sbnd2_;
+
+    /// Horizontal velocity boundaries
+    VectorX<T> ubnd1_;
+    VectorX<T> ubnd2_;
+
+    /// Moisture tracer boundaries (column t holds the boundary values of tracer t)
+    MatrixX<T> qbnd1_;
+    MatrixX<T> qbnd2_;
+
+    /// Leading dimension of all two-dimensional fields (shared by the staggered and unstaggered fields)
+    int ld_;
+
+    /// Register the two-dimensional fields (including the tracers) in @c mats and the vectors in @c vecs by their
+    /// names (see Solver::getMat and Solver::getVec)
+    void registerFields(std::map<std::string, Field<T>*>& mats, std::map<std::string, VectorX<T>*>& vecs);
+
+    /// @brief Convert all fields of @c other to the scalar type @c T and release the fields of @c other
+    ///
+    /// The fields are converted one after another, hence the memory of at most one field is held twice.
+    ///
+    /// @throw std::bad_alloc if out of memory
+    template <class U>
+    void convertFrom(SolverFields<U>& other);
+};
+
+ISEN_NAMESPACE_END
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_SOLVER_FUSED_H
+#define ISEN_SOLVER_FUSED_H
+
+#include <Isen/Common.h>
+#include <Isen/SolverCpu.h>
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Multi threaded CPU version with a fused prognostic step
+///
+/// The prognostic step (isentropic density, velocity and moisture), the boundary exchange, the horizontal diffusion
+/// and the clipping of the moisture variables only couple grid points within the same vertical level. They are
+/// therefore executed in a single sweep over the levels, each level being processed while it resides in cache.
+class SolverFused : public SolverCpu
+{
+public:
+    using Base = SolverCpu;
+
+    /// @brief Allocate memory
+    ///
+    /// @throw IsenException if out of memory
+    SolverFused(std::shared_ptr<NameList> namelist, Output::ArchiveType archiveType = Output::ArchiveType::Text);
+
+    /// Run the time loop of Solver (the fused prognostic step opens its own parallel region)
+    virtual void run() override { Solver::run(); }
+
+    /// Advance all prognostic fields by one time step in a single pass
+    virtual void prognosticStep() noexcept override;
+
+    /// Free all memory
+    virtual ~SolverFused() {}
+};
+
+ISEN_NAMESPACE_END
+
+#endif
@@ -0,0 +1,101 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_SOLVER_MPI_H
+#define ISEN_SOLVER_MPI_H
+
+#include <Isen/Common.h>
+#include <Isen/SolverCpu.h>
+
+#ifdef ISEN_MPI
+
+#include <Isen/Decomposition.h>
+#include <memory>
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Distributed memory version of SolverCpu decomposing the x-domain over the MPI ranks
+///
+/// Each rank advances the dry dynamics of its slab of the domain (see Decomposition) with the kernels of SolverCpu,
+/// the boundary conditions are replaced by halo exchanges. The exchange of the prognostic fields is overlapped with
+/// the diffusion of the interior of the slab, the exchange of the diffused fields with the diagnostic step of the
+/// owned columns (the halos are diagnosed afterwards). The results are bitwise identical to SolverCpu.
+///
+/// All ranks initialize the global fields (see Solver::init), they are assembled again from the slabs at the output
+/// steps (on the first rank) and at the end of the simulation (on all ranks). Only the first rank keeps and writes the
+/// output, the other ranks discard their frames. MPI is initialized on first use if the application hasn't done so (and finalized at exit). Checkpoints are
+/// assembled and written by the first rank, a restarted simulation (see Solver::restart) scatters the restored global
+/// fields.
+///
+/// Moist simulations fall back to the SolverCpu implementation, i.e every rank computes the whole domain.
+class SolverMpi : public SolverCpu
+{
+public:
+    using Base = SolverCpu;
+
+    /// @brief Allocate memory
+    ///
+    /// @throw IsenException if out of memory or the domain is too small for the number of ranks
+    SolverMpi(std::shared_ptr<NameList> namelist, Output::ArchiveType archiveType = Output::ArchiveType::Text);
+
+    /// Run the simulation
+    virtual void run() override;
+
+    /// Write the simulation to the output file (first rank only)
+    virtual void write(std::string filename = "") override;
+
+    /// Free all memory
+    virtual ~SolverMpi() {}
+
+private:
+    /// Copy the slab of the calling rank out of the global fields
+    void scatterFields();
+
+    /// Assemble the global fields from the slabs (on all ranks if @c all is true)
+    void gatherFields(bool all);
+
+    /// Extrapolate the old time level of the slab (see Solver::rescaleOldTimeLevel)
+    void rescaleOldTimeLevelLocal(double ratio) noexcept;
+
+    std::unique_ptr<Decomposition> decomposition_;
+
+    /// Leading dimension of the local fields
+    int ldLocal_;
+
+    //-------------------------------------------------
+    // Local fields of the slab (see Solver)
+    //-------------------------------------------------
+    VectorXf topoLocal_;
+
+    FieldXf zhtoldLocal_;
+    FieldXf zhtnowLocal_;
+
+    FieldXf uoldLocal_;
+    FieldXf unowLocal_;
+    FieldXf unewLocal_;
+
+    FieldXf soldLocal_;
+    FieldXf snowLocal_;
+    FieldXf snewLocal_;
+
+    FieldXf mtgLocal_;
+    FieldXf exnLocal_;
+    FieldXf prsLocal_;
+};
+
+ISEN_NAMESPACE_END
+
+#endif
+
+#endif
@@ -0,0 +1,128 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_TIME_CONTROL_H
+#define ISEN_TIME_CONTROL_H
+
+#include <Isen/Common.h>
+#include <Isen/NameList.h>
+#include <algorithm>
+#include <cmath>
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Time step control of the leapfrog scheme
+///
+/// With a fixed time step (default), the simulation takes NameList::nts steps of NameList::dt and produces an output
+/// every NameList::iout-th step. With NameList::iadapt, the time step is adapted after each step such that the CFL
+/// number of the fastest signal reaches NameList::cfl_target, bounded by the growth and shrink rates NameList::dt_grow
+/// and NameList::dt_shrink and by NameList::dt_max. The outputs are produced at the same times @c n * iout * dt as with the
+/// fixed time step: the steps are shortened to land exactly on the output times and on the end of the simulation.
+///
+/// The leapfrog scheme requires the old time level to lie one time step in the past. If the time step changes, the
+/// solver has to extrapolate the old time level linearly to the new time step (see TimeControl::oldLevelRatio and
+/// Solver::rescaleOldTimeLevel).
+class TimeControl
+{
+public:
+    /// @brief Initialize the time step control
+    ///
+    /// @throw IsenException if the parameters of the adaptive time step are invalid
+    TimeControl(const NameList& namelist);
+
+    /// Check if the end of the simulation has not been reached yet
+    bool running() const noexcept { return adaptive_ ? time_ < timeEnd_ : step_ < nts_; }
+
+    /// Begin the next time step (sets the time step, the time and the output flag)
+    void advance() noexcept;
+
+    /// @brief Adapt the next time step to the signal speed of the current time step
+    ///
+    /// The fastest signal is an external gravity wave (see TimeControl::waveSpeed) advected by the maximum velocity
+    /// @c umax, i.e the time step is chosen such that (umax + cwave) * dt / dx = NameList::cfl_target. Has no effect if
+    /// the time step is fixed.
+    void adapt(double umax, double cwave) noexcept;
+
+    /// @brief Speed of the external gravity wave sqrt(g * H) [m/s]
+    ///
+    /// H is the maximal depth of the model atmosphere, given by the staggered geometric height @c zht with @c nz1
+    /// levels.
+    template <class Matrix>
+    static double waveSpeed(const Matrix& zht, int nz1, double g) noexcept
+    {
+        double depth = 0;
+        for(int i = 0; i < zht.rows(); ++i)
+            depth = std::max(depth, double(zht(i, nz1 - 1) - zht(i, 0)));
+        return std::sqrt(g * depth);
+    }
+
+    /// Check if the time step is adaptive
+    bool isAdaptive() const noexcept { return adaptive_; }
+
+    /// Index of the current time step (starting at 1)
+    int step() const noexcept { return step_; }
+
+    /// Time at the end of the current time step [s]
+    double time() const noexcept { return time_; }
+
+    /// Current time step [s]
+    double dt() const noexcept { return dt_; }
+
+    /// Time step divided by the grid spacing (halved in the first time step, which is a forward step)
+    double dtdx() const noexcept { return step_ == 1 ? 0.5 * dt_ / dx_ : dt_ / dx_; }
+
+    /// Ratio of the current to the previous time step (one if the old time level needs no extrapolation)
+    double oldLevelRatio() const noexcept { return ratio_; }
+
+    /// Check if an output has to be produced at the end of the current time step
+    bool isOutputStep() const noexcept { return output_; }
+
+    /// @brief Number of steps of NameList::dt completed so far
+    ///
+    /// This is the index of the current time step with a fixed time step and serves as the progress of the simulation.
+    int progress() const noexcept;
+
+    /// Store the state of the time step control in @c checkpoint (see Solver::restart)
+    void save(Checkpoint& checkpoint) const;
+
+    /// @brief Restore the state of the time step control from @c checkpoint
+    ///
+    /// @throw IsenException if the checkpoint holds no time step control
+    void load(const Checkpoint& checkpoint);
+
+private:
+    bool adaptive_;
+    int nts_;
+    int iout_;
+    double dt0_;
+    double dx_;
+    double timeEnd_;
+
+    double cflTarget_;
+    double grow_;
+    double shrink_;
+    double dtMax_;
+
+    int step_;
+    int nout_;      ///< Number of outputs produced so far
+    double time_;
+    double dt_;
+    double dtNext_; ///< Time step proposed by the controller (before shortening to the output times)
+    double ratio_;
+    bool output_;
+};
+
+ISEN_NAMESPACE_END
+
+#endif
@@ -0,0 +1,125 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_TRACER_H
+#define ISEN_TRACER_H
+
+#include <Isen/Common.h>
+#include <Isen/Field.h>
+#include <vector>
+
+ISEN_NAMESPACE_BEGIN
+
+/// Moisture tracers advected by the model
+struct Tracer
+{
+    /// Position of the tracers in a TracerField
+    enum Index : int
+    {
+        QV = 0, ///< Water vapor
+        QC,     ///< Specific cloud water content
+        QR,     ///< Specific rain water content
+        NC,     ///< Cloud-droplet number density (two-moment scheme only)
+        NR      ///< Rain-droplet number density (two-moment scheme only)
+    };
+
+    /// Number of tracers of the microphysics scheme @c imicrophys (see NameList)
+    static int count(int imicrophys) noexcept { return imicrophys == 2 ? 5 : 3; }
+};
+
+/// @brief All tracers of one time level, stored in a single allocation
+///
+/// The tracers are blocked: tracer @c t occupies the elements [t * stride(), (t + 1) * stride()) of data() and each
+/// block is a padded field of size rows() x cols() with leading dimension ld() (see Field). A kernel can therefore
+/// process all tracers of a level in a single pass given the base pointer and the stride (see kernel_progTracers),
+/// whereas every tracer is still accessible as an ordinary Field via operator[].
+template <class T>
+class TracerField
+{
+public:
+    TracerField() noexcept : stride_(0) {}
+
+    TracerField(const TracerField&) = delete;
+    TracerField& operator=(const TracerField&) = delete;
+
+    /// @brief Resize to @c numTracers tracers of size @c rows x @c cols with leading dimension @c ld
+    /// (Field::leadingDimension if negative)
+    ///
+    /// The content is undefined after the call.
+    ///
+    /// @throw std::bad_alloc if out of memory
+    void resize(int numTracers, int rows, int cols, int ld = -1)
+    {
+        ld = ld < 0 ? Field<T>::leadingDimension(rows) : ld;
+        stride_ = ld * cols;
+
+        // One column of the buffer per tracer, every block is thus aligned to Field::Alignment
+        buffer_.resize(stride_, numTracers, stride_);
+
+        tracers_.resize(numTracers);
+        for(int t = 0; t < numTracers; ++t)
+            tracers_[t] = Field<T>(buffer_.data() + std::size_t(t) * stride_, rows, cols, ld);
+    }
+
+    /// @brief Exchange the tracers of the two time levels in O(1)
+    ///
+    /// The tracers are swapped in place, hence references and pointers to the Fields remain valid (and refer to the
+    /// same time level as before).
+    void swap(TracerField& other) noexcept
+    {
+        assert(tracers_.size() == other.tracers_.size());
+
+        buffer_.swap(other.buffer_);
+        std::swap(stride_, other.stride_);
+        for(std::size_t t = 0; t < tracers_.size(); ++t)
+            tracers_[t].swap(other.tracers_[t]);
+    }
+
+    /// Access tracer @c t (see Tracer::Index)
+    Field<T>& operator[](int t) noexcept
+    {
+        assert(t >= 0 && t < size());
+        return tracers_[t];
+    }
+    const Field<T>& operator[](int t) const noexcept
+    {
+        assert(t >= 0 && t < size());
+        return tracers_[t];
+    }
+
+    /// Number of tracers
+    int size() const noexcept { return static_cast<int>(tracers_.size()); }
+
+    /// Pointer to the first tracer
+    T* data() noexcept { return buffer_.data(); }
+    const T* data() const noexcept { return buffer_.data(); }
+
+    /// Distance of two tracers in elements
+    int stride() const noexcept { return stride_; }
+
+    /// Number of allocated elements (stride() * size())
+    std::size_t capacity() const noexcept { return buffer_.capacity(); }
+
+private:
+    Field<T> buffer_;
+    std::vector<Field<T>> tracers_;
+    int stride_;
+};
+
+/// Tracers in double precision
+using TracerXf = TracerField<double>;
+
+ISEN_NAMESPACE_END
+
+#endif
@@ -28,9 +28,15 @@
 
 ISEN_NAMESPACE_BEGIN
 
+/// Eigen3 typedefs of the fields templated on the scalar type (matrices are stored in ColMajor order)
+template <class T>
+using MatrixX = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+template <class T>
+using VectorX = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
 /// Eigen3 typedefs (matrices are stored in ColMajor order)
-using MatrixXf = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>;
-using VectorXf = Eigen::Matrix<double, Eigen::Dynamic, 1>;
+using MatrixXf = MatrixX<double>;
+using VectorXf = VectorX<double>;
 using MatrixXi = Eigen::Matrix<int, Eigen::Dynamic, Eigen::Dynamic>;
 using VectorXi = Eigen::Matrix<int, Eigen::Dynamic, 1>;
 using Vector2f = Eigen::Matrix<double, 2, 1>;
@@ -0,0 +1,236 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#include <Isen/Checkpoint.h>
+#include <Isen/NameList.h>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/filesystem.hpp>
+#include <cstdio>
+#include <limits>
+#include <sstream>
+
+ISEN_NAMESPACE_BEGIN
+
+namespace
+{
+
+const char magic[8] = {'I', 'S', 'E', 'N', 'C', 'K', 'P', 'T'};
+const std::uint32_t version = 1;
+
+/// Close the file on scope exit
+struct FileGuard
+{
+    std::FILE* file;
+    ~FileGuard()
+    {
+        if(file)
+            std::fclose(file);
+    }
+};
+
+template <class T>
+inline bool writeValue(std::FILE* file, T value)
+{
+    return std::fwrite(&value, sizeof(T), 1, file) == 1;
+}
+
+template <class T>
+inline bool readValue(std::FILE* file, T& value)
+{
+    return std::fread(&value, sizeof(T), 1, file) == 1;
+}
+
+} // anonymous namespace
+
+void Checkpoint::write(const std::string& filename) const
+{
+    const std::string tmpFilename = filename + ".tmp";
+    bool ok = true;
+    {
+        FileGuard guard{std::fopen(tmpFilename.c_str(), "wb")};
+        if(!guard.file)
+            throw IsenException("failed to open file: %s", tmpFilename);
+
+        ok &= std::fwrite(magic, sizeof(magic), 1, guard.file) == 1;
+        ok &= writeValue(guard.file, version);
+        ok &= writeValue(guard.file, static_cast<std::uint32_t>(records_.size()));
+
+        for(const auto& r : records_)
+        {
+            const std::string& name = r.first;
+            const Record& record = r.second;
+
+            ok &= writeValue(guard.file, static_cast<std::uint32_t>(name.size()));
+            ok &= std::fwrite(name.data(), 1, name.size(), guard.file) == name.size();
+            ok &= writeValue(guard.file, static_cast<std::uint32_t>(record.type));
+            ok &= writeValue(guard.file, static_cast<std::uint64_t>(record.rows));
+            ok &= writeValue(guard.file, static_cast<std::uint64_t>(record.cols));
+            ok &= std::fwrite(record.data.data(), 1, record.data.size(), guard.file) == record.data.size();
+        }
+
+        ok &= std::fclose(guard.file) == 0;
+        guard.file = nullptr;
+    }
+
+    if(!ok || std::rename(tmpFilename.c_str(), filename.c_str()) != 0)
+    {
+        std::remove(tmpFilename.c_str());
+        throw IsenException("failed to write checkpoint: %s", filename);
+    }
+}
+
+void Checkpoint::read(const std::string& filename)
+{
+    FileGuard guard{std::fopen(filename.c_str(), "rb")};
+    if(!guard.file)
+        throw IsenException("failed to open file: %s", filename);
+
+    auto corrupt = [&]() { return IsenException("'%s' is not a valid checkpoint", filename); };
+
+    // The sizes in the headers are checked against the remaining bytes of the file before allocating the records (a
+    // truncated or foreign file would otherwise cause huge allocations or garbage fields)
+    boost::system::error_code ec;
+    std::uint64_t remaining = boost::filesystem::file_size(filename, ec);
+    if(ec)
+        throw IsenException("failed to open file: %s", filename);
+
+    auto consume = [&](std::uint64_t size) {
+        if(size > remaining)
+            throw IsenException("'%s' is not a valid checkpoint (truncated file)", filename);
+        remaining -= size;
+    };
+
+    char fileMagic[sizeof(magic)];
+    std::uint32_t fileVersion, numRecords;
+    if(std::fread(fileMagic, sizeof(fileMagic), 1, guard.file) != 1
+       || std::memcmp(fileMagic, magic, sizeof(magic)) != 0 || !readValue(guard.file, fileVersion)
+       || !readValue(guard.file, numRecords))
+        throw corrupt();
+    consume(sizeof(fileMagic) + sizeof(fileVersion) + sizeof(numRecords));
+
+    if(fileVersion != version)
+        throw IsenException("unsupported version %i of checkpoint '%s'", fileVersion, filename);
+
+    static const std::size_t sizeOf[] = {sizeof(char), sizeof(int), sizeof(float), sizeof(double)};
+
+    std::map<std::string, Record> records;
+    for(std::uint32_t n = 0; n < numRecords; ++n)
+    {
+        std::uint32_t nameSize, type;
+        std::uint64_t rows, cols;
+
+        if(!readValue(guard.file, nameSize))
+            throw corrupt();
+        consume(sizeof(nameSize) + std::uint64_t(nameSize));
+
+        std::string name(nameSize, '\0');
+        if(std::fread(&name[0], 1, nameSize, guard.file) != nameSize || !readValue(guard.file, type)
+           || !readValue(guard.file, rows) || !readValue(guard.file, cols) || type > Double)
+            throw corrupt();
+        consume(sizeof(type) + sizeof(rows) + sizeof(cols));
+
+        const std::uint64_t maxDim = std::numeric_limits<int>::max();
+        if(rows > maxDim || cols > maxDim || (rows != 0 && cols > remaining / sizeOf[type] / rows))
+            throw IsenException("'%s' is not a valid checkpoint (record '%s' has %i x %i elements)", filename, name,
+                                rows, cols);
+        consume(rows * cols * sizeOf[type]);
+
+        Record& record = records[name];
+        record.type = static_cast<Type>(type);
+        record.rows = static_cast<int>(rows);
+        record.cols = static_cast<int>(cols);
+        record.data.resize(rows * cols * sizeOf[type]);
+        if(std::fread(record.data.data(), 1, record.data.size(), guard.file) != record.data.size())
+            throw corrupt();
+    }
+
+    records_.swap(records);
+}
+
+void Checkpoint::setNameList(const NameList& namelist)
+{
+    std::ostringstream sout;
+    {
+        boost::archive::binary_oarchive oa(sout);
+        oa << namelist;
+    }
+    const std::string str = sout.str();
+    add("namelist", str.data(), static_cast<int>(str.size()), 1, static_cast<int>(str.size()));
+}
+
+std::shared_ptr<NameList> Checkpoint::getNameList() const
+{
+    std::vector<char> buffer;
+    get("namelist", buffer);
+
+    auto namelist = std::make_shared<NameList>();
+    std::istringstream sin(std::string(buffer.begin(), buffer.end()));
+    boost::archive::binary_iarchive ia(sin);
+    ia >> *namelist;
+    namelist->update();
+    return namelist;
+}
+
+const Checkpoint::Record& Checkpoint::find(const std::string& name, Type type) const
+{
+    auto it = records_.find(name);
+    if(it == records_.end())
+        throw IsenException("checkpoint: no record named '%s'", name);
+    if(it->second.type != type)
+        throw IsenException("checkpoint: record '%s' has an unexpected type", name);
+    return it->second;
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+    try
+    {
+        wait();
+    }
+    catch(const std::exception& e)
+    {
+        warning("isen", e.what());
+    }
+}
+
+void CheckpointWriter::write(std::shared_ptr<const Checkpoint> checkpoint, const std::string& filename)
+{
+    wait();
+
+    thread_ = std::thread([this, checkpoint, filename]() {
+        try
+        {
+            checkpoint->write(filename);
+        }
+        catch(...)
+        {
+            exception_ = std::current_exception();
+        }
+    });
+}
+
+void CheckpointWriter::wait()
+{
+    if(thread_.joinable())
+        thread_.join();
+
+    if(exception_)
+    {
+        std::exception_ptr exception = exception_;
+        exception_ = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+ISEN_NAMESPACE_END
@@ -12,6 +12,8 @@
  */
 
 #include <Isen/CommandLine.h>
+#include <Isen/Numa.h>
+#include <Isen/Simd.h>
 #include <Isen/Terminal.h>
 #include <boost/filesystem.hpp>
 #include <boost/version.hpp>
@@ -46,7 +48,11 @@ CommandLine::CommandLine() : desc_("Options", Terminal::getWidth())
         ("file,f", po::value<std::vector<std::string>>(),
          "Specify the input file(s) which will be parsed. Usually a valid "
          "MATLAB (.m) or Python (.py) file containing the input variables (namelist). "
-         "Multiple files will be parsed/executed one after another.")
+         "Multiple files will be parsed/executed one after another (see --jobs).")
+        // --restart
+        ("restart", po::value<std::string>(), "Continue the simulation of the given checkpoint file (written every "
+                                              "icheckpoint-th time step). The NameList is taken from the checkpoint, "
+                                              "no input file is required.")
         // --no-output
         ("no-output", "Don't write simulation to output file.")
         // --print-namelist
@@ -61,12 +67,55 @@ CommandLine::CommandLine() : desc_("Options", Terminal::getWidth())
         ("solver,s", po::value<std::string>(), "Set the solver implementation. Allowed values are:"
                                                 "\n ref - Refrence implementation"
                                                 "\n cpu - Parallel cpu optimized implementation"
+                                                "\n cpu-f32 - Parallel cpu implementation in single precision"
+                                                "\n cpu-mixed - Parallel cpu implementation with single precision "
+                                                "storage of the old time levels (same as 'cpu' with imixprec=1)"
+                                                "\n fused - Parallel cpu implementation with a fused prognostic step"
+                                                "\n blocked - Parallel cpu implementation with temporal blocking"
+                                                "\n mpi - Distributed memory implementation decomposing the x-domain "
+                                                "over the MPI ranks (launch with mpirun)"
                                                 "\nBy default the cpu implementation is used.")
+        // --simd
+        ("simd", po::value<std::string>(), "Set the SIMD instruction set of the cpu kernels. Allowed values are:"
+                                           "\n scalar - No explicit vectorization"
+                                           "\n sse4.2 - 128-bit SSE4.2"
+                                           "\n avx2   - 256-bit AVX2"
+                                           "\n avx512 - 512-bit AVX-512F"
+                                           "\nBy default the widest instruction set supported by the CPU is used.")
+        // --numa
+        ("numa", po::value<std::string>(), "Set the NUMA placement policy of the fields. Allowed values are:"
+                                           "\n first-touch - Parallel initialization with the partitioning of the "
+                                           "kernels (bind the threads with OMP_PROC_BIND)"
+                                           "\n interleave  - Interleave the pages over all nodes (requires libnuma)"
+                                           "\n bind        - Bind the pages to the node of the main thread (requires "
+                                           "libnuma)"
+                                           "\nBy default the first-touch policy is used.")
+        // --ensemble
+        ("ensemble", "Advance the simulations of all input files together as one ensemble. The members have to share "
+                     "the grid and the time stepping (nx, nz, dt, time, ...) but may differ in all physical "
+                     "parameters. The solver implementation is ignored.")
+        // --jobs, -j
+        ("jobs,j", po::value<int>(), "Run the simulations of the input files as a batch with N concurrent jobs. The "
+                                     "cores are partitioned among the jobs, each simulation runs in a process of its "
+                                     "own such that a failing simulation doesn't affect the others. A summary "
+                                     "(status, runtime and output file) of all input files is printed in the end.")
+        // --summary
+        ("summary", po::value<std::string>(), "Write the summary of the batch (see --jobs) to the given file instead "
+                                              "of printing it.")
+        // --verify
+        ("verify", "Run the cpu implementation (double precision) alongside and report the deviation of the final "
+                   "fields from it.")
         // --archive, -a
         ("archive,a", po::value<std::string>(), "Set the archive type of the output file(s). Allowed values are:"
                                                 "\n text - A portable plain text archive"
                                                 "\n xml  - A portable XML archive"
                                                 "\n bin  - A non-portable native binary archive"
+                                                "\n stream - A non-portable native binary archive whose"
+                                                "\n          frames are written during the simulation"
+                                                "\n mapped - A memory-mappable native binary archive"
+                                                "\n          whose frames can be read individually"
+                                                "\n chunked - A compressed archive of chunks written"
+                                                "\n           during the simulation (see 'compression')"
                                                 "\nBy default a plain text archive is being used.")
         // --parsing-style
         ("parsing-style", po::value<std::string>(),
@@ -102,9 +151,15 @@ void CommandLine::parse(int argc, const char* const argv[])
         po::notify(variableMap_);
 
         // Validation
-        validate<std::string>("archive", variableMap_, {"text", "xml", "bin"});
-        validate<std::string>("solver", variableMap_, {"ref", "cpu"});        
+        validate<std::string>("archive", variableMap_, {"text", "xml", "bin", "stream", "mapped", "chunked"});
+        validate<std::string>("solver", variableMap_, {"ref", "cpu", "cpu-f32", "cpu-mixed", "fused", "blocked", "mpi"});        
         validate<std::string>("parsing-style", variableMap_, {"matlab", "python"});
+        validate<std::string>("simd", variableMap_, {"scalar", "sse4.2", "avx2", "avx512"});
+        validate<std::string>("numa", variableMap_, {"first-touch", "interleave", "bind"});
+
+        if(variableMap_.count("jobs") && variableMap_["jobs"].as<int>() < 1)
+            throw po::validation_error(po::validation_error::invalid_option_value, "jobs",
+                                       std::to_string(variableMap_["jobs"].as<int>()));
     }
     catch(const std::exception& e)
     {
@@ -139,6 +194,16 @@ void CommandLine::printVersion() noexcept
     // Boost version
     std::cout << " - Boost version: " << BOOST_LIB_VERSION << "\n";
 
+    // SIMD instruction set selected at startup
+    std::cout << " - SIMD instruction set: " << Simd::toString(Simd::get()) << "\n";
+
+    // NUMA support
+#ifdef ISEN_NUMA
+    std::cout << " - NUMA: libnuma (" << Numa::numNodes() << (Numa::numNodes() == 1 ? " node" : " nodes") << ")\n";
+#else
+    std::cout << " - NUMA: first-touch only (no libnuma)\n";
+#endif
+
     // Python version
 #ifdef ISEN_PYTHON
     std::cout << " - Python version: " << ISEN_PYTHON_VERSION_STRING << "\n";
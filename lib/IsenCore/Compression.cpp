@@ -0,0 +1,224 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#include <Isen/Compression.h>
+#include <cstring>
+
+#ifdef ISEN_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef ISEN_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef ISEN_ZSTD
+#include <zstd.h>
+#endif
+
+ISEN_NAMESPACE_BEGIN
+
+namespace
+{
+
+/// Byte k of value i is moved to position k * n + i
+void shuffle(const void* data, std::size_t n, std::size_t typeSize, char* out) noexcept
+{
+    const char* src = static_cast<const char*>(data);
+    for(std::size_t i = 0; i < n; ++i)
+        for(std::size_t k = 0; k < typeSize; ++k)
+            out[k * n + i] = src[i * typeSize + k];
+}
+
+void unshuffle(const char* in, std::size_t n, std::size_t typeSize, void* data) noexcept
+{
+    char* dst = static_cast<char*>(data);
+    for(std::size_t k = 0; k < typeSize; ++k)
+        for(std::size_t i = 0; i < n; ++i)
+            dst[i * typeSize + k] = in[k * n + i];
+}
+
+} // anonymous namespace
+
+bool Compression::isAvailable(CompressionCodec codec) noexcept
+{
+    switch(codec)
+    {
+        case CompressionCodec::None:
+            return true;
+#ifdef ISEN_ZLIB
+        case CompressionCodec::Zlib:
+            return true;
+#endif
+#ifdef ISEN_LZ4
+        case CompressionCodec::Lz4:
+            return true;
+#endif
+#ifdef ISEN_ZSTD
+        case CompressionCodec::Zstd:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+CompressionCodec Compression::fromString(const std::string& name)
+{
+    CompressionCodec codec;
+    if(name == "auto")
+    {
+        for(CompressionCodec c : {CompressionCodec::Zstd, CompressionCodec::Lz4, CompressionCodec::Zlib})
+            if(isAvailable(c))
+                return c;
+        return CompressionCodec::None;
+    }
+    else if(name == "none")
+        codec = CompressionCodec::None;
+    else if(name == "zlib")
+        codec = CompressionCodec::Zlib;
+    else if(name == "lz4")
+        codec = CompressionCodec::Lz4;
+    else if(name == "zstd")
+        codec = CompressionCodec::Zstd;
+    else
+        throw IsenException("unknown compression '%s' (expected none, zlib, lz4, zstd or auto)", name);
+
+    if(!isAvailable(codec))
+        throw IsenException("compression '%s' is not available in this build", name);
+    return codec;
+}
+
+const char* Compression::toString(CompressionCodec codec) noexcept
+{
+    switch(codec)
+    {
+        case CompressionCodec::None:
+            return "none";
+        case CompressionCodec::Zlib:
+            return "zlib";
+        case CompressionCodec::Lz4:
+            return "lz4";
+        case CompressionCodec::Zstd:
+            return "zstd";
+        default:
+            return "unknown";
+    }
+}
+
+void Compression::compress(CompressionCodec codec, const void* data, std::size_t n, std::size_t typeSize,
+                           std::vector<char>& out)
+{
+    const std::size_t size = n * typeSize;
+    if(codec == CompressionCodec::None)
+    {
+        out.resize(size);
+        shuffle(data, n, typeSize, out.data());
+        return;
+    }
+
+    std::vector<char> shuffled(size);
+    shuffle(data, n, typeSize, shuffled.data());
+
+    switch(codec)
+    {
+#ifdef ISEN_ZLIB
+        case CompressionCodec::Zlib:
+        {
+            uLongf outSize = compressBound(static_cast<uLong>(size));
+            out.resize(outSize);
+            if(compress2(reinterpret_cast<Bytef*>(out.data()), &outSize,
+                         reinterpret_cast<const Bytef*>(shuffled.data()), static_cast<uLong>(size), Z_BEST_SPEED)
+               != Z_OK)
+                throw IsenException("zlib: compression failed");
+            out.resize(outSize);
+            return;
+        }
+#endif
+#ifdef ISEN_LZ4
+        case CompressionCodec::Lz4:
+        {
+            out.resize(LZ4_compressBound(static_cast<int>(size)));
+            const int outSize = LZ4_compress_default(shuffled.data(), out.data(), static_cast<int>(size),
+                                                     static_cast<int>(out.size()));
+            if(outSize <= 0)
+                throw IsenException("lz4: compression failed");
+            out.resize(outSize);
+            return;
+        }
+#endif
+#ifdef ISEN_ZSTD
+        case CompressionCodec::Zstd:
+        {
+            out.resize(ZSTD_compressBound(size));
+            const std::size_t outSize = ZSTD_compress(out.data(), out.size(), shuffled.data(), size, 1);
+            if(ZSTD_isError(outSize))
+                throw IsenException("zstd: %s", ZSTD_getErrorName(outSize));
+            out.resize(outSize);
+            return;
+        }
+#endif
+        default:
+            throw IsenException("compression '%s' is not available in this build", toString(codec));
+    }
+}
+
+void Compression::decompress(CompressionCodec codec, const char* src, std::size_t size, void* data, std::size_t n,
+                             std::size_t typeSize)
+{
+    const std::size_t outSize = n * typeSize;
+    if(codec == CompressionCodec::None)
+    {
+        if(size != outSize)
+            throw IsenException("corrupted block (%i bytes, expected %i)", size, outSize);
+        unshuffle(src, n, typeSize, data);
+        return;
+    }
+
+    std::vector<char> shuffled(outSize);
+    bool ok = false;
+
+    switch(codec)
+    {
+#ifdef ISEN_ZLIB
+        case CompressionCodec::Zlib:
+        {
+            uLongf destSize = static_cast<uLongf>(outSize);
+            ok = uncompress(reinterpret_cast<Bytef*>(shuffled.data()), &destSize,
+                            reinterpret_cast<const Bytef*>(src), static_cast<uLong>(size))
+                     == Z_OK
+                 && destSize == outSize;
+            break;
+        }
+#endif
+#ifdef ISEN_LZ4
+        case CompressionCodec::Lz4:
+            ok = LZ4_decompress_safe(src, shuffled.data(), static_cast<int>(size), static_cast<int>(outSize))
+                 == static_cast<int>(outSize);
+            break;
+#endif
+#ifdef ISEN_ZSTD
+        case CompressionCodec::Zstd:
+            ok = ZSTD_decompress(shuffled.data(), outSize, src, size) == outSize;
+            break;
+#endif
+        default:
+            throw IsenException("compression '%s' is not available in this build", toString(codec));
+    }
+
+    if(!ok)
+        throw IsenException("%s: corrupted block", toString(codec));
+    unshuffle(shuffled.data(), n, typeSize, data);
+}
+
+ISEN_NAMESPACE_END
@@ -0,0 +1,242 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#include <Isen/Boundary.h>
+#include <Isen/Decomposition.h>
+
+#ifdef ISEN_MPI
+
+ISEN_NAMESPACE_BEGIN
+
+Decomposition::Decomposition(int nx, int nb, bool periodic, MPI_Comm comm)
+    : comm_(comm), nx_(nx), nb_(nb), periodic_(periodic), numFields_(0)
+{
+    MPI_Comm_rank(comm_, &rank_);
+    MPI_Comm_size(comm_, &size_);
+
+    // Balanced slabs, the halo exchange with the direct neighbours requires at least 2 * nb points per rank
+    if(nx < 2 * nb * size_)
+        throw IsenException("cannot decompose %i points over %i ranks (at least %i points per rank are required)", nx,
+                            size_, 2 * nb);
+
+    begin_.resize(size_);
+    nxLocal_.resize(size_);
+    for(int r = 0; r < size_; ++r)
+    {
+        begin_[r] = nb + static_cast<int>((static_cast<long long>(r) * nx) / size_);
+        nxLocal_[r] = nb + static_cast<int>((static_cast<long long>(r + 1) * nx) / size_) - begin_[r];
+    }
+
+    left_ = rank_ > 0 ? rank_ - 1 : (periodic_ ? size_ - 1 : MPI_PROC_NULL);
+    right_ = rank_ < size_ - 1 ? rank_ + 1 : (periodic_ ? 0 : MPI_PROC_NULL);
+}
+
+Decomposition::~Decomposition()
+{
+    if(!requests_.empty())
+        MPI_Waitall(static_cast<int>(requests_.size()), requests_.data(), MPI_STATUSES_IGNORE);
+}
+
+void Decomposition::ownedRows(int rank, Grid grid, int& first, int& last) const noexcept
+{
+    first = rank == 0 ? 0 : nb_;
+    last = rank == size_ - 1 ? nxLocal_[rank] + 2 * nb_ + (grid == Staggered) : nxLocal_[rank] + nb_;
+}
+
+void Decomposition::scatter(const FieldXf& global, FieldXf& local, Grid grid) const noexcept
+{
+    const int offset = begin() - nb_;
+    const int rows = this->rows(grid);
+
+    for(int k = 0; k < local.cols(); ++k)
+        for(int j = 0; j < rows; ++j)
+            local.data()[k * local.ld() + j] = global.data()[k * global.ld() + offset + j];
+}
+
+void Decomposition::scatter(const VectorXf& global, VectorXf& local) const
+{
+    local = global.segment(begin() - nb_, global.size() - nx_ + nxLocal());
+}
+
+void Decomposition::gather(const FieldXf& local, FieldXf& global, Grid grid, bool all)
+{
+    const int cols = local.cols();
+
+    // Owned rows of each rank (level by level)
+    std::vector<int> counts(size_), displs(size_);
+    for(int r = 0, displ = 0; r < size_; ++r)
+    {
+        int first, last;
+        ownedRows(r, grid, first, last);
+        counts[r] = (last - first) * cols;
+        displs[r] = displ;
+        displ += counts[r];
+    }
+
+    int first, last;
+    ownedRows(rank_, grid, first, last);
+
+    std::vector<double> sendbuf(counts[rank_]);
+    for(int k = 0, c = 0; k < cols; ++k)
+        for(int j = first; j < last; ++j)
+            sendbuf[c++] = local.data()[k * local.ld() + j];
+
+    std::vector<double> recvbuf(displs.back() + counts.back());
+    if(all)
+        MPI_Allgatherv(sendbuf.data(), counts[rank_], MPI_DOUBLE, recvbuf.data(), counts.data(), displs.data(),
+                       MPI_DOUBLE, comm_);
+    else
+    {
+        MPI_Gatherv(sendbuf.data(), counts[rank_], MPI_DOUBLE, recvbuf.data(), counts.data(), displs.data(),
+                    MPI_DOUBLE, 0, comm_);
+        if(rank_ != 0)
+            return;
+    }
+
+    for(int r = 0; r < size_; ++r)
+    {
+        ownedRows(r, grid, first, last);
+        const int offset = begin_[r] - nb_;
+
+        for(int k = 0, c = displs[r]; k < cols; ++k)
+            for(int j = first; j < last; ++j)
+                global.data()[k * global.ld() + offset + j] = recvbuf[c++];
+    }
+}
+
+void Decomposition::pack(Message& msg) noexcept
+{
+    for(int k = 0, c = 0; k < msg.cols; ++k)
+        for(int j = 0; j < msg.count; ++j)
+            msg.buffer[c++] = msg.data[k * msg.ld + msg.row + j];
+}
+
+void Decomposition::unpack(const Message& msg) noexcept
+{
+    for(int k = 0, c = 0; k < msg.cols; ++k)
+        for(int j = 0; j < msg.count; ++j)
+            msg.data[k * msg.ld + msg.row + j] = msg.buffer[c++];
+}
+
+void Decomposition::exchangeBegin(FieldXf& phi, Grid grid)
+{
+    const int nxl = nxLocal();
+    const bool staggered = grid == Staggered;
+
+    // The messages sent to the left neighbour carry the last staggered point of the neighbour, unless they wrap around
+    // the periodic domain (the staggered fields have a period of nx + 1)
+    const bool wrapLeft = rank_ == 0;
+    const bool wrapRight = rank_ == size_ - 1;
+
+    const int leftTag = 2 * numFields_;
+    const int rightTag = 2 * numFields_ + 1;
+    ++numFields_;
+
+    if(static_cast<int>(sends_.size()) < 2 * numFields_)
+    {
+        sends_.resize(2 * numFields_);
+        recvs_.resize(2 * numFields_);
+    }
+
+    auto post = [&](Message& msg, int row, int count, int neighbour, int tag, bool send) {
+        msg.data = phi.data();
+        msg.ld = phi.ld();
+        msg.cols = phi.cols();
+        msg.row = row;
+        msg.count = count;
+        msg.buffer.resize(count * phi.cols());
+
+        requests_.emplace_back();
+        if(send)
+        {
+            pack(msg);
+            MPI_Isend(msg.buffer.data(), static_cast<int>(msg.buffer.size()), MPI_DOUBLE, neighbour, tag, comm_,
+                      &requests_.back());
+        }
+        else
+            MPI_Irecv(msg.buffer.data(), static_cast<int>(msg.buffer.size()), MPI_DOUBLE, neighbour, tag, comm_,
+                      &requests_.back());
+    };
+
+    Message* recvs = &recvs_[2 * (numFields_ - 1)];
+    Message* sends = &sends_[2 * (numFields_ - 1)];
+
+    // Receive the halos (a message to MPI_PROC_NULL is never posted)
+    recvs[0].count = recvs[1].count = 0;
+    if(left_ != MPI_PROC_NULL)
+        post(recvs[0], 0, nb_, left_, rightTag, false);
+    if(right_ != MPI_PROC_NULL)
+        post(recvs[1], nxl + nb_ + (staggered && wrapRight), nb_ + (staggered && !wrapRight), right_, leftTag, false);
+
+    // Send the owned points next to the halos of the neighbours
+    if(left_ != MPI_PROC_NULL)
+        post(sends[0], nb_, nb_ + (staggered && !wrapLeft), left_, leftTag, true);
+    if(right_ != MPI_PROC_NULL)
+        post(sends[1], nxl + (staggered && wrapRight), nb_, right_, rightTag, true);
+}
+
+void Decomposition::exchangeEnd()
+{
+    MPI_Waitall(static_cast<int>(requests_.size()), requests_.data(), MPI_STATUSES_IGNORE);
+
+    for(int f = 0; f < numFields_; ++f)
+    {
+        if(left_ != MPI_PROC_NULL)
+            unpack(recvs_[2 * f]);
+        if(right_ != MPI_PROC_NULL)
+            unpack(recvs_[2 * f + 1]);
+    }
+
+    requests_.clear();
+    numFields_ = 0;
+}
+
+void Decomposition::relax(FieldXf& phi, Grid grid, const VectorXf& phi1, const VectorXf& phi2) const noexcept
+{
+    const int n = nx_ + 2 * nb_ + (grid == Staggered);
+    const int offset = begin() - nb_;
+
+    int first, last;
+    ownedRows(rank_, grid, first, last);
+
+    for(int k = 0; k < phi.cols(); ++k)
+    {
+        double* phik = phi.data() + k * phi.ld();
+        for(int j = first; j < last; ++j)
+        {
+            const int g = offset + j;
+            if(g < Boundary::RelaxWidth)
+                phik[j] = Boundary::relaxPoint(phik[j], phi1[k], g);
+            else if(g >= n - Boundary::RelaxWidth)
+                phik[j] = Boundary::relaxPoint(phik[j], phi2[k], n - 1 - g);
+        }
+    }
+}
+
+double Decomposition::allreduceMax(double value) const
+{
+    double result;
+    MPI_Allreduce(&value, &result, 1, MPI_DOUBLE, MPI_MAX, comm_);
+    return result;
+}
+
+double Decomposition::allreduceSum(double value) const
+{
+    double result;
+    MPI_Allreduce(&value, &result, 1, MPI_DOUBLE, MPI_SUM, comm_);
+    return result;
+}
+
+ISEN_NAMESPACE_END
+
+#endif
@@ -0,0 +1,60 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#include <Isen/Deviation.h>
+#include <Isen/Solver.h>
+#include <boost/format.hpp>
+#include <cmath>
+#include <iostream>
+
+ISEN_NAMESPACE_BEGIN
+
+std::vector<Deviation> Deviation::compute(const Solver& solver, const Solver& reference)
+{
+    static const char* fields[] = {"zhtnow", "unow", "snow",  "mtg",   "exn",  "prs",
+                                   "qvnow",  "qcnow", "qrnow", "prec", "tot_prec"};
+
+    std::vector<Deviation> deviations;
+    for(const char* name : fields)
+    {
+        const auto field = solver.getField(name);
+        const auto fieldRef = reference.getField(name);
+
+        if(fieldRef.size() == 0)
+            continue;
+
+        if(field.rows() != fieldRef.rows() || field.cols() != fieldRef.cols())
+            throw IsenException("dimension mismatch of field '%s'", name);
+
+        const double maxRef = fieldRef.cwiseAbs().maxCoeff();
+        const double maxAbs = (field - fieldRef).cwiseAbs().maxCoeff();
+
+        Deviation deviation;
+        deviation.name = name;
+        deviation.maxAbs = maxAbs;
+        deviation.maxRel = maxRef > 0.0 ? maxAbs / maxRef : maxAbs;
+        deviation.rms = std::sqrt((field - fieldRef).squaredNorm() / field.size());
+        deviations.push_back(deviation);
+    }
+    return deviations;
+}
+
+void Deviation::print(std::ostream& out, const std::vector<Deviation>& deviations)
+{
+    out << boost::format("%-10s %14s %14s %14s\n") % "Field" % "Max abs" % "Max rel" % "RMS";
+    for(const auto& deviation : deviations)
+        out << boost::format("%-10s %14.6e %14.6e %14.6e\n") % deviation.name % deviation.maxAbs % deviation.maxRel
+                   % deviation.rms;
+}
+
+ISEN_NAMESPACE_END
@@ -0,0 +1,312 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#include <Isen/Encoding.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+ISEN_NAMESPACE_BEGIN
+
+namespace
+{
+
+/// Quantized values have to be exactly representable as double (2^52)
+const double maxQuantized = 4503599627370496.0;
+
+/// Round to half precision (round to nearest even, overflows to infinity)
+std::uint16_t toHalf(float value) noexcept
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const std::uint16_t sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000);
+    const std::uint32_t abs = bits & 0x7fffffff;
+
+    // Infinity and NaN (and values which overflow)
+    if(abs >= 0x47800000)
+        return sign | (abs > 0x7f800000 ? 0x7e00 : 0x7c00);
+
+    // Subnormal numbers are multiples of 2^-24
+    if(abs < 0x38800000)
+        return sign | static_cast<std::uint16_t>(std::lrint(std::fabs(value) * 16777216.0f));
+
+    // Rebias the exponent and round the mantissa to 10 bits
+    const std::uint32_t half = abs - 0x38000000;
+    return sign | static_cast<std::uint16_t>((half + 0xfff + ((half >> 13) & 1)) >> 13);
+}
+
+double fromHalf(std::uint16_t half) noexcept
+{
+    const int exponent = (half >> 10) & 0x1f;
+    const int mantissa = half & 0x3ff;
+
+    double value;
+    if(exponent == 0)
+        value = std::ldexp(mantissa, -24);
+    else if(exponent == 31)
+        value = mantissa ? std::numeric_limits<double>::quiet_NaN() : std::numeric_limits<double>::infinity();
+    else
+        value = std::ldexp(mantissa + 1024, exponent - 25);
+    return (half & 0x8000) ? -value : value;
+}
+
+/// Map signed to unsigned integers such that small magnitudes have small codes
+inline std::uint64_t zigzag(std::int64_t value) noexcept
+{
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+inline std::int64_t unzigzag(std::uint64_t code) noexcept
+{
+    return static_cast<std::int64_t>(code >> 1) ^ -static_cast<std::int64_t>(code & 1);
+}
+
+/// Reversible integer lifting of 4 values with distance @c stride (two levels of the S-transform)
+inline void forwardLift(std::int64_t* p, std::size_t stride) noexcept
+{
+    const std::int64_t d0 = p[stride] - p[0];
+    const std::int64_t s0 = p[0] + (d0 >> 1);
+    const std::int64_t d1 = p[3 * stride] - p[2 * stride];
+    const std::int64_t s1 = p[2 * stride] + (d1 >> 1);
+    const std::int64_t d = s1 - s0;
+
+    p[0] = s0 + (d >> 1);
+    p[stride] = d;
+    p[2 * stride] = d0;
+    p[3 * stride] = d1;
+}
+
+inline void inverseLift(std::int64_t* p, std::size_t stride) noexcept
+{
+    const std::int64_t d = p[stride];
+    const std::int64_t s0 = p[0] - (d >> 1);
+    const std::int64_t s1 = d + s0;
+    const std::int64_t d0 = p[2 * stride];
+    const std::int64_t d1 = p[3 * stride];
+
+    p[0] = s0 - (d0 >> 1);
+    p[stride] = d0 + p[0];
+    p[2 * stride] = s1 - (d1 >> 1);
+    p[3 * stride] = d1 + p[2 * stride];
+}
+
+/// Transform the blocks of 4 x 4 values of a frame (incomplete blocks at the boundary are transformed in one or no
+/// direction)
+void forwardTransform(std::int64_t* frame, std::size_t rows, std::size_t cols) noexcept
+{
+    for(std::size_t i = 0; i < rows; ++i)
+        for(std::size_t k = 0; k + 4 <= cols; k += 4)
+            forwardLift(frame + i * cols + k, 1);
+    for(std::size_t i = 0; i + 4 <= rows; i += 4)
+        for(std::size_t k = 0; k < cols; ++k)
+            forwardLift(frame + i * cols + k, cols);
+}
+
+void inverseTransform(std::int64_t* frame, std::size_t rows, std::size_t cols) noexcept
+{
+    for(std::size_t i = 0; i + 4 <= rows; i += 4)
+        for(std::size_t k = 0; k < cols; ++k)
+            inverseLift(frame + i * cols + k, cols);
+    for(std::size_t i = 0; i < rows; ++i)
+        for(std::size_t k = 0; k + 4 <= cols; k += 4)
+            inverseLift(frame + i * cols + k, 1);
+}
+
+bool encodeFloat32(CompressionCodec codec, double bound, const double* data, std::size_t n, std::vector<char>& out)
+{
+    std::vector<float> values(n);
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        values[i] = static_cast<float>(data[i]);
+        if(!(std::fabs(values[i] - data[i]) <= bound))
+            return false;
+    }
+    Compression::compress(codec, values.data(), n, out);
+    return true;
+}
+
+bool encodeFloat16(CompressionCodec codec, double bound, const double* data, std::size_t n, std::vector<char>& out)
+{
+    std::vector<std::uint16_t> values(n);
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        values[i] = toHalf(static_cast<float>(data[i]));
+        if(!(std::fabs(fromHalf(values[i]) - data[i]) <= bound))
+            return false;
+    }
+    Compression::compress(codec, values.data(), n, out);
+    return true;
+}
+
+bool encodeQuantized(CompressionCodec codec, EncodingMode mode, double bound, const double* data,
+                     std::size_t numFrames, std::size_t rows, std::size_t cols, std::vector<char>& out)
+{
+    const std::size_t frameSize = rows * cols;
+    const std::size_t n = numFrames * frameSize;
+    const double step = 2.0 * bound;
+
+    std::vector<std::int64_t> values(n);
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        const double x = data[i] / step;
+        if(!(std::fabs(x) < maxQuantized))
+            return false;
+
+        values[i] = std::llround(x);
+        if(!(std::fabs(values[i] * step - data[i]) <= bound))
+            return false;
+    }
+
+    if(mode == EncodingMode::Delta)
+    {
+        for(std::size_t i = n; i-- > frameSize;)
+            values[i] -= values[i - frameSize];
+    }
+    else if(mode == EncodingMode::Transform)
+    {
+        for(std::size_t m = 0; m < numFrames; ++m)
+            forwardTransform(values.data() + m * frameSize, rows, cols);
+    }
+
+    std::vector<std::uint64_t> codes(n);
+    for(std::size_t i = 0; i < n; ++i)
+        codes[i] = zigzag(values[i]);
+    Compression::compress(codec, codes.data(), n, out);
+    return true;
+}
+
+} // anonymous namespace
+
+EncodingMode Encoding::fromString(const std::string& name)
+{
+    for(EncodingMode mode : {EncodingMode::Lossless, EncodingMode::Float32, EncodingMode::Float16,
+                             EncodingMode::Fixed, EncodingMode::Delta, EncodingMode::Transform})
+        if(name == toString(mode))
+            return mode;
+    throw IsenException("unknown encoding '%s' (expected lossless, float32, float16, fixed, delta or transform)",
+                        name);
+}
+
+const char* Encoding::toString(EncodingMode mode) noexcept
+{
+    switch(mode)
+    {
+        case EncodingMode::Lossless:
+            return "lossless";
+        case EncodingMode::Float32:
+            return "float32";
+        case EncodingMode::Float16:
+            return "float16";
+        case EncodingMode::Fixed:
+            return "fixed";
+        case EncodingMode::Delta:
+            return "delta";
+        case EncodingMode::Transform:
+            return "transform";
+        default:
+            return "unknown";
+    }
+}
+
+EncodingMode Encoding::encode(CompressionCodec codec, EncodingMode mode, double bound, const double* data,
+                              std::size_t numFrames, std::size_t rows, std::size_t cols, std::vector<char>& out)
+{
+    const std::size_t n = numFrames * rows * cols;
+    if(bound > 0.0)
+    {
+        switch(mode)
+        {
+            case EncodingMode::Float32:
+                if(encodeFloat32(codec, bound, data, n, out))
+                    return mode;
+                break;
+            case EncodingMode::Float16:
+                if(encodeFloat16(codec, bound, data, n, out))
+                    return mode;
+                break;
+            case EncodingMode::Fixed:
+            case EncodingMode::Delta:
+            case EncodingMode::Transform:
+                if(encodeQuantized(codec, mode, bound, data, numFrames, rows, cols, out))
+                    return mode;
+                break;
+            default:
+                break;
+        }
+    }
+
+    Compression::compress(codec, data, n, out);
+    return EncodingMode::Lossless;
+}
+
+void Encoding::decode(CompressionCodec codec, EncodingMode mode, double bound, const char* src, std::size_t size,
+                      double* data, std::size_t numFrames, std::size_t rows, std::size_t cols)
+{
+    const std::size_t frameSize = rows * cols;
+    const std::size_t n = numFrames * frameSize;
+
+    switch(mode)
+    {
+        case EncodingMode::Lossless:
+            Compression::decompress(codec, src, size, data, n);
+            break;
+        case EncodingMode::Float32:
+        {
+            std::vector<float> values(n);
+            Compression::decompress(codec, src, size, values.data(), n);
+            std::copy(values.begin(), values.end(), data);
+            break;
+        }
+        case EncodingMode::Float16:
+        {
+            std::vector<std::uint16_t> values(n);
+            Compression::decompress(codec, src, size, values.data(), n);
+            for(std::size_t i = 0; i < n; ++i)
+                data[i] = fromHalf(values[i]);
+            break;
+        }
+        case EncodingMode::Fixed:
+        case EncodingMode::Delta:
+        case EncodingMode::Transform:
+        {
+            std::vector<std::uint64_t> codes(n);
+            Compression::decompress(codec, src, size, codes.data(), n);
+
+            std::vector<std::int64_t> values(n);
+            for(std::size_t i = 0; i < n; ++i)
+                values[i] = unzigzag(codes[i]);
+
+            if(mode == EncodingMode::Delta)
+            {
+                for(std::size_t i = frameSize; i < n; ++i)
+                    values[i] += values[i - frameSize];
+            }
+            else if(mode == EncodingMode::Transform)
+            {
+                for(std::size_t m = 0; m < numFrames; ++m)
+                    inverseTransform(values.data() + m * frameSize, rows, cols);
+            }
+
+            const double step = 2.0 * bound;
+            for(std::size_t i = 0; i < n; ++i)
+                data[i] = values[i] * step;
+            break;
+        }
+        default:
+            throw IsenException("unknown encoding %i", static_cast<int>(mode));
+    }
+}
+
+ISEN_NAMESPACE_END
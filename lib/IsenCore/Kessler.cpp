@@ -15,40 +15,43 @@
 #include <Isen/Kessler.h>
 #include <Isen/Logger.h>
 #include <Isen/MeteoUtils.h>
+#include <Isen/Numa.h>
 #include <cmath>
 
 ISEN_NAMESPACE_BEGIN
 
-Kessler::Kessler(std::shared_ptr<NameList> namelist) : namelist_(namelist)
+template <class T, class S>
+KesslerT<T, S>::KesslerT(std::shared_ptr<NameList> namelist)
+    : namelist_(namelist), tier_(FastMath::toTier(namelist->imath)), dt_(namelist->dt), nfalld_(-1.0), nfalldNew_(-1.0), kMax_(0)
 {
     KESSLER_DECLARE_ALL_ALIASES
 
     try
     {
-        rho_ = MatrixXf::Zero(nxb, nz);
-        qcprod_ = MatrixXf::Zero(nxb, nz);
-
-        qrr_ = MatrixXf::Zero(nxb, nz);
-        vt_fact_ = MatrixXf::Zero(nxb, nz);
-        vt_ = MatrixXf::Zero(nxb, nz);
-
-        rdzw_ = MatrixXf::Zero(nxb, nz);
-        crmax_ = MatrixXf::Zero(nxb, nz);
-
-        ppt_ = VectorXf::Zero(nxb);
-        zw_ = MatrixXf::Zero(nxb, nz);
-        k_max_value_per_col_ = VectorXf::Zero(nz);
-
-        qrprod_ = MatrixXf::Zero(nxb, nz);
-        pressure_ = MatrixXf::Zero(nxb, nz);
-        gam_ = MatrixXf::Zero(nxb, nz);
-        es_ = MatrixXf::Zero(nxb, nz);
-        qvs_ = MatrixXf::Zero(nxb, nz);
-        diff_ = MatrixXf::Zero(nxb, nz);
-        produc_ = MatrixXf::Zero(nxb, nz);
-        ern_ = MatrixXf::Zero(nxb, nz);
-
-        production_ = MatrixXf::Zero(nxb, nz);
+        Numa::allocate(rho_, nxb, nz);
+        Numa::allocate(qcprod_, nxb, nz);
+
+        Numa::allocate(qrr_, nxb, nz);
+        Numa::allocate(vt_fact_, nxb, nz);
+        Numa::allocate(vt_, nxb, nz);
+
+        Numa::allocate(rdzw_, nxb, nz);
+        Numa::allocate(crmax_, nxb, nz);
+
+        ppt_ = ScratchVector::Zero(nxb);
+        Numa::allocate(zw_, nxb, nz);
+        k_max_value_per_col_ = ScratchVector::Zero(nz);
+
+        Numa::allocate(qrprod_, nxb, nz);
+        Numa::allocate(pressure_, nxb, nz);
+        Numa::allocate(gam_, nxb, nz);
+        Numa::allocate(es_, nxb, nz);
+        Numa::allocate(qvs_, nxb, nz);
+        Numa::allocate(diff_, nxb, nz);
+        Numa::allocate(produc_, nxb, nz);
+        Numa::allocate(ern_, nxb, nz);
+
+        Numa::allocate(production_, nxb, nz);
     }
     catch(std::bad_alloc&)
     {
@@ -57,7 +60,82 @@ Kessler::Kessler(std::shared_ptr<NameList> namelist) : namelist_(namelist)
     }
 }
 
-void Kessler::apply(
+template <class T, class S>
+void KesslerT<T, S>::apply(
+    // Output
+    MatrixXf& temp,
+    MatrixXf& qvnew,
+    MatrixXf& qcnew,
+    MatrixXf& qrnew,
+    VectorXf& tot_prec,
+    VectorXf& prec,
+
+    // Input
+    const VectorXf& th0,
+    const MatrixXf& prs,
+    const MatrixXf& snow,
+    const MatrixXf& qvnow,
+    const MatrixXf& qcnow,
+    const MatrixXf& qrnow,
+    const MatrixXf& exn,
+    const MatrixXf& zhtnow) noexcept
+{
+#pragma omp parallel
+    applyTeam(temp, qvnew, qcnew, qrnew, tot_prec, prec, th0, prs, snow, qvnow, qcnow, qrnow, exn, zhtnow);
+}
+
+/// @brief Reduce the thread-local maximum @c local into @c shared and wait for all threads of the team
+///
+/// @c shared has to be reset by a single thread before (followed by a barrier).
+template <class V>
+static void teamReduceMax(V& shared, V local) noexcept
+{
+#pragma omp critical(KesslerTeamReduceMax)
+    shared = std::max(shared, local);
+#pragma omp barrier
+}
+
+template <class T, class S>
+void KesslerT<T, S>::applyTeam(
+    // Output
+    MatrixXf& temp,
+    MatrixXf& qvnew,
+    MatrixXf& qcnew,
+    MatrixXf& qrnew,
+    VectorXf& tot_prec,
+    VectorXf& prec,
+
+    // Input
+    const VectorXf& th0,
+    const MatrixXf& prs,
+    const MatrixXf& snow,
+    const MatrixXf& qvnow,
+    const MatrixXf& qcnow,
+    const MatrixXf& qrnow,
+    const MatrixXf& exn,
+    const MatrixXf& zhtnow) noexcept
+{
+    switch(tier_)
+    {
+        case MathTier::Polynomial:
+            applyTeam(MathPolynomial<T>(), temp, qvnew, qcnew, qrnew, tot_prec, prec, th0, prs, snow, qvnow, qcnow,
+                      qrnow, exn, zhtnow);
+            break;
+        case MathTier::Table:
+            applyTeam(MathTable<T>(), temp, qvnew, qcnew, qrnew, tot_prec, prec, th0, prs, snow, qvnow, qcnow, qrnow,
+                      exn, zhtnow);
+            break;
+        default:
+            applyTeam(MathExact<T>(), temp, qvnew, qcnew, qrnew, tot_prec, prec, th0, prs, snow, qvnow, qcnow, qrnow,
+                      exn, zhtnow);
+    }
+}
+
+template <class T, class S>
+template <class Math>
+void KesslerT<T, S>::applyTeam(
+    const Math& math,
+
     // Output
     MatrixXf& temp,
     MatrixXf& qvnew,
@@ -80,45 +158,39 @@ void Kessler::apply(
 
     // Define constants
     //--------------------------------------------------------
-    const double dt_in = 2 * dt;
+    const T dt_in = 2 * dt_;
 
-    const double c1 = 0.001 * autoconv_mult;
-    const double c2 = autoconv_th;
-    constexpr double c3 = 2.2;
-    constexpr double c4 = 0.875;
+    const T c1 = 0.001 * autoconv_mult;
+    const T c2 = autoconv_th;
+    constexpr T c3 = 2.2;
+    constexpr T c4 = 0.875;
 
-    constexpr double svp2 = 17.67;
-    constexpr double svp3 = 29.65;
-    constexpr double svpt0 = 273.15;
+    constexpr T svp2 = 17.67;
+    constexpr T svp3 = 29.65;
+    constexpr T svpt0 = 273.15;
 
-    const double ep2 = r / r_v;
-    constexpr double xlv = 2.5 * 1e06;
-    constexpr double max_cr_sedimentation = 0.75;
-    constexpr double rhowater = 1000.;
+    const T ep2 = r / r_v;
+    constexpr T xlv = 2.5 * 1e06;
+    constexpr T max_cr_sedimentation = 0.75;
+    constexpr T rhowater = 1000.;
     
-    const double f5 = svp2 * (svpt0 - svp3) * xlv / cp;
+    const T f5 = svp2 * (svpt0 - svp3) * xlv / T(cp);
     
-    // Reset rain rate to zero
+    // Reset rain rate and the reduction variables
+    #pragma omp for nowait
     for(int i = 0; i < nxb; ++i)
         prec(i) = 0.0;
-    
-    // Reduction variables
-    double nfalld = -1.0;
-    double nfalld_new = -1.0;
-    int k_max = 0;
 
-#ifdef ISEN_COMPILER_MSVC
-    #pragma omp parallel shared(nfalld, nfalld_new, k_max) // MSVC only implements OpenMP 1.0 ...
-#else
-    #pragma omp parallel
-#endif
+    #pragma omp single
+    nfalld_ = -1.0;
+
     {
         // Compute density
         //--------------------------------------------------------
         #pragma omp for nowait 
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
-                rho_(i, k) = snow(i, k) * dth / (zhtnow(i, k + 1) - zhtnow(i, k));
+                rho_(i, k) = snow(i, k) * T(dth) / (zhtnow(i, k + 1) - zhtnow(i, k));
     
         // Terminal velocity calculation and advection
         //--------------------------------------------------------
@@ -130,45 +202,44 @@ void Kessler::apply(
         #pragma omp for nowait
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
-                qrr_(i, k) = std::max(0.0, 0.001 * qrnow(i, k) * rho_(i, k));
+                qrr_(i, k) = std::max(T(0), T(0.001) * qrnow(i, k) * rho_(i, k));
         
         #pragma omp for // wait for qrr      
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
-                vt_fact_(i, k) = 36.34 * vt_mult * std::sqrt(rho_(i, 0) / rho_(i, k));
+                vt_fact_(i, k) = T(36.34) * T(vt_mult) * std::sqrt(T(rho_(i, 0)) / rho_(i, k));
 
         #pragma omp for nowait      
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
-                vt_(i, k) = std::pow(qrr_(i, k), 0.1364) * vt_fact_(i, k);
+                vt_(i, k) = math.pow(T(qrr_(i, k)), T(0.1364)) * vt_fact_(i, k);
         
         #pragma omp for // wait for vt     
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
-                rdzw_(i, k) = 1.0 / (zhtnow(i, k + 1) - zhtnow(i, k));
+                rdzw_(i, k) = T(1) / (zhtnow(i, k + 1) - zhtnow(i, k));
     
         // Determine Courant number
         #pragma omp for          
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
-                crmax_(i, k) = std::max(0.5 * dt_in * vt_(i, k) * rdzw_(i, k), 0.0);
+                crmax_(i, k) = std::max(T(0.5) * dt_in * vt_(i, k) * rdzw_(i, k), T(0));
 
         // Determine maximum nfall for all grid points
-#ifdef ISEN_COMPILER_MSVC
-        #pragma omp single
-#else
-        #pragma omp for reduction(max: nfalld)
-#endif
+        double nfalld = -1.0;
+        #pragma omp for nowait
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
-                nfalld = std::max(nfalld, std::max(1.0, std::ceil(0.5 + crmax_(i, k) / max_cr_sedimentation)));
+                nfalld = std::max(nfalld,
+                                  std::max(1.0, double(std::ceil(T(0.5) + crmax_(i, k) / max_cr_sedimentation))));
+        teamReduceMax(nfalld_, nfalld);
     
-        int nfall = static_cast<int>(nfalld);
+        int nfall = static_cast<int>(nfalld_);
         assert(nfall > 0);
     
         // Splitting so Courant number for sedimentation is stable
-        double dtfall = dt_in / nfall;
-        double time_sediment = dt_in;
+        T dtfall = dt_in / nfall;
+        T time_sediment = dt_in;
     
         if(sediment_on)
         {
@@ -177,46 +248,46 @@ void Kessler::apply(
             {
                 time_sediment = time_sediment - dtfall;
 
-                k_max = 0;
+                #pragma omp single nowait
+                kMax_ = 0;
         
                 #pragma omp for
                 for(int i = 0; i < nxb; ++i)
-                    ppt_(i) = rho_(i, 0) * qcprod_(i, 0) * vt_(i, 0) * dtfall / rhowater;
+                    ppt_(i) = T(rho_(i, 0)) * qcprod_(i, 0) * vt_(i, 0) * dtfall / rhowater;
     
                 // Precipitation (mm/h)
                 #pragma omp for nowait          
                 for(int i = 0; i < nxb; ++i)
-                    prec(i) = ppt_(i) * 1000 / dtfall * 3600;
+                    prec(i) = T(ppt_(i)) * 1000 / dtfall * 3600;
     
                 // Accumulated precipitation (mm)
                 #pragma omp for nowait           
                 for(int i = 0; i < nxb; ++i)
-                    tot_prec(i) = tot_prec(i) + ppt_(i) * 1000;
+                    tot_prec(i) = tot_prec(i) + T(ppt_(i)) * 1000;
     
                 // Time split loop, fallout with flux upstream
                 #pragma omp for
                 for(int k = 0; k < nz; ++k)
                     for(int i = 0; i < nxb; ++i)
-                        zw_(i, k) = qcprod_(i, k) * vt_(i, k) * rho_(i, k);
+                        zw_(i, k) = T(qcprod_(i, k)) * vt_(i, k) * rho_(i, k);
     
                 #pragma omp for
                 for(int k = 0; k < nz; ++k)
                 {
                     // Find max element per col
-                    double max_element = zw_(0, k);
+                    T max_element = zw_(0, k);
                     for(int i = 1; i < nxb; ++i)
-                        max_element = std::max(max_element, zw_(i, k));
+                        max_element = std::max(max_element, T(zw_(i, k)));
                     k_max_value_per_col_(k) = max_element;
                 }
     
-                // Find largest index which is non-zero  
-#ifdef ISEN_COMPILER_MSVC
-                #pragma omp single
-#else
-                #pragma omp for reduction(max: k_max)
-#endif
+                // Find largest index which is non-zero
+                int k_max = 0;
+                #pragma omp for nowait
                 for(int k = 1; k < nz; ++k)
                     k_max = k_max_value_per_col_(k) != 0.0 ? k : k_max;
+                teamReduceMax(kMax_, k_max);
+                k_max = kMax_;
                 
                 if(k_max == (nz - 1))
                 {
@@ -224,13 +295,13 @@ void Kessler::apply(
                     for(int k = 0; k < k_max; ++k)
                         for(int i = 0; i < nxb; ++i)
                             qcprod_(i, k) = qcprod_(i, k)
-                                            - dtfall * (rdzw_(i, k) / rho_(i, k)) * (zw_(i, k) - zw_(i, k + 1));
+                                            - dtfall * (T(rdzw_(i, k)) / rho_(i, k)) * (T(zw_(i, k)) - zw_(i, k + 1));
     
                     #pragma omp for                
                     for(int i = 0; i < nxb; ++i)
                         qcprod_(i, nz - 1) = qcprod_(i, nz - 1)
                                              - dtfall * rdzw_(i, nz - 1) * zw_(i, nz - 1)
-                                                   / (rho_(i, nz - 1) * rho_(i, nz - 1));
+                                                   / (T(rho_(i, nz - 1)) * rho_(i, nz - 1));
                 }
                 else
                 {
@@ -238,7 +309,7 @@ void Kessler::apply(
                     for(int k = 0; k <= k_max; ++k)
                         for(int i = 0; i < nxb; ++i)
                             qcprod_(i, k) = qcprod_(i, k)
-                                            - dtfall * (rdzw_(i, k) / rho_(i, k)) * (zw_(i, k) - zw_(i, k + 1));
+                                            - dtfall * (T(rdzw_(i, k)) / rho_(i, k)) * (T(zw_(i, k)) - zw_(i, k + 1));
                 }
     
                 // Compute new sedimentation velocity and check/recompute new sedimentation timestep
@@ -246,35 +317,36 @@ void Kessler::apply(
                 if(nfall > 1)
                 {
                     nfall = nfall - 1;
-                    nfalld_new = -1.0;
+
+                    #pragma omp single nowait
+                    nfalldNew_ = -1.0;
     
                     #pragma omp for                                
                     for(int k = 0; k < nz; ++k)
                         for(int i = 0; i < nxb; ++i)
-                            qrr_(i, k) = std::max(0.0, 0.001 * qcprod_(i, k) * rho_(i, k));
+                            qrr_(i, k) = std::max(T(0), T(0.001) * qcprod_(i, k) * rho_(i, k));
     
                     #pragma omp for                                                
                     for(int k = 0; k < nz; ++k)
                         for(int i = 0; i < nxb; ++i)
-                            vt_(i, k) = std::pow(qrr_(i, k), 0.1364) * vt_fact_(i, k);
+                            vt_(i, k) = math.pow(T(qrr_(i, k)), T(0.1364)) * vt_fact_(i, k);
     
                     #pragma omp for                                                
                     for(int k = 0; k < nz; ++k)
                         for(int i = 0; i < nxb; ++i)
-                            crmax_(i, k) = std::max(time_sediment * vt_(i, k) * rdzw_(i, k), 0.0);
+                            crmax_(i, k) = std::max(time_sediment * vt_(i, k) * rdzw_(i, k), T(0));
 
-#ifdef ISEN_COMPILER_MSVC
-                    #pragma omp single
-#else
-                    #pragma omp for reduction(max: nfalld_new)
-#endif
+                    double nfalld_new = -1.0;
+                    #pragma omp for nowait
                     for(int k = 0; k < nz; ++k)
                         for(int i = 0; i < nxb; ++i)
                             nfalld_new
                                 = std::max(nfalld_new, std::max(1.0, 
-                                                                std::ceil(0.5 + crmax_(i, k) / max_cr_sedimentation)));
+                                                                double(std::ceil(T(0.5) + crmax_(i, k) 
+                                                                                             / max_cr_sedimentation))));
+                    teamReduceMax(nfalldNew_, nfalld_new);
                     
-                    int nfall_new = static_cast<int>(nfalld_new);
+                    int nfall_new = static_cast<int>(nfalldNew_);
     
                     if(nfall_new != nfall)
                     {
@@ -303,55 +375,56 @@ void Kessler::apply(
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
             {
-                double factorn = 1.0 / (1.0 + c3 * dt_in * std::pow(std::max(0.0, qrnow(i, k)), c4));
-                qrprod_(i, k) = qcnow(i, k) * (1.0 - factorn) + c1 * dt_in * factorn * std::max(0.0, qcnow(i, k) - c2);
+                T factorn = T(1) / (T(1) + c3 * dt_in * math.pow(std::max(T(0), qrnow(i, k)), c4));
+                qrprod_(i, k)
+                    = qcnow(i, k) * (T(1) - factorn) + c1 * dt_in * factorn * std::max(T(0), qcnow(i, k) - c2);
             }
     
         // Set limit
         #pragma omp for nowait              
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
-                qcnew(i, k) = std::max(qcnow(i, k) - qrprod_(i, k), 0.0);
+                qcnew(i, k) = std::max(qcnow(i, k) - qrprod_(i, k), T(0));
     
         #pragma omp for nowait              
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
-                qrnew(i, k) = std::max(qcprod_(i, k) + qrprod_(i, k), 0.0);
+                qrnew(i, k) = std::max(T(qcprod_(i, k)) + qrprod_(i, k), T(0));
     
         // Atmospheric conditions
         //--------------------------------------------------------
         #pragma omp for nowait               
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
-                temp(i, k) = 0.5 * ((exn(i, k + 1) / cp) * th0(k + 1) + (exn(i, k) / cp) * th0(k));
+                temp(i, k) = T(0.5) * ((exn(i, k + 1) / T(cp)) * th0(k + 1) + (exn(i, k) / T(cp)) * th0(k));
     
         #pragma omp for nowait            
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
-                pressure_(i, k) = 0.5 * (prs(i, k) + prs(i, k + 1));
+                pressure_(i, k) = T(0.5) * (prs(i, k) + prs(i, k + 1));
     
         #pragma omp for nowait            
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
-                gam_(i, k) = 2.5 * 1e06 / (1004 * 0.5 * (exn(i, k) + exn(i, k + 1)) / cp);
+                gam_(i, k) = T(2.5 * 1e06) / (T(1004 * 0.5) * (exn(i, k) + exn(i, k + 1)) / T(cp));
     
         #pragma omp for // wait for es and pressure        
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
-                es_(i, k) = MeteoUtils::eswat1(temp(i, k)) * 100;
+                es_(i, k) = MeteoUtils::eswat1<T>(temp(i, k), math) * 100;
     
         #pragma omp for                
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
-                qvs_(i, k) = ep2 * es_(i, k) / (pressure_(i, k) - es_(i, k));
+                qvs_(i, k) = ep2 * es_(i, k) / (T(pressure_(i, k)) - es_(i, k));
     
         // Calculate saturation deficit
         #pragma omp for nowait              
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
             {
-                double diff_delta = qvs_(i, k) - qvnow(i, k);
-                diff_(i, k) = diff_delta < 0.0 ? 0.0 : diff_delta;
+                T diff_delta = qvs_(i, k) - qvnow(i, k);
+                diff_(i, k) = diff_delta < T(0) ? T(0) : diff_delta;
             }
     
         // Saturation adjustment: condensation/evaporation
@@ -359,7 +432,7 @@ void Kessler::apply(
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
                 produc_(i, k) = (qvnow(i, k) - qvs_(i, k)) / 
-                                 (1.0 + pressure_(i, k) / (pressure_(i, k) - es_(i, k)) 
+                                 (T(1) + pressure_(i, k) / (T(pressure_(i, k)) - es_(i, k)) 
                                   * qvs_(i, k) * f5 / ((temp(i, k) - svp3) * (temp(i, k) - svp3)));
     
         // Evaporation of rain
@@ -369,17 +442,20 @@ void Kessler::apply(
             #pragma omp for                    
             for(int k = 0; k < nz; ++k)
                 for(int i = 0; i < nxb; ++i)
-                    ern_(i, k) = std::min(dt_in * (((1.6 + 124.9 * std::pow(0.001 * rho_(i, k) * qrnew(i, k), 0.2046))
-                                                    * (std::pow(0.001 * rho_(i, k) * qrnew(i, k), 0.525)))
-                                                   / (2.55 * 1e08 / (pressure_(i, k) * qvs_(i, k) + 5.4 * 1e05)))
-                                              * (diff_(i, k) / (0.001 * rho_(i, k) * qvs_(i, k))),
-                                          std::max(-produc_(i, k) - qcnew(i, k), 0.0));
+                {
+                    const T rhoqr = T(0.001) * rho_(i, k) * qrnew(i, k);
+                    ern_(i, k) = std::min(dt_in * (((T(1.6) + T(124.9) * math.pow(rhoqr, T(0.2046)))
+                                                    * (math.pow(rhoqr, T(0.525))))
+                                                   / (T(2.55 * 1e08) / (T(pressure_(i, k)) * qvs_(i, k) + T(5.4 * 1e05))))
+                                              * (diff_(i, k) / (T(0.001) * rho_(i, k) * qvs_(i, k))),
+                                          std::max(-produc_(i, k) - qcnew(i, k), T(0)));
+                }
     
             // Limit evaporation of rain to current rain amount
             #pragma omp for nowait                  
             for(int k = 0; k < nz; ++k)
                 for(int i = 0; i < nxb; ++i)
-                    ern_(i, k) = std::min(ern_(i, k), qrnew(i, k));
+                    ern_(i, k) = std::min(T(ern_(i, k)), qrnew(i, k));
         }
         else
         {
@@ -394,17 +470,17 @@ void Kessler::apply(
         #pragma omp for                
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
-                production_(i, k) = std::max(produc_(i, k), -qcnew(i, k));
+                production_(i, k) = std::max(T(produc_(i, k)), -qcnew(i, k));
     
         #pragma omp for nowait             
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
-                temp(i, k) = gam_(i, k) * (production_(i, k) - ern_(i, k));
+                temp(i, k) = gam_(i, k) * (T(production_(i, k)) - ern_(i, k));
     
         #pragma omp for nowait      
         for(int k = 0; k < nz; ++k)
             for(int i = 0; i < nxb; ++i)
-                qvnew(i, k) = std::max(qvnow(i, k) - production_(i, k) + ern_(i, k), 0.0);
+                qvnew(i, k) = std::max(qvnow(i, k) - production_(i, k) + ern_(i, k), T(0));
 
         #pragma omp for nowait      
         for(int k = 0; k < nz; ++k)
@@ -418,4 +494,8 @@ void Kessler::apply(
     }
 }
 
+template class KesslerT<double>;
+template class KesslerT<float>;
+template class KesslerT<double, float>;
+
 ISEN_NAMESPACE_END
@@ -0,0 +1,500 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#include <Isen/Common.h>
+#include <Isen/KesslerColumn.h>
+#include <Isen/Logger.h>
+#include <Isen/MeteoUtils.h>
+#include <algorithm>
+#include <cmath>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+ISEN_NAMESPACE_BEGIN
+
+/// Number of threads of the current team (1 outside of a parallel region)
+static int teamSize() noexcept
+{
+#ifdef _OPENMP
+    return omp_get_num_threads();
+#else
+    return 1;
+#endif
+}
+
+/// Id of the calling thread within the current team
+static int teamRank() noexcept
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+static int maxTeamSize() noexcept
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/// @brief Terminal velocity of rain for the rain water @c qr, the density @c rho and the density at the ground @c rho0
+///
+/// The rain water density and the velocity factor are rounded to @c S as in KesslerT.
+template <class T, class S, class Math>
+static inline S terminalVelocity(const Math& math, T qr, S rho0, S rho, T vtMult) noexcept
+{
+    const S qrr = std::max(T(0), T(0.001) * qr * rho);
+    const S vtFact = T(36.34) * vtMult * std::sqrt(T(rho0) / rho);
+    return math.pow(T(qrr), T(0.1364)) * vtFact;
+}
+
+template <class T, class S>
+KesslerColumnT<T, S>::KesslerColumnT(std::shared_ptr<NameList> namelist)
+    : namelist_(namelist), tier_(FastMath::toTier(namelist->imath)), dt_(namelist->dt)
+{
+    KESSLER_DECLARE_ALL_ALIASES
+
+    try
+    {
+        columns_.assign(maxTeamSize(), ScratchVector::Zero(3 * nz * BlockWidth));
+        nfall_.assign(2 * maxTeamSize(), -1.0);
+    }
+    catch(std::bad_alloc&)
+    {
+        LOG() << logger::failed;
+        throw IsenException("out of memory");
+    }
+}
+
+template <class T, class S>
+void KesslerColumnT<T, S>::apply(
+    // Output
+    MatrixXf& temp,
+    MatrixXf& qvnew,
+    MatrixXf& qcnew,
+    MatrixXf& qrnew,
+    VectorXf& tot_prec,
+    VectorXf& prec,
+
+    // Input
+    const VectorXf& th0,
+    const MatrixXf& prs,
+    const MatrixXf& snow,
+    const MatrixXf& qvnow,
+    const MatrixXf& qcnow,
+    const MatrixXf& qrnow,
+    const MatrixXf& exn,
+    const MatrixXf& zhtnow) noexcept
+{
+#pragma omp parallel
+    applyTeam(temp, qvnew, qcnew, qrnew, tot_prec, prec, th0, prs, snow, qvnow, qcnow, qrnow, exn, zhtnow);
+}
+
+template <class T, class S>
+void KesslerColumnT<T, S>::applyTeam(
+    // Output
+    MatrixXf& temp,
+    MatrixXf& qvnew,
+    MatrixXf& qcnew,
+    MatrixXf& qrnew,
+    VectorXf& tot_prec,
+    VectorXf& prec,
+
+    // Input
+    const VectorXf& th0,
+    const MatrixXf& prs,
+    const MatrixXf& snow,
+    const MatrixXf& qvnow,
+    const MatrixXf& qcnow,
+    const MatrixXf& qrnow,
+    const MatrixXf& exn,
+    const MatrixXf& zhtnow) noexcept
+{
+    switch(tier_)
+    {
+        case MathTier::Polynomial:
+            applyTeam(MathPolynomial<T>(), temp, qvnew, qcnew, qrnew, tot_prec, prec, th0, prs, snow, qvnow, qcnow,
+                      qrnow, exn, zhtnow);
+            break;
+        case MathTier::Table:
+            applyTeam(MathTable<T>(), temp, qvnew, qcnew, qrnew, tot_prec, prec, th0, prs, snow, qvnow, qcnow, qrnow,
+                      exn, zhtnow);
+            break;
+        default:
+            applyTeam(MathExact<T>(), temp, qvnew, qcnew, qrnew, tot_prec, prec, th0, prs, snow, qvnow, qcnow, qrnow,
+                      exn, zhtnow);
+    }
+}
+
+template <class T, class S>
+template <class Math>
+void KesslerColumnT<T, S>::applyTeam(
+    const Math& math,
+
+    // Output
+    MatrixXf& temp,
+    MatrixXf& qvnew,
+    MatrixXf& qcnew,
+    MatrixXf& qrnew,
+    VectorXf& tot_prec,
+    VectorXf& prec,
+
+    // Input
+    const VectorXf& th0,
+    const MatrixXf& prs,
+    const MatrixXf& snow,
+    const MatrixXf& qvnow,
+    const MatrixXf& qcnow,
+    const MatrixXf& qrnow,
+    const MatrixXf& exn,
+    const MatrixXf& zhtnow) noexcept
+{
+    KESSLER_DECLARE_ALL_ALIASES
+
+    // Define constants (see KesslerT::applyTeam)
+    //--------------------------------------------------------
+    const T dt_in = 2 * dt_;
+
+    const T c1 = 0.001 * autoconv_mult;
+    const T c2 = autoconv_th;
+    constexpr T c3 = 2.2;
+    constexpr T c4 = 0.875;
+
+    constexpr T svp2 = 17.67;
+    constexpr T svp3 = 29.65;
+    constexpr T svpt0 = 273.15;
+
+    const T ep2 = r / r_v;
+    constexpr T xlv = 2.5 * 1e06;
+    constexpr T max_cr_sedimentation = 0.75;
+    constexpr T rhowater = 1000.;
+
+    const T f5 = svp2 * (svpt0 - svp3) * xlv / T(cp);
+    const T vtMult = T(vt_mult);
+
+    constexpr int B = BlockWidth;
+    const int numBlocks = (nxb + B - 1) / B;
+
+    // The team may be larger than anticipated (e.g a num_threads clause)
+    #pragma omp single
+    if(static_cast<int>(columns_.size()) < teamSize())
+    {
+        columns_.resize(teamSize(), ScratchVector::Zero(3 * nz * B));
+        nfall_.resize(2 * teamSize(), -1.0);
+    }
+
+    const int rank = teamRank();
+    S* rho = columns_[rank].data();
+    S* rdzw = rho + nz * B;
+    S* zw = rdzw + nz * B;
+
+    // Density and inverse layer thickness of the columns [i0, i1)
+    auto loadColumns = [&](int i0, int i1) {
+        for(int k = 0; k < nz; ++k)
+            for(int i = i0; i < i1; ++i)
+            {
+                rho[k * B + i - i0] = snow(i, k) * T(dth) / (zhtnow(i, k + 1) - zhtnow(i, k));
+                rdzw[k * B + i - i0] = T(1) / (zhtnow(i, k + 1) - zhtnow(i, k));
+            }
+    };
+
+    // Maximum of the thread-local values @c local over the team (the slots alternate between consecutive calls)
+    int slot = 0;
+    auto teamMaxNfall = [&](double local) -> double {
+        nfall_[2 * rank + slot] = local;
+        #pragma omp barrier
+        double nfalld = -1.0;
+        for(int t = 0; t < teamSize(); ++t)
+            nfalld = std::max(nfalld, nfall_[2 * t + slot]);
+        slot ^= 1;
+        return nfalld;
+    };
+
+    // The sweeps over the grid use the same static partitioning of the blocks, a thread thus only ever touches its own
+    // columns and consecutive sweeps don't have to be separated by barriers.
+    if(sediment_on && sediment_col)
+    {
+        // Sedimentation with the number of sub-steps of each column. The columns are copied to the scratch (density,
+        // inverse layer thickness, rain water, terminal velocity and flux) and columns without rain are skipped. The
+        // blocks are scheduled dynamically as the work per column varies with the amount of rain.
+        //--------------------------------------------------------
+        S* qrc = zw + nz;
+        S* vt = qrc + nz;
+
+        #pragma omp for schedule(dynamic, 1) // wait for all columns
+        for(int block = 0; block < numBlocks; ++block)
+            for(int i = block * B; i < std::min(nxb, (block + 1) * B); ++i)
+            {
+                bool rain = false;
+                for(int k = 0; k < nz; ++k)
+                {
+                    qrc[k] = qrnow(i, k);
+                    rain |= qrc[k] > S(0);
+                }
+
+                if(!rain)
+                {
+                    for(int k = 0; k < nz; ++k)
+                        qrnew(i, k) = qrc[k];
+                    prec(i) = 0.0;
+                    continue;
+                }
+
+                for(int k = 0; k < nz; ++k)
+                {
+                    rho[k] = snow(i, k) * T(dth) / (zhtnow(i, k + 1) - zhtnow(i, k));
+                    rdzw[k] = T(1) / (zhtnow(i, k + 1) - zhtnow(i, k));
+                }
+
+                double nfalld = -1.0;
+                for(int k = 0; k < nz; ++k)
+                {
+                    vt[k] = terminalVelocity(math, qrnow(i, k), rho[0], rho[k], vtMult);
+                    const S crmax = std::max(T(0.5) * dt_in * vt[k] * rdzw[k], T(0));
+                    nfalld = std::max(nfalld, std::max(1.0, double(std::ceil(T(0.5) + crmax / max_cr_sedimentation))));
+                }
+
+                int nfall = static_cast<int>(nfalld);
+                T dtfall = dt_in / nfall;
+                T time_sediment = dt_in;
+
+                while(nfall > 0)
+                {
+                    time_sediment = time_sediment - dtfall;
+
+                    const S ppt = T(rho[0]) * qrc[0] * vt[0] * dtfall / rhowater;
+                    prec(i) = T(ppt) * 1000 / dtfall * 3600;
+                    tot_prec(i) = tot_prec(i) + T(ppt) * 1000;
+
+                    for(int k = 0; k < nz; ++k)
+                        zw[k] = T(qrc[k]) * vt[k] * rho[k];
+
+                    for(int k = 0; k < nz - 1; ++k)
+                        qrc[k] = qrc[k] - dtfall * (T(rdzw[k]) / rho[k]) * (T(zw[k]) - zw[k + 1]);
+                    qrc[nz - 1] = qrc[nz - 1] - dtfall * rdzw[nz - 1] * zw[nz - 1] / (T(rho[nz - 1]) * rho[nz - 1]);
+
+                    if(nfall > 1)
+                    {
+                        nfall = nfall - 1;
+
+                        double nfalld_new = -1.0;
+                        for(int k = 0; k < nz; ++k)
+                        {
+                            vt[k] = terminalVelocity(math, T(qrc[k]), rho[0], rho[k], vtMult);
+                            const S crmax = std::max(time_sediment * vt[k] * rdzw[k], T(0));
+                            nfalld_new = std::max(
+                                nfalld_new, std::max(1.0, double(std::ceil(T(0.5) + crmax / max_cr_sedimentation))));
+                        }
+
+                        const int nfall_new = static_cast<int>(nfalld_new);
+                        if(nfall_new != nfall)
+                        {
+                            nfall = nfall_new;
+                            dtfall = time_sediment / nfall;
+                        }
+                    }
+                    else
+                    {
+                        nfall = 0;
+                    }
+                }
+
+                for(int k = 0; k < nz; ++k)
+                    qrnew(i, k) = qrc[k];
+            }
+    }
+    else if(sediment_on)
+    {
+        // Terminal velocity and number of sedimentation sub-steps. The rain water subject to sedimentation is kept in
+        // qrnew and the terminal velocity in temp.
+        //--------------------------------------------------------
+        double nfalld = -1.0;
+
+        #pragma omp for schedule(static) nowait
+        for(int block = 0; block < numBlocks; ++block)
+        {
+            const int i0 = block * B, i1 = std::min(nxb, i0 + B);
+            loadColumns(i0, i1);
+
+            for(int k = 0; k < nz; ++k)
+                for(int i = i0; i < i1; ++i)
+                {
+                    const S vt = terminalVelocity(math, qrnow(i, k), rho[i - i0], rho[k * B + i - i0], vtMult);
+                    const S crmax = std::max(T(0.5) * dt_in * vt * rdzw[k * B + i - i0], T(0));
+
+                    qrnew(i, k) = S(qrnow(i, k));
+                    temp(i, k) = vt;
+                    nfalld = std::max(
+                        nfalld, std::max(1.0, double(std::ceil(T(0.5) + crmax / max_cr_sedimentation))));
+                }
+        }
+
+        int nfall = static_cast<int>(teamMaxNfall(nfalld));
+        assert(nfall > 0);
+
+        // Splitting so Courant number for sedimentation is stable
+        T dtfall = dt_in / nfall;
+        T time_sediment = dt_in;
+
+        while(nfall > 0)
+        {
+            time_sediment = time_sediment - dtfall;
+            const bool lastStep = nfall == 1;
+
+            double nfalldNew = -1.0;
+
+            #pragma omp for schedule(static) nowait
+            for(int block = 0; block < numBlocks; ++block)
+            {
+                const int i0 = block * B, i1 = std::min(nxb, i0 + B);
+                loadColumns(i0, i1);
+
+                for(int i = i0; i < i1; ++i)
+                {
+                    const S ppt = T(rho[i - i0]) * qrnew(i, 0) * temp(i, 0) * dtfall / rhowater;
+
+                    // Precipitation (mm/h)
+                    prec(i) = T(ppt) * 1000 / dtfall * 3600;
+
+                    // Accumulated precipitation (mm)
+                    tot_prec(i) = tot_prec(i) + T(ppt) * 1000;
+                }
+
+                // Fallout with flux upstream. The levels above the highest non-zero flux of the grid, which are
+                // skipped by KesslerT, remain unchanged as their flux difference vanishes.
+                for(int k = 0; k < nz; ++k)
+                    for(int i = i0; i < i1; ++i)
+                        zw[k * B + i - i0] = qrnew(i, k) * temp(i, k) * rho[k * B + i - i0];
+
+                for(int k = 0; k < nz - 1; ++k)
+                    for(int i = i0; i < i1; ++i)
+                    {
+                        const int j = k * B + i - i0;
+                        qrnew(i, k) = S(qrnew(i, k) - dtfall * (T(rdzw[j]) / rho[j]) * (T(zw[j]) - zw[j + B]));
+                    }
+
+                for(int i = i0; i < i1; ++i)
+                {
+                    const int j = (nz - 1) * B + i - i0;
+                    qrnew(i, nz - 1) = S(qrnew(i, nz - 1) - dtfall * rdzw[j] * zw[j] / (T(rho[j]) * rho[j]));
+                }
+
+                // New sedimentation velocity and Courant number if this isn't the last sub-step
+                if(!lastStep)
+                    for(int k = 0; k < nz; ++k)
+                        for(int i = i0; i < i1; ++i)
+                        {
+                            const int j = k * B + i - i0;
+                            const S vt = terminalVelocity(math, qrnew(i, k), rho[i - i0], rho[j], vtMult);
+                            const S crmax = std::max(time_sediment * vt * rdzw[j], T(0));
+
+                            temp(i, k) = vt;
+                            nfalldNew = std::max(
+                                nfalldNew, std::max(1.0, double(std::ceil(T(0.5) + crmax / max_cr_sedimentation))));
+                        }
+            }
+
+            // Check/recompute the sedimentation timestep
+            if(!lastStep)
+            {
+                nfall = nfall - 1;
+                const int nfall_new = static_cast<int>(teamMaxNfall(nfalldNew));
+
+                if(nfall_new != nfall)
+                {
+                    nfall = nfall_new;
+                    dtfall = time_sediment / nfall;
+                }
+            }
+            else
+            {
+                nfall = 0;
+            }
+        }
+    }
+
+    // Production/deletion of qc and qr, saturation adjustment and evaporation of rain
+    //--------------------------------------------------------
+    #pragma omp for schedule(static)
+    for(int block = 0; block < numBlocks; ++block)
+    {
+        const int i0 = block * B, i1 = std::min(nxb, i0 + B);
+
+        if(!sediment_on)
+            for(int i = i0; i < i1; ++i)
+                prec(i) = 0.0;
+
+        for(int k = 0; k < nz; ++k)
+            for(int i = i0; i < i1; ++i)
+            {
+                const S qcprod = sediment_on ? qrnew(i, k) : T(0);
+
+                const T factorn = T(1) / (T(1) + c3 * dt_in * math.pow(std::max(T(0), qrnow(i, k)), c4));
+                const S qrprod
+                    = qcnow(i, k) * (T(1) - factorn) + c1 * dt_in * factorn * std::max(T(0), qcnow(i, k) - c2);
+
+                // Set limit
+                T qc = std::max(qcnow(i, k) - qrprod, T(0));
+                T qr = std::max(T(qcprod) + qrprod, T(0));
+
+                // Atmospheric conditions
+                const T t = T(0.5) * ((exn(i, k + 1) / T(cp)) * th0(k + 1) + (exn(i, k) / T(cp)) * th0(k));
+                const S pressure = T(0.5) * (prs(i, k) + prs(i, k + 1));
+                const S gam = T(2.5 * 1e06) / (T(1004 * 0.5) * (exn(i, k) + exn(i, k + 1)) / T(cp));
+                const S es = MeteoUtils::eswat1<T>(t, math) * 100;
+                const S qvs = ep2 * es / (T(pressure) - es);
+
+                // Calculate saturation deficit
+                const T diff_delta = qvs - qvnow(i, k);
+                const S diff = diff_delta < T(0) ? T(0) : diff_delta;
+
+                // Saturation adjustment: condensation/evaporation
+                const S produc = (qvnow(i, k) - qvs)
+                                 / (T(1) + pressure / (T(pressure) - es) * qvs * f5 / ((t - svp3) * (t - svp3)));
+
+                // Evaporation of rain (limited to the current rain amount)
+                S ern = 0.0;
+                if(iern)
+                {
+                    const S rho_k = snow(i, k) * T(dth) / (zhtnow(i, k + 1) - zhtnow(i, k));
+                    const T rhoqr = T(0.001) * rho_k * qr;
+                    ern = std::min(dt_in * (((T(1.6) + T(124.9) * math.pow(rhoqr, T(0.2046)))
+                                             * (math.pow(rhoqr, T(0.525))))
+                                            / (T(2.55 * 1e08) / (T(pressure) * qvs + T(5.4 * 1e05))))
+                                       * (diff / (T(0.001) * rho_k * qvs)),
+                                   std::max(-produc - qc, T(0)));
+                    ern = std::min(T(ern), qr);
+                }
+
+                // Update all variables
+                const S production = std::max(T(produc), -qc);
+
+                temp(i, k) = gam * (T(production) - ern);
+                qvnew(i, k) = std::max(qvnow(i, k) - production + ern, T(0));
+                qcnew(i, k) = qc + production;
+                qrnew(i, k) = qr - ern;
+            }
+    }
+}
+
+template class KesslerColumnT<double>;
+template class KesslerColumnT<float>;
+template class KesslerColumnT<double, float>;
+
+ISEN_NAMESPACE_END
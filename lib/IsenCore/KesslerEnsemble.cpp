@@ -0,0 +1,435 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+
+#include <Isen/Common.h>
+#include <Isen/Kessler.h>
+#include <Isen/KesslerEnsemble.h>
+#include <Isen/Logger.h>
+#include <Isen/MeteoUtils.h>
+#include <Isen/Numa.h>
+#include <algorithm>
+#include <cmath>
+
+ISEN_NAMESPACE_BEGIN
+
+KesslerEnsemble::KesslerEnsemble(const std::vector<std::shared_ptr<NameList>>& namelists)
+    : namelist_(namelists.front()), size_(static_cast<int>(namelists.size())),
+      tier_(FastMath::toTier(namelists.front()->imath)), dt_(namelists.front()->dt)
+{
+    KESSLER_DECLARE_ALL_ALIASES
+
+    try
+    {
+        const int rows = nxb * size_;
+
+        vtFactRow_ = VectorXf::Zero(rows);
+        c1Row_ = VectorXf::Zero(rows);
+        c2Row_ = VectorXf::Zero(rows);
+
+        for(int i = 0; i < nxb; ++i)
+            for(int m = 0; m < size_; ++m)
+            {
+                vtFactRow_(i * size_ + m) = 36.34 * namelists[m]->vt_mult;
+                c1Row_(i * size_ + m) = 0.001 * namelists[m]->autoconv_mult;
+                c2Row_(i * size_ + m) = namelists[m]->autoconv_th;
+            }
+
+        nfall_.assign(size_, 0);
+        crmax_.assign(size_, 0.0);
+        dtfall_.assign(size_, 0.0);
+        timeSediment_.assign(size_, 0.0);
+        dtfallRow_ = VectorXf::Zero(rows);
+        timeSedimentRow_ = VectorXf::Zero(rows);
+        lastStepRow_.assign(rows, 0);
+
+        // Same leading dimension as the interleaved fields of SolverEnsemble
+        const int ld = FieldXf::leadingDimension(nxb1 * size_);
+        Numa::allocate(rho_, rows, nz, ld);
+        Numa::allocate(qcprod_, rows, nz, ld);
+        Numa::allocate(vtFact_, rows, nz, ld);
+        Numa::allocate(vt_, rows, nz, ld);
+        Numa::allocate(rdzw_, rows, nz, ld);
+        Numa::allocate(zw_, rows, nz, ld);
+    }
+    catch(std::bad_alloc&)
+    {
+        LOG() << logger::failed;
+        throw IsenException("out of memory");
+    }
+}
+
+void KesslerEnsemble::applyTeam(
+    // Output
+    FieldXf& temp,
+    FieldXf& qvnew,
+    FieldXf& qcnew,
+    FieldXf& qrnew,
+    VectorXf& tot_prec,
+    VectorXf& prec,
+
+    // Input
+    const VectorXf& th0,
+    const FieldXf& prs,
+    const FieldXf& snow,
+    const FieldXf& qvnow,
+    const FieldXf& qcnow,
+    const FieldXf& qrnow,
+    const FieldXf& exn,
+    const FieldXf& zhtnow) noexcept
+{
+    switch(tier_)
+    {
+        case MathTier::Polynomial:
+            applyTeam(MathPolynomial<double>(), temp, qvnew, qcnew, qrnew, tot_prec, prec, th0, prs, snow, qvnow,
+                      qcnow, qrnow, exn, zhtnow);
+            break;
+        case MathTier::Table:
+            applyTeam(MathTable<double>(), temp, qvnew, qcnew, qrnew, tot_prec, prec, th0, prs, snow, qvnow, qcnow,
+                      qrnow, exn, zhtnow);
+            break;
+        default:
+            applyTeam(MathExact<double>(), temp, qvnew, qcnew, qrnew, tot_prec, prec, th0, prs, snow, qvnow, qcnow,
+                      qrnow, exn, zhtnow);
+    }
+}
+
+void KesslerEnsemble::teamReduceCourant(const std::vector<double>& local) noexcept
+{
+#pragma omp critical(KesslerEnsembleReduceCourant)
+    for(int m = 0; m < size_; ++m)
+        crmax_[m] = std::max(crmax_[m], local[m]);
+#pragma omp barrier
+}
+
+/// Reduce the Courant numbers @c cr of a level of @c M members into their maxima @c crmax
+static void reduceLevelCourant(std::vector<double>& crmax, const std::vector<double>& cr, int nxb, int M) noexcept
+{
+    double* ISEN_RESTRICT out = crmax.data();
+    for(int i = 0; i < nxb; ++i)
+    {
+        const double* ISEN_RESTRICT in = cr.data() + i * M;
+        for(int m = 0; m < M; ++m)
+            out[m] = std::max(out[m], in[m]);
+    }
+}
+
+template <class Math>
+void KesslerEnsemble::applyTeam(
+    const Math& math,
+
+    // Output
+    FieldXf& temp,
+    FieldXf& qvnew,
+    FieldXf& qcnew,
+    FieldXf& qrnew,
+    VectorXf& tot_prec,
+    VectorXf& prec,
+
+    // Input
+    const VectorXf& th0,
+    const FieldXf& prs,
+    const FieldXf& snow,
+    const FieldXf& qvnow,
+    const FieldXf& qcnow,
+    const FieldXf& qrnow,
+    const FieldXf& exn,
+    const FieldXf& zhtnow) noexcept
+{
+    KESSLER_DECLARE_ALL_ALIASES
+
+    const int M = size_;
+    const int n = nxb * M;
+    const int ld = rho_.ld();
+    assert(prs.ld() == ld && snow.ld() == ld && zhtnow.ld() == ld);
+
+    // Define constants (see KesslerT::applyTeam)
+    //--------------------------------------------------------
+    const double dt_in = 2 * dt_;
+
+    constexpr double c3 = 2.2;
+    constexpr double c4 = 0.875;
+
+    constexpr double svp2 = 17.67;
+    constexpr double svp3 = 29.65;
+    constexpr double svpt0 = 273.15;
+
+    const double ep2 = r / r_v;
+    constexpr double xlv = 2.5 * 1e06;
+    constexpr double max_cr_sedimentation = 0.75;
+    constexpr double rhowater = 1000.;
+
+    const double f5 = svp2 * (svpt0 - svp3) * xlv / cp;
+
+    double* rho = rho_.data();
+    double* qcprod = qcprod_.data();
+    double* vtFact = vtFact_.data();
+    double* vt = vt_.data();
+    double* rdzw = rdzw_.data();
+    double* zw = zw_.data();
+
+    const double* vtFactRow = vtFactRow_.data();
+    const double* c1Row = c1Row_.data();
+    const double* c2Row = c2Row_.data();
+    const double* dtfallRow = dtfallRow_.data();
+    const double* timeSedimentRow = timeSedimentRow_.data();
+    const char* lastStepRow = lastStepRow_.data();
+
+    // Number of sedimentation sub-steps for the maximal Courant number crmax (see KesslerT::applyTeam, the maximum over
+    // all points commutes with the rounding)
+    auto nfallOf = [&](double crmax) {
+        return static_cast<int>(std::max(1.0, double(std::ceil(0.5 + crmax / max_cr_sedimentation))));
+    };
+
+    // Rows of a level (private to the calling thread)
+    std::vector<double> cr(n), th0k(n), th0k1(n), tempk(n), pressure(n), es(n), qvs(n), produc(n), ern(n);
+    std::vector<double> crmaxLocal(M, 0.0);
+
+    // Reset rain rate and the reduction variables
+    #pragma omp single
+    {
+        prec.setZero();
+        std::fill(crmax_.begin(), crmax_.end(), 0.0);
+    }
+
+    // Compute density
+    //--------------------------------------------------------
+    #pragma omp for schedule(static)
+    for(int k = 0; k < nz; ++k)
+    {
+        const int o = k * ld;
+        for(int j = o; j < o + n; ++j)
+        {
+            rho[j] = snow.data()[j] * dth / (zhtnow.data()[j + ld] - zhtnow.data()[j]);
+            rdzw[j] = 1.0 / (zhtnow.data()[j + ld] - zhtnow.data()[j]);
+        }
+
+        if(sediment_on)
+            std::copy(qrnow.data() + o, qrnow.data() + o + n, qcprod + o);
+        else
+            std::fill(qcprod + o, qcprod + o + n, 0.0);
+    }
+
+    // Terminal velocity and Courant number
+    //--------------------------------------------------------
+    #pragma omp for schedule(static) nowait
+    for(int k = 0; k < nz; ++k)
+    {
+        const int o = k * ld;
+        for(int j = 0; j < n; ++j)
+            vtFact[o + j] = vtFactRow[j] * std::sqrt(rho[j] / rho[o + j]);
+
+        // The rain water vanishes on most of the grid, pow(0, y) = 0 is skipped (see terminalVelocity)
+        for(int j = o; j < o + n; ++j)
+        {
+            const double qrr = std::max(0.0, 0.001 * qrnow.data()[j] * rho[j]);
+            vt[j] = qrr > 0.0 ? math.pow(qrr, 0.1364) * vtFact[j] : 0.0;
+        }
+
+        for(int j = 0; j < n; ++j)
+            cr[j] = std::max(0.5 * dt_in * vt[o + j] * rdzw[o + j], 0.0);
+        reduceLevelCourant(crmaxLocal, cr, nxb, M);
+    }
+    teamReduceCourant(crmaxLocal);
+
+    // Splitting so Courant number for sedimentation is stable
+    #pragma omp single
+    for(int m = 0; m < M; ++m)
+    {
+        nfall_[m] = nfallOf(crmax_[m]);
+        dtfall_[m] = dt_in / nfall_[m];
+        timeSediment_[m] = dt_in;
+    }
+
+    // Sedimentation (split loop for stability), members without sub-steps left take sub-steps of length zero
+    //--------------------------------------------------------
+    while(sediment_on && std::any_of(nfall_.begin(), nfall_.end(), [](int nfall) { return nfall > 0; }))
+    {
+        #pragma omp single
+        {
+            for(int m = 0; m < M; ++m)
+            {
+                if(nfall_[m] > 0)
+                    timeSediment_[m] = timeSediment_[m] - dtfall_[m];
+                crmax_[m] = 0.0;
+            }
+
+            for(int i = 0; i < nxb; ++i)
+                for(int m = 0; m < M; ++m)
+                {
+                    dtfallRow_(i * M + m) = nfall_[m] > 0 ? dtfall_[m] : 0.0;
+                    timeSedimentRow_(i * M + m) = timeSediment_[m];
+                    lastStepRow_[i * M + m] = nfall_[m] <= 1;
+                }
+        }
+
+        // Precipitation (mm/h) and accumulated precipitation (mm)
+        #pragma omp for schedule(static) nowait
+        for(int j = 0; j < n; ++j)
+            if(dtfallRow[j] > 0.0)
+            {
+                const double ppt = rho[j] * qcprod[j] * vt[j] * dtfallRow[j] / rhowater;
+                prec(j) = ppt * 1000 / dtfallRow[j] * 3600;
+                tot_prec(j) = tot_prec(j) + ppt * 1000;
+            }
+
+        // Time split loop, fallout with flux upstream
+        #pragma omp for schedule(static)
+        for(int k = 0; k < nz; ++k)
+            for(int j = k * ld; j < k * ld + n; ++j)
+                zw[j] = qcprod[j] * vt[j] * rho[j];
+
+        #pragma omp for schedule(static)
+        for(int k = 0; k < nz; ++k)
+        {
+            const int o = k * ld;
+            if(k < nz - 1)
+                for(int j = 0; j < n; ++j)
+                    qcprod[o + j] = qcprod[o + j]
+                                    - dtfallRow[j] * (rdzw[o + j] / rho[o + j]) * (zw[o + j] - zw[o + ld + j]);
+            else
+                for(int j = 0; j < n; ++j)
+                    qcprod[o + j] = qcprod[o + j]
+                                    - dtfallRow[j] * rdzw[o + j] * zw[o + j] / (rho[o + j] * rho[o + j]);
+        }
+
+        // Compute new sedimentation velocity and Courant number if this isn't the last split step of a member
+        if(std::any_of(nfall_.begin(), nfall_.end(), [](int nfall) { return nfall > 1; }))
+        {
+            std::fill(crmaxLocal.begin(), crmaxLocal.end(), 0.0);
+
+            #pragma omp for schedule(static) nowait
+            for(int k = 0; k < nz; ++k)
+            {
+                const int o = k * ld;
+                // The members in their last (or past their last) sub-step keep their velocity, it is only multiplied
+                // by their vanishing sub-steps from now on
+                for(int j = 0; j < n; ++j)
+                {
+                    const double qrr = std::max(0.0, 0.001 * qcprod[o + j] * rho[o + j]);
+                    if(!lastStepRow[j])
+                        vt[o + j] = qrr > 0.0 ? math.pow(qrr, 0.1364) * vtFact[o + j] : 0.0;
+                }
+
+                for(int j = 0; j < n; ++j)
+                    cr[j] = std::max(timeSedimentRow[j] * vt[o + j] * rdzw[o + j], 0.0);
+                reduceLevelCourant(crmaxLocal, cr, nxb, M);
+            }
+            teamReduceCourant(crmaxLocal);
+        }
+
+        #pragma omp single
+        for(int m = 0; m < M; ++m)
+        {
+            if(nfall_[m] > 1)
+            {
+                nfall_[m] = nfall_[m] - 1;
+
+                const int nfallNew = nfallOf(crmax_[m]);
+                if(nfallNew != nfall_[m])
+                {
+                    nfall_[m] = nfallNew;
+                    dtfall_[m] = timeSediment_[m] / nfall_[m];
+                }
+            }
+            else
+                nfall_[m] = 0;
+        }
+    }
+
+    // Production/deletion of qc and qr, saturation adjustment and evaporation of rain (a level at a time)
+    //--------------------------------------------------------
+    #pragma omp for schedule(static)
+    for(int k = 0; k < nz; ++k)
+    {
+        const int o = k * ld;
+
+        for(int i = 0; i < nxb; ++i)
+            for(int m = 0; m < M; ++m)
+            {
+                th0k[i * M + m] = th0(k * M + m);
+                th0k1[i * M + m] = th0((k + 1) * M + m);
+            }
+
+        // Production/deletion of qc and qr
+        for(int j = 0; j < n; ++j)
+        {
+            const double qrnowj = qrnow.data()[o + j];
+            const double qcnowj = qcnow.data()[o + j];
+
+            const double factorn = qrnowj > 0.0 ? 1.0 / (1.0 + c3 * dt_in * math.pow(qrnowj, c4)) : 1.0;
+            const double qrprod = qcnowj * (1.0 - factorn) + c1Row[j] * dt_in * factorn * std::max(0.0, qcnowj - c2Row[j]);
+
+            qcnew.data()[o + j] = std::max(qcnowj - qrprod, 0.0);
+            qrnew.data()[o + j] = std::max(qcprod[o + j] + qrprod, 0.0);
+        }
+
+        // Atmospheric conditions
+        for(int j = 0; j < n; ++j)
+        {
+            tempk[j] = 0.5 * ((exn.data()[o + ld + j] / cp) * th0k1[j] + (exn.data()[o + j] / cp) * th0k[j]);
+            pressure[j] = 0.5 * (prs.data()[o + j] + prs.data()[o + ld + j]);
+        }
+
+        for(int j = 0; j < n; ++j)
+            es[j] = MeteoUtils::eswat1<double>(tempk[j], math) * 100;
+
+        // Saturation adjustment: condensation/evaporation
+        for(int j = 0; j < n; ++j)
+        {
+            qvs[j] = ep2 * es[j] / (pressure[j] - es[j]);
+            produc[j] = (qvnow.data()[o + j] - qvs[j])
+                        / (1.0 + pressure[j] / (pressure[j] - es[j]) * qvs[j] * f5
+                                     / ((tempk[j] - svp3) * (tempk[j] - svp3)));
+        }
+
+        // Evaporation of rain
+        if(iern)
+        {
+            for(int j = 0; j < n; ++j)
+            {
+                const double diffDelta = qvs[j] - qvnow.data()[o + j];
+                const double diff = diffDelta < 0.0 ? 0.0 : diffDelta;
+                const double rhoqr = 0.001 * rho[o + j] * qrnew.data()[o + j];
+
+                // Without rain the evaporation vanishes, pow(0, y) = 0 is skipped
+                if(rhoqr > 0.0)
+                {
+                    ern[j] = std::min(dt_in * (((1.6 + 124.9 * math.pow(rhoqr, 0.2046)) * (math.pow(rhoqr, 0.525)))
+                                               / (2.55 * 1e08 / (pressure[j] * qvs[j] + 5.4 * 1e05)))
+                                          * (diff / (0.001 * rho[o + j] * qvs[j])),
+                                      std::max(-produc[j] - qcnew.data()[o + j], 0.0));
+                    ern[j] = std::min(ern[j], qrnew.data()[o + j]);
+                }
+                else
+                    ern[j] = 0.0;
+            }
+        }
+        else
+            std::fill(ern.begin(), ern.end(), 0.0);
+
+        // Update all variables
+        for(int j = 0; j < n; ++j)
+        {
+            const double production = std::max(produc[j], -qcnew.data()[o + j]);
+            const double gam = 2.5 * 1e06 / (1004 * 0.5 * (exn.data()[o + j] + exn.data()[o + ld + j]) / cp);
+
+            temp.data()[o + j] = gam * (production - ern[j]);
+            qvnew.data()[o + j] = std::max(qvnow.data()[o + j] - production + ern[j], 0.0);
+            qcnew.data()[o + j] = qcnew.data()[o + j] + production;
+            qrnew.data()[o + j] = qrnew.data()[o + j] - ern[j];
+        }
+    }
+}
+
+ISEN_NAMESPACE_END
@@ -76,6 +76,42 @@ void NameList::setByName(const std::string& name, const int& value)
     {
         this->iout = value;
     }
+    else if(name == "icheckpoint")
+    {
+        this->icheckpoint = value;
+    }
+    else if(name == "chunk_nt")
+    {
+        this->chunk_nt = value;
+    }
+    else if(name == "chunk_nx")
+    {
+        this->chunk_nx = value;
+    }
+    else if(name == "out_xmin")
+    {
+        this->out_xmin = value;
+    }
+    else if(name == "out_xmax")
+    {
+        this->out_xmax = value;
+    }
+    else if(name == "out_zmin")
+    {
+        this->out_zmin = value;
+    }
+    else if(name == "out_zmax")
+    {
+        this->out_zmax = value;
+    }
+    else if(name == "out_xstride")
+    {
+        this->out_xstride = value;
+    }
+    else if(name == "out_zstride")
+    {
+        this->out_zstride = value;
+    }
     else if(name == "xl")
     {
         this->xl = value;
@@ -120,6 +156,14 @@ void NameList::setByName(const std::string& name, const int& value)
     {
         this->imicrophys = value;
     }
+    else if(name == "tblock")
+    {
+        this->tblock = value;
+    }
+    else if(name == "imath")
+    {
+        this->imath = value;
+    }
     else
     {
         // Try floating point and boolean options
@@ -187,6 +231,66 @@ void NameList::setByName(const std::string& name, const double& value)
     {
         this->autoconv_mult = value;
     }
+    else if(name == "cfl_target")
+    {
+        this->cfl_target = value;
+    }
+    else if(name == "dt_grow")
+    {
+        this->dt_grow = value;
+    }
+    else if(name == "dt_shrink")
+    {
+        this->dt_shrink = value;
+    }
+    else if(name == "dt_max")
+    {
+        this->dt_max = value;
+    }
+    else if(name == "tol_z")
+    {
+        this->tol_z = value;
+    }
+    else if(name == "tol_u")
+    {
+        this->tol_u = value;
+    }
+    else if(name == "tol_s")
+    {
+        this->tol_s = value;
+    }
+    else if(name == "tol_prec")
+    {
+        this->tol_prec = value;
+    }
+    else if(name == "tol_tot_prec")
+    {
+        this->tol_tot_prec = value;
+    }
+    else if(name == "tol_qv")
+    {
+        this->tol_qv = value;
+    }
+    else if(name == "tol_qc")
+    {
+        this->tol_qc = value;
+    }
+    else if(name == "tol_qr")
+    {
+        this->tol_qr = value;
+    }
+    else if(name == "tol_nr")
+    {
+        this->tol_nr = value;
+    }
+    else if(name == "tol_nc")
+    {
+        this->tol_nc = value;
+    }
+    else if(name == "tol_dthetadt")
+    {
+        this->tol_dthetadt = value;
+    }
     else
     {
         throw IsenException("variable '%s' is not part of Namelist", name);
@@ -242,6 +346,18 @@ void NameList::setByName(const std::string& name, const bool& value)
     {
         this->sediment_on = value;
     }
+    else if(name == "imixprec")
+    {
+        this->imixprec = value;
+    }
+    else if(name == "sediment_col")
+    {
+        this->sediment_col = value;
+    }
+    else if(name == "iadapt")
+    {
+        this->iadapt = value;
+    }
     else
     {
         throw IsenException("variable '%s' is not part of Namelist", name);
@@ -257,6 +373,18 @@ void NameList::setByName(const std::string& name, const std::string& value)
     {
         this->run_name = value;
     }
+    else if(name == "compression")
+    {
+        this->compression = value;
+    }
+    else if(name == "encoding")
+    {
+        this->encoding = value;
+    }
+    else if(name == "out_fields")
+    {
+        this->out_fields = value;
+    }
     else
     {
         throw IsenException("variable '%s' is not part of Namelist", name);
@@ -275,6 +403,29 @@ void NameList::print(std::ostream& out, bool color) const
     out << internal::printHelper("run_name", this->run_name);
     out << internal::printHelper("iout", this->iout);
     out << internal::printHelper("iiniout", this->iiniout);
+    out << internal::printHelper("icheckpoint", this->icheckpoint);
+    out << internal::printHelper("compression", this->compression);
+    out << internal::printHelper("chunk_nt", this->chunk_nt);
+    out << internal::printHelper("chunk_nx", this->chunk_nx);
+    out << internal::printHelper("encoding", this->encoding);
+    out << internal::printHelper("tol_z", this->tol_z);
+    out << internal::printHelper("tol_u", this->tol_u);
+    out << internal::printHelper("tol_s", this->tol_s);
+    out << internal::printHelper("tol_prec", this->tol_prec);
+    out << internal::printHelper("tol_tot_prec", this->tol_tot_prec);
+    out << internal::printHelper("tol_qv", this->tol_qv);
+    out << internal::printHelper("tol_qc", this->tol_qc);
+    out << internal::printHelper("tol_qr", this->tol_qr);
+    out << internal::printHelper("tol_nr", this->tol_nr);
+    out << internal::printHelper("tol_nc", this->tol_nc);
+    out << internal::printHelper("tol_dthetadt", this->tol_dthetadt);
+    out << internal::printHelper("out_fields", this->out_fields);
+    out << internal::printHelper("out_xmin", this->out_xmin);
+    out << internal::printHelper("out_xmax", this->out_xmax);
+    out << internal::printHelper("out_zmin", this->out_zmin);
+    out << internal::printHelper("out_zmax", this->out_zmax);
+    out << internal::printHelper("out_xstride", this->out_xstride);
+    out << internal::printHelper("out_zstride", this->out_zstride);
 
     internal::header(out, color, "Domain size");
     out << internal::printHelper("xl", this->xl);
@@ -285,6 +436,11 @@ void NameList::print(std::ostream& out, bool color) const
     out << internal::printHelper("time", this->time);
     out << internal::printHelper("dt", this->dt);
     out << internal::printHelper("diff", this->diff);
+    out << internal::printHelper("iadapt", this->iadapt);
+    out << internal::printHelper("cfl_target", this->cfl_target);
+    out << internal::printHelper("dt_grow", this->dt_grow);
+    out << internal::printHelper("dt_shrink", this->dt_shrink);
+    out << internal::printHelper("dt_max", this->dt_max);
 
     internal::header(out, color, "Topography");
     out << internal::printHelper("topomx", this->topomx);
@@ -323,6 +479,12 @@ void NameList::print(std::ostream& out, bool color) const
     out << internal::printHelper("autoconv_th", this->autoconv_th);
     out << internal::printHelper("autoconv_mult", this->autoconv_mult);
     out << internal::printHelper("sediment_on", this->sediment_on);
+    out << internal::printHelper("sediment_col", this->sediment_col);
+
+    internal::header(out, color, "Solver options");
+    out << internal::printHelper("tblock", this->tblock);
+    out << internal::printHelper("imixprec", this->imixprec);
+    out << internal::printHelper("imath", this->imath);
 
     internal::header(out, color, "Computed input parameters");
     out << internal::printHelper("dx", this->dx);    
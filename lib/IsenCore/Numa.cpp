@@ -0,0 +1,306 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#include <Isen/Numa.h>
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <sstream>
+#include <vector>
+
+#ifdef ISEN_NUMA
+#include <numa.h>
+#include <numaif.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+ISEN_NAMESPACE_BEGIN
+
+namespace
+{
+
+/// Placement policy used for new allocations
+NumaPolicy& activePolicy() noexcept
+{
+    static NumaPolicy policy = NumaPolicy::FirstTouch;
+    return policy;
+}
+
+#ifdef ISEN_NUMA
+
+/// Check if the kernel supports the NUMA API (numa_available has to be called before any other libnuma function)
+bool libnumaAvailable() noexcept
+{
+    static const bool available = numa_available() >= 0;
+    return available;
+}
+
+/// Node of the CPU the calling thread is running on
+int currentNode() noexcept
+{
+    const int cpu = sched_getcpu();
+    return cpu < 0 ? 0 : std::max(0, numa_node_of_cpu(cpu));
+}
+
+/// Extend the memory range [ptr, ptr + bytes) to page boundaries, returns the first page and the number of pages
+std::size_t pageRange(const void* ptr, std::size_t bytes, char*& first) noexcept
+{
+    const std::uintptr_t pageSize = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(ptr) & ~(pageSize - 1);
+    const std::uintptr_t end = reinterpret_cast<std::uintptr_t>(ptr) + bytes;
+    first = reinterpret_cast<char*>(begin);
+    return (end - begin + pageSize - 1) / pageSize;
+}
+
+#endif
+
+/// @brief Apply the placement policy to the memory range [ptr, ptr + bytes) before it is touched
+///
+/// In contrast to NumaScope, the policy is attached to the memory range itself and thus independent of the thread
+/// which touches the pages first.
+void placeRange(void* ptr, std::size_t bytes) noexcept
+{
+#ifdef ISEN_NUMA
+    if(activePolicy() == NumaPolicy::FirstTouch || bytes == 0)
+        return;
+
+    char* first;
+    const std::size_t numPages = pageRange(ptr, bytes, first);
+    const std::size_t length = numPages * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+
+    if(activePolicy() == NumaPolicy::Interleave)
+        numa_interleave_memory(first, length, numa_all_nodes_ptr);
+    else
+        numa_tonode_memory(first, length, currentNode());
+#else
+    (void)ptr;
+    (void)bytes;
+#endif
+}
+
+/// Binding of the OpenMP threads to the cores
+const char* threadBinding() noexcept
+{
+#if defined(_OPENMP) && _OPENMP >= 201307
+    switch(omp_get_proc_bind())
+    {
+        case omp_proc_bind_false:
+            return "threads not bound";
+        case omp_proc_bind_master:
+            return "threads bound (master)";
+        case omp_proc_bind_close:
+            return "threads bound (close)";
+        case omp_proc_bind_spread:
+            return "threads bound (spread)";
+        default:
+            return "threads bound";
+    }
+#else
+    return "thread binding unknown";
+#endif
+}
+
+} // anonymous namespace
+
+NumaPolicy Numa::getPolicy() noexcept
+{
+    return activePolicy();
+}
+
+void Numa::setPolicy(NumaPolicy policy)
+{
+    if(!isAvailable(policy))
+        throw IsenException("NUMA policy '%s' requires libnuma", toString(policy));
+    activePolicy() = policy;
+}
+
+bool Numa::isAvailable(NumaPolicy policy) noexcept
+{
+    if(policy == NumaPolicy::FirstTouch)
+        return true;
+#ifdef ISEN_NUMA
+    return libnumaAvailable();
+#else
+    return false;
+#endif
+}
+
+int Numa::numNodes() noexcept
+{
+#ifdef ISEN_NUMA
+    if(libnumaAvailable())
+        return std::max(1, numa_num_configured_nodes());
+#endif
+    return 1;
+}
+
+template <class T>
+void Numa::allocate(MatrixX<T>& mat, int rows, int cols)
+{
+    mat.resize(rows, cols);
+
+    T* data = mat.data();
+    placeRange(data, sizeof(T) * mat.size());
+
+    // First touch with the same partitioning of the levels as the kernels
+#pragma omp parallel for schedule(static)
+    for(int k = 0; k < cols; ++k)
+        std::fill(data + std::size_t(k) * rows, data + std::size_t(k + 1) * rows, T(0));
+}
+
+template <class T>
+void Numa::allocate(Field<T>& field, int rows, int cols, int ld)
+{
+    field.resize(rows, cols, ld);
+
+    T* data = field.data();
+    const std::size_t stride = field.ld();
+    placeRange(data, sizeof(T) * field.capacity());
+
+#pragma omp parallel for schedule(static)
+    for(int k = 0; k < cols; ++k)
+        std::fill(data + k * stride, data + (k + 1) * stride, T(0));
+}
+
+template <class T>
+void Numa::allocate(TracerField<T>& tracers, int numTracers, int rows, int cols, int ld)
+{
+    tracers.resize(numTracers, rows, cols, ld);
+    if(numTracers == 0)
+        return;
+
+    T* data = tracers.data();
+    const std::size_t tracerStride = tracers.stride();
+    const std::size_t stride = tracers[0].ld();
+    placeRange(data, sizeof(T) * tracers.capacity());
+
+#pragma omp parallel for schedule(static)
+    for(int k = 0; k < cols; ++k)
+        for(int t = 0; t < numTracers; ++t)
+            std::fill(data + t * tracerStride + k * stride, data + t * tracerStride + (k + 1) * stride, T(0));
+}
+
+template void Numa::allocate<double>(MatrixX<double>& mat, int rows, int cols);
+template void Numa::allocate<float>(MatrixX<float>& mat, int rows, int cols);
+template void Numa::allocate<double>(Field<double>& field, int rows, int cols, int ld);
+template void Numa::allocate<float>(Field<float>& field, int rows, int cols, int ld);
+template void Numa::allocate<double>(TracerField<double>& tracers, int numTracers, int rows, int cols, int ld);
+template void Numa::allocate<float>(TracerField<float>& tracers, int numTracers, int rows, int cols, int ld);
+
+std::string Numa::describe(const void* ptr, std::size_t bytes)
+{
+    std::ostringstream ss;
+    const int nodes = numNodes();
+    ss << toString(getPolicy()) << ", " << nodes << (nodes == 1 ? " node" : " nodes");
+
+#ifdef ISEN_NUMA
+    // Query the node of each page (without moving them)
+    if(libnumaAvailable() && nodes > 1 && bytes > 0)
+    {
+        char* first;
+        const std::size_t numPages = pageRange(ptr, bytes, first);
+        const std::size_t pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+
+        std::vector<void*> pages(numPages);
+        std::vector<int> status(numPages, -1);
+        for(std::size_t i = 0; i < numPages; ++i)
+            pages[i] = first + i * pageSize;
+
+        std::vector<std::size_t> pagesPerNode(numa_max_node() + 1, 0);
+        std::size_t placedPages = 0;
+        if(move_pages(0, numPages, pages.data(), nullptr, status.data(), 0) == 0)
+            for(int node : status)
+                if(node >= 0 && node < static_cast<int>(pagesPerNode.size()))
+                {
+                    ++pagesPerNode[node];
+                    ++placedPages;
+                }
+
+        if(placedPages > 0)
+        {
+            ss << " (";
+            bool firstNode = true;
+            for(std::size_t node = 0; node < pagesPerNode.size(); ++node)
+            {
+                if(pagesPerNode[node] == 0)
+                    continue;
+                ss << (firstNode ? "" : ", ") << (100 * pagesPerNode[node] + placedPages / 2) / placedPages
+                   << "% node " << node;
+                firstNode = false;
+            }
+            ss << ")";
+        }
+    }
+#else
+    (void)ptr;
+    (void)bytes;
+#endif
+
+    ss << ", " << threadBinding();
+    return ss.str();
+}
+
+const char* Numa::toString(NumaPolicy policy) noexcept
+{
+    switch(policy)
+    {
+        case NumaPolicy::Interleave:
+            return "interleave";
+        case NumaPolicy::Bind:
+            return "bind";
+        default:
+            return "first-touch";
+    }
+}
+
+NumaPolicy Numa::fromString(const std::string& str)
+{
+    for(auto policy : {NumaPolicy::FirstTouch, NumaPolicy::Interleave, NumaPolicy::Bind})
+        if(str == toString(policy))
+            return policy;
+    throw IsenException("invalid NUMA policy '%s'", str);
+}
+
+NumaScope::NumaScope() noexcept : active_(false)
+{
+#ifdef ISEN_NUMA
+    if(Numa::getPolicy() == NumaPolicy::Interleave)
+    {
+        numa_set_interleave_mask(numa_all_nodes_ptr);
+        active_ = true;
+    }
+    else if(Numa::getPolicy() == NumaPolicy::Bind)
+    {
+        struct bitmask* nodes = numa_allocate_nodemask();
+        numa_bitmask_setbit(nodes, currentNode());
+        numa_set_membind(nodes);
+        numa_free_nodemask(nodes);
+        active_ = true;
+    }
+#endif
+}
+
+NumaScope::~NumaScope()
+{
+#ifdef ISEN_NUMA
+    if(active_)
+        numa_set_localalloc();
+#endif
+}
+
+ISEN_NAMESPACE_END
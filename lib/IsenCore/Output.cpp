@@ -11,9 +11,12 @@
  *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
  */
 
+#include <Isen/Checkpoint.h>
 #include <Isen/Logger.h>
+#include <Isen/Numa.h>
 #include <Isen/Output.h>
 #include <Isen/Solver.h>
+#include <algorithm>
 #include <array>
 #include <boost/archive/binary_iarchive.hpp>
 #include <boost/archive/binary_oarchive.hpp>
@@ -22,51 +25,138 @@
 #include <boost/archive/xml_iarchive.hpp>
 #include <boost/archive/xml_oarchive.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/make_shared.hpp>
+#include <cstdio>
+#include <cstring>
 #include <ctime>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 ISEN_NAMESPACE_BEGIN
 
-Output::Output(Output::ArchiveType archiveType) : archiveType_(archiveType), curIt_(0)
+namespace internal
+{
+
+/// Names of the fields in NameList::out_fields (separated by ':' or ',')
+inline std::vector<std::string> splitFields(const std::string& list)
+{
+    std::vector<std::string> names;
+    std::size_t first = 0;
+    while(first <= list.size())
+    {
+        const std::size_t last = std::min(list.find_first_of(":,", first), list.size());
+        if(last > first)
+            names.push_back(list.substr(first, last - first));
+        first = last + 1;
+    }
+    return names;
+}
+
+/// @brief Columns and levels of a tile of the transposed copy
+///
+/// The columns of a tile are the unit of work of a task, the levels keep the cache lines of the field touched by a
+/// tile (4 lines wide, one per level) in the cache until all columns they hold are copied.
+constexpr int OutputTileColumns = 32;
+constexpr int OutputTileLevels = 256;
+
+/// Element of the field at @c p (averaged with its right neighbour if the field is staggered)
+template <bool Staggered, class T>
+inline double sample(const T* p) noexcept
+{
+    return Staggered ? 0.5 * (double(p[0]) + double(p[1])) : double(p[0]);
+}
+
+/// @brief Copy the columns [i0, i1) of the output window @c src to the frame @c out (transposed)
+///
+/// The element (i, k) of the window is src[i * xstride + k * kstride] and is stored at out[i * levels + k], i.e each
+/// column is written contiguously.
+template <bool Staggered, class T>
+inline void transposeColumns(const T* src, std::ptrdiff_t xstride, std::ptrdiff_t kstride, int levels, int i0, int i1,
+                             double* out) noexcept
+{
+    for(int k0 = 0; k0 < levels; k0 += OutputTileLevels)
+    {
+        const int k1 = std::min(k0 + OutputTileLevels, levels);
+        for(int i = i0; i < i1; ++i)
+        {
+            const T* col = src + i * xstride + k0 * kstride;
+            double* row = out + std::size_t(i) * levels;
+            for(int k = k0; k < k1; ++k, col += kstride)
+                row[k] = sample<Staggered>(col);
+        }
+    }
+}
+
+/// Copy the columns [i0, i1) of the output window of @c mat to the frame @c out (see transposeColumns)
+template <class T>
+inline void copyWindow(const Field<T>& mat, const OutputWindow& window, int nb, bool staggered, int levels, int i0,
+                       int i1, double* out) noexcept
+{
+    const std::ptrdiff_t ld = mat.ld();
+    const T* src = mat.data() + window.zmin * ld + window.xmin + (staggered ? 0 : nb);
+    if(staggered)
+        transposeColumns<true>(src, window.xstride, window.zstride * ld, levels, i0, i1, out);
+    else
+        transposeColumns<false>(src, window.xstride, window.zstride * ld, levels, i0, i1, out);
+}
+}
+
+Output::Output(Output::ArchiveType archiveType)
+    : archiveType_(archiveType), curIt_(0), copySolver_(nullptr), streaming_(false), discard_(false)
 {
 }
 
 Output::Output(std::shared_ptr<NameList> namelist, Output::ArchiveType archiveType)
-    : archiveType_(archiveType), namelist_(internal::make_shared_ptr(namelist)), curIt_(0)
+    : archiveType_(archiveType), namelist_(internal::make_shared_ptr(namelist)), curIt_(0), copySolver_(nullptr),
+      streaming_(archiveType == Stream || archiveType == Chunked), discard_(false)
 {
     SOLVER_DECLARE_ALL_ALIASES
 
+    // Fail before the simulation if the codec isn't available or the selection is invalid
+    if(archiveType_ == Chunked)
+    {
+        Compression::fromString(compression);
+        Encoding::fromString(encoding);
+    }
+
+    if(!OutputWindow(*namelist_).valid(*namelist_))
+        throw IsenException("invalid output window: x in [%i, %i) with stride %i, z in [%i, %i) with stride %i "
+                            "(nx = %i, nz = %i)",
+                            out_xmin, out_xmax, out_xstride, out_zmin, out_zmax, out_zstride, nx, nz);
+
+    if(out_fields != "all")
+    {
+        const std::vector<FrameField> fields = frameFields(true);
+        const std::vector<std::string> names = internal::splitFields(out_fields);
+        if(names.empty())
+            throw IsenException("no output fields selected");
+
+        for(const std::string& name : names)
+            if(name != "t" && std::none_of(fields.begin(), fields.end(),
+                                           [&](const FrameField& field) { return name == field.name; }))
+                throw IsenException("output field '%s' is unknown or not available", name);
+    }
+
     Timer t;
     LOG() << "Preparing output ... " << logger::flush;
 
-    // Allocate memory
+    // Allocate memory. The buffers are written by the master thread (see Output::makeOutput), its first touch in the
+    // constructor places them on the right node. Explicit policies are applied via NumaScope. Streamed frames only
+    // need the buffers of the writer (see OutputStream and OutputStore).
     try
     {
-        outputData_.z.resize(nout * nz1 * nx);
-        outputData_.u.resize(nout * nz * nx);
-        outputData_.s.resize(nout * nz * nx);
-        outputData_.t.resize(nout);
+        NumaScope numaScope;
 
-        if(imoist)
+        if(!streaming_)
         {
-            outputData_.prec.resize(nout * nx);
-            outputData_.tot_prec.resize(nout * nx);
-            outputData_.qv.resize(nout * nz * nx);
-            outputData_.qc.resize(nout * nz * nx);
-            outputData_.qr.resize(nout * nz * nx);
-
-            if(imicrophys == 2)
-            {
-                outputData_.nr.resize(nout * nz * nx);
-                outputData_.nc.resize(nout * nz * nx);
-            }
-
-            if(idthdt)
-            {
-                outputData_.dthetadt.resize(nout * nz * nx);
-            }
+            for(const FrameField& field : frameFields())
+                field.data->resize(nout * field.size);
+            outputData_.t.resize(nout);
         }
     }
     catch(std::bad_alloc&)
@@ -81,120 +171,404 @@ Output::Output(std::shared_ptr<NameList> namelist, Output::ArchiveType archiveTy
     LOG_SUCCESS(t);
 }
 
-void Output::makeOutput(const Solver* solver) noexcept
+std::vector<Output::FrameField> Output::frameFields(bool all) const
 {
     SOLVER_DECLARE_ALL_ALIASES
-    
-    // Height in z-coordinates (transposed)
-    const auto& zhtnow = solver->getMat("zhtnow");            
-    auto it_z = outputData_.z.begin() + curIt_ * nz1 * nx;
-    for(int i = nb; i < (nx + nb); ++i)
-        for(int k = 0; k < nz1; ++k, ++it_z)
-            *it_z = zhtnow(i, k);
-
-    // Horizontal velocity (transposed)
-    const auto& unow = solver->getMat("unow");
-    auto it_u = outputData_.u.begin() + curIt_ * nz * nx;
-    for(int i = 0; i < nx; ++i)
-        for(int k = 0; k < nz; ++k, ++it_u)
-            *it_u = 0.5 * (unow(i, k) + unow(i + 1, k));
-
-    // Isentropic density (transposed)
-    const auto& snow = solver->getMat("snow");                
-    auto it_s = outputData_.s.begin() + curIt_ * nz * nx;
-    for(int i = nb; i < (nx + nb); ++i)
-        for(int k = 0; k < nz; ++k, ++it_s)
-            *it_s = snow(i, k);
 
-    // Time vector
-    outputData_.t[curIt_] = curIt_ * iout * dt;
+    const OutputWindow window(*namelist_);
+    const std::size_t nxOut = window.nx();
+    const int nzOut = window.nz();
+    const int nz1Out = window.nz1();
 
+    std::vector<FrameField> fields{{"z", &outputData_.z, nz1Out * nxOut, tol_z, "zhtnow", nz1Out},
+                                   {"u", &outputData_.u, nzOut * nxOut, tol_u, "unow", nzOut},
+                                   {"s", &outputData_.s, nzOut * nxOut, tol_s, "snow", nzOut}};
     if(imoist)
     {
-        // Precipitation
-        const auto& prec = solver->getVec("prec");
-        auto it_prec = outputData_.prec.begin() + curIt_ * nx;
-        for(int i = nb; i < (nx + nb); ++i, ++it_prec)
-            *it_prec = prec(i);
-
-        // Accumulated precipitation
-        const auto& tot_prec = solver->getVec("tot_prec");
-        auto it_tot_prec = outputData_.tot_prec.begin() + curIt_ * nx;
-        for(int i = nb; i < (nx + nb); ++i, ++it_tot_prec)
-            *it_tot_prec = tot_prec(i);
-
-        // Specific humidity (transposed)
-        const auto& qvnow = solver->getMat("qvnow");
-        auto it_qv = outputData_.qv.begin() + curIt_ * nz * nx;
-        for(int i = nb; i < (nx + nb); ++i)
-            for(int k = 0; k < nz; ++k, ++it_qv)
-                *it_qv = qvnow(i, k);
-
-        // Specific cloud water content (transposed)
-        const auto& qcnow = solver->getMat("qcnow");
-        auto it_qc = outputData_.qc.begin() + curIt_ * nz * nx;
-        for(int i = nb; i < (nx + nb); ++i)
-            for(int k = 0; k < nz; ++k, ++it_qc)
-                *it_qc = qcnow(i, k);
-
-        // Specific rain water content (transposed)
-        const auto& qrnow = solver->getMat("qrnow");
-        auto it_qr = outputData_.qr.begin() + curIt_ * nz * nx;
-        for(int i = nb; i < (nx + nb); ++i)
-            for(int k = 0; k < nz; ++k, ++it_qr)
-                *it_qr = qrnow(i, k);
+        fields.push_back({"prec", &outputData_.prec, nxOut, tol_prec, "prec", 0});
+        fields.push_back({"tot_prec", &outputData_.tot_prec, nxOut, tol_tot_prec, "tot_prec", 0});
+        fields.push_back({"qv", &outputData_.qv, nzOut * nxOut, tol_qv, "qvnow", nzOut});
+        fields.push_back({"qc", &outputData_.qc, nzOut * nxOut, tol_qc, "qcnow", nzOut});
+        fields.push_back({"qr", &outputData_.qr, nzOut * nxOut, tol_qr, "qrnow", nzOut});
 
         if(imicrophys == 2)
         {
-            // Rain-droplet number density (transposed)
-            //TODO...
-
-            // Cloud droplet number density (transposed)
-            //TODO...
+            fields.push_back({"nr", &outputData_.nr, nzOut * nxOut, tol_nr, nullptr, nzOut});
+            fields.push_back({"nc", &outputData_.nc, nzOut * nxOut, tol_nc, nullptr, nzOut});
         }
 
         if(idthdt)
+            fields.push_back({"dthetadt", &outputData_.dthetadt, nzOut * nxOut, tol_dthetadt, nullptr, nzOut});
+    }
+
+    if(all || out_fields == "all")
+        return fields;
+
+    const std::vector<std::string> names = internal::splitFields(out_fields);
+    fields.erase(std::remove_if(fields.begin(), fields.end(),
+                                [&](const FrameField& field) {
+                                    return std::find(names.begin(), names.end(), field.name) == names.end();
+                                }),
+                 fields.end());
+    return fields;
+}
+
+OutputLayout Output::streamLayout() const
+{
+    OutputLayout layout;
+    for(const FrameField& field : frameFields())
+        layout.emplace_back(field.name, field.size);
+    return layout;
+}
+
+const std::vector<double>& Output::load(const char* name, std::vector<double>& data) const
+{
+    if(!source_ || !data.empty())
+        return data;
+
+    const int numFrames = source_->numFrames();
+    if(std::strcmp(name, "t") == 0)
+    {
+        data.resize(numFrames);
+        for(int n = 0; n < numFrames; ++n)
+            data[n] = source_->time(n);
+    }
+    else if(source_->has(name))
+    {
+        const std::size_t size = source_->size(name);
+        data.resize(numFrames * size);
+        for(int n = 0; n < numFrames; ++n)
+            std::copy_n(source_->frame(name, n), size, data.data() + n * size);
+    }
+    return data;
+}
+
+void Output::loadAll() const
+{
+    if(!source_)
+        return;
+
+    load("t", outputData_.t);
+    for(const FrameField& field : frameFields())
+        load(field.name, *field.data);
+}
+
+int Output::numFrames() const
+{
+    return source_ ? source_->numFrames() : static_cast<int>(outputData_.t.size());
+}
+
+double Output::time(int n) const
+{
+    if(source_)
+        return source_->time(n);
+
+    if(n < 0 || n >= numFrames())
+        throw IsenException("Output: frame %i is out of range [0, %i)", n, numFrames());
+    return outputData_.t[n];
+}
+
+bool Output::has(const std::string& name) const
+{
+    if(name == "t")
+        return true;
+    if(source_)
+        return source_->has(name);
+
+    const std::vector<FrameField> fields = frameFields();
+    return std::any_of(fields.begin(), fields.end(), [&](const FrameField& field) { return name == field.name; });
+}
+
+int Output::frameNx() const
+{
+    return OutputWindow(*namelist_).nx();
+}
+
+int Output::frameNz(const std::string& name) const
+{
+    for(const FrameField& field : frameFields())
+        if(name == field.name)
+            return field.levels;
+    throw IsenException("Output: no field named '%s'", name);
+}
+
+std::size_t Output::frameSize(const std::string& name) const
+{
+    if(source_)
+        return source_->size(name);
+
+    for(const FrameField& field : frameFields())
+        if(name == field.name)
+            return field.size;
+    throw IsenException("Output: no field named '%s'", name);
+}
+
+double Output::errorBound(const std::string& name) const
+{
+    if(source_)
+        return source_->bound(name);
+
+    frameSize(name);
+    return 0.0;
+}
+
+const double* Output::frame(const std::string& name, int n) const
+{
+    if(source_)
+        return source_->frame(name, n);
+
+    const std::size_t size = frameSize(name);
+    for(const FrameField& field : frameFields())
+        if(name == field.name)
         {
-            // Latent heating
-            //TODO...
+            if(n < 0 || n >= numFrames() || field.data->size() < (n + 1) * size)
+                throw IsenException("Output: frame %i is out of range [0, %i)", n, numFrames());
+            return field.data->data() + n * size;
         }
+    return nullptr;
+}
+
+std::shared_ptr<OutputSink> Output::openSink(const std::string& filename, std::uint64_t offset, int frame) const
+{
+    if(archiveType_ == ArchiveType::Chunked)
+    {
+        std::vector<double> bounds;
+        for(const FrameField& field : frameFields())
+            bounds.push_back(field.bound);
+        return std::make_shared<OutputStore>(filename, *namelist_, streamLayout(),
+                                             Compression::fromString(namelist_->compression), namelist_->chunk_nt,
+                                             namelist_->chunk_nx, Encoding::fromString(namelist_->encoding), bounds,
+                                             0, offset, frame);
     }
+    return std::make_shared<OutputStream>(filename, *namelist_, streamLayout(), 3, offset);
+}
 
-    ++curIt_;
+double* Output::acquireStreamFrame() noexcept
+{
+    if(streamError_)
+        return nullptr;
+
+    try
+    {
+        if(!stream_)
+            stream_ = openSink(makeFilename());
+        return stream_->acquire();
+    }
+    catch(...)
+    {
+        streamError_ = std::current_exception();
+        return nullptr;
+    }
 }
 
-void Output::write(std::string filename)
+void Output::discardFrames()
 {
-    if(filename.empty())
+    discard_ = true;
+    streaming_ = false;
+    outputData_ = internal::OutputData();
+}
+
+void Output::resolveCopies(const Solver* solver)
+{
+    copies_.clear();
+    for(const FrameField& field : frameFields())
     {
-        std::string ext;
-        switch(archiveType_)
+        FrameCopy copy{nullptr, nullptr, nullptr, nullptr, std::strcmp(field.name, "u") == 0};
+        if(field.source && field.levels > 0)
         {
-            case ArchiveType::Text:
-                ext = ".txt";
-                break;
-            case ArchiveType::Xml:
-                ext = ".xml";
-                break;
-            case ArchiveType::Binary:
-                ext = ".bin";
-                break;
-            default:
-                throw IsenException("unknown archive type");
+            if(!(copy.matF32 = solver->getMatF32(field.source)))
+                copy.mat = &solver->getMat(field.source);
         }
+        else if(field.source)
+        {
+            if(!(copy.vecF32 = solver->getVecF32(field.source)))
+                copy.vec = &solver->getVec(field.source);
+        }
+        copies_.push_back(copy);
+    }
+    copySolver_ = solver;
+}
 
-        // Create (unique) file
-        filename = namelist_->run_name;
-        if(boost::filesystem::exists(filename + ext))
+void Output::makeOutput(const Solver* solver) noexcept
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    if(discard_)
+    {
+        ++curIt_;
+        return;
+    }
+
+    // The frame is either stored in the buffers of all frames or handed to the stream writer. The fields are visited
+    // in the order of Output::frameFields.
+    double* frame = nullptr;
+    std::size_t offset = 1;
+    if(streaming_ && !(frame = acquireStreamFrame()))
+    {
+        ++curIt_;
+        return;
+    }
+
+    auto target = [&](std::vector<double>& data, std::size_t size) -> double* {
+        if(!frame)
+            return data.data() + curIt_ * size;
+        double* ptr = frame + offset;
+        offset += size;
+        return ptr;
+    };
+
+    // Time vector
+    if(frame)
+        frame[0] = curIt_ * iout * dt;
+    else
+        outputData_.t[curIt_] = curIt_ * iout * dt;
+
+    // Columns i and levels k of the output window are copied (transposed), the cell-centered fields are offset by the
+    // halo while the staggered velocity is averaged to the cell centers
+    if(copySolver_ != solver)
+        resolveCopies(solver);
+
+    const std::vector<FrameField> fields = frameFields();
+    const OutputWindow window(*namelist_);
+    const int nxOut = window.nx();
+    std::vector<double*> targets;
+    for(std::size_t f = 0; f < fields.size(); ++f)
+    {
+        const FrameCopy& copy = copies_[f];
+        double* it = target(*fields[f].data, fields[f].size);
+        targets.push_back(it);
+
+        if(copy.hasVector())
+        {
+            // Precipitation and accumulated precipitation
+            for(int i = window.xmin; i < window.xmax; i += window.xstride, ++it)
+                *it = copy.vec ? (*copy.vec)(i + nb) : double((*copy.vecF32)(i + nb));
+        }
+        else if(!copy.hasLevels() && frame)
         {
-            std::array<char, 80> buffer;
-            auto t = std::time(nullptr);
-            auto tm = std::localtime(&t);
+            std::fill_n(it, fields[f].size, 0.0);
+        }
+    }
 
-            std::strftime(buffer.data(), buffer.size(), "-%H-%M-%S", tm);
-            filename += std::string(buffer.data());
+    auto copyColumns = [&](std::size_t f, int i0, int i1) noexcept {
+        const FrameCopy& copy = copies_[f];
+        if(copy.mat)
+            internal::copyWindow(*copy.mat, window, nb, copy.staggered, fields[f].levels, i0, i1, targets[f]);
+        else
+            internal::copyWindow(*copy.matF32, window, nb, copy.staggered, fields[f].levels, i0, i1, targets[f]);
+    };
+
+    auto copyAll = [&]() noexcept {
+        for(std::size_t f = 0; f < copies_.size(); ++f)
+            if(copies_[f].hasLevels())
+                copyColumns(f, 0, nxOut);
+    };
+
+#if defined(_OPENMP) && _OPENMP >= 200805
+    auto spawnCopies = [&]() noexcept {
+        for(std::size_t f = 0; f < copies_.size(); ++f)
+            if(copies_[f].hasLevels())
+                for(int i0 = 0; i0 < nxOut; i0 += internal::OutputTileColumns)
+                {
+#pragma omp task firstprivate(f, i0)
+                    copyColumns(f, i0, std::min(i0 + internal::OutputTileColumns, nxOut));
+                }
+#pragma omp taskwait
+    };
+
+    // Without other threads to execute them, the tasks are pure overhead
+    if(omp_in_parallel())
+    {
+        if(omp_get_num_threads() > 1)
+            spawnCopies();
+        else
+            copyAll();
+    }
+    else if(omp_get_max_threads() > 1)
+    {
+#pragma omp parallel
+#pragma omp single
+        spawnCopies();
+    }
+    else
+        copyAll();
+#else
+    copyAll();
+#endif
+
+    if(frame)
+        stream_->submit();
+
+    ++curIt_;
+}
+
+std::string Output::makeFilename() const
+{
+    if(!filename_.empty())
+        return filename_;
+
+    std::string ext = extension(archiveType_);
+
+    // Create (unique) file
+    std::string filename = namelist_->run_name;
+    if(boost::filesystem::exists(filename + ext))
+    {
+        std::array<char, 80> buffer;
+        auto t = std::time(nullptr);
+        auto tm = std::localtime(&t);
+
+        std::strftime(buffer.data(), buffer.size(), "-%H-%M-%S", tm);
+        filename += std::string(buffer.data());
+    }
+    return filename + ext;
+}
+
+void Output::write(std::string filename)
+{
+    if(streaming_)
+    {
+        Timer t;
+        LOG() << "Writing to '" << (filename.empty() && stream_ ? stream_->filename() : filename) << "' ..."
+              << logger::flush;
+        try
+        {
+            if(streamError_)
+                std::rethrow_exception(streamError_);
+
+            // Without any frame the archive consists of the header only
+            if(!stream_)
+                stream_ = openSink(filename.empty() ? makeFilename() : filename);
+            else if(!filename.empty() && filename != stream_->filename())
+                throw IsenException("the frames were streamed to '%s' (set the output file before the simulation)",
+                                    stream_->filename());
+            stream_->close();
         }
-        filename += ext;
+        catch(...)
+        {
+            LOG() << logger::failed;
+            throw;
+        }
+        LOG_SUCCESS(t);
+        return;
+    }
+
+    if(filename.empty())
+        filename = makeFilename();
+
+    // The file may replace the mapped or chunked archive
+    loadAll();
+    source_.reset();
+
+    if(archiveType_ == ArchiveType::Stream || archiveType_ == ArchiveType::Chunked)
+    {
+        writeStream(filename);
+        return;
+    }
+
+    if(archiveType_ == ArchiveType::Mapped)
+    {
+        writeMapped(filename);
+        return;
     }
 
     std::ios_base::openmode flags
@@ -243,6 +617,27 @@ void Output::write(std::string filename)
     LOG_SUCCESS(t);
 }
 
+std::string Output::extension(ArchiveType archiveType)
+{
+    switch(archiveType)
+    {
+        case ArchiveType::Text:
+            return ".txt";
+        case ArchiveType::Xml:
+            return ".xml";
+        case ArchiveType::Binary:
+            return ".bin";
+        case ArchiveType::Stream:
+            return ".isen";
+        case ArchiveType::Mapped:
+            return ".imap";
+        case ArchiveType::Chunked:
+            return ".ichk";
+        default:
+            throw IsenException("unknown archive type");
+    }
+}
+
 void Output::read(const std::string& filename)
 {
     Timer t;
@@ -259,6 +654,12 @@ void Output::read(const std::string& filename)
             archiveType_ = ArchiveType::Xml;
         else if(ext == ".bin")
             archiveType_ = ArchiveType::Binary;
+        else if(ext == ".isen")
+            archiveType_ = ArchiveType::Stream;
+        else if(ext == ".imap")
+            archiveType_ = ArchiveType::Mapped;
+        else if(ext == ".ichk")
+            archiveType_ = ArchiveType::Chunked;
         else
         {
             LOG() << logger::failed;
@@ -266,6 +667,47 @@ void Output::read(const std::string& filename)
         }
     }
 
+    source_.reset();
+
+    if(archiveType_ == ArchiveType::Mapped || archiveType_ == ArchiveType::Chunked)
+    {
+        try
+        {
+            std::shared_ptr<OutputSource> source;
+            if(archiveType_ == ArchiveType::Mapped)
+                source = std::make_shared<OutputMap>(filename);
+            else
+                source = std::make_shared<OutputStoreReader>(filename);
+            auto namelist = source->getNameList();
+            namelist_ = internal::make_shared_ptr(namelist);
+            outputData_ = internal::OutputData();
+            source_ = source;
+            curIt_ = source_->numFrames();
+        }
+        catch(...)
+        {
+            LOG() << logger::failed;
+            throw;
+        }
+        LOG_SUCCESS(t);
+        return;
+    }
+
+    if(archiveType_ == ArchiveType::Stream)
+    {
+        try
+        {
+            readStream(filename);
+        }
+        catch(...)
+        {
+            LOG() << logger::failed;
+            throw;
+        }
+        LOG_SUCCESS(t);
+        return;
+    }
+
     std::ios_base::openmode flags
         = archiveType_ == ArchiveType::Binary ? std::ios::in | std::ios::binary : std::ios::in;
 
@@ -311,5 +753,201 @@ void Output::read(const std::string& filename)
     LOG_SUCCESS(t);
 }
 
+void Output::writeStream(const std::string& filename)
+{
+    Timer t;
+    LOG() << "Writing to '" << filename << "' ..." << logger::flush;
+
+    try
+    {
+        const std::vector<FrameField> fields = frameFields();
+        std::shared_ptr<OutputSink> stream = openSink(filename);
+
+        for(std::size_t n = 0; n < outputData_.t.size(); ++n)
+        {
+            double* frame = stream->acquire();
+            frame[0] = outputData_.t[n];
+
+            std::size_t offset = 1;
+            for(const FrameField& field : fields)
+            {
+                if(field.data->size() >= (n + 1) * field.size)
+                    std::copy_n(field.data->data() + n * field.size, field.size, frame + offset);
+                else
+                    std::fill_n(frame + offset, field.size, 0.0);
+                offset += field.size;
+            }
+            stream->submit();
+        }
+        stream->close();
+    }
+    catch(...)
+    {
+        LOG() << logger::failed;
+        throw;
+    }
+    LOG_SUCCESS(t);
+}
+
+void Output::writeMapped(const std::string& filename)
+{
+    Timer t;
+    LOG() << "Writing to '" << filename << "' ..." << logger::flush;
+
+    try
+    {
+        std::vector<const double*> data;
+        for(const FrameField& field : frameFields())
+            data.push_back(field.data->size() >= outputData_.t.size() * field.size ? field.data->data() : nullptr);
+        OutputMap::write(filename, *namelist_, streamLayout(), outputData_.t, data);
+    }
+    catch(...)
+    {
+        LOG() << logger::failed;
+        throw;
+    }
+    LOG_SUCCESS(t);
+}
+
+void Output::readStream(const std::string& filename)
+{
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> file(std::fopen(filename.c_str(), "rb"), &std::fclose);
+    if(!file)
+        throw IsenException("no such file: %s", filename);
+
+    auto namelist = boost::make_shared<NameList>();
+    OutputStream::Layout layout;
+    const std::uint64_t headerSize = OutputStream::readHeader(file.get(), *namelist, layout);
+    namelist_ = namelist;
+
+    std::size_t frameSize = 1;
+    for(const auto& field : layout)
+        frameSize += field.second;
+
+    // A frame which is still being written is ignored
+    const std::uint64_t fileSize = boost::filesystem::file_size(filename);
+    const std::size_t numFrames = static_cast<std::size_t>((fileSize - headerSize) / (frameSize * sizeof(double)));
+
+    // Destination of the fields (unknown fields are skipped)
+    outputData_ = internal::OutputData();
+    const std::vector<FrameField> fields = frameFields();
+    std::vector<std::vector<double>*> data;
+    for(const auto& field : layout)
+    {
+        auto it = std::find_if(fields.begin(), fields.end(), [&](const FrameField& f) {
+            return field.first == f.name && field.second == f.size;
+        });
+        data.push_back(it != fields.end() ? it->data : nullptr);
+        if(data.back())
+            data.back()->resize(numFrames * field.second);
+    }
+    outputData_.t.resize(numFrames);
+
+    std::vector<double> frame(frameSize);
+    for(std::size_t n = 0; n < numFrames; ++n)
+    {
+        if(std::fread(frame.data(), sizeof(double), frameSize, file.get()) != frameSize)
+            throw IsenException("corrupted stream archive: %s", filename);
+
+        outputData_.t[n] = frame[0];
+
+        std::size_t offset = 1;
+        for(std::size_t f = 0; f < layout.size(); ++f)
+        {
+            if(data[f])
+                std::copy_n(frame.data() + offset, layout[f].second, data[f]->data() + n * layout[f].second);
+            offset += layout[f].second;
+        }
+    }
+
+    curIt_ = static_cast<int>(numFrames);
+}
+
+namespace internal
+{
+
+/// Output fields with their names in a checkpoint
+template <class OutputDataT>
+inline std::array<std::pair<const char*, decltype(&std::declval<OutputDataT&>().z)>, 12>
+checkpointFields(OutputDataT& data)
+{
+    return {{std::make_pair("output.z", &data.z), std::make_pair("output.u", &data.u),
+             std::make_pair("output.s", &data.s), std::make_pair("output.t", &data.t),
+             std::make_pair("output.prec", &data.prec), std::make_pair("output.tot_prec", &data.tot_prec),
+             std::make_pair("output.qv", &data.qv), std::make_pair("output.qc", &data.qc),
+             std::make_pair("output.qr", &data.qr), std::make_pair("output.nr", &data.nr),
+             std::make_pair("output.nc", &data.nc), std::make_pair("output.dthetadt", &data.dthetadt)}};
+}
+}
+
+void Output::saveState(Checkpoint& checkpoint) const
+{
+    checkpoint.add("output.curIt", curIt_);
+
+    // Streamed frames are on disk already
+    if(streaming_)
+    {
+        if(streamError_)
+            std::rethrow_exception(streamError_);
+
+        if(stream_)
+        {
+            stream_->flush();
+            const std::string& file = stream_->filename();
+            checkpoint.add("output.stream", file.data(), static_cast<int>(file.size()), 1,
+                           static_cast<int>(file.size()));
+            checkpoint.add("output.stream.size", static_cast<double>(stream_->size()));
+        }
+        return;
+    }
+
+    for(const auto& field : internal::checkpointFields(outputData_))
+        checkpoint.add(field.first, *field.second);
+}
+
+void Output::loadState(const Checkpoint& checkpoint)
+{
+    curIt_ = checkpoint.get<int>("output.curIt");
+
+    if(discard_)
+        return;
+
+    const bool streamed = !checkpoint.has("output.t");
+    if(streamed != streaming_)
+        throw IsenException(streamed ? "checkpoint: the output was streamed (use the stream or chunked archive)"
+                                     : "checkpoint: the output wasn't streamed (use a non-stream archive)");
+
+    // Continue the stream archive after the last frame of the checkpoint. A stream opened before the restart (e.g by
+    // the initial output) only holds frames which are replaced by the checkpoint.
+    if(streaming_)
+    {
+        if(stream_)
+        {
+            const std::string file = stream_->filename();
+            stream_.reset();
+            std::remove(file.c_str());
+        }
+        streamError_ = nullptr;
+        if(checkpoint.has("output.stream"))
+        {
+            std::vector<char> buffer;
+            checkpoint.get("output.stream", buffer);
+            const std::string file(buffer.begin(), buffer.end());
+            const auto size = static_cast<std::uint64_t>(checkpoint.get<double>("output.stream.size"));
+            if(boost::filesystem::path(file).extension() != extension(archiveType_))
+                throw IsenException("checkpoint: the output was streamed to '%s' (use the same archive)", file);
+            stream_ = openSink(file, size, curIt_);
+        }
+        return;
+    }
+
+    // The buffers keep the size of the current NameList (e.g if the integration time was extended)
+    for(const auto& field : internal::checkpointFields(outputData_))
+    {
+        const std::size_t size = field.second->size();
+        checkpoint.get(field.first, *field.second);
+        field.second->resize(size);
+    }
+}
 
 ISEN_NAMESPACE_END
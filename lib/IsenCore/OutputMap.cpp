@@ -0,0 +1,314 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#include <Isen/NameList.h>
+#include <Isen/OutputMap.h>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#ifdef ISEN_PLATFORM_WINDOWS
+#include <windows.h>
+#elif defined(ISEN_PLATFORM_POSIX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+ISEN_NAMESPACE_BEGIN
+
+namespace
+{
+
+const char magic[8] = {'I', 'S', 'E', 'N', 'I', 'M', 'A', 'P'};
+const std::uint32_t version = 1;
+const std::uint64_t alignment = 64;
+
+struct Header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t numFields;
+    std::uint64_t numFrames;
+    std::uint64_t frameSize;
+    std::uint64_t namelistOffset;
+    std::uint64_t namelistSize;
+    std::uint64_t fieldsOffset;
+    std::uint64_t indexOffset;
+};
+
+struct FieldEntry
+{
+    char name[32];
+    std::uint64_t size;
+    std::uint64_t offset;
+};
+
+static_assert(sizeof(Header) == 64, "unexpected padding of the header");
+static_assert(sizeof(FieldEntry) == 48, "unexpected padding of the field table");
+
+inline std::uint64_t align(std::uint64_t offset)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+inline bool isLittleEndian()
+{
+    const std::uint32_t value = 1;
+    char byte;
+    std::memcpy(&byte, &value, 1);
+    return byte == 1;
+}
+
+} // anonymous namespace
+
+void OutputMap::write(const std::string& filename, const NameList& namelist, const Layout& layout,
+                      const std::vector<double>& t, const std::vector<const double*>& data)
+{
+    if(!isLittleEndian())
+        throw IsenException("mapped archives require a little-endian host");
+
+    std::ostringstream sout;
+    {
+        boost::archive::binary_oarchive oa(sout);
+        oa << namelist;
+    }
+    const std::string str = sout.str();
+
+    // Layout of a frame
+    std::vector<FieldEntry> fields(layout.size());
+    std::uint64_t frameSize = sizeof(double);
+    for(std::size_t f = 0; f < layout.size(); ++f)
+    {
+        if(layout[f].first.size() >= sizeof(FieldEntry::name))
+            throw IsenException("field name '%s' is too long", layout[f].first);
+
+        std::memset(&fields[f], 0, sizeof(FieldEntry));
+        std::memcpy(fields[f].name, layout[f].first.data(), layout[f].first.size());
+        fields[f].size = layout[f].second;
+        fields[f].offset = align(frameSize);
+        frameSize = fields[f].offset + layout[f].second * sizeof(double);
+    }
+    frameSize = align(frameSize);
+
+    // Layout of the file
+    Header header;
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.numFields = static_cast<std::uint32_t>(layout.size());
+    header.numFrames = t.size();
+    header.frameSize = frameSize;
+    header.fieldsOffset = sizeof(Header);
+    header.namelistOffset = header.fieldsOffset + fields.size() * sizeof(FieldEntry);
+    header.namelistSize = str.size();
+    header.indexOffset = align(header.namelistOffset + str.size());
+
+    const std::uint64_t framesOffset = align(header.indexOffset + t.size() * sizeof(std::uint64_t));
+    std::vector<std::uint64_t> index(t.size());
+    for(std::size_t n = 0; n < t.size(); ++n)
+        index[n] = framesOffset + n * frameSize;
+
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if(!file)
+        throw IsenException("failed to open file: %s", filename);
+
+    const std::vector<char> padding(alignment, 0);
+    bool ok = std::fwrite(&header, sizeof(Header), 1, file) == 1;
+    ok &= fields.empty() || std::fwrite(fields.data(), sizeof(FieldEntry), fields.size(), file) == fields.size();
+    ok &= std::fwrite(str.data(), 1, str.size(), file) == str.size();
+    ok &= std::fwrite(padding.data(), 1, header.indexOffset - (header.namelistOffset + str.size()), file)
+          == header.indexOffset - (header.namelistOffset + str.size());
+    ok &= index.empty() || std::fwrite(index.data(), sizeof(std::uint64_t), index.size(), file) == index.size();
+    ok &= std::fwrite(padding.data(), 1, framesOffset - (header.indexOffset + index.size() * sizeof(std::uint64_t)),
+                      file)
+          == framesOffset - (header.indexOffset + index.size() * sizeof(std::uint64_t));
+
+    std::vector<char> frame(frameSize);
+    for(std::size_t n = 0; n < t.size() && ok; ++n)
+    {
+        std::memset(frame.data(), 0, frame.size());
+        std::memcpy(frame.data(), &t[n], sizeof(double));
+        for(std::size_t f = 0; f < layout.size(); ++f)
+            if(data[f])
+                std::memcpy(frame.data() + fields[f].offset, data[f] + n * layout[f].second,
+                            layout[f].second * sizeof(double));
+        ok &= std::fwrite(frame.data(), 1, frame.size(), file) == frame.size();
+    }
+
+    ok &= std::fclose(file) == 0;
+    if(!ok)
+        throw IsenException("failed to write to file: %s", filename);
+}
+
+OutputMap::OutputMap(const std::string& filename) : filename_(filename), data_(nullptr), size_(0)
+{
+    if(!isLittleEndian())
+        throw IsenException("mapped archives require a little-endian host");
+
+#ifdef ISEN_PLATFORM_WINDOWS
+    file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file_ == INVALID_HANDLE_VALUE)
+        throw IsenException("no such file: %s", filename);
+
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file_, &fileSize);
+    size_ = static_cast<std::size_t>(fileSize.QuadPart);
+
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(!mapping_ || !(data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0))))
+    {
+        if(mapping_)
+            CloseHandle(mapping_);
+        CloseHandle(file_);
+        throw IsenException("failed to map file: %s", filename);
+    }
+#elif defined(ISEN_PLATFORM_POSIX)
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw IsenException("no such file: %s", filename);
+
+    struct stat st;
+    if(fstat(fd, &st) != 0)
+    {
+        close(fd);
+        throw IsenException("failed to map file: %s", filename);
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+
+    // The mapping stays valid after closing the file
+    void* data = size_ > 0 ? mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if(data == MAP_FAILED)
+        throw IsenException("failed to map file: %s", filename);
+    data_ = static_cast<const char*>(data);
+#endif
+
+    try
+    {
+        auto corrupt = [&]() { return IsenException("'%s' is not a mapped archive", filename); };
+
+        Header header;
+        if(size_ < sizeof(Header))
+            throw corrupt();
+        std::memcpy(&header, data_, sizeof(Header));
+
+        if(std::memcmp(header.magic, magic, sizeof(magic)) != 0)
+            throw corrupt();
+        if(header.version != version)
+            throw IsenException("unsupported version %i of mapped archive '%s'", header.version, filename);
+
+        if(header.fieldsOffset + header.numFields * sizeof(FieldEntry) > size_
+           || header.namelistOffset + header.namelistSize > size_
+           || header.indexOffset + header.numFrames * sizeof(std::uint64_t) > size_)
+            throw corrupt();
+
+        for(std::uint32_t f = 0; f < header.numFields; ++f)
+        {
+            FieldEntry field;
+            std::memcpy(&field, data_ + header.fieldsOffset + f * sizeof(FieldEntry), sizeof(FieldEntry));
+            field.name[sizeof(field.name) - 1] = '\0';
+            if(field.offset % sizeof(double) != 0 || field.offset + field.size * sizeof(double) > header.frameSize)
+                throw corrupt();
+
+            layout_.emplace_back(std::string(field.name), field.size);
+            offsets_.push_back(field.offset);
+        }
+
+        index_.resize(header.numFrames);
+        if(!index_.empty())
+            std::memcpy(index_.data(), data_ + header.indexOffset, index_.size() * sizeof(std::uint64_t));
+        for(std::uint64_t offset : index_)
+            if(offset % sizeof(double) != 0 || offset + header.frameSize > size_)
+                throw corrupt();
+
+        namelistOffset_ = header.namelistOffset;
+        namelistSize_ = header.namelistSize;
+    }
+    catch(...)
+    {
+        unmap();
+        throw;
+    }
+}
+
+OutputMap::~OutputMap()
+{
+    unmap();
+}
+
+void OutputMap::unmap() noexcept
+{
+    if(!data_)
+        return;
+
+#ifdef ISEN_PLATFORM_WINDOWS
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_);
+    CloseHandle(file_);
+#elif defined(ISEN_PLATFORM_POSIX)
+    munmap(const_cast<char*>(data_), size_);
+#endif
+    data_ = nullptr;
+}
+
+std::shared_ptr<NameList> OutputMap::getNameList() const
+{
+    auto namelist = std::make_shared<NameList>();
+    std::istringstream sin(std::string(data_ + namelistOffset_, namelistSize_));
+    boost::archive::binary_iarchive ia(sin);
+    ia >> *namelist;
+    namelist->update();
+    return namelist;
+}
+
+int OutputMap::fieldIndex(const std::string& name) const noexcept
+{
+    for(std::size_t f = 0; f < layout_.size(); ++f)
+        if(layout_[f].first == name)
+            return static_cast<int>(f);
+    return -1;
+}
+
+const char* OutputMap::frameData(int n) const
+{
+    if(n < 0 || n >= numFrames())
+        throw IsenException("frame %i is out of range [0, %i)", n, numFrames());
+    return data_ + index_[n];
+}
+
+double OutputMap::time(int n) const
+{
+    return *reinterpret_cast<const double*>(frameData(n));
+}
+
+std::size_t OutputMap::size(const std::string& name) const
+{
+    const int f = fieldIndex(name);
+    if(f < 0)
+        throw IsenException("no field named '%s' in '%s'", name, filename_);
+    return layout_[f].second;
+}
+
+const double* OutputMap::frame(const std::string& name, int n) const
+{
+    const int f = fieldIndex(name);
+    if(f < 0)
+        throw IsenException("no field named '%s' in '%s'", name, filename_);
+    return reinterpret_cast<const double*>(frameData(n) + offsets_[f]);
+}
+
+ISEN_NAMESPACE_END
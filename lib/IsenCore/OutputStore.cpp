@@ -0,0 +1,579 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#include <Isen/NameList.h>
+#include <Isen/OutputStore.h>
+#include <algorithm>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/filesystem.hpp>
+#include <cstring>
+#include <sstream>
+
+ISEN_NAMESPACE_BEGIN
+
+namespace
+{
+
+const char magic[8] = {'I', 'S', 'E', 'N', 'C', 'H', 'N', 'K'};
+const char endMagic[8] = {'I', 'S', 'E', 'N', 'C', 'E', 'N', 'D'};
+const char chunkMagic[4] = {'C', 'H', 'N', 'K'};
+const std::uint32_t version = 2;
+
+/// Header of a chunk: magic, field, frame, number of frames, row, number of rows, encoding (uint32) and size (uint64).
+/// Version 1 has no encoding.
+const std::uint32_t chunkHeaderValues = 6;
+const std::uint64_t chunkHeaderSize = 36;
+
+/// Size of the trailer: number of chunks, offset of the index (uint64) and magic
+const std::uint64_t trailerSize = 24;
+
+static_assert(sizeof(internal::StoreChunk) == 40, "unexpected padding of the chunk index");
+
+template <class T>
+inline bool writeValue(std::FILE* file, T value)
+{
+    return std::fwrite(&value, sizeof(T), 1, file) == 1;
+}
+
+template <class T>
+inline bool readValue(std::FILE* file, T& value)
+{
+    return std::fread(&value, sizeof(T), 1, file) == 1;
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------------------------------------------
+//  OutputStore
+//------------------------------------------------------------------------------------------------------------------
+
+OutputStore::OutputStore(const std::string& filename, const NameList& namelist, const OutputLayout& layout,
+                         CompressionCodec codec, int chunkFrames, int chunkColumns, EncodingMode encoding,
+                         const std::vector<double>& bounds, int numThreads, std::uint64_t offset, int frame)
+    : file_(nullptr), filename_(filename), size_(0), codec_(codec), chunkFrames_(std::max(1, chunkFrames)),
+      chunkRows_(std::max(1, chunkColumns)), frameSize_(1), current_(0), frame_(frame), stop_(false)
+{
+    if(!Compression::isAvailable(codec_))
+        throw IsenException("compression '%s' is not available in this build", Compression::toString(codec_));
+
+    // The frames of the fields consist of one row per column of the output window
+    const std::size_t nx = OutputWindow(namelist).nx();
+    fields_.push_back(internal::StoreField{"t", 1, 1, EncodingMode::Lossless, 0.0});
+    offsets_.push_back(0);
+    for(std::size_t f = 0; f < layout.size(); ++f)
+    {
+        const auto& field = layout[f];
+        const std::size_t rows = field.second % nx == 0 ? nx : 1;
+        const double bound = f < bounds.size() && encoding != EncodingMode::Lossless ? std::max(0.0, bounds[f]) : 0.0;
+        fields_.push_back(internal::StoreField{field.first, rows, field.second / rows,
+                                               bound > 0.0 ? encoding : EncodingMode::Lossless, bound});
+        offsets_.push_back(frameSize_);
+        frameSize_ += field.second;
+    }
+
+    if(offset > 0)
+    {
+        // Append to the existing chunks
+        boost::system::error_code ec;
+        if(!boost::filesystem::exists(filename_) || boost::filesystem::file_size(filename_) < offset)
+            throw IsenException("chunked archive '%s' is missing chunks", filename_);
+
+        OutputStoreReader reader(filename_);
+        if(reader.codec() != codec_)
+            throw IsenException("chunked archive '%s' uses compression '%s'", filename_,
+                                Compression::toString(reader.codec()));
+        for(const internal::StoreChunk& chunk : reader.chunks())
+            if(chunk.offset + chunk.size <= offset)
+                index_.push_back(chunk);
+
+        boost::filesystem::resize_file(filename_, offset, ec);
+        if(ec || !(file_ = std::fopen(filename_.c_str(), "ab")))
+            throw IsenException("failed to open file: %s", filename_);
+        size_ = offset;
+    }
+    else
+    {
+        if(!(file_ = std::fopen(filename_.c_str(), "wb")))
+            throw IsenException("failed to open file: %s", filename_);
+
+        std::ostringstream sout;
+        {
+            boost::archive::binary_oarchive oa(sout);
+            oa << namelist;
+        }
+        const std::string str = sout.str();
+
+        bool ok = std::fwrite(magic, sizeof(magic), 1, file_) == 1;
+        ok &= writeValue(file_, version);
+        ok &= writeValue(file_, static_cast<std::uint32_t>(codec_));
+        ok &= writeValue(file_, static_cast<std::uint64_t>(str.size()));
+        ok &= std::fwrite(str.data(), 1, str.size(), file_) == str.size();
+        ok &= writeValue(file_, static_cast<std::uint32_t>(fields_.size()));
+        for(const auto& field : fields_)
+        {
+            ok &= writeValue(file_, static_cast<std::uint32_t>(field.name.size()));
+            ok &= std::fwrite(field.name.data(), 1, field.name.size(), file_) == field.name.size();
+            ok &= writeValue(file_, static_cast<std::uint64_t>(field.rows));
+            ok &= writeValue(file_, static_cast<std::uint64_t>(field.cols));
+            ok &= writeValue(file_, static_cast<std::uint32_t>(field.encoding));
+            ok &= writeValue(file_, field.bound);
+        }
+        ok &= std::fflush(file_) == 0;
+
+        if(!ok)
+        {
+            std::fclose(file_);
+            throw IsenException("failed to write to file: %s", filename_);
+        }
+        size_ = static_cast<std::uint64_t>(std::ftell(file_));
+    }
+
+    try
+    {
+        for(Buffer& buffer : buffers_)
+            buffer.data.resize(chunkFrames_ * frameSize_);
+    }
+    catch(std::bad_alloc&)
+    {
+        std::fclose(file_);
+        throw IsenException("out of memory");
+    }
+
+    if(numThreads <= 0)
+        numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    for(int t = 0; t < numThreads; ++t)
+        workers_.emplace_back(&OutputStore::work, this);
+}
+
+OutputStore::~OutputStore()
+{
+    try
+    {
+        close();
+    }
+    catch(const std::exception& e)
+    {
+        warning("isen", e.what());
+    }
+}
+
+double* OutputStore::acquire()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    Buffer& buffer = buffers_[current_];
+    cond_.wait(lock, [&buffer] { return !buffer.sealed; });
+
+    if(buffer.numFrames == 0)
+        buffer.frame = frame_;
+    return buffer.data.data() + buffer.numFrames * frameSize_;
+}
+
+void OutputStore::submit()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++frame_;
+    if(++buffers_[current_].numFrames == chunkFrames_)
+        seal(current_);
+}
+
+void OutputStore::seal(int b)
+{
+    Buffer& buffer = buffers_[b];
+    buffer.sealed = true;
+    for(int f = 0; f < static_cast<int>(fields_.size()); ++f)
+        for(int row = 0; row < static_cast<int>(fields_[f].rows); row += chunkRows_, ++buffer.pending)
+            tasks_.push_back(Task{b, f, row});
+
+    current_ = 1 - b;
+    cond_.notify_all();
+}
+
+void OutputStore::work()
+{
+    std::vector<double> chunk;
+    std::vector<char> compressed;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(true)
+    {
+        cond_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+        if(tasks_.empty())
+            return;
+
+        const Task task = tasks_.front();
+        tasks_.pop_front();
+
+        Buffer& buffer = buffers_[task.buffer];
+        const internal::StoreField& field = fields_[task.field];
+        const std::size_t numRows = std::min<std::size_t>(chunkRows_, field.rows - task.row);
+        const bool failed = static_cast<bool>(exception_);
+
+        internal::StoreChunk header{static_cast<std::uint32_t>(task.field),
+                                    static_cast<std::uint32_t>(buffer.frame),
+                                    static_cast<std::uint32_t>(buffer.numFrames),
+                                    static_cast<std::uint32_t>(task.row),
+                                    static_cast<std::uint32_t>(numRows),
+                                    0,
+                                    0,
+                                    0};
+        lock.unlock();
+
+        // Gather and compress the chunk (the buffer isn't modified while it is sealed)
+        std::exception_ptr error;
+        if(!failed)
+        {
+            try
+            {
+                chunk.resize(header.numFrames * numRows * field.cols);
+                for(std::size_t n = 0; n < header.numFrames; ++n)
+                    std::copy_n(buffer.data.data() + n * frameSize_ + offsets_[task.field] + task.row * field.cols,
+                                numRows * field.cols, chunk.data() + n * numRows * field.cols);
+                header.encoding = static_cast<std::uint32_t>(Encoding::encode(
+                    codec_, field.encoding, field.bound, chunk.data(), header.numFrames, numRows, field.cols, compressed));
+            }
+            catch(...)
+            {
+                error = std::current_exception();
+            }
+        }
+
+        lock.lock();
+        if(!failed && !error)
+        {
+            header.offset = size_ + chunkHeaderSize;
+            header.size = compressed.size();
+
+            bool ok = std::fwrite(chunkMagic, sizeof(chunkMagic), 1, file_) == 1;
+            ok &= std::fwrite(&header, sizeof(std::uint32_t), chunkHeaderValues, file_) == chunkHeaderValues;
+            ok &= writeValue(file_, header.size);
+            ok &= std::fwrite(compressed.data(), 1, compressed.size(), file_) == compressed.size();
+
+            if(ok)
+            {
+                size_ = header.offset + header.size;
+                index_.push_back(header);
+            }
+            else
+                error = std::make_exception_ptr(IsenException("failed to write to file: %s", filename_));
+        }
+
+        if(error && !exception_)
+            exception_ = error;
+
+        // The buffer is available again once all its chunks are written
+        if(--buffer.pending == 0)
+        {
+            if(!exception_ && std::fflush(file_) != 0)
+                exception_ = std::make_exception_ptr(IsenException("failed to write to file: %s", filename_));
+            buffer.sealed = false;
+            buffer.numFrames = 0;
+            cond_.notify_all();
+        }
+    }
+}
+
+void OutputStore::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(buffers_[current_].numFrames > 0 && !buffers_[current_].sealed)
+        seal(current_);
+
+    cond_.wait(lock, [this] { return tasks_.empty() && buffers_[0].pending == 0 && buffers_[1].pending == 0; });
+    if(exception_)
+        std::rethrow_exception(exception_);
+}
+
+void OutputStore::close()
+{
+    if(!file_)
+        return;
+
+    std::exception_ptr error;
+    try
+    {
+        flush();
+    }
+    catch(...)
+    {
+        error = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cond_.notify_all();
+    for(std::thread& worker : workers_)
+        worker.join();
+    workers_.clear();
+
+    // Index of the chunks
+    bool ok = true;
+    if(!error)
+    {
+        ok &= index_.empty()
+              || std::fwrite(index_.data(), sizeof(internal::StoreChunk), index_.size(), file_) == index_.size();
+        ok &= writeValue(file_, static_cast<std::uint64_t>(index_.size()));
+        ok &= writeValue(file_, size_);
+        ok &= std::fwrite(endMagic, sizeof(endMagic), 1, file_) == 1;
+        if(ok)
+            size_ += index_.size() * sizeof(internal::StoreChunk) + trailerSize;
+    }
+
+    ok &= std::fclose(file_) == 0;
+    file_ = nullptr;
+
+    if(error)
+        std::rethrow_exception(error);
+    if(!ok)
+        throw IsenException("failed to write to file: %s", filename_);
+}
+
+//------------------------------------------------------------------------------------------------------------------
+//  OutputStoreReader
+//------------------------------------------------------------------------------------------------------------------
+
+OutputStoreReader::OutputStoreReader(const std::string& filename)
+    : file_(std::fopen(filename.c_str(), "rb")), filename_(filename), numFrames_(0)
+{
+    if(!file_)
+        throw IsenException("no such file: %s", filename);
+
+    try
+    {
+        auto corrupt = [&]() { return IsenException("'%s' is not a chunked archive", filename); };
+
+        char fileMagic[sizeof(magic)];
+        std::uint32_t fileVersion, codec, numFields;
+        std::uint64_t namelistSize;
+
+        if(std::fread(fileMagic, sizeof(fileMagic), 1, file_) != 1
+           || std::memcmp(fileMagic, magic, sizeof(magic)) != 0 || !readValue(file_, fileVersion))
+            throw corrupt();
+
+        if(fileVersion < 1 || fileVersion > version)
+            throw IsenException("unsupported version %i of chunked archive '%s'", fileVersion, filename);
+
+        if(!readValue(file_, codec) || codec > static_cast<std::uint32_t>(CompressionCodec::Zstd)
+           || !readValue(file_, namelistSize))
+            throw corrupt();
+
+        codec_ = static_cast<CompressionCodec>(codec);
+        if(!Compression::isAvailable(codec_))
+            throw IsenException("compression '%s' of '%s' is not available in this build",
+                                Compression::toString(codec_), filename);
+
+        namelist_.resize(namelistSize);
+        if(std::fread(&namelist_[0], 1, namelistSize, file_) != namelistSize || !readValue(file_, numFields))
+            throw corrupt();
+
+        for(std::uint32_t f = 0; f < numFields; ++f)
+        {
+            std::uint32_t nameSize, encoding = 0;
+            std::uint64_t rows, cols;
+            double bound = 0.0;
+            if(!readValue(file_, nameSize))
+                throw corrupt();
+
+            std::string name(nameSize, '\0');
+            if(std::fread(&name[0], 1, nameSize, file_) != nameSize || !readValue(file_, rows)
+               || !readValue(file_, cols))
+                throw corrupt();
+
+            // The encodings were added in version 2
+            if(fileVersion >= 2 && (!readValue(file_, encoding) || !readValue(file_, bound)))
+                throw corrupt();
+            if(encoding > static_cast<std::uint32_t>(EncodingMode::Transform))
+                throw corrupt();
+            fields_.push_back(internal::StoreField{name, rows, cols, static_cast<EncodingMode>(encoding), bound});
+        }
+
+        if(fields_.empty() || fields_[0].name != "t")
+            throw corrupt();
+
+        const std::uint64_t headerSize = static_cast<std::uint64_t>(std::ftell(file_));
+        const std::uint64_t fileSize = boost::filesystem::file_size(filename);
+
+        // Read the index or, if the archive wasn't closed, scan the chunks
+        bool indexed = false;
+        if(fileSize >= headerSize + trailerSize)
+        {
+            std::uint64_t numChunks, indexOffset;
+            char trailerMagic[sizeof(endMagic)];
+            std::fseek(file_, static_cast<long>(fileSize - trailerSize), SEEK_SET);
+            if(readValue(file_, numChunks) && readValue(file_, indexOffset)
+               && std::fread(trailerMagic, sizeof(trailerMagic), 1, file_) == 1
+               && std::memcmp(trailerMagic, endMagic, sizeof(endMagic)) == 0
+               && indexOffset + numChunks * sizeof(internal::StoreChunk) + trailerSize == fileSize)
+            {
+                index_.resize(numChunks);
+                std::fseek(file_, static_cast<long>(indexOffset), SEEK_SET);
+                if(numChunks > 0
+                   && std::fread(index_.data(), sizeof(internal::StoreChunk), numChunks, file_) != numChunks)
+                    throw corrupt();
+                indexed = true;
+            }
+        }
+
+        if(!indexed)
+        {
+            std::fseek(file_, static_cast<long>(headerSize), SEEK_SET);
+            const std::uint32_t headerValues = fileVersion >= 2 ? chunkHeaderValues : chunkHeaderValues - 1;
+            const std::uint64_t recordHeaderSize = sizeof(chunkMagic) + headerValues * sizeof(std::uint32_t)
+                                                   + sizeof(std::uint64_t);
+            for(std::uint64_t pos = headerSize; pos + recordHeaderSize <= fileSize;)
+            {
+                char marker[sizeof(chunkMagic)];
+                internal::StoreChunk chunk{0, 0, 0, 0, 0, 0, 0, 0};
+                if(std::fread(marker, sizeof(marker), 1, file_) != 1
+                   || std::memcmp(marker, chunkMagic, sizeof(chunkMagic)) != 0
+                   || std::fread(&chunk, sizeof(std::uint32_t), headerValues, file_) != headerValues
+                   || !readValue(file_, chunk.size))
+                    break;
+
+                // A chunk which is still being written is ignored
+                chunk.offset = pos + recordHeaderSize;
+                if(chunk.offset + chunk.size > fileSize)
+                    break;
+
+                index_.push_back(chunk);
+                pos = chunk.offset + chunk.size;
+                std::fseek(file_, static_cast<long>(pos), SEEK_SET);
+            }
+        }
+
+        // Chunks of each field by their first frame
+        chunks_.resize(fields_.size());
+        for(std::size_t c = 0; c < index_.size(); ++c)
+        {
+            const internal::StoreChunk& chunk = index_[c];
+            if(chunk.field >= fields_.size() || chunk.row + chunk.numRows > fields_[chunk.field].rows
+               || chunk.encoding > static_cast<std::uint32_t>(EncodingMode::Transform))
+                throw corrupt();
+
+            chunks_[chunk.field][chunk.frame].push_back(c);
+            if(chunk.field == 0)
+                numFrames_ = std::max(numFrames_, static_cast<int>(chunk.frame + chunk.numFrames));
+        }
+    }
+    catch(...)
+    {
+        std::fclose(file_);
+        throw;
+    }
+
+    cache_.resize(fields_.size());
+}
+
+OutputStoreReader::~OutputStoreReader()
+{
+    std::fclose(file_);
+}
+
+std::shared_ptr<NameList> OutputStoreReader::getNameList() const
+{
+    auto namelist = std::make_shared<NameList>();
+    std::istringstream sin(namelist_);
+    boost::archive::binary_iarchive ia(sin);
+    ia >> *namelist;
+    namelist->update();
+    return namelist;
+}
+
+int OutputStoreReader::fieldIndex(const std::string& name) const noexcept
+{
+    for(std::size_t f = 0; f < fields_.size(); ++f)
+        if(fields_[f].name == name)
+            return static_cast<int>(f);
+    return -1;
+}
+
+double OutputStoreReader::time(int n) const
+{
+    return load(0, n)[0];
+}
+
+std::size_t OutputStoreReader::size(const std::string& name) const
+{
+    const int f = fieldIndex(name);
+    if(f < 0)
+        throw IsenException("no field named '%s' in '%s'", name, filename_);
+    return fields_[f].rows * fields_[f].cols;
+}
+
+double OutputStoreReader::bound(const std::string& name) const
+{
+    const int f = fieldIndex(name);
+    if(f < 0)
+        throw IsenException("no field named '%s' in '%s'", name, filename_);
+    return fields_[f].bound;
+}
+
+const double* OutputStoreReader::frame(const std::string& name, int n) const
+{
+    const int f = fieldIndex(name);
+    if(f < 0)
+        throw IsenException("no field named '%s' in '%s'", name, filename_);
+    return load(f, n);
+}
+
+const double* OutputStoreReader::load(int f, int n) const
+{
+    if(n < 0 || n >= numFrames_)
+        throw IsenException("frame %i is out of range [0, %i)", n, numFrames_);
+
+    const internal::StoreField& field = fields_[f];
+    const std::size_t frameSize = field.rows * field.cols;
+    Cache& cache = cache_[f];
+
+    if(n < cache.frame || n >= cache.frame + cache.numFrames)
+    {
+        // Chunks of the time span containing frame n
+        auto it = chunks_[f].upper_bound(n);
+        if(it == chunks_[f].begin() || n >= std::prev(it)->first + static_cast<int>(index_[std::prev(it)->second[0]].numFrames))
+            throw IsenException("frame %i of field '%s' is missing in '%s'", n, field.name, filename_);
+        --it;
+
+        const int numFrames = index_[it->second[0]].numFrames;
+        cache.frame = -1;
+        cache.data.assign(numFrames * frameSize, 0.0);
+
+        std::vector<char> compressed;
+        std::vector<double> chunk;
+        for(std::size_t c : it->second)
+        {
+            const internal::StoreChunk& header = index_[c];
+            compressed.resize(header.size);
+            chunk.resize(header.numFrames * header.numRows * field.cols);
+
+            std::fseek(file_, static_cast<long>(header.offset), SEEK_SET);
+            if(header.numFrames != static_cast<std::uint32_t>(numFrames)
+               || std::fread(compressed.data(), 1, compressed.size(), file_) != compressed.size())
+                throw IsenException("'%s' is not a chunked archive", filename_);
+
+            Encoding::decode(codec_, static_cast<EncodingMode>(header.encoding), field.bound, compressed.data(),
+                             compressed.size(), chunk.data(), header.numFrames, header.numRows, field.cols);
+            for(int m = 0; m < numFrames; ++m)
+                std::copy_n(chunk.data() + m * header.numRows * field.cols, header.numRows * field.cols,
+                            cache.data.data() + m * frameSize + header.row * field.cols);
+        }
+
+        cache.frame = it->first;
+        cache.numFrames = numFrames;
+    }
+
+    return cache.data.data() + (n - cache.frame) * frameSize;
+}
+
+ISEN_NAMESPACE_END
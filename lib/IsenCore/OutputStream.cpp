@@ -0,0 +1,250 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#include <Isen/NameList.h>
+#include <Isen/OutputStream.h>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/filesystem.hpp>
+#include <cstring>
+#include <sstream>
+
+ISEN_NAMESPACE_BEGIN
+
+namespace
+{
+
+const char magic[8] = {'I', 'S', 'E', 'N', 'S', 'T', 'R', 'M'};
+const std::uint32_t version = 1;
+
+template <class T>
+inline bool writeValue(std::FILE* file, T value)
+{
+    return std::fwrite(&value, sizeof(T), 1, file) == 1;
+}
+
+template <class T>
+inline bool readValue(std::FILE* file, T& value)
+{
+    return std::fread(&value, sizeof(T), 1, file) == 1;
+}
+
+} // anonymous namespace
+
+OutputStream::OutputStream(const std::string& filename, const NameList& namelist, const Layout& layout,
+                           int numBuffers, std::uint64_t offset)
+    : file_(nullptr), filename_(filename), frameSize_(1), size_(0), acquired_(-1), stop_(false)
+{
+    for(const auto& field : layout)
+        frameSize_ += field.second;
+
+    if(offset > 0)
+    {
+        // Append to the existing frames
+        boost::system::error_code ec;
+        if(!boost::filesystem::exists(filename_) || boost::filesystem::file_size(filename_) < offset)
+            throw IsenException("stream archive '%s' is missing frames", filename_);
+
+        boost::filesystem::resize_file(filename_, offset, ec);
+        if(ec || !(file_ = std::fopen(filename_.c_str(), "ab")))
+            throw IsenException("failed to open file: %s", filename_);
+        size_ = offset;
+    }
+    else
+    {
+        if(!(file_ = std::fopen(filename_.c_str(), "wb")))
+            throw IsenException("failed to open file: %s", filename_);
+
+        std::ostringstream sout;
+        {
+            boost::archive::binary_oarchive oa(sout);
+            oa << namelist;
+        }
+        const std::string str = sout.str();
+
+        bool ok = std::fwrite(magic, sizeof(magic), 1, file_) == 1;
+        ok &= writeValue(file_, version);
+        ok &= writeValue(file_, static_cast<std::uint64_t>(str.size()));
+        ok &= std::fwrite(str.data(), 1, str.size(), file_) == str.size();
+        ok &= writeValue(file_, static_cast<std::uint32_t>(layout.size()));
+        for(const auto& field : layout)
+        {
+            ok &= writeValue(file_, static_cast<std::uint32_t>(field.first.size()));
+            ok &= std::fwrite(field.first.data(), 1, field.first.size(), file_) == field.first.size();
+            ok &= writeValue(file_, static_cast<std::uint64_t>(field.second));
+        }
+        ok &= std::fflush(file_) == 0;
+
+        if(!ok)
+        {
+            std::fclose(file_);
+            throw IsenException("failed to write to file: %s", filename_);
+        }
+        size_ = static_cast<std::uint64_t>(std::ftell(file_));
+    }
+
+    try
+    {
+        buffers_.resize(numBuffers, std::vector<double>(frameSize_, 0.0));
+    }
+    catch(std::bad_alloc&)
+    {
+        std::fclose(file_);
+        throw IsenException("out of memory");
+    }
+
+    for(int b = 0; b < numBuffers; ++b)
+        free_.push_back(b);
+
+    thread_ = std::thread(&OutputStream::writeLoop, this);
+}
+
+OutputStream::~OutputStream()
+{
+    try
+    {
+        close();
+    }
+    catch(const std::exception& e)
+    {
+        warning("isen", e.what());
+    }
+}
+
+double* OutputStream::acquire()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this] { return !free_.empty(); });
+
+    acquired_ = free_.front();
+    free_.pop_front();
+    return buffers_[acquired_].data();
+}
+
+void OutputStream::submit()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        assert(acquired_ >= 0);
+        queue_.push_back(acquired_);
+        acquired_ = -1;
+    }
+    cond_.notify_all();
+}
+
+void OutputStream::writeLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(true)
+    {
+        cond_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if(queue_.empty())
+            return;
+
+        // The frame is written without holding the lock, the buffer stays in the queue until it is on disk
+        const std::vector<double>& buffer = buffers_[queue_.front()];
+        const bool failed = static_cast<bool>(exception_);
+        lock.unlock();
+
+        bool ok = failed;
+        if(!failed)
+            ok = std::fwrite(buffer.data(), sizeof(double), buffer.size(), file_) == buffer.size()
+                 && std::fflush(file_) == 0;
+
+        lock.lock();
+        if(!ok)
+            exception_ = std::make_exception_ptr(IsenException("failed to write to file: %s", filename_));
+        else if(!failed)
+            size_ += buffer.size() * sizeof(double);
+
+        free_.push_back(queue_.front());
+        queue_.pop_front();
+        cond_.notify_all();
+    }
+}
+
+void OutputStream::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this] { return queue_.empty(); });
+    if(exception_)
+        std::rethrow_exception(exception_);
+}
+
+void OutputStream::close()
+{
+    if(!file_)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cond_.notify_all();
+    thread_.join();
+
+    const bool ok = std::fclose(file_) == 0;
+    file_ = nullptr;
+
+    if(exception_)
+        std::rethrow_exception(exception_);
+    if(!ok)
+        throw IsenException("failed to write to file: %s", filename_);
+}
+
+std::uint64_t OutputStream::readHeader(std::FILE* file, NameList& namelist, Layout& layout)
+{
+    char fileMagic[sizeof(magic)];
+    std::uint32_t fileVersion, numFields;
+    std::uint64_t namelistSize;
+
+    if(std::fread(fileMagic, sizeof(fileMagic), 1, file) != 1 || std::memcmp(fileMagic, magic, sizeof(magic)) != 0
+       || !readValue(file, fileVersion))
+        throw IsenException("not a stream archive");
+
+    if(fileVersion != version)
+        throw IsenException("unsupported version %i of the stream archive", fileVersion);
+
+    if(!readValue(file, namelistSize))
+        throw IsenException("corrupted stream archive");
+
+    std::string str(namelistSize, '\0');
+    if(std::fread(&str[0], 1, namelistSize, file) != namelistSize)
+        throw IsenException("corrupted stream archive");
+
+    std::istringstream sin(str);
+    boost::archive::binary_iarchive ia(sin);
+    ia >> namelist;
+    namelist.update();
+
+    if(!readValue(file, numFields))
+        throw IsenException("corrupted stream archive");
+
+    layout.clear();
+    for(std::uint32_t f = 0; f < numFields; ++f)
+    {
+        std::uint32_t nameSize;
+        std::uint64_t size;
+        if(!readValue(file, nameSize))
+            throw IsenException("corrupted stream archive");
+
+        std::string name(nameSize, '\0');
+        if(std::fread(&name[0], 1, nameSize, file) != nameSize || !readValue(file, size))
+            throw IsenException("corrupted stream archive");
+        layout.emplace_back(name, size);
+    }
+
+    return static_cast<std::uint64_t>(std::ftell(file));
+}
+
+ISEN_NAMESPACE_END
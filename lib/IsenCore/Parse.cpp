@@ -117,6 +117,29 @@ Parser::Parser(Style style, bool prettyPrintErrors)
     ADD_KNOWN_VARIABLE(run_name);
     ADD_KNOWN_VARIABLE(iout);
     ADD_KNOWN_VARIABLE(iiniout);
+    ADD_KNOWN_VARIABLE(icheckpoint);
+    ADD_KNOWN_VARIABLE(compression);
+    ADD_KNOWN_VARIABLE(chunk_nt);
+    ADD_KNOWN_VARIABLE(chunk_nx);
+    ADD_KNOWN_VARIABLE(encoding);
+    ADD_KNOWN_VARIABLE(tol_z);
+    ADD_KNOWN_VARIABLE(tol_u);
+    ADD_KNOWN_VARIABLE(tol_s);
+    ADD_KNOWN_VARIABLE(tol_prec);
+    ADD_KNOWN_VARIABLE(tol_tot_prec);
+    ADD_KNOWN_VARIABLE(tol_qv);
+    ADD_KNOWN_VARIABLE(tol_qc);
+    ADD_KNOWN_VARIABLE(tol_qr);
+    ADD_KNOWN_VARIABLE(tol_nr);
+    ADD_KNOWN_VARIABLE(tol_nc);
+    ADD_KNOWN_VARIABLE(tol_dthetadt);
+    ADD_KNOWN_VARIABLE(out_fields);
+    ADD_KNOWN_VARIABLE(out_xmin);
+    ADD_KNOWN_VARIABLE(out_xmax);
+    ADD_KNOWN_VARIABLE(out_zmin);
+    ADD_KNOWN_VARIABLE(out_zmax);
+    ADD_KNOWN_VARIABLE(out_xstride);
+    ADD_KNOWN_VARIABLE(out_zstride);
     ADD_KNOWN_VARIABLE(xl);
     ADD_KNOWN_VARIABLE(nx);
     ADD_KNOWN_VARIABLE(thl);
@@ -124,6 +147,11 @@ Parser::Parser(Style style, bool prettyPrintErrors)
     ADD_KNOWN_VARIABLE(time);
     ADD_KNOWN_VARIABLE(dt);
     ADD_KNOWN_VARIABLE(diff);
+    ADD_KNOWN_VARIABLE(iadapt);
+    ADD_KNOWN_VARIABLE(cfl_target);
+    ADD_KNOWN_VARIABLE(dt_grow);
+    ADD_KNOWN_VARIABLE(dt_shrink);
+    ADD_KNOWN_VARIABLE(dt_max);
     ADD_KNOWN_VARIABLE(topomx);
     ADD_KNOWN_VARIABLE(topowd);
     ADD_KNOWN_VARIABLE(topotim);
@@ -150,6 +178,10 @@ Parser::Parser(Style style, bool prettyPrintErrors)
     ADD_KNOWN_VARIABLE(autoconv_th);
     ADD_KNOWN_VARIABLE(autoconv_mult);
     ADD_KNOWN_VARIABLE(sediment_on);
+    ADD_KNOWN_VARIABLE(sediment_col);
+    ADD_KNOWN_VARIABLE(tblock);
+    ADD_KNOWN_VARIABLE(imixprec);
+    ADD_KNOWN_VARIABLE(imath);
 
     #undef ADD_KNOWN_VARIABLE
 
@@ -13,6 +13,7 @@
 
 #include <Isen/Progressbar.h>
 #include <Isen/Terminal.h>
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
 #include <string>
@@ -67,6 +68,15 @@ void Progressbar::advance()
     timer_.start();
 }
 
+void Progressbar::advanceTo(int step)
+{
+    if(disableProgressbar)
+        return;
+
+    while(curStep_ < std::min(step, maxStep_))
+        advance();
+}
+
 void Progressbar::pause() const
 {
     if(disableProgressbar)
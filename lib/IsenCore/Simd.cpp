@@ -0,0 +1,209 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#include <Isen/Simd.h>
+#include <Isen/SolverCpuKernel.h>
+#include <Isen/SolverCpuSimd.h>
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define ISEN_SIMD_X86 1
+#if defined(ISEN_COMPILER_MSVC)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+ISEN_NAMESPACE_BEGIN
+
+namespace
+{
+
+#ifdef ISEN_SIMD_X86
+
+/// Query CPUID leaf @c leaf (sub-leaf @c subleaf) and return {eax, ebx, ecx, edx}
+void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4]) noexcept
+{
+#if defined(ISEN_COMPILER_MSVC)
+    int r[4];
+    __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for(int i = 0; i < 4; ++i)
+        regs[i] = static_cast<unsigned int>(r[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+/// Read the extended control register XCR0 (register state enabled by the operating system)
+unsigned long long xgetbv0() noexcept
+{
+#if defined(ISEN_COMPILER_MSVC)
+    return _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+/// Widest instruction set supported by the CPU and the operating system
+SimdInstructionSet detectCpu() noexcept
+{
+    unsigned int regs[4];
+
+    cpuid(0, 0, regs);
+    const unsigned int maxLeaf = regs[0];
+    if(maxLeaf < 1)
+        return SimdInstructionSet::Scalar;
+
+    cpuid(1, 0, regs);
+    const bool sse42 = regs[2] & (1u << 20);
+    const bool osxsave = regs[2] & (1u << 27);
+    const bool avx = regs[2] & (1u << 28);
+
+    if(!sse42)
+        return SimdInstructionSet::Scalar;
+
+    // The OS has to save the YMM (and ZMM) registers on context switches
+    if(!osxsave || !avx || maxLeaf < 7)
+        return SimdInstructionSet::SSE42;
+
+    const unsigned long long xcr0 = xgetbv0();
+    const bool osYmm = (xcr0 & 0x6) == 0x6;
+    const bool osZmm = (xcr0 & 0xe6) == 0xe6;
+
+    cpuid(7, 0, regs);
+    const bool avx2 = regs[1] & (1u << 5);
+    const bool avx512f = regs[1] & (1u << 16);
+
+    if(avx512f && osZmm)
+        return SimdInstructionSet::AVX512;
+    if(avx2 && osYmm)
+        return SimdInstructionSet::AVX2;
+    return SimdInstructionSet::SSE42;
+}
+
+#else
+
+SimdInstructionSet detectCpu() noexcept
+{
+    return SimdInstructionSet::Scalar;
+}
+
+#endif
+
+/// Instruction set used by the kernels (selected on first use)
+SimdInstructionSet& activeInstructionSet() noexcept
+{
+    static SimdInstructionSet isa = Simd::detect();
+    return isa;
+}
+
+/// Kernel table of @c isa (nullptr if the instruction set has not been compiled)
+template <class T>
+const SolverCpuKernels<T>* kernelTable(SimdInstructionSet isa) noexcept
+{
+    static const SolverCpuKernels<T> scalar = {&kernel_horizontalDiffusion<T>,
+                                               &kernel_clipMoisture<T>,
+                                               &kernel_geometricHeight<T>,
+                                               &kernel_diagMontgomery_Montgomery<T>,
+                                               &kernel_diagPressure<T>,
+                                               &kernel_progIsendens<T>,
+                                               &kernel_progMoisture<T>,
+                                               &kernel_progTracers<T>,
+                                               &kernel_progVelocity<T>,
+                                               &kernel_progEnsemble<T>,
+                                               &kernel_diagPressureEnsemble<T>,
+                                               &kernel_geometricHeightEnsemble<T>};
+    switch(isa)
+    {
+        case SimdInstructionSet::SSE42:
+            return solverCpuKernelsSSE42<T>();
+        case SimdInstructionSet::AVX2:
+            return solverCpuKernelsAVX2<T>();
+        case SimdInstructionSet::AVX512:
+            return solverCpuKernelsAVX512<T>();
+        default:
+            return &scalar;
+    }
+}
+
+} // anonymous namespace
+
+SimdInstructionSet Simd::detect() noexcept
+{
+    int isa = static_cast<int>(detectCpu());
+    while(!isCompiled(static_cast<SimdInstructionSet>(isa)))
+        --isa;
+    return static_cast<SimdInstructionSet>(isa);
+}
+
+SimdInstructionSet Simd::get() noexcept
+{
+    return activeInstructionSet();
+}
+
+void Simd::set(SimdInstructionSet isa)
+{
+    if(!isCompiled(isa))
+        throw IsenException("SIMD instruction set '%s' has not been compiled", toString(isa));
+    if(static_cast<int>(isa) > static_cast<int>(detectCpu()))
+        throw IsenException("SIMD instruction set '%s' is not supported by the CPU", toString(isa));
+    activeInstructionSet() = isa;
+}
+
+bool Simd::isAvailable(SimdInstructionSet isa) noexcept
+{
+    return isCompiled(isa) && static_cast<int>(isa) <= static_cast<int>(detectCpu());
+}
+
+bool Simd::isCompiled(SimdInstructionSet isa) noexcept
+{
+    return kernelTable<double>(isa) != nullptr;
+}
+
+const char* Simd::toString(SimdInstructionSet isa) noexcept
+{
+    switch(isa)
+    {
+        case SimdInstructionSet::SSE42:
+            return "sse4.2";
+        case SimdInstructionSet::AVX2:
+            return "avx2";
+        case SimdInstructionSet::AVX512:
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
+
+SimdInstructionSet Simd::fromString(const std::string& str)
+{
+    for(auto isa : {SimdInstructionSet::Scalar, SimdInstructionSet::SSE42, SimdInstructionSet::AVX2,
+                    SimdInstructionSet::AVX512})
+        if(str == toString(isa))
+            return isa;
+    throw IsenException("invalid SIMD instruction set '%s'", str);
+}
+
+template <class T>
+const SolverCpuKernels<T>& solverCpuKernels() noexcept
+{
+    return *kernelTable<T>(activeInstructionSet());
+}
+
+template const SolverCpuKernels<double>& solverCpuKernels<double>() noexcept;
+template const SolverCpuKernels<float>& solverCpuKernels<float>() noexcept;
+
+ISEN_NAMESPACE_END
@@ -0,0 +1,441 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+
+#include <Isen/Boundary.h>
+#include <Isen/Logger.h>
+#include <Isen/Numa.h>
+#include <Isen/Progressbar.h>
+#include <Isen/SolverBlocked.h>
+#include <Isen/SolverCpuKernel.h>
+#include <Isen/Timer.h>
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+#ifdef ISEN_PYTHON
+#include <boost/python.hpp>
+#endif
+
+ISEN_NAMESPACE_BEGIN
+
+namespace
+{
+
+/// Number of points the valid region of a tile shrinks (on each side) per time step. The prognostic step reaches two
+/// points into the neighbourhood, the diffusion one more and the density stencil skips one point at the seam of the
+/// periodic domain (see below).
+constexpr int R = 4;
+
+/// Width (in grid points) of the tiles (without halos). The buffers of a tile should fit into the L2 cache.
+constexpr int defaultTileWidth = 128;
+
+/// @brief Geometry of a tile
+///
+/// The staggered velocity has a period of 'nx + 1' while the unstaggered fields have a period of 'nx' (see
+/// Solver::applyPeriodicBoundary). We therefore index the window of a tile by the periodic positions of the velocity
+/// (m = 0, ..., Lu - 1) which are mapped to the position 'q0 + m (mod nx + 1)'. The unstaggered fields exist at all
+/// positions but the last one (position nx, called the seam). Hence, the unstaggered fields are stored contiguously
+/// (j = 0, ..., Ls - 1) and the unstaggered point j is located at position m = j + (j >= mSeam).
+struct Window
+{
+    int q0;    ///< First position of the window
+    int Lu;    ///< Number of velocity points
+    int Ls;    ///< Number of unstaggered points
+    int mSeam; ///< Local index of the seam (Lu if the window does not contain the seam)
+
+    /// Position of the unstaggered point j
+    int m(int j) const noexcept { return j + (j >= mSeam); }
+
+    /// First unstaggered point at or behind position M
+    int j(int M) const noexcept { return M - (M > mSeam); }
+};
+
+/// Thread local buffers of a tile
+struct TileBuffer
+{
+    TileBuffer(int L, int nz)
+    {
+        const int nz1 = nz + 1;
+        mem.reset(new double[L * (6 * nz + 5 * nz1 + 1)]);
+
+        double* ptr = mem.get();
+        auto next = [&](int nlevels) {
+            double* p = ptr;
+            ptr += L * nlevels;
+            return p;
+        };
+
+        uold = next(nz);
+        unow = next(nz);
+        unew = next(nz);
+        sold = next(nz);
+        snow = next(nz);
+        snew = next(nz);
+        mtg = next(nz1);
+        prs = next(nz1);
+        exn = next(nz1);
+        zhtnow = next(nz1);
+        zhtold = next(nz1);
+        topo = next(1);
+    }
+
+    std::unique_ptr<double[]> mem;
+    double *uold, *unow, *unew, *sold, *snow, *snew, *mtg, *prs, *exn, *zhtnow, *zhtold, *topo;
+};
+
+} // anonymous namespace
+
+SolverBlocked::SolverBlocked(std::shared_ptr<NameList> namelist, Output::ArchiveType archiveType)
+    : Base(namelist, archiveType)
+{}
+
+// -------------------------------------------------- advanceBlock -----------------------------------------------------
+void SolverBlocked::advanceBlock(std::vector<StepInfo>& steps, int tileWidth)
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    const int nsteps = static_cast<int>(steps.size());
+    const int nu = nx + 1;
+    const int H = R * nsteps;
+    const int ntiles = (nu + tileWidth - 1) / tileWidth;
+    const int L = tileWidth + 2 * H;
+
+    const double gdth = g * dth;
+    const double prs0 = prs0_(nz);
+    const double fac = cp * std::pow(1.0 / pref, rdcp);
+    const double th0dth05 = dth * 0.5 + th0_(0);
+    const double rcpg05 = 0.5 * r / cp / g;
+
+    for(auto& step : steps)
+        step.umax = -std::numeric_limits<double>::max();
+
+#pragma omp parallel
+    {
+        TileBuffer buf(L, nz);
+        std::vector<double> umaxLocal(nsteps, -std::numeric_limits<double>::max());
+
+#pragma omp for schedule(dynamic)
+        for(int tile = 0; tile < ntiles; ++tile)
+        {
+            const int tileBegin = tile * tileWidth;
+            const int tileEnd = std::min(nu, tileBegin + tileWidth);
+
+            Window w;
+            w.q0 = (tileBegin - H + nu) % nu;
+            w.Lu = tileEnd - tileBegin + 2 * H;
+            w.mSeam = (nx - w.q0 + nu) % nu;
+            if(w.mSeam >= w.Lu)
+                w.mSeam = w.Lu;
+            w.Ls = w.Lu - (w.mSeam < w.Lu);
+
+            auto upos = [&](int m) { return nb + (w.q0 + m) % nu; };
+            auto spos = [&](int j) { return nb + (w.q0 + w.m(j)) % nu; };
+
+            // Load the window
+            //--------------------------------------------------------
+            for(int k = 0; k < nz; ++k)
+                for(int m = 0; m < w.Lu; ++m)
+                {
+                    buf.uold[k * L + m] = uold_(upos(m), k);
+                    buf.unow[k * L + m] = unow_(upos(m), k);
+                }
+
+            for(int k = 0; k < nz; ++k)
+                for(int j = 0; j < w.Ls; ++j)
+                {
+                    buf.sold[k * L + j] = sold_(spos(j), k);
+                    buf.snow[k * L + j] = snow_(spos(j), k);
+                    buf.mtg[k * L + j] = mtg_(spos(j), k);
+                }
+
+            for(int k = 0; k < nz1; ++k)
+                for(int j = 0; j < w.Ls; ++j)
+                    buf.zhtnow[k * L + j] = zhtnow_(spos(j), k);
+
+            for(int j = 0; j < w.Ls; ++j)
+                buf.topo[j] = topo_(spos(j));
+
+            // Advance the window
+            //--------------------------------------------------------
+            for(int t = 1; t <= nsteps; ++t)
+            {
+                const double dtdx = steps[t - 1].dtdx;
+                const double dtdx05 = 0.5 * dtdx;
+                const double dtdx2 = 2 * dtdx;
+                const double topofact = steps[t - 1].topofact;
+                const double gtopofact = g * topofact;
+
+                // Valid region of the previous time step, the prognostic step and the current time step
+                const int a = R * (t - 1), b = w.Lu - R * (t - 1);
+                const int pa = a + 2, pb = b - 2;
+                const int da = R * t, db = w.Lu - R * t;
+
+                const int uSeam = std::min(std::max(pa, w.mSeam + 1), pb);
+                const int sSeam = std::min(std::max(w.j(pa), w.mSeam), w.j(pb));
+
+                for(int k = 0; k < nz; ++k)
+                {
+                    const double* ISEN_RESTRICT unow = buf.unow + k * L;
+                    double* ISEN_RESTRICT uold = buf.uold + k * L;
+                    double* ISEN_RESTRICT unew = buf.unew + k * L;
+                    const double* ISEN_RESTRICT snow = buf.snow + k * L;
+                    double* ISEN_RESTRICT sold = buf.sold + k * L;
+                    double* ISEN_RESTRICT snew = buf.snew + k * L;
+                    const double* ISEN_RESTRICT mtg = buf.mtg + k * L;
+
+                    // Velocity (the Montgomery potential of the points behind the seam is shifted by one)
+                    for(int off = 0; off < 2; ++off)
+                        for(int m = (off ? uSeam : pa); m < (off ? pb : uSeam); ++m)
+                        {
+                            double unow_delta = unow[m] * (unow[m + 1] - unow[m - 1]);
+                            double mtg_dtdx2 = dtdx2 * (mtg[m - off] - mtg[m - off - 1]);
+                            unew[m] = uold[m] - dtdx * unow_delta - mtg_dtdx2;
+                        }
+
+                    // Isentropic density (the velocity of the points behind the seam is shifted by one)
+                    for(int off = 0; off < 2; ++off)
+                        for(int j = (off ? sSeam : w.j(pa)); j < (off ? w.j(pb) : sSeam); ++j)
+                        {
+                            const int m = j + off;
+                            double snow_iplus1 = snow[j + 1] * (unow[m + 2] + unow[m + 1]);
+                            double snow_iminus1 = snow[j - 1] * (unow[m] + unow[m - 1]);
+                            snew[j] = sold[j] - dtdx05 * (snow_iplus1 - snow_iminus1);
+                        }
+
+                    // Diffusion (the diffused fields are stored in the old fields)
+                    const double tau025 = 0.25 * tau_(k);
+                    if(tau_(k) > 0.0)
+                    {
+                        for(int m = da; m < db; ++m)
+                            uold[m] = unew[m] + tau025 * (unew[m - 1] - 2 * unew[m] + unew[m + 1]);
+                        for(int j = w.j(da); j < w.j(db); ++j)
+                            sold[j] = snew[j] + tau025 * (snew[j - 1] - 2 * snew[j] + snew[j + 1]);
+                    }
+                    else
+                    {
+                        for(int m = da; m < db; ++m)
+                            uold[m] = unew[m];
+                        for(int j = w.j(da); j < w.j(db); ++j)
+                            sold[j] = snew[j];
+                    }
+                }
+
+                std::swap(buf.uold, buf.unow);
+                std::swap(buf.sold, buf.snow);
+
+                // Diagnostic step
+                const int ja = w.j(da), jb = w.j(db);
+
+                // Pressure
+                for(int j = ja; j < jb; ++j)
+                    buf.prs[nz * L + j] = prs0;
+                for(int k = nz - 1; k >= 0; --k)
+                    for(int j = ja; j < jb; ++j)
+                        buf.prs[k * L + j] = buf.prs[(k + 1) * L + j] + gdth * buf.snow[k * L + j];
+
+                // Exner function
+                for(int k = 0; k < nz1; ++k)
+                    exnerRange(mathTier_, k * L + ja, k * L + jb, buf.exn, buf.prs, fac, rdcp);
+
+                // Montgomery
+                for(int j = ja; j < jb; ++j)
+                    buf.mtg[j] = gtopofact * buf.topo[j] + th0dth05 * buf.exn[j];
+                for(int k = 1; k < nz; ++k)
+                    for(int j = ja; j < jb; ++j)
+                        buf.mtg[k * L + j] = buf.mtg[(k - 1) * L + j] + dth * buf.exn[k * L + j];
+
+                // Geometric height
+                std::swap(buf.zhtold, buf.zhtnow);
+                for(int j = ja; j < jb; ++j)
+                    buf.zhtnow[j] = buf.topo[j] * topofact;
+                for(int k = 1; k < nz1; ++k)
+                {
+                    const double th0_kminus1 = th0_(k - 1);
+                    const double th0_center = th0_(k);
+                    for(int j = ja; j < jb; ++j)
+                    {
+                        double th0exn = th0_kminus1 * buf.exn[(k - 1) * L + j] + th0_center * buf.exn[k * L + j];
+                        double prs_delta = (buf.prs[k * L + j] - buf.prs[(k - 1) * L + j])
+                                           / (0.5 * (buf.prs[k * L + j] + buf.prs[(k - 1) * L + j]));
+                        buf.zhtnow[k * L + j] = buf.zhtnow[(k - 1) * L + j] - rcpg05 * th0exn * prs_delta;
+                    }
+                }
+
+                // Maximum velocity of the tile
+                double& umax = umaxLocal[t - 1];
+                for(int k = 0; k < nz; ++k)
+                    for(int m = H; m < w.Lu - H; ++m)
+                        umax = std::max(umax, std::fabs(buf.unow[k * L + m]));
+            }
+
+            // Store the interior of the window
+            //--------------------------------------------------------
+            for(int k = 0; k < nz; ++k)
+                for(int m = H; m < w.Lu - H; ++m)
+                {
+                    uoldNext_(upos(m), k) = buf.uold[k * L + m];
+                    unowNext_(upos(m), k) = buf.unow[k * L + m];
+                    unew_(upos(m), k) = buf.unew[k * L + m];
+                }
+
+            for(int k = 0; k < nz; ++k)
+                for(int j = w.j(H); j < w.j(w.Lu - H); ++j)
+                {
+                    soldNext_(spos(j), k) = buf.sold[k * L + j];
+                    snowNext_(spos(j), k) = buf.snow[k * L + j];
+                    snew_(spos(j), k) = buf.snew[k * L + j];
+                    mtgNext_(spos(j), k) = buf.mtg[k * L + j];
+                }
+
+            for(int k = 0; k < nz1; ++k)
+                for(int j = w.j(H); j < w.j(w.Lu - H); ++j)
+                {
+                    prs_(spos(j), k) = buf.prs[k * L + j];
+                    exn_(spos(j), k) = buf.exn[k * L + j];
+                    zhtnow_(spos(j), k) = buf.zhtnow[k * L + j];
+                    zhtold_(spos(j), k) = buf.zhtold[k * L + j];
+                }
+        }
+
+#pragma omp critical
+        for(int t = 0; t < nsteps; ++t)
+            steps[t].umax = std::max(steps[t].umax, umaxLocal[t]);
+    }
+
+    uold_.swap(uoldNext_);
+    unow_.swap(unowNext_);
+    sold_.swap(soldNext_);
+    snow_.swap(snowNext_);
+    mtg_.swap(mtgNext_);
+
+    // Exchange the boundaries of all fields
+    Boundary::periodic(uold_, nx + 1, nb);
+    Boundary::periodic(unow_, nx + 1, nb);
+    Boundary::periodic(unew_, nx + 1, nb);
+    Boundary::periodic(sold_, nx, nb);
+    Boundary::periodic(snow_, nx, nb);
+    Boundary::periodic(snew_, nx, nb);
+    Boundary::periodic(mtg_, nx, nb);
+    Boundary::periodic(prs_, nx, nb);
+    Boundary::periodic(exn_, nx, nb);
+    Boundary::periodic(zhtnow_, nx, nb);
+    Boundary::periodic(zhtold_, nx, nb);
+}
+
+// -------------------------------------------------- run --------------------------------------------------------------
+void SolverBlocked::run()
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    // Temporal blocking is only available for the dry dynamics with periodic boundaries and a fixed time step (and
+    // without checkpoints, which require the state at the end of every time step)
+    if(imoist || irelax || iadapt || icheckpoint > 0 || restartTimeControl_)
+    {
+        Base::run();
+        return;
+    }
+
+    // The window of a tile (including the halos) must not wrap around the periodic domain
+    const int nu = nx + 1;
+    const int ntiles = std::max(2, (nu + defaultTileWidth - 1) / defaultTileWidth);
+    const int tileWidth = (nu + ntiles - 1) / ntiles;
+
+    int depth = std::max(1, tblock);
+    while(depth > 1 && tileWidth + 2 * R * depth > nu)
+        --depth;
+
+    if(tileWidth + 2 * R * depth > nu)
+    {
+        Base::run();
+        return;
+    }
+
+    try
+    {
+        Numa::allocate(uoldNext_, nxb1, nz, ld_);
+        Numa::allocate(unowNext_, nxb1, nz, ld_);
+        Numa::allocate(soldNext_, nxb, nz, ld_);
+        Numa::allocate(snowNext_, nxb, nz, ld_);
+        Numa::allocate(mtgNext_, nxb, nz, ld_);
+    }
+    catch(std::bad_alloc&)
+    {
+        throw IsenException("out of memory");
+    }
+
+    Timer t;
+
+    Progressbar pbar(nts);
+    const bool logIsDisabled = LOG().isDisabled();
+    Progressbar::disableProgressbar = logIsDisabled;
+
+    double curTime = 0;
+    std::vector<StepInfo> steps;
+
+    // Loop over all temporal blocks
+    //------------------------------------------------------------
+    for(int i = 1; i < (nts + 1); i += static_cast<int>(steps.size()))
+    {
+        // Temporal blocks end at the output steps
+        const int nsteps = std::min(std::min(depth, nts + 1 - i), iout - (i - 1) % iout);
+
+        steps.resize(nsteps);
+        for(int n = 0; n < nsteps; ++n)
+        {
+            curTime += dt;
+            steps[n].topofact = std::min(1., curTime / topotim);
+            steps[n].dtdx = (i + n) == 1 ? 0.5 * dt / dx : dt / dx;
+        }
+
+        advanceBlock(steps, tileWidth);
+
+        // Check maximum CFL condition of every time step
+        //--------------------------------------------------------
+        for(const auto& step : steps)
+        {
+            if(!iprtcfl)
+                pbar.advance();
+
+            dtdx_ = step.dtdx;
+            topofact_ = step.topofact;
+            checkCFL(step.umax);
+        }
+
+        // Output every 'iout'-th time step
+        //--------------------------------------------------------
+        if(((i + nsteps - 1) % iout) == 0)
+            output_->makeOutput(this);
+
+#ifdef ISEN_PYTHON
+        // Handle Python signals
+        //--------------------------------------------------------
+        if(PyErr_CheckSignals() == -1)
+            throw IsenException("PySolver::run : signal caught");
+#endif
+    }
+
+    pbar.pause();
+    if(!logIsDisabled)
+        Progressbar::printBar('=');
+
+    if(logIsDisabled && itime)
+        std::printf("Elapsed time: %s\n", timeString(t.stop()).c_str());
+
+    LOG() << "Finished time loop ...";
+    LOG_SUCCESS(t);
+}
+
+ISEN_NAMESPACE_END
@@ -19,161 +19,193 @@
 #include <Isen/Output.h>
 #include <Isen/Progressbar.h>
 #include <Isen/SolverCpu.h>
+#include <Isen/SolverCpuKernel.h>
+#include <Isen/SolverCpuSimd.h>
+#include <Isen/TimeControl.h>
 #include <Isen/Timer.h>
+#include <exception>
+#include <limits>
+
+#ifdef ISEN_PYTHON
+#include <boost/python.hpp>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 ISEN_NAMESPACE_BEGIN
 
 SolverCpu::SolverCpu(std::shared_ptr<NameList> namelist, Output::ArchiveType archiveType)
-    : Base(namelist, archiveType)
-{}
+    : Base(namelist, archiveType), mathTier_(FastMath::toTier(namelist->imath))
+{
+    // Replace the Kessler scheme of the Solver
+    if(namelist->imoist && namelist->imicrophys == 1)
+    {
+        kessler_.reset();
+        kesslerColumn_ = std::make_shared<KesslerColumn>(namelist_);
+    }
+}
 
 // -------------------------------------------------- horizontalDiffusion ----------------------------------------------
+template <class T>
 ISEN_NO_INLINE void kernel_horizontalDiffusion(const int nx,
                                                const int nz,
                                                const int nb,
-                                               double* ISEN_RESTRICT unew,
-                                               double* ISEN_RESTRICT snew,
-                                               double* ISEN_RESTRICT qvnew,
-                                               double* ISEN_RESTRICT qcnew,
-                                               double* ISEN_RESTRICT qrnew,
-                                               const double* ISEN_RESTRICT unow,
-                                               const double* ISEN_RESTRICT snow,
-                                               const double* ISEN_RESTRICT qvnow,
-                                               const double* ISEN_RESTRICT qcnow,
-                                               const double* ISEN_RESTRICT qrnow,
-                                               const double* ISEN_RESTRICT tau,
-                                               const bool imoist)
+                                               const int ld,
+                                               const int ntr,
+                                               const int stride,
+                                               T* ISEN_RESTRICT unew,
+                                               T* ISEN_RESTRICT snew,
+                                               T* ISEN_RESTRICT qnew,
+                                               const T* ISEN_RESTRICT unow,
+                                               const T* ISEN_RESTRICT snow,
+                                               const T* ISEN_RESTRICT qnow,
+                                               const T* ISEN_RESTRICT tau,
+                                               FieldReduction<T>* reduction)
 {
     const int nxnb = nx + nb;
     const int nxnb1 = nx + nb + 1;
 
-    const int nxb = nx + 2 * nb;
-    const int nxb1 = nx + 2 * nb + 1;
+    T umax = T(0), smass = T(0), check = T(0);
 
-#pragma omp parallel for
+#pragma omp for nowait
     for(int k = 0; k < nz; ++k)
     {
-        const double tau025 = 0.25 * tau[k];
+        const T tau025 = T(0.25) * tau[k];
 
         // Velocity
         if(tau[k] > 0.0)
             for(int i = nb; i < nxnb1; ++i)
-                unew[k * nxb1 + i] = unow[k * nxb1 + i]
+                unew[k * ld + i] = unow[k * ld + i]
                                      + tau025
-                                           * (unow[k * nxb1 + i - 1] - 2 * unow[k * nxb1 + i] + unow[k * nxb1 + i + 1]);
+                                           * (unow[k * ld + i - 1] - 2 * unow[k * ld + i] + unow[k * ld + i + 1]);
         else
             for(int i = nb; i < nxnb1; ++i)
-                unew[k * nxb1 + i] = unow[k * nxb1 + i];
+                unew[k * ld + i] = unow[k * ld + i];
 
         // Isentropic density
         if(tau[k] > 0.0)
             for(int i = nb; i < nxnb; ++i)
-                snew[k * nxb + i] = snow[k * nxb + i]
-                                    + tau025 * (snow[k * nxb + i - 1] - 2 * snow[k * nxb + i] + snow[k * nxb + i + 1]);
+                snew[k * ld + i] = snow[k * ld + i]
+                                    + tau025 * (snow[k * ld + i - 1] - 2 * snow[k * ld + i] + snow[k * ld + i + 1]);
         else
             for(int i = nb; i < nxnb; ++i)
-                snew[k * nxb + i] = snow[k * nxb + i];
+                snew[k * ld + i] = snow[k * ld + i];
 
-        if(imoist)
+        // Moisture tracers
+        for(int t = 0; t < ntr; ++t)
         {
-            // qv
-            if(tau[k] > 0.0)
-                for(int i = nb; i < nxnb; ++i)
-                    qvnew[k * nxb + i]
-                        = qvnow[k * nxb + i]
-                          + tau025 * (qvnow[k * nxb + i - 1] - 2 * qvnow[k * nxb + i] + qvnow[k * nxb + i + 1]);
-            else
-                for(int i = nb; i < nxnb; ++i)
-                    qvnew[k * nxb + i] = qvnow[k * nxb + i];
+            T* ISEN_RESTRICT qnewk = qnew + t * stride + k * ld;
+            const T* ISEN_RESTRICT qnowk = qnow + t * stride + k * ld;
 
-            // qc
             if(tau[k] > 0.0)
                 for(int i = nb; i < nxnb; ++i)
-                    qcnew[k * nxb + i]
-                        = qcnow[k * nxb + i]
-                          + tau025 * (qcnow[k * nxb + i - 1] - 2 * qcnow[k * nxb + i] + qcnow[k * nxb + i + 1]);
+                    qnewk[i] = qnowk[i] + tau025 * (qnowk[i - 1] - 2 * qnowk[i] + qnowk[i + 1]);
             else
                 for(int i = nb; i < nxnb; ++i)
-                    qcnew[k * nxb + i] = qcnow[k * nxb + i];
+                    qnewk[i] = qnowk[i];
+        }
 
-            // qr
-            if(tau[k] > 0.0)
-                for(int i = nb; i < nxnb; ++i)
-                    qrnew[k * nxb + i]
-                        = qrnow[k * nxb + i]
-                          + tau025 * (qrnow[k * nxb + i - 1] - 2 * qrnow[k * nxb + i] + qrnow[k * nxb + i + 1]);
-            else
-                for(int i = nb; i < nxnb; ++i)
-                    qrnew[k * nxb + i] = qrnow[k * nxb + i];
+        // Reductions (the rows are still in the cache)
+        if(reduction)
+        {
+            for(int i = nb; i < nxnb1; ++i)
+            {
+                umax = std::max(umax, std::fabs(unew[k * ld + i]));
+                check += unew[k * ld + i] - unew[k * ld + i];
+            }
+            for(int i = nb; i < nxnb; ++i)
+            {
+                smass += snew[k * ld + i];
+                check += snew[k * ld + i] - snew[k * ld + i];
+            }
         }
     }
+
+    if(reduction)
+    {
+        reduction->umax = std::max(reduction->umax, umax);
+        reduction->smass += smass;
+        reduction->check += check;
+    }
 }
 
 void SolverCpu::horizontalDiffusion() noexcept
 {
     SOLVER_DECLARE_ALL_ALIASES
-    kernel_horizontalDiffusion(nx, nz, nb, unew_.data(), snew_.data(), qvnew_.data(), qcnew_.data(), qrnew_.data(),
-                               unow_.data(), snow_.data(), qvnow_.data(), qcnow_.data(), qrnow_.data(), tau_.data(),
-                               imoist);
+#pragma omp parallel
+    solverCpuKernels<double>().horizontalDiffusion(nx, nz, nb, ld_, imoist ? qnew_.size() : 0, qnew_.stride(),
+                                                   unew_.data(), snew_.data(), qnew_.data(), unow_.data(),
+                                                   snow_.data(), qnow_.data(), tau_.data(), nullptr);
 }
 
 
 // -------------------------------------------------- clipMoisture -----------------------------------------------------
 
+template <class T>
 ISEN_NO_INLINE void kernel_clipMoisture(const int nx,
                                         const int nz,
                                         const int nb,
-                                        double* ISEN_RESTRICT qnow)
+                                        const int ld,
+                                        const int ntr,
+                                        const int stride,
+                                        T* ISEN_RESTRICT qnow)
 {
     const int nxb = nx + 2 * nb;
     
+#pragma omp for nowait
     for(int k = 0; k < nz; ++k)
-        for(int i = 0; i < nxb; ++i)
-            qnow[k*nxb + i] = qnow[k*nxb + i] < 0.0 ? 0.0 : qnow[k*nxb + i];
+        for(int t = 0; t < ntr; ++t)
+        {
+            T* ISEN_RESTRICT qnowk = qnow + t * stride + k * ld;
+            for(int i = 0; i < nxb; ++i)
+                qnowk[i] = qnowk[i] < T(0) ? T(0) : qnowk[i];
+        }
 }
                                            
 void SolverCpu::clipMoisture() noexcept
 {
     SOLVER_DECLARE_ALL_ALIASES
-    kernel_clipMoisture(nx, nz, nb, qvnew_.data());
-    kernel_clipMoisture(nx, nz, nb, qcnew_.data());
-    kernel_clipMoisture(nx, nz, nb, qrnew_.data());
+#pragma omp parallel
+    solverCpuKernels<double>().clipMoisture(nx, nz, nb, ld_, qnew_.size(), qnew_.stride(), qnew_.data());
 }
 
 // -------------------------------------------------- geometricHeight --------------------------------------------------
+template <class T>
 ISEN_NO_INLINE void kernel_geometricHeight(const int nx,
                                            const int nz,
                                            const int nb,
-                                           double* ISEN_RESTRICT zhtnow,
-                                           const double* ISEN_RESTRICT topo,
-                                           const double* ISEN_RESTRICT th0,
-                                           const double* ISEN_RESTRICT exn,
-                                           const double* ISEN_RESTRICT prs,
-                                           const double topofact,
-                                           const double rcpg05)
+                                           const int ld,
+                                           T* ISEN_RESTRICT zhtnow,
+                                           const T* ISEN_RESTRICT topo,
+                                           const T* ISEN_RESTRICT th0,
+                                           const T* ISEN_RESTRICT exn,
+                                           const T* ISEN_RESTRICT prs,
+                                           const T topofact,
+                                           const T rcpg05)
 {
     const int nxb = nx + 2 * nb;
     const int nz1 = nz + 1;
 
-    #pragma omp parallel
+    // Each column only depends on itself. The static schedule assigns the same columns to the same thread in every
+    // level, hence the levels don't need to be synchronized.
+    #pragma omp for schedule(static) nowait
+    for(int i = 0; i < nxb; ++i)
+        zhtnow[i] = topo[i] * topofact;
+
+    for(int k = 1; k < nz1; ++k)
     {
-        #pragma omp for
+        T th0_kminus1 = th0[k - 1];
+        T th0_center = th0[k];
+        
+        #pragma omp for schedule(static) nowait
         for(int i = 0; i < nxb; ++i)
-            zhtnow[i] = topo[i] * topofact;
-    
-        for(int k = 1; k < nz1; ++k)
         {
-            double th0_kminus1 = th0[k - 1];
-            double th0_center = th0[k];
-            
-            #pragma omp for        
-            for(int i = 0; i < nxb; ++i)
-            {
-                double th0exn = th0_kminus1 * exn[(k - 1) * nxb + i] + th0_center * exn[k * nxb + i];
-                double prs_delta = (prs[k * nxb + i] - prs[(k - 1) * nxb + i])
-                                   / (0.5 * (prs[k * nxb + i] + prs[(k - 1) * nxb + i]));
-                zhtnow[k * nxb + i] = zhtnow[(k - 1) * nxb + i] - rcpg05 * th0exn * prs_delta;
-            }
+            T th0exn = th0_kminus1 * exn[(k - 1) * ld + i] + th0_center * exn[k * ld + i];
+            T prs_delta = (prs[k * ld + i] - prs[(k - 1) * ld + i])
+                               / (T(0.5) * (prs[k * ld + i] + prs[(k - 1) * ld + i]));
+            zhtnow[k * ld + i] = zhtnow[(k - 1) * ld + i] - rcpg05 * th0exn * prs_delta;
         }
     }
 }
@@ -181,191 +213,983 @@ ISEN_NO_INLINE void kernel_geometricHeight(const int nx,
 void SolverCpu::geometricHeight() noexcept
 {
     SOLVER_DECLARE_ALL_ALIASES
-    kernel_geometricHeight(nx, nz, nb, zhtnow_.data(), topo_.data(), th0_.data(), exn_.data(), prs_.data(), topofact_,
-                           0.5 * r / cp / g);
+#pragma omp parallel
+    solverCpuKernels<double>().geometricHeight(nx, nz, nb, ld_, zhtnow_.data(), topo_.data(), th0_.data(), exn_.data(),
+                                               prs_.data(), topofact_, 0.5 * r / cp / g);
 }
 
 // -------------------------------------------------- diagMontgomery ---------------------------------------------------
+template <class Math, class T>
+static inline void exnerRangeImpl(const Math& math,
+                                  const int begin,
+                                  const int end,
+                                  T* ISEN_RESTRICT exn,
+                                  const T* ISEN_RESTRICT prs,
+                                  const T fac,
+                                  const T rdcp)
+{
+    for(int i = begin; i < end; ++i)
+        exn[i] = fac * math.pow(prs[i], rdcp);
+}
+
+template <class T>
+void exnerRange(const MathTier tier,
+                const int begin,
+                const int end,
+                T* ISEN_RESTRICT exn,
+                const T* ISEN_RESTRICT prs,
+                const T fac,
+                const T rdcp)
+{
+    switch(tier)
+    {
+        case MathTier::Polynomial:
+            exnerRangeImpl(MathPolynomial<T>(), begin, end, exn, prs, fac, rdcp);
+            break;
+        case MathTier::Table:
+            exnerRangeImpl(MathTable<T>(), begin, end, exn, prs, fac, rdcp);
+            break;
+        default:
+            exnerRangeImpl(MathExact<T>(), begin, end, exn, prs, fac, rdcp);
+    }
+}
+
+template <class T>
 ISEN_NO_INLINE void kernel_diagMontgomery_Exner(const int nx,
                                                 const int nz,
                                                 const int nb,
-                                                double* ISEN_RESTRICT exn,
-                                                const double* ISEN_RESTRICT prs,
+                                                const int ld,
+                                                T* ISEN_RESTRICT exn,
+                                                const T* ISEN_RESTRICT prs,
                                                 const double cp,
                                                 const double pref,
-                                                const double rdcp)
+                                                const double rdcp,
+                                                const MathTier tier)
 {
     const int nxb = nx + 2 * nb;
     const int nz1 = nz + 1;
     
-    const double fac = cp * std::pow(1.0 / pref, rdcp);
+    const T fac = cp * std::pow(1.0 / pref, rdcp);
 
-#pragma omp parallel for
+#pragma omp for nowait
     for(int k = 0; k < nz1; ++k)
-        for(int i = 0; i < nxb; ++i)
-            exn[k * nxb + i] = fac * std::pow(prs[k * nxb + i], rdcp);
+        exnerRange(tier, k * ld, k * ld + nxb, exn, prs, fac, T(rdcp));
 }
 
+template <class T>
 ISEN_NO_INLINE void kernel_diagMontgomery_Montgomery(const int nx,
                                                      const int nz,
                                                      const int nb,
-                                                     double* ISEN_RESTRICT mtg,
-                                                     const double* ISEN_RESTRICT topo,
-                                                     const double* ISEN_RESTRICT exn,
-                                                     const double th0,
-                                                     const double cp,
-                                                     const double dth,
-                                                     const double gtopofact)
+                                                     const int ld,
+                                                     T* ISEN_RESTRICT mtg,
+                                                     const T* ISEN_RESTRICT topo,
+                                                     const T* ISEN_RESTRICT exn,
+                                                     const T th0,
+                                                     const T cp,
+                                                     const T dth,
+                                                     const T gtopofact)
 {
     const int nxb = nx + 2 * nb;
-    const double th0dth05 = dth * 0.5 + th0;
+    const T th0dth05 = dth * T(0.5) + th0;
 
-    
-    #pragma omp parallel
-    {
-        #pragma omp for  
+    // See kernel_geometricHeight
+    #pragma omp for schedule(static) nowait
+    for(int i = 0; i < nxb; ++i)
+        mtg[i] = gtopofact * topo[i] + th0dth05 * exn[i];
+
+    for(int k = 1; k < nz; ++k)
+        #pragma omp for schedule(static) nowait
         for(int i = 0; i < nxb; ++i)
-            mtg[i] = gtopofact * topo[i] + th0dth05 * exn[i];
-    
-        for(int k = 1; k < nz; ++k)
-            #pragma omp for              
-            for(int i = 0; i < nxb; ++i)
-                mtg[k * nxb + i] = mtg[(k - 1) * nxb + i] + dth * exn[k * nxb + i];
-    }
+            mtg[k * ld + i] = mtg[(k - 1) * ld + i] + dth * exn[k * ld + i];
 }
 
 void SolverCpu::diagMontgomery() noexcept
 {
     SOLVER_DECLARE_ALL_ALIASES
 
-    // Exner function
-    kernel_diagMontgomery_Exner(nx, nz, nb, exn_.data(), prs_.data(), cp, pref, rdcp);
+#pragma omp parallel
+    {
+        // Exner function
+        kernel_diagMontgomery_Exner(nx, nz, nb, ld_, exn_.data(), prs_.data(), cp, pref, rdcp, mathTier_);
+
+#pragma omp barrier
 
-    // Montgomery
-    kernel_diagMontgomery_Montgomery(nx, nz, nb, mtg_.data(), topo_.data(), exn_.data(), th0_(0), cp, dth,  g * topofact_);
+        // Montgomery
+        solverCpuKernels<double>().diagMontgomery_Montgomery(nx, nz, nb, ld_, mtg_.data(), topo_.data(), exn_.data(),
+                                                             th0_(0), cp, dth, g * topofact_);
+    }
 }
 
 
 // -------------------------------------------------- diagPressure -----------------------------------------------------
+template <class T>
 ISEN_NO_INLINE void kernel_diagPressure(const int nxb,
                                         const int nz,
-                                        double* ISEN_RESTRICT prs,
-                                        const double* ISEN_RESTRICT snow,
-                                        const double gdth,
-                                        const double prs0)
+                                        const int ld,
+                                        T* ISEN_RESTRICT prs,
+                                        const T* ISEN_RESTRICT snow,
+                                        const T gdth,
+                                        const T prs0)
 {
-    const int nz_offset = nz * nxb;
+    const int nz_offset = nz * ld;
 
-    #pragma omp parallel
+    // See kernel_geometricHeight
+    #pragma omp for schedule(static) nowait
+    for(int i = 0; i < nxb; ++i)
+        prs[nz_offset + i] = prs0;
+
+    for(int k = nz - 1; k >= 0; --k)
     {
-        #pragma omp for    
+        #pragma omp for schedule(static) nowait
         for(int i = 0; i < nxb; ++i)
-            prs[nz_offset + i] = prs0;
-    
-        for(int k = nz - 1; k >= 0; --k)
-        {
-            #pragma omp for            
-            for(int i = 0; i < nxb; ++i)
-                prs[k * nxb + i] = prs[(k + 1) * nxb + i] + gdth * snow[k * nxb + i];
-        }
+            prs[k * ld + i] = prs[(k + 1) * ld + i] + gdth * snow[k * ld + i];
     }
 }
 
 void SolverCpu::diagPressure() noexcept
 {
     SOLVER_DECLARE_ALL_ALIASES
-    kernel_diagPressure(nxb, nz, prs_.data(), snow_.data(), g * dth, prs0_(nz));
+#pragma omp parallel
+    solverCpuKernels<double>().diagPressure(nxb, nz, ld_, prs_.data(), snow_.data(), g * dth, prs0_(nz));
+}
+
+// -------------------------------------------------- diagColumn -------------------------------------------------------
+template <class T>
+ISEN_NO_INLINE void kernel_diagColumn(const int nx,
+                                      const int nz,
+                                      const int nb,
+                                      const int ld,
+                                      T* ISEN_RESTRICT prs,
+                                      T* ISEN_RESTRICT exn,
+                                      T* ISEN_RESTRICT mtg,
+                                      T* ISEN_RESTRICT zhtnow,
+                                      const T* ISEN_RESTRICT snow,
+                                      const T* ISEN_RESTRICT topo,
+                                      const T* ISEN_RESTRICT th0,
+                                      const T gdth,
+                                      const T prs0,
+                                      const double cp,
+                                      const double pref,
+                                      const double rdcp,
+                                      const T dth,
+                                      const T gtopofact,
+                                      const T topofact,
+                                      const T rcpg05,
+                                      const MathTier tier)
+{
+    const int nxb = nx + 2 * nb;
+    const int nz1 = nz + 1;
+
+    const T fac = cp * std::pow(1.0 / pref, rdcp);
+    const T th0dth05 = dth * T(0.5) + th0[0];
+
+    // Distribute the columns evenly over the threads in chunks of whole cache lines. A chunk is limited to
+    // DiagColumnChunk cache lines such that its columns of all fields stay in the L2 cache between the two sweeps.
+    int numThreads = 1;
+#ifdef _OPENMP
+    numThreads = omp_get_num_threads();
+#endif
+    const int lanes = Field<T>::Lanes;
+    const int linesPerThread = ((nxb + lanes - 1) / lanes + numThreads - 1) / numThreads;
+    const int chunk = lanes * std::max(1, std::min(linesPerThread, DiagColumnChunk));
+    const int numChunks = (nxb + chunk - 1) / chunk;
+
+    #pragma omp for schedule(static) nowait
+    for(int c = 0; c < numChunks; ++c)
+    {
+        const int begin = c * chunk;
+        const int end = std::min(begin + chunk, nxb);
+
+        // Pressure (downward integration)
+        for(int i = begin; i < end; ++i)
+            prs[nz * ld + i] = prs0;
+
+        for(int k = nz - 1; k >= 0; --k)
+            for(int i = begin; i < end; ++i)
+                prs[k * ld + i] = prs[(k + 1) * ld + i] + gdth * snow[k * ld + i];
+
+        // Exner function, Montgomery potential and geometric height (upward integration)
+        exnerRange(tier, begin, end, exn, prs, fac, T(rdcp));
+
+        for(int i = begin; i < end; ++i)
+        {
+            mtg[i] = gtopofact * topo[i] + th0dth05 * exn[i];
+            zhtnow[i] = topo[i] * topofact;
+        }
+
+        for(int k = 1; k < nz1; ++k)
+        {
+            exnerRange(tier, k * ld + begin, k * ld + end, exn, prs, fac, T(rdcp));
+
+            if(k < nz)
+                for(int i = begin; i < end; ++i)
+                    mtg[k * ld + i] = mtg[(k - 1) * ld + i] + dth * exn[k * ld + i];
+
+            T th0_kminus1 = th0[k - 1];
+            T th0_center = th0[k];
+
+            for(int i = begin; i < end; ++i)
+            {
+                T th0exn = th0_kminus1 * exn[(k - 1) * ld + i] + th0_center * exn[k * ld + i];
+                T prs_delta = (prs[k * ld + i] - prs[(k - 1) * ld + i])
+                                   / (T(0.5) * (prs[k * ld + i] + prs[(k - 1) * ld + i]));
+                zhtnow[k * ld + i] = zhtnow[(k - 1) * ld + i] - rcpg05 * th0exn * prs_delta;
+            }
+        }
+    }
 }
 
 // -------------------------------------------------- progIsendens -----------------------------------------------------
+template <class T>
 ISEN_NO_INLINE void kernel_progIsendens(const int nx,
                                         const int nz,
                                         const int nb,
-                                        double* ISEN_RESTRICT snew,
-                                        const double* ISEN_RESTRICT snow,
-                                        const double* ISEN_RESTRICT sold,
-                                        const double* ISEN_RESTRICT unow,
-                                        const double dtdx05)
+                                        const int ld,
+                                        T* ISEN_RESTRICT snew,
+                                        const T* ISEN_RESTRICT snow,
+                                        const T* ISEN_RESTRICT sold,
+                                        const T* ISEN_RESTRICT unow,
+                                        const T dtdx05)
 {
-    const int nxb = nx + 2 * nb;
-    const int nxb1 = nx + 2 * nb + 1;
     const int nxnb = nx + nb;
 
-#pragma omp parallel for
+#pragma omp for nowait
     for(int k = 0; k < nz; ++k)
         for(int i = nb; i < nxnb; ++i)
         {
-            double snow_iplus1 = snow[k*nxb + i + 1] * (unow[k*nxb1 + i + 2] + unow[k*nxb1 + i + 1]);
-            double snow_iminus1 = snow[k*nxb + i - 1] * (unow[k*nxb1 + i] + unow[k*nxb1 + i -1]);
-            snew[k*nxb + i] = sold[k*nxb + i] - dtdx05 * (snow_iplus1 - snow_iminus1);
+            T snow_iplus1 = snow[k * ld + i + 1] * (unow[k * ld + i + 2] + unow[k * ld + i + 1]);
+            T snow_iminus1 = snow[k * ld + i - 1] * (unow[k * ld + i] + unow[k * ld + i -1]);
+            snew[k * ld + i] = sold[k * ld + i] - dtdx05 * (snow_iplus1 - snow_iminus1);
         }
 }
 
 void SolverCpu::progIsendens() noexcept
 {
     SOLVER_DECLARE_ALL_ALIASES
-    kernel_progIsendens(nx, nz, nb, snew_.data(), snow_.data(), sold_.data(), unow_.data(), 0.5 * dtdx_);
+#pragma omp parallel
+    solverCpuKernels<double>().progIsendens(nx, nz, nb, ld_, snew_.data(), snow_.data(), sold_.data(), unow_.data(),
+                                            0.5 * dtdx_);
 }
 
 // -------------------------------------------------- progMoisture -----------------------------------------------------
+template <class T>
 ISEN_NO_INLINE void kernel_progMoisture(const int nx,
                                         const int nz,
                                         const int nb,
-                                        double* ISEN_RESTRICT qnew,                                       
-                                        const double* ISEN_RESTRICT qnow,
-                                        const double* ISEN_RESTRICT qold,
-                                        const double* ISEN_RESTRICT unow,
-                                        const double dtdx05)
+                                        const int ld,
+                                        const int ntr,
+                                        const int stride,
+                                        T* ISEN_RESTRICT qnew,                                       
+                                        const T* ISEN_RESTRICT qnow,
+                                        const T* ISEN_RESTRICT qold,
+                                        const T* ISEN_RESTRICT unow,
+                                        const T dtdx05)
 {
-    const int nxb = nx + 2 * nb;
-    const int nxb1 = nx + 2 * nb + 1;
     const int nxnb = nx + nb;
     
-#pragma omp parallel for
+    // The velocity of a point is loaded once for all tracers
+#pragma omp for nowait
     for(int k = 0; k < nz; ++k)
         for(int i = nb; i < nxnb; ++i)
-            qnew[k*nxb + i] = qold[k*nxb + i] - dtdx05 * (unow[k*nxb1 + i] + unow[k*nxb1 + i + 1]) 
-                                                       * (qnow[k*nxb + i + 1] - qnow[k*nxb + i - 1]);
+        {
+            const T flux = dtdx05 * (unow[k * ld + i] + unow[k * ld + i + 1]);
+            for(int t = 0; t < ntr; ++t)
+            {
+                const int c = t * stride + k * ld + i;
+                qnew[c] = qold[c] - flux * (qnow[c + 1] - qnow[c - 1]);
+            }
+        }
 }
 
 void SolverCpu::progMoisture() noexcept
 {
     SOLVER_DECLARE_ALL_ALIASES
-    kernel_progMoisture(nx, nz, nb, qvnew_.data(), qvnow_.data(), qvold_.data(), unow_.data(), 0.5 * dtdx_);
-    kernel_progMoisture(nx, nz, nb, qcnew_.data(), qcnow_.data(), qcold_.data(), unow_.data(), 0.5 * dtdx_);
-    kernel_progMoisture(nx, nz, nb, qrnew_.data(), qrnow_.data(), qrold_.data(), unow_.data(), 0.5 * dtdx_);
+#pragma omp parallel
+    solverCpuKernels<double>().progMoisture(nx, nz, nb, ld_, qnew_.size(), qnew_.stride(), qnew_.data(),
+                                            qnow_.data(), qold_.data(), unow_.data(), 0.5 * dtdx_);
+}
+
+// -------------------------------------------------- progTracers ------------------------------------------------------
+template <class T>
+ISEN_NO_INLINE void kernel_progTracers(const int nx,
+                                       const int nz,
+                                       const int nb,
+                                       const int ld,
+                                       const int ntr,
+                                       const int stride,
+                                       T* ISEN_RESTRICT qold,
+                                       const T* ISEN_RESTRICT qnow,
+                                       T* ISEN_RESTRICT qnew,
+                                       const T* ISEN_RESTRICT unow,
+                                       const T* ISEN_RESTRICT tau,
+                                       const T* ISEN_RESTRICT qbnd1,
+                                       const T* ISEN_RESTRICT qbnd2,
+                                       const T dtdx05)
+{
+    const int nxb = nx + 2 * nb;
+    const int nxnb = nx + nb;
+
+#pragma omp for nowait
+    for(int k = 0; k < nz; ++k)
+    {
+        const T tau025 = T(0.25) * tau[k];
+
+        // Advection of all tracers (see kernel_progMoisture)
+        for(int i = nb; i < nxnb; ++i)
+        {
+            const T flux = dtdx05 * (unow[k * ld + i] + unow[k * ld + i + 1]);
+            for(int t = 0; t < ntr; ++t)
+            {
+                const int c = t * stride + k * ld + i;
+                qnew[c] = qold[c] - flux * (qnow[c + 1] - qnow[c - 1]);
+            }
+        }
+
+        // Boundaries, diffusion and clipping while the level of the tracer is in the cache
+        for(int t = 0; t < ntr; ++t)
+        {
+            T* ISEN_RESTRICT qnewk = qnew + t * stride + k * ld;
+            T* ISEN_RESTRICT qoldk = qold + t * stride + k * ld;
+
+            if(qbnd1)
+                Boundary::relaxLevel(qnewk, nx, nb, qbnd1[t * nz + k], qbnd2[t * nz + k]);
+            else
+                Boundary::periodicLevel(qnewk, nx, nb);
+
+            if(tau[k] > 0.0)
+                for(int i = nb; i < nxnb; ++i)
+                    qoldk[i] = qnewk[i] + tau025 * (qnewk[i - 1] - 2 * qnewk[i] + qnewk[i + 1]);
+            else
+                for(int i = nb; i < nxnb; ++i)
+                    qoldk[i] = qnewk[i];
+
+            if(!qbnd1)
+                Boundary::periodicLevel(qoldk, nx, nb);
+
+            for(int i = 0; i < nxb; ++i)
+                qoldk[i] = qoldk[i] < T(0) ? T(0) : qoldk[i];
+        }
+    }
 }
 
 // -------------------------------------------------- progVelocity -----------------------------------------------------
+template <class T>
 ISEN_NO_INLINE void kernel_progVelocity(const int nx,
                                         const int nz,
                                         const int nb,
-                                        double* ISEN_RESTRICT unew,
-                                        const double* ISEN_RESTRICT unow,
-                                        const double* ISEN_RESTRICT uold,
-                                        const double* ISEN_RESTRICT mtg,
-                                        const double dtdx)
+                                        const int ld,
+                                        T* ISEN_RESTRICT unew,
+                                        const T* ISEN_RESTRICT unow,
+                                        const T* ISEN_RESTRICT uold,
+                                        const T* ISEN_RESTRICT mtg,
+                                        const T dtdx)
 {
-    const int nxb = nx + 2 * nb;
-    const int nx1b = nx + 2 * nb + 1;
     const int nx1nb = nx + nb + 1;
 
-    const double dtdx2 = 2 * dtdx;
+    const T dtdx2 = 2 * dtdx;
 
-#pragma omp parallel for
+#pragma omp for nowait
     for(int k = 0; k < nz; ++k)
         for(int i = nb; i < nx1nb; ++i)
         {
-            double unow_delta = unow[k * nx1b + i] * (unow[k * nx1b + i + 1] - unow[k * nx1b + i - 1]);
-            double mtg_dtdx2 = dtdx2 * (mtg[k * nxb + i] - mtg[k * nxb + i - 1]);
-            unew[k * nx1b + i] = uold[k * nx1b + i] - dtdx * unow_delta - mtg_dtdx2;
+            T unow_delta = unow[k * ld + i] * (unow[k * ld + i + 1] - unow[k * ld + i - 1]);
+            T mtg_dtdx2 = dtdx2 * (mtg[k * ld + i] - mtg[k * ld + i - 1]);
+            unew[k * ld + i] = uold[k * ld + i] - dtdx * unow_delta - mtg_dtdx2;
         }
 }
 
 void SolverCpu::progVelocity() noexcept
 {
     SOLVER_DECLARE_ALL_ALIASES
-    kernel_progVelocity(nx, nz, nb, unew_.data(), unow_.data(), uold_.data(), mtg_.data(), dtdx_);
+#pragma omp parallel
+    solverCpuKernels<double>().progVelocity(nx, nz, nb, ld_, unew_.data(), unow_.data(), uold_.data(), mtg_.data(),
+                                            dtdx_);
+}
+
+// -------------------------------------------------- progEnsemble -----------------------------------------------------
+/// Relax a level of all members towards their boundary values @c phi1 and @c phi2 (see Boundary::relaxLevel)
+template <class T>
+static inline void relaxLevelEnsemble(T* ISEN_RESTRICT phi,
+                                      const int nx,
+                                      const int nb,
+                                      const int M,
+                                      const T* ISEN_RESTRICT phi1,
+                                      const T* ISEN_RESTRICT phi2)
+{
+    const int n = 2 * nb + nx;
+
+    for(int i = 0; i < Boundary::RelaxWidth; ++i)
+        for(int m = 0; m < M; ++m)
+        {
+            phi[i * M + m] = Boundary::relaxPoint(phi[i * M + m], phi1[m], i);
+            phi[(n - 1 - i) * M + m] = Boundary::relaxPoint(phi[(n - 1 - i) * M + m], phi2[m], i);
+        }
+}
+
+/// Diffuse the points [begin, end) of a level of all members with their diffusion coefficients @c tau (@c sel is 1
+/// where @c tau is positive and 0 otherwise)
+template <class T>
+static inline void diffuseLevelEnsemble(const int begin,
+                                        const int end,
+                                        const int M,
+                                        T* ISEN_RESTRICT phinew,
+                                        const T* ISEN_RESTRICT phinow,
+                                        const T* ISEN_RESTRICT tau,
+                                        const T* ISEN_RESTRICT sel)
+{
+    for(int i = begin; i < end; ++i)
+    {
+        const T* ISEN_RESTRICT left = phinow + (i - 1) * M;
+        const T* ISEN_RESTRICT center = phinow + i * M;
+        const T* ISEN_RESTRICT right = phinow + (i + 1) * M;
+        T* ISEN_RESTRICT out = phinew + i * M;
+
+        for(int m = 0; m < M; ++m)
+            out[m] = sel[m] * (center[m] + T(0.25) * tau[m] * (left[m] - 2 * center[m] + right[m]))
+                     + (T(1) - sel[m]) * center[m];
+    }
 }
 
+template <class T>
+ISEN_NO_INLINE void kernel_progEnsemble(const int nx,
+                                        const int nz,
+                                        const int nb,
+                                        const int M,
+                                        const int ld,
+                                        const int ntr,
+                                        const int stride,
+                                        T* ISEN_RESTRICT uold,
+                                        const T* ISEN_RESTRICT unow,
+                                        T* ISEN_RESTRICT unew,
+                                        T* ISEN_RESTRICT sold,
+                                        const T* ISEN_RESTRICT snow,
+                                        T* ISEN_RESTRICT snew,
+                                        T* ISEN_RESTRICT qold,
+                                        const T* ISEN_RESTRICT qnow,
+                                        T* ISEN_RESTRICT qnew,
+                                        const T* ISEN_RESTRICT mtg,
+                                        const T* ISEN_RESTRICT tau,
+                                        const T* ISEN_RESTRICT sel,
+                                        const T* ISEN_RESTRICT ubnd1,
+                                        const T* ISEN_RESTRICT ubnd2,
+                                        const T* ISEN_RESTRICT sbnd1,
+                                        const T* ISEN_RESTRICT sbnd2,
+                                        const T* ISEN_RESTRICT qbnd1,
+                                        const T* ISEN_RESTRICT qbnd2,
+                                        const bool diffuseTracers,
+                                        const T dtdx)
+{
+    const int nxb = nx + 2 * nb;
+    const int nxnb = nx + nb;
+    const int nxnb1 = nx + nb + 1;
+
+    const T dtdx05 = T(0.5) * dtdx;
+    const T dtdx2 = 2 * dtdx;
+
+#pragma omp for nowait
+    for(int k = 0; k < nz; ++k)
+    {
+        const int o = k * ld;
+        const T* ISEN_RESTRICT tauk = tau + k * M;
+        const T* ISEN_RESTRICT selk = sel + k * M;
+
+        // Advection, the members of all interior points of a level are contiguous
+        for(int j = o + nb * M; j < o + nxnb * M; ++j)
+            snew[j] = sold[j] - dtdx05 * (snow[j + M] * (unow[j + 2 * M] + unow[j + M])
+                                          - snow[j - M] * (unow[j] + unow[j - M]));
+
+        for(int t = 0; t < ntr; ++t)
+            for(int j = o + nb * M; j < o + nxnb * M; ++j)
+            {
+                const int c = t * stride + j;
+                qnew[c] = qold[c] - dtdx05 * (unow[j] + unow[j + M]) * (qnow[c + M] - qnow[c - M]);
+            }
+
+        for(int j = o + nb * M; j < o + nxnb1 * M; ++j)
+            unew[j] = uold[j] - dtdx * unow[j] * (unow[j + M] - unow[j - M]) - dtdx2 * (mtg[j] - mtg[j - M]);
+
+        // Boundaries, diffusion and clipping while the level is in the cache (see kernel_progTracers)
+        if(sbnd1)
+        {
+            relaxLevelEnsemble(unew + o, nx + 1, nb, M, ubnd1 + k * M, ubnd2 + k * M);
+            relaxLevelEnsemble(snew + o, nx, nb, M, sbnd1 + k * M, sbnd2 + k * M);
+        }
+        else
+        {
+            Boundary::periodicLevel(unew + o, (nx + 1) * M, nb * M);
+            Boundary::periodicLevel(snew + o, nx * M, nb * M);
+        }
+
+        diffuseLevelEnsemble(nb, nxnb1, M, uold + o, unew + o, tauk, selk);
+        diffuseLevelEnsemble(nb, nxnb, M, sold + o, snew + o, tauk, selk);
+
+        if(!sbnd1)
+        {
+            Boundary::periodicLevel(uold + o, (nx + 1) * M, nb * M);
+            Boundary::periodicLevel(sold + o, nx * M, nb * M);
+        }
+
+        for(int t = 0; t < ntr; ++t)
+        {
+            T* ISEN_RESTRICT qnewk = qnew + t * stride + o;
+            T* ISEN_RESTRICT qoldk = qold + t * stride + o;
+
+            if(sbnd1)
+                relaxLevelEnsemble(qnewk, nx, nb, M, qbnd1 + (t * nz + k) * M, qbnd2 + (t * nz + k) * M);
+            else
+                Boundary::periodicLevel(qnewk, nx * M, nb * M);
+
+            if(diffuseTracers)
+                diffuseLevelEnsemble(nb, nxnb, M, qoldk, qnewk, tauk, selk);
+            else
+                for(int j = nb * M; j < nxnb * M; ++j)
+                    qoldk[j] = qnewk[j];
+
+            if(!sbnd1)
+                Boundary::periodicLevel(qoldk, nx * M, nb * M);
+
+            for(int j = 0; j < nxb * M; ++j)
+                qoldk[j] = qoldk[j] < T(0) ? T(0) : qoldk[j];
+        }
+    }
+}
+
+// -------------------------------------------------- diagEnsemble -----------------------------------------------------
+template <class T>
+ISEN_NO_INLINE void kernel_diagPressureEnsemble(const int begin,
+                                                const int end,
+                                                const int nz,
+                                                const int M,
+                                                const int ld,
+                                                T* ISEN_RESTRICT prs,
+                                                const T* ISEN_RESTRICT snow,
+                                                const T* ISEN_RESTRICT prs0,
+                                                const T gdth)
+{
+    for(int i = begin; i < end; ++i)
+        for(int m = 0; m < M; ++m)
+            prs[nz * ld + i * M + m] = prs0[nz * M + m];
+
+    for(int k = nz - 1; k >= 0; --k)
+        for(int j = k * ld + begin * M; j < k * ld + end * M; ++j)
+            prs[j] = prs[j + ld] + gdth * snow[j];
+}
+
+template <class T>
+ISEN_NO_INLINE void kernel_geometricHeightEnsemble(const int begin,
+                                                   const int end,
+                                                   const int nx,
+                                                   const int nz,
+                                                   const int nb,
+                                                   const int M,
+                                                   const int ld,
+                                                   T* ISEN_RESTRICT mtg,
+                                                   T* ISEN_RESTRICT zhtnow,
+                                                   const T* ISEN_RESTRICT exn,
+                                                   const T* ISEN_RESTRICT prs,
+                                                   const T* ISEN_RESTRICT unow,
+                                                   const T* ISEN_RESTRICT snow,
+                                                   const T* ISEN_RESTRICT topo,
+                                                   const T* ISEN_RESTRICT th0,
+                                                   const T* ISEN_RESTRICT topofact,
+                                                   const T g,
+                                                   const T dth,
+                                                   const T rcpg05,
+                                                   T* ISEN_RESTRICT umax,
+                                                   T* ISEN_RESTRICT smass,
+                                                   T* ISEN_RESTRICT check)
+{
+    const T dth05 = dth * T(0.5);
+
+    for(int i = begin; i < end; ++i)
+    {
+        const int c0 = i * M;
+
+        // Montgomery potential and geometric height (upward integration)
+        for(int m = 0; m < M; ++m)
+        {
+            const T gtopofact = g * topofact[m];
+            mtg[c0 + m] = gtopofact * topo[c0 + m] + th0[m] * exn[c0 + m] + dth05 * exn[c0 + m];
+            zhtnow[c0 + m] = topo[c0 + m] * topofact[m];
+        }
+
+        for(int k = 1; k < nz + 1; ++k)
+        {
+            if(k < nz)
+                for(int m = 0; m < M; ++m)
+                    mtg[k * ld + c0 + m] = mtg[(k - 1) * ld + c0 + m] + dth * exn[k * ld + c0 + m];
+
+            for(int m = 0; m < M; ++m)
+            {
+                const int c = k * ld + c0 + m;
+                T th0exn = th0[(k - 1) * M + m] * exn[c - ld] + th0[k * M + m] * exn[c];
+                T prs_delta = (prs[c] - prs[c - ld]) / (T(0.5) * (prs[c] + prs[c - ld]));
+                zhtnow[c] = zhtnow[c - ld] - rcpg05 * th0exn * prs_delta;
+            }
+        }
+
+        // Health metrics (only the interior points contribute to the mass)
+        const bool interior = i >= nb && i < nx + nb;
+        for(int k = 0; k < nz; ++k)
+            for(int m = 0; m < M; ++m)
+            {
+                const T u = unow[k * ld + c0 + m];
+                const T s = snow[k * ld + c0 + m];
+                umax[m] = std::max(umax[m], std::fabs(u));
+                smass[m] += interior ? s : T(0);
+                check[m] += (u - u) + (s - s);
+            }
+    }
+}
+
+// -------------------------------------------------- microphysics -----------------------------------------------------
+void SolverCpu::microphysics() noexcept
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    if(imicrophys == 1) // Kessler scheme
+    {
+        kesslerColumn_->apply(
+            // Output
+            temp_, qnew_[Tracer::QV], qnew_[Tracer::QC], qnew_[Tracer::QR], tot_prec_, prec_,
+
+            // Input
+            th0_, prs_, snow_, qnow_[Tracer::QV], qnow_[Tracer::QC], qnow_[Tracer::QR], exn_, zhtnow_);
+    }
+    else
+        Base::microphysics();
+}
+
+// -------------------------------------------------- time step --------------------------------------------------------
+template <class T>
+void SolverCpu::rescaleOldTimeLevelTeam(SolverFields<T>& fields, double ratio) noexcept
+{
+    SOLVER_DECLARE_ALL_ALIASES
+    const int ntr = imoist ? fields.qnow_.size() : 0;
+    const T factor = static_cast<T>(ratio);
+
+    auto& uold = fields.uold_;
+    auto& unow = fields.unow_;
+    auto& sold = fields.sold_;
+    auto& snow = fields.snow_;
+    auto& qold = fields.qold_;
+    auto& qnow = fields.qnow_;
+
+    // Same as Solver::rescaleOldTimeLevel, one level per iteration
+    #pragma omp for schedule(static)
+    for(int k = 0; k < nz; ++k)
+    {
+        uold.col(k) = unow.col(k) - factor * (unow.col(k) - uold.col(k));
+        sold.col(k) = snow.col(k) - factor * (snow.col(k) - sold.col(k));
+
+        for(int t = 0; t < ntr; ++t)
+            qold[t].col(k) = qnow[t].col(k) - factor * (qnow[t].col(k) - qold[t].col(k));
+    }
+}
+
+void SolverCpu::rescaleOldTimeLevel(double ratio) noexcept
+{
+#pragma omp parallel
+    rescaleOldTimeLevelTeam<double>(*this, ratio);
+}
+
+void SolverCpu::setTimeStep(double dt) noexcept
+{
+    Base::setTimeStep(dt);
+    if(kesslerColumn_)
+        kesslerColumn_->setTimeStep(dt);
+}
+
+// -------------------------------------------------- run --------------------------------------------------------------
+template <class T>
+void SolverCpu::reduceVelocityBoundary(FieldReduction<T>& reduction, const Field<T>& u, int nx, int nb) noexcept
+{
+    // Solver::computeCFL considers all but the last staggered point
+    const int nxb = nx + 2 * nb;
+
+    auto reducePoint = [&](int i, int k) {
+        reduction.umax = std::max(reduction.umax, std::fabs(u(i, k)));
+        reduction.check += u(i, k) - u(i, k);
+    };
+
+    for(int k = 0; k < u.cols(); ++k)
+    {
+        for(int i = 0; i < nb; ++i)
+            reducePoint(i, k);
+        for(int i = nx + nb + 1; i < nxb; ++i)
+            reducePoint(i, k);
+    }
+}
+
+template <class T>
+StepHealth SolverCpu::toStepHealth(const FieldReduction<T>& reduction, double dxdth) noexcept
+{
+    StepHealth health;
+    health.umax = reduction.umax;
+    health.mass = dxdth * reduction.smass;
+    health.finite = reduction.check == T(0);
+    return health;
+}
+
+void SolverCpu::run()
+{
+    runTimeLoop<double>(*this, kesslerColumn_.get());
+}
+
+template <class T>
+void SolverCpu::runTimeLoop(SolverFields<T>& fields, KesslerColumnT<T>* kessler)
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    const auto& kernels = solverCpuKernels<T>();
+    const int ntr = imoist ? fields.qnow_.size() : 0;
+    const int ld = fields.ld_;
+
+    auto& zhtold = fields.zhtold_;
+    auto& zhtnow = fields.zhtnow_;
+    auto& uold = fields.uold_;
+    auto& unow = fields.unow_;
+    auto& unew = fields.unew_;
+    auto& sold = fields.sold_;
+    auto& snow = fields.snow_;
+    auto& snew = fields.snew_;
+    auto& qold = fields.qold_;
+    auto& qnow = fields.qnow_;
+    auto& qnew = fields.qnew_;
+
+    Timer t;
+
+    Progressbar pbar(nts);
+    const bool logIsDisabled = LOG().isDisabled();
+    Progressbar::disableProgressbar = logIsDisabled;
+
+    TimeControl timeControl = startTimeControl();
+    FieldReduction<T> reduction;
+
+    // Exceptions must not leave the parallel region, they are rethrown once the team has been joined
+    std::exception_ptr exception;
+    bool abort = false;
+
+    // The loop condition is only updated by the master thread at the end of a time step (see below), as the time
+    // control is advanced while the other threads may still be testing the loop condition
+    bool running = timeControl.running();
+
+    // Loop over all time steps
+    //
+    // The team of threads is created once for the whole time loop. The kernels are orphaned worksharing loops (see
+    // SolverCpuKernel.h) and the steps are separated by barriers only where the data dependencies require them.
+    //------------------------------------------------------------
+#pragma omp parallel
+    while(running)
+    {
+        #pragma omp single
+        {
+            timeControl.advance();
+
+            if(!iprtcfl)
+                pbar.advanceTo(timeControl.progress());
+
+            topofact_ = std::min(1., timeControl.time() / topotim);
+
+            // Special treatment of first time step and of changes of the (adaptive) time step
+            dtdx_ = timeControl.dtdx();
+            if(timeControl.oldLevelRatio() != 1.0)
+                setTimeStep(timeControl.dt());
+
+            reduction.reset();
+        }
+
+        if(timeControl.oldLevelRatio() != 1.0)
+            rescaleOldTimeLevelTeam(fields, timeControl.oldLevelRatio());
+
+        // Prognostic step (the prognostic kernels are independent of each other)
+        //--------------------------------------------------------
+        kernels.progIsendens(nx, nz, nb, ld, snew.data(), snow.data(), sold.data(), unow.data(), 0.5 * dtdx_);
+
+        // The tracers are advanced completely (including boundaries, diffusion and clipping), the diffused tracers
+        // reside in the 'old' time level afterwards
+        if(imoist)
+            kernels.progTracers(nx, nz, nb, ld, ntr, qnow.stride(), qold.data(), qnow.data(), qnew.data(),
+                                unow.data(), fields.tau_.data(), irelax ? fields.qbnd1_.data() : nullptr,
+                                fields.qbnd2_.data(), 0.5 * dtdx_);
+
+        kernels.progVelocity(nx, nz, nb, ld, unew.data(), unow.data(), uold.data(), fields.mtg_.data(), dtdx_);
+
+        #pragma omp barrier
+
+        // Exchange boundaries if periodic or relax the dynamic fields
+        //--------------------------------------------------------
+        #pragma omp single
+        {
+            if(!irelax)
+                applyPeriodicBoundaryDynamics(fields);
+            else
+                applyRelaxationBoundaryDynamics(fields);
+
+            uold.swap(unow);
+            sold.swap(snow);
+            qold.swap(qnow);
+
+            unow.swap(unew);
+            snow.swap(snew);
+        }
+
+        // Diffusion and gravity wave absorber, the health metrics of the step are reduced on the fly
+        //--------------------------------------------------------
+        FieldReduction<T> reductionThread;
+        reductionThread.reset();
+
+        kernels.horizontalDiffusion(nx, nz, nb, ld, 0, 0, unew.data(), snew.data(), nullptr, unow.data(),
+                                    snow.data(), nullptr, fields.tau_.data(), &reductionThread);
+
+        #pragma omp critical(SolverCpuReduction)
+        {
+            reduction.umax = std::max(reduction.umax, reductionThread.umax);
+            reduction.smass += reductionThread.smass;
+            reduction.check += reductionThread.check;
+        }
+
+        #pragma omp barrier
+
+        #pragma omp single
+        {
+            if(!irelax)
+                applyPeriodicBoundaryDynamics(fields);
+
+            unow.swap(unew);
+            snow.swap(snew);
+
+            zhtnow.swap(zhtold);
+
+            reduceVelocityBoundary(reduction, unow, nx, nb);
+        }
+
+        // Diagnostic step
+        //--------------------------------------------------------
+
+        // Pressure, Exner function, Montgomery potential and geometric height (staggered) in a single sweep per
+        // column
+        kernel_diagColumn<T>(nx, nz, nb, ld, fields.prs_.data(), fields.exn_.data(), fields.mtg_.data(),
+                             zhtnow.data(), snow.data(), fields.topo_.data(), fields.th0_.data(), g * dth, prs0_(nz),
+                             cp, pref, rdcp, dth, g * topofact_, topofact_, 0.5 * r / cp / g, mathTier_);
+
+        #pragma omp barrier
+
+        // Microphysics
+        //---------------------------------------------------------
+        if(kessler)
+            kessler->applyTeam(
+                // Output
+                fields.temp_, qnew[Tracer::QV], qnew[Tracer::QC], qnew[Tracer::QR], fields.tot_prec_, fields.prec_,
+
+                // Input
+                fields.th0_, fields.prs_, snow, qnow[Tracer::QV], qnow[Tracer::QC], qnow[Tracer::QR], fields.exn_,
+                zhtnow);
+
+        #pragma omp barrier
+
+        // CFL condition, output and signals are handled by the master thread (which holds the Python GIL)
+        //--------------------------------------------------------
+        #pragma omp master
+        {
+            try
+            {
+                qnow.swap(qnew);
+
+                checkHealth(toStepHealth(reduction, dx * dth));
+                if(timeControl.isAdaptive())
+                    timeControl.adapt(reduction.umax, TimeControl::waveSpeed(zhtnow, nz1, g));
+
+                if(timeControl.isOutputStep())
+                    output_->makeOutput(this);
+
+                if(isCheckpointStep(timeControl))
+                    makeCheckpoint(timeControl);
+
+                running = timeControl.running();
+
+#ifdef ISEN_PYTHON
+                if(PyErr_CheckSignals() == -1)
+                    throw IsenException("PySolver::run : signal caught");
+#endif
+            }
+            catch(...)
+            {
+                exception = std::current_exception();
+                abort = true;
+            }
+        }
+
+        #pragma omp barrier
+
+        if(abort)
+            break;
+    }
+
+    if(exception)
+        std::rethrow_exception(exception);
+
+    finishCheckpoint();
+
+    pbar.pause();
+    if(!logIsDisabled)
+        Progressbar::printBar('=');
+
+    if(logIsDisabled && itime)
+        std::printf("Elapsed time: %s\n", timeString(t.stop()).c_str());
+
+    LOG() << "Finished time loop ...";
+    LOG_SUCCESS(t);
+}
+
+// -------------------------------------------------- instantiation ----------------------------------------------------
+template void SolverCpu::reduceVelocityBoundary<double>(FieldReduction<double>&, const Field<double>&, int,
+                                                       int) noexcept;
+template void SolverCpu::reduceVelocityBoundary<float>(FieldReduction<float>&, const Field<float>&, int, int) noexcept;
+template StepHealth SolverCpu::toStepHealth<double>(const FieldReduction<double>&, double) noexcept;
+template StepHealth SolverCpu::toStepHealth<float>(const FieldReduction<float>&, double) noexcept;
+template void SolverCpu::rescaleOldTimeLevelTeam<double>(SolverFields<double>&, double) noexcept;
+template void SolverCpu::rescaleOldTimeLevelTeam<float>(SolverFields<float>&, double) noexcept;
+template void SolverCpu::runTimeLoop<double>(SolverFields<double>&, KesslerColumnT<double>*);
+template void SolverCpu::runTimeLoop<float>(SolverFields<float>&, KesslerColumnT<float>*);
+
+#define ISEN_SOLVER_CPU_INSTANTIATE_KERNELS(T)                                                                         \
+    template void kernel_horizontalDiffusion<T>(const int, const int, const int, const int, const int, const int, T*, \
+                                                T*, T*, const T*, const T*, const T*, const T*, FieldReduction<T>*);   \
+    template void kernel_clipMoisture<T>(const int, const int, const int, const int, const int, const int, T*);        \
+    template void kernel_geometricHeight<T>(const int, const int, const int, const int, T*, const T*, const T*,        \
+                                            const T*, const T*, const T, const T);                                     \
+    template void kernel_diagMontgomery_Exner<T>(const int, const int, const int, const int, T*, const T*,             \
+                                                 const double, const double, const double, const MathTier);            \
+    template void kernel_diagMontgomery_Montgomery<T>(const int, const int, const int, const int, T*, const T*,        \
+                                                      const T*, const T, const T, const T, const T);                   \
+    template void kernel_diagPressure<T>(const int, const int, const int, T*, const T*, const T, const T);             \
+    template void kernel_diagColumn<T>(const int, const int, const int, const int, T*, T*, T*, T*, const T*, const T*, \
+                                       const T*, const T, const T, const double, const double, const double, const T,  \
+                                       const T, const T, const T, const MathTier);                                     \
+    template void exnerRange<T>(const MathTier, const int, const int, T*, const T*, const T, const T);                 \
+    template void kernel_progIsendens<T>(const int, const int, const int, const int, T*, const T*, const T*,          \
+                                         const T*, const T);                                                           \
+    template void kernel_progMoisture<T>(const int, const int, const int, const int, const int, const int, T*,        \
+                                         const T*, const T*, const T*, const T);                                       \
+    template void kernel_progTracers<T>(const int, const int, const int, const int, const int, const int, T*,         \
+                                        const T*, T*, const T*, const T*, const T*, const T*, const T);                \
+    template void kernel_progVelocity<T>(const int, const int, const int, const int, T*, const T*, const T*,          \
+                                         const T*, const T);                                                           \
+    template void kernel_progEnsemble<T>(const int, const int, const int, const int, const int, const int, const int, \
+                                         T*, const T*, T*, T*, const T*, T*, T*, const T*, T*, const T*, const T*,     \
+                                         const T*, const T*, const T*, const T*, const T*, const T*, const T*,         \
+                                         const bool, const T);                                                         \
+    template void kernel_diagPressureEnsemble<T>(const int, const int, const int, const int, const int, T*,           \
+                                                 const T*, const T*, const T);                                         \
+    template void kernel_geometricHeightEnsemble<T>(const int, const int, const int, const int, const int, const int, \
+                                                    const int, T*, T*, const T*, const T*, const T*, const T*,         \
+                                                    const T*, const T*, const T*, const T, const T, const T, T*,       \
+                                                    T*, T*);
+
+ISEN_SOLVER_CPU_INSTANTIATE_KERNELS(double)
+ISEN_SOLVER_CPU_INSTANTIATE_KERNELS(float)
+
+#undef ISEN_SOLVER_CPU_INSTANTIATE_KERNELS
+
 ISEN_NAMESPACE_END
@@ -0,0 +1,150 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#include <Isen/Checkpoint.h>
+#include <Isen/Logger.h>
+#include <Isen/SolverCpuF32.h>
+
+ISEN_NAMESPACE_BEGIN
+
+SolverCpuF32::SolverCpuF32(std::shared_ptr<NameList> namelist, Output::ArchiveType archiveType)
+    : Base(namelist, archiveType), singlePrecision_(false)
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    fieldsF32_.ld_ = Field<float>::leadingDimension(nxb1);
+
+    if(imoist && imicrophys == 1)
+        kesslerF32_ = std::make_shared<KesslerColumnT<float>>(namelist_);
+}
+
+void SolverCpuF32::toSinglePrecision()
+{
+    if(singlePrecision_)
+        return;
+
+    try
+    {
+        fieldsF32_.convertFrom(*this);
+    }
+    catch(std::bad_alloc&)
+    {
+        throw IsenException("out of memory");
+    }
+
+    // The tracers exist only now, the pointers remain valid until the fields are converted back
+    matMapF32_.clear();
+    vecMapF32_.clear();
+    fieldsF32_.registerFields(matMapF32_, vecMapF32_);
+
+    singlePrecision_ = true;
+    output_->resetCopies();
+}
+
+void SolverCpuF32::toDoublePrecision()
+{
+    if(!singlePrecision_)
+        return;
+
+    try
+    {
+        convertFrom(fieldsF32_);
+    }
+    catch(std::bad_alloc&)
+    {
+        throw IsenException("out of memory");
+    }
+
+    matMapF32_.clear();
+    vecMapF32_.clear();
+
+    singlePrecision_ = false;
+    output_->resetCopies();
+}
+
+const Field<float>* SolverCpuF32::getMatF32(const std::string& name) const
+{
+    auto it = matMapF32_.find(name);
+    return it != matMapF32_.end() ? it->second : nullptr;
+}
+
+const VectorX<float>* SolverCpuF32::getVecF32(const std::string& name) const
+{
+    auto it = vecMapF32_.find(name);
+    return it != vecMapF32_.end() ? it->second : nullptr;
+}
+
+void SolverCpuF32::setTimeStep(double dt) noexcept
+{
+    Base::setTimeStep(dt);
+    if(kesslerF32_)
+        kesslerF32_->setTimeStep(dt);
+}
+
+void SolverCpuF32::saveState(Checkpoint& checkpoint) const
+{
+    // The released double precision fields are stored as empty records
+    Base::saveState(checkpoint);
+
+    if(singlePrecision_)
+    {
+        for(const auto& mat : matMapF32_)
+            checkpoint.add(mat.first + "F32", *mat.second);
+
+        for(const auto& vec : vecMapF32_)
+            checkpoint.add(vec.first + "F32", *vec.second);
+
+        checkpoint.add("qbnd1F32", fieldsF32_.qbnd1_);
+        checkpoint.add("qbnd2F32", fieldsF32_.qbnd2_);
+    }
+}
+
+void SolverCpuF32::loadState(const Checkpoint& checkpoint)
+{
+    // The checkpoints are written by the time loop, i.e in single precision. The fields are converted back to double
+    // precision afterwards, which is lossless.
+    toSinglePrecision();
+    Base::loadState(checkpoint);
+
+    for(auto& mat : matMapF32_)
+        checkpoint.get(mat.first + "F32", *mat.second);
+
+    for(auto& vec : vecMapF32_)
+        checkpoint.get(vec.first + "F32", vec.second->data(), vec.second->rows(), 1, vec.second->rows());
+
+    checkpoint.get("qbnd1F32", fieldsF32_.qbnd1_.data(), fieldsF32_.qbnd1_.rows(), fieldsF32_.qbnd1_.cols(),
+                   fieldsF32_.qbnd1_.rows());
+    checkpoint.get("qbnd2F32", fieldsF32_.qbnd2_.data(), fieldsF32_.qbnd2_.rows(), fieldsF32_.qbnd2_.cols(),
+                   fieldsF32_.qbnd2_.rows());
+
+    toDoublePrecision();
+}
+
+void SolverCpuF32::run()
+{
+    toSinglePrecision();
+
+    try
+    {
+        runTimeLoop<float>(fieldsF32_, kesslerF32_.get());
+    }
+    catch(...)
+    {
+        toDoublePrecision();
+        throw;
+    }
+
+    toDoublePrecision();
+}
+
+ISEN_NAMESPACE_END
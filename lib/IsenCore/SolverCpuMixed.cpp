@@ -0,0 +1,308 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#include <Isen/Boundary.h>
+#include <Isen/Logger.h>
+#include <Isen/Numa.h>
+#include <Isen/SolverCpuMixed.h>
+
+ISEN_NAMESPACE_BEGIN
+
+SolverCpuMixed::SolverCpuMixed(std::shared_ptr<NameList> namelist, Output::ArchiveType archiveType)
+    : Base(namelist, archiveType)
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    try
+    {
+        Numa::allocate(uoldF32_, nxb1, nz, ld_);
+        Numa::allocate(soldF32_, nxb, nz, ld_);
+
+        if(imoist)
+        {
+            Numa::allocate(qoldF32_, Tracer::count(imicrophys), nxb, nz, ld_);
+
+            // Replace the Kessler scheme of the SolverCpu
+            if(imicrophys == 1)
+            {
+                kesslerColumn_.reset();
+                kesslerMixed_ = std::make_shared<KesslerColumnT<double, float>>(namelist_);
+            }
+        }
+    }
+    catch(std::bad_alloc&)
+    {
+        throw IsenException("out of memory");
+    }
+}
+
+void SolverCpuMixed::init() noexcept
+{
+    Base::init();
+
+    // Convert the old time levels (the fields are already allocated, hence this does not allocate memory)
+    uoldF32_ = uold_.cast<float>();
+    soldF32_ = sold_.cast<float>();
+    uold_.resize(0, 0);
+    sold_.resize(0, 0);
+
+    if(namelist_->imoist)
+    {
+        for(int t = 0; t < qold_.size(); ++t)
+            qoldF32_[t] = qold_[t].cast<float>();
+        qold_.resize(qold_.size(), 0, 0);
+    }
+}
+
+// -------------------------------------------------- diffusion (single level) -----------------------------------------
+static ISEN_INLINE void level_horizontalDiffusion(const int begin,
+                                                  const int end,
+                                                  double* ISEN_RESTRICT phinew,
+                                                  const double* ISEN_RESTRICT phinow,
+                                                  const double tau,
+                                                  const double tau025)
+{
+    if(tau > 0.0)
+        for(int i = begin; i < end; ++i)
+            phinew[i] = phinow[i] + tau025 * (phinow[i - 1] - 2 * phinow[i] + phinow[i + 1]);
+    else
+        for(int i = begin; i < end; ++i)
+            phinew[i] = phinow[i];
+}
+
+// -------------------------------------------------- rotate time levels (single level) -------------------------------
+//
+// The current time level is rounded to single precision and becomes the old time level, the diffused 'new' time level
+// becomes the current time level. As in Solver::prognosticStep the diffusion only writes the inner points into the
+// buffer of the old time level, the halo of the current time level is thus the former halo of the old time level.
+//
+static ISEN_INLINE void level_rotate(const int nx,
+                                     const int nb,
+                                     float* ISEN_RESTRICT phiold,
+                                     double* ISEN_RESTRICT phinow,
+                                     const double* ISEN_RESTRICT phinew,
+                                     const double tau,
+                                     const double tau025)
+{
+    const int nxnb = nx + nb;
+
+    for(int i = 0; i < nb; ++i)
+    {
+        const float left = phiold[i];
+        phiold[i] = static_cast<float>(phinow[i]);
+        phinow[i] = left;
+
+        const float right = phiold[nxnb + i];
+        phiold[nxnb + i] = static_cast<float>(phinow[nxnb + i]);
+        phinow[nxnb + i] = right;
+    }
+
+    for(int i = nb; i < nxnb; ++i)
+        phiold[i] = static_cast<float>(phinow[i]);
+
+    level_horizontalDiffusion(nb, nxnb, phinow, phinew, tau, tau025);
+}
+
+// -------------------------------------------------- prognosticStep ---------------------------------------------------
+//
+// For every level k:
+//
+//  1. The prognostic step reads the (single precision) old and the current time level and writes the new time level
+//     into the 'new' fields, followed by the exchange (periodic) or relaxation of the boundaries.
+//  2. The time levels are rotated (see level_rotate), followed by the periodic exchange and the clipping of the
+//     moisture variables.
+//
+// This yields the same rotation of the time levels as Solver::prognosticStep without any swapping of the fields, the
+// 'new' fields keep the undiffused new time level.
+//
+ISEN_NO_INLINE void kernel_mixedStep(const int nx,
+                                     const int nz,
+                                     const int nb,
+                                     const int ld,
+                                     double* ISEN_RESTRICT unew,
+                                     float* ISEN_RESTRICT uold,
+                                     double* ISEN_RESTRICT unow,
+                                     double* ISEN_RESTRICT snew,
+                                     float* ISEN_RESTRICT sold,
+                                     double* ISEN_RESTRICT snow,
+                                     double* ISEN_RESTRICT qnew,
+                                     float* ISEN_RESTRICT qold,
+                                     double* ISEN_RESTRICT qnow,
+                                     const int ntr,
+                                     const int stride,
+                                     const double* ISEN_RESTRICT mtg,
+                                     const double* ISEN_RESTRICT tau,
+                                     const double* ISEN_RESTRICT ubnd1,
+                                     const double* ISEN_RESTRICT ubnd2,
+                                     const double* ISEN_RESTRICT sbnd1,
+                                     const double* ISEN_RESTRICT sbnd2,
+                                     const double* ISEN_RESTRICT qbnd1,
+                                     const double* ISEN_RESTRICT qbnd2,
+                                     const double dtdx,
+                                     const bool irelax)
+{
+    const int nxb = nx + 2 * nb;
+    const int nxnb = nx + nb;
+    const int nx1nb = nx + nb + 1;
+
+    const double dtdx05 = 0.5 * dtdx;
+    const double dtdx2 = 2 * dtdx;
+
+#pragma omp parallel for
+    for(int k = 0; k < nz; ++k)
+    {
+        const double tau025 = 0.25 * tau[k];
+
+        double* ISEN_RESTRICT unowk = unow + k * ld;
+        double* ISEN_RESTRICT unewk = unew + k * ld;
+        float* ISEN_RESTRICT uoldk = uold + k * ld;
+
+        double* ISEN_RESTRICT snowk = snow + k * ld;
+        double* ISEN_RESTRICT snewk = snew + k * ld;
+        float* ISEN_RESTRICT soldk = sold + k * ld;
+
+        const double* ISEN_RESTRICT mtgk = mtg + k * ld;
+
+        // Isentropic density
+        for(int i = nb; i < nxnb; ++i)
+        {
+            double snow_iplus1 = snowk[i + 1] * (unowk[i + 2] + unowk[i + 1]);
+            double snow_iminus1 = snowk[i - 1] * (unowk[i] + unowk[i - 1]);
+            snewk[i] = soldk[i] - dtdx05 * (snow_iplus1 - snow_iminus1);
+        }
+
+        // Velocity
+        for(int i = nb; i < nx1nb; ++i)
+        {
+            double unow_delta = unowk[i] * (unowk[i + 1] - unowk[i - 1]);
+            double mtg_dtdx2 = dtdx2 * (mtgk[i] - mtgk[i - 1]);
+            unewk[i] = uoldk[i] - dtdx * unow_delta - mtg_dtdx2;
+        }
+
+        // Moisture scalars (the current velocity is overwritten below)
+        for(int t = 0; t < ntr; ++t)
+        {
+            double* ISEN_RESTRICT qnowk = qnow + t * stride + k * ld;
+            double* ISEN_RESTRICT qnewk = qnew + t * stride + k * ld;
+            float* ISEN_RESTRICT qoldk = qold + t * stride + k * ld;
+
+            for(int i = nb; i < nxnb; ++i)
+                qnewk[i] = qoldk[i] - dtdx05 * (unowk[i] + unowk[i + 1]) * (qnowk[i + 1] - qnowk[i - 1]);
+
+            if(irelax)
+                Boundary::relaxLevel(qnewk, nx, nb, qbnd1[t * nz + k], qbnd2[t * nz + k]);
+            else
+                Boundary::periodicLevel(qnewk, nx, nb);
+
+            level_rotate(nx, nb, qoldk, qnowk, qnewk, tau[k], tau025);
+
+            if(!irelax)
+                Boundary::periodicLevel(qnowk, nx, nb);
+
+            for(int i = 0; i < nxb; ++i)
+                qnowk[i] = qnowk[i] < 0.0 ? 0.0 : qnowk[i];
+        }
+
+        if(irelax)
+        {
+            Boundary::relaxLevel(snewk, nx, nb, sbnd1[k], sbnd2[k]);
+            Boundary::relaxLevel(unewk, nx + 1, nb, ubnd1[k], ubnd2[k]);
+        }
+        else
+        {
+            Boundary::periodicLevel(snewk, nx, nb);
+            Boundary::periodicLevel(unewk, nx + 1, nb);
+        }
+
+        level_rotate(nx, nb, soldk, snowk, snewk, tau[k], tau025);
+        level_rotate(nx + 1, nb, uoldk, unowk, unewk, tau[k], tau025);
+
+        if(!irelax)
+        {
+            Boundary::periodicLevel(snowk, nx, nb);
+            Boundary::periodicLevel(unowk, nx + 1, nb);
+        }
+    }
+}
+
+void SolverCpuMixed::prognosticStep() noexcept
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    // The single precision old time level has the same layout as the tracers in double precision
+    assert(!imoist || qoldF32_.stride() == qnow_.stride());
+
+    kernel_mixedStep(nx, nz, nb, ld_, unew_.data(), uoldF32_.data(), unow_.data(), snew_.data(), soldF32_.data(),
+                     snow_.data(), qnew_.data(), qoldF32_.data(), qnow_.data(), imoist ? qnow_.size() : 0,
+                     qnow_.stride(), mtg_.data(), tau_.data(), ubnd1_.data(), ubnd2_.data(), sbnd1_.data(),
+                     sbnd2_.data(), qbnd1_.data(), qbnd2_.data(), dtdx_, irelax);
+}
+
+void SolverCpuMixed::microphysics() noexcept
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    if(imicrophys == 1) // Kessler scheme
+    {
+        kesslerMixed_->apply(
+            // Output
+            temp_, qnew_[Tracer::QV], qnew_[Tracer::QC], qnew_[Tracer::QR], tot_prec_, prec_,
+
+            // Input
+            th0_, prs_, snow_, qnow_[Tracer::QV], qnow_[Tracer::QC], qnow_[Tracer::QR], exn_, zhtnow_);
+    }
+    else
+        Base::microphysics();
+}
+
+void SolverCpuMixed::rescaleOldTimeLevel(double ratio) noexcept
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    // The extrapolation is carried out in double precision
+    uoldF32_ = (unow_ - ratio * (unow_ - uoldF32_.cast<double>())).cast<float>();
+    soldF32_ = (snow_ - ratio * (snow_ - soldF32_.cast<double>())).cast<float>();
+
+    if(imoist)
+        for(int t = 0; t < qnow_.size(); ++t)
+            qoldF32_[t] = (qnow_[t] - ratio * (qnow_[t] - qoldF32_[t].cast<double>())).cast<float>();
+}
+
+void SolverCpuMixed::setTimeStep(double dt) noexcept
+{
+    Base::setTimeStep(dt);
+    if(kesslerMixed_)
+        kesslerMixed_->setTimeStep(dt);
+}
+
+void SolverCpuMixed::saveState(Checkpoint& checkpoint) const
+{
+    Base::saveState(checkpoint);
+
+    checkpoint.add("uoldF32", uoldF32_);
+    checkpoint.add("soldF32", soldF32_);
+    for(int t = 0; t < qoldF32_.size(); ++t)
+        checkpoint.add(std::string("qoldF32.") + std::to_string(t), qoldF32_[t]);
+}
+
+void SolverCpuMixed::loadState(const Checkpoint& checkpoint)
+{
+    Base::loadState(checkpoint);
+
+    checkpoint.get("uoldF32", uoldF32_);
+    checkpoint.get("soldF32", soldF32_);
+    for(int t = 0; t < qoldF32_.size(); ++t)
+        checkpoint.get(std::string("qoldF32.") + std::to_string(t), qoldF32_[t]);
+}
+
+ISEN_NAMESPACE_END
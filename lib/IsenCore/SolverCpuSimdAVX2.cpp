@@ -0,0 +1,111 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+// This translation unit is compiled with AVX2 enabled (see CMakeLists.txt) and must only include intrinsics and
+// SolverCpuSimdImpl.h (see SolverCpuSimd.h)
+#include <Isen/SolverCpuSimd.h>
+
+#ifdef ISEN_SIMD_AVX2
+
+#include <immintrin.h>
+
+#define ISEN_SIMD_NAMESPACE simd_avx2
+
+ISEN_NAMESPACE_BEGIN
+
+namespace simd_avx2
+{
+
+template <class T>
+struct Vec;
+
+/// 4 x double
+template <>
+struct Vec<double>
+{
+    static constexpr int Width = 4;
+
+    __m256d v;
+
+    ISEN_INLINE Vec(__m256d value) : v(value) {}
+    ISEN_INLINE Vec(double value) : v(_mm256_set1_pd(value)) {}
+
+    static ISEN_INLINE Vec load(const double* ptr) { return Vec(_mm256_loadu_pd(ptr)); }
+    ISEN_INLINE void store(double* ptr) const { _mm256_storeu_pd(ptr, v); }
+    static ISEN_INLINE Vec loadAligned(const double* ptr) { return Vec(_mm256_load_pd(ptr)); }
+    ISEN_INLINE void storeAligned(double* ptr) const { _mm256_store_pd(ptr, v); }
+
+    friend ISEN_INLINE Vec operator+(Vec a, Vec b) { return Vec(_mm256_add_pd(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator-(Vec a, Vec b) { return Vec(_mm256_sub_pd(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator*(Vec a, Vec b) { return Vec(_mm256_mul_pd(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator/(Vec a, Vec b) { return Vec(_mm256_div_pd(a.v, b.v)); }
+    friend ISEN_INLINE Vec clipNegative(Vec a)
+    {
+        return Vec(_mm256_andnot_pd(_mm256_cmp_pd(a.v, _mm256_setzero_pd(), _CMP_LT_OQ), a.v));
+    }
+    friend ISEN_INLINE Vec abs(Vec a) { return Vec(_mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v)); }
+    friend ISEN_INLINE Vec max(Vec a, Vec b) { return Vec(_mm256_max_pd(a.v, b.v)); }
+};
+
+/// 8 x float
+template <>
+struct Vec<float>
+{
+    static constexpr int Width = 8;
+
+    __m256 v;
+
+    ISEN_INLINE Vec(__m256 value) : v(value) {}
+    ISEN_INLINE Vec(float value) : v(_mm256_set1_ps(value)) {}
+
+    static ISEN_INLINE Vec load(const float* ptr) { return Vec(_mm256_loadu_ps(ptr)); }
+    ISEN_INLINE void store(float* ptr) const { _mm256_storeu_ps(ptr, v); }
+    static ISEN_INLINE Vec loadAligned(const float* ptr) { return Vec(_mm256_load_ps(ptr)); }
+    ISEN_INLINE void storeAligned(float* ptr) const { _mm256_store_ps(ptr, v); }
+
+    friend ISEN_INLINE Vec operator+(Vec a, Vec b) { return Vec(_mm256_add_ps(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator-(Vec a, Vec b) { return Vec(_mm256_sub_ps(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator*(Vec a, Vec b) { return Vec(_mm256_mul_ps(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator/(Vec a, Vec b) { return Vec(_mm256_div_ps(a.v, b.v)); }
+    friend ISEN_INLINE Vec clipNegative(Vec a)
+    {
+        return Vec(_mm256_andnot_ps(_mm256_cmp_ps(a.v, _mm256_setzero_ps(), _CMP_LT_OQ), a.v));
+    }
+    friend ISEN_INLINE Vec abs(Vec a) { return Vec(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)); }
+    friend ISEN_INLINE Vec max(Vec a, Vec b) { return Vec(_mm256_max_ps(a.v, b.v)); }
+};
+
+} // namespace simd_avx2
+
+ISEN_NAMESPACE_END
+
+#include <Isen/SolverCpuSimdImpl.h>
+
+#endif // ISEN_SIMD_AVX2
+
+ISEN_NAMESPACE_BEGIN
+
+template <class T>
+const SolverCpuKernels<T>* solverCpuKernelsAVX2() noexcept
+{
+#ifdef ISEN_SIMD_AVX2
+    return simd_avx2::kernelTable<T>();
+#else
+    return nullptr;
+#endif
+}
+
+template const SolverCpuKernels<double>* solverCpuKernelsAVX2<double>() noexcept;
+template const SolverCpuKernels<float>* solverCpuKernelsAVX2<float>() noexcept;
+
+ISEN_NAMESPACE_END
@@ -0,0 +1,119 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+// This translation unit is compiled with AVX-512F enabled (see CMakeLists.txt) and must only include intrinsics and
+// SolverCpuSimdImpl.h (see SolverCpuSimd.h)
+#include <Isen/SolverCpuSimd.h>
+
+#ifdef ISEN_SIMD_AVX512
+
+#include <immintrin.h>
+
+#define ISEN_SIMD_NAMESPACE simd_avx512
+
+ISEN_NAMESPACE_BEGIN
+
+namespace simd_avx512
+{
+
+template <class T>
+struct Vec;
+
+/// 8 x double
+template <>
+struct Vec<double>
+{
+    static constexpr int Width = 8;
+
+    __m512d v;
+
+    ISEN_INLINE Vec(__m512d value) : v(value) {}
+    ISEN_INLINE Vec(double value) : v(_mm512_set1_pd(value)) {}
+
+    static ISEN_INLINE Vec load(const double* ptr) { return Vec(_mm512_loadu_pd(ptr)); }
+    ISEN_INLINE void store(double* ptr) const { _mm512_storeu_pd(ptr, v); }
+    static ISEN_INLINE Vec loadAligned(const double* ptr) { return Vec(_mm512_load_pd(ptr)); }
+    ISEN_INLINE void storeAligned(double* ptr) const { _mm512_store_pd(ptr, v); }
+
+    friend ISEN_INLINE Vec operator+(Vec a, Vec b) { return Vec(_mm512_add_pd(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator-(Vec a, Vec b) { return Vec(_mm512_sub_pd(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator*(Vec a, Vec b) { return Vec(_mm512_mul_pd(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator/(Vec a, Vec b) { return Vec(_mm512_div_pd(a.v, b.v)); }
+    friend ISEN_INLINE Vec clipNegative(Vec a)
+    {
+        const __mmask8 negative = _mm512_cmp_pd_mask(a.v, _mm512_setzero_pd(), _CMP_LT_OQ);
+        return Vec(_mm512_mask_blend_pd(negative, a.v, _mm512_setzero_pd()));
+    }
+    friend ISEN_INLINE Vec abs(Vec a) { return Vec(_mm512_abs_pd(a.v)); }
+    friend ISEN_INLINE Vec max(Vec a, Vec b)
+    {
+        return Vec(_mm512_mask_blend_pd(_mm512_cmp_pd_mask(a.v, b.v, _CMP_GT_OQ), b.v, a.v));
+    }
+};
+
+/// 16 x float
+template <>
+struct Vec<float>
+{
+    static constexpr int Width = 16;
+
+    __m512 v;
+
+    ISEN_INLINE Vec(__m512 value) : v(value) {}
+    ISEN_INLINE Vec(float value) : v(_mm512_set1_ps(value)) {}
+
+    static ISEN_INLINE Vec load(const float* ptr) { return Vec(_mm512_loadu_ps(ptr)); }
+    ISEN_INLINE void store(float* ptr) const { _mm512_storeu_ps(ptr, v); }
+    static ISEN_INLINE Vec loadAligned(const float* ptr) { return Vec(_mm512_load_ps(ptr)); }
+    ISEN_INLINE void storeAligned(float* ptr) const { _mm512_store_ps(ptr, v); }
+
+    friend ISEN_INLINE Vec operator+(Vec a, Vec b) { return Vec(_mm512_add_ps(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator-(Vec a, Vec b) { return Vec(_mm512_sub_ps(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator*(Vec a, Vec b) { return Vec(_mm512_mul_ps(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator/(Vec a, Vec b) { return Vec(_mm512_div_ps(a.v, b.v)); }
+    friend ISEN_INLINE Vec clipNegative(Vec a)
+    {
+        const __mmask16 negative = _mm512_cmp_ps_mask(a.v, _mm512_setzero_ps(), _CMP_LT_OQ);
+        return Vec(_mm512_mask_blend_ps(negative, a.v, _mm512_setzero_ps()));
+    }
+    friend ISEN_INLINE Vec abs(Vec a) { return Vec(_mm512_abs_ps(a.v)); }
+    friend ISEN_INLINE Vec max(Vec a, Vec b)
+    {
+        return Vec(_mm512_mask_blend_ps(_mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ), b.v, a.v));
+    }
+};
+
+} // namespace simd_avx512
+
+ISEN_NAMESPACE_END
+
+#include <Isen/SolverCpuSimdImpl.h>
+
+#endif // ISEN_SIMD_AVX512
+
+ISEN_NAMESPACE_BEGIN
+
+template <class T>
+const SolverCpuKernels<T>* solverCpuKernelsAVX512() noexcept
+{
+#ifdef ISEN_SIMD_AVX512
+    return simd_avx512::kernelTable<T>();
+#else
+    return nullptr;
+#endif
+}
+
+template const SolverCpuKernels<double>* solverCpuKernelsAVX512<double>() noexcept;
+template const SolverCpuKernels<float>* solverCpuKernelsAVX512<float>() noexcept;
+
+ISEN_NAMESPACE_END
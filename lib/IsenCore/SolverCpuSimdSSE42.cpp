@@ -0,0 +1,111 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+// This translation unit is compiled with SSE4.2 enabled (see CMakeLists.txt) and must only include intrinsics and
+// SolverCpuSimdImpl.h (see SolverCpuSimd.h)
+#include <Isen/SolverCpuSimd.h>
+
+#ifdef ISEN_SIMD_SSE42
+
+#include <nmmintrin.h>
+
+#define ISEN_SIMD_NAMESPACE simd_sse42
+
+ISEN_NAMESPACE_BEGIN
+
+namespace simd_sse42
+{
+
+template <class T>
+struct Vec;
+
+/// 2 x double
+template <>
+struct Vec<double>
+{
+    static constexpr int Width = 2;
+
+    __m128d v;
+
+    ISEN_INLINE Vec(__m128d value) : v(value) {}
+    ISEN_INLINE Vec(double value) : v(_mm_set1_pd(value)) {}
+
+    static ISEN_INLINE Vec load(const double* ptr) { return Vec(_mm_loadu_pd(ptr)); }
+    ISEN_INLINE void store(double* ptr) const { _mm_storeu_pd(ptr, v); }
+    static ISEN_INLINE Vec loadAligned(const double* ptr) { return Vec(_mm_load_pd(ptr)); }
+    ISEN_INLINE void storeAligned(double* ptr) const { _mm_store_pd(ptr, v); }
+
+    friend ISEN_INLINE Vec operator+(Vec a, Vec b) { return Vec(_mm_add_pd(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator-(Vec a, Vec b) { return Vec(_mm_sub_pd(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator*(Vec a, Vec b) { return Vec(_mm_mul_pd(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator/(Vec a, Vec b) { return Vec(_mm_div_pd(a.v, b.v)); }
+    friend ISEN_INLINE Vec clipNegative(Vec a)
+    {
+        return Vec(_mm_andnot_pd(_mm_cmplt_pd(a.v, _mm_setzero_pd()), a.v));
+    }
+    friend ISEN_INLINE Vec abs(Vec a) { return Vec(_mm_andnot_pd(_mm_set1_pd(-0.0), a.v)); }
+    friend ISEN_INLINE Vec max(Vec a, Vec b) { return Vec(_mm_max_pd(a.v, b.v)); }
+};
+
+/// 4 x float
+template <>
+struct Vec<float>
+{
+    static constexpr int Width = 4;
+
+    __m128 v;
+
+    ISEN_INLINE Vec(__m128 value) : v(value) {}
+    ISEN_INLINE Vec(float value) : v(_mm_set1_ps(value)) {}
+
+    static ISEN_INLINE Vec load(const float* ptr) { return Vec(_mm_loadu_ps(ptr)); }
+    ISEN_INLINE void store(float* ptr) const { _mm_storeu_ps(ptr, v); }
+    static ISEN_INLINE Vec loadAligned(const float* ptr) { return Vec(_mm_load_ps(ptr)); }
+    ISEN_INLINE void storeAligned(float* ptr) const { _mm_store_ps(ptr, v); }
+
+    friend ISEN_INLINE Vec operator+(Vec a, Vec b) { return Vec(_mm_add_ps(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator-(Vec a, Vec b) { return Vec(_mm_sub_ps(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator*(Vec a, Vec b) { return Vec(_mm_mul_ps(a.v, b.v)); }
+    friend ISEN_INLINE Vec operator/(Vec a, Vec b) { return Vec(_mm_div_ps(a.v, b.v)); }
+    friend ISEN_INLINE Vec clipNegative(Vec a)
+    {
+        return Vec(_mm_andnot_ps(_mm_cmplt_ps(a.v, _mm_setzero_ps()), a.v));
+    }
+    friend ISEN_INLINE Vec abs(Vec a) { return Vec(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)); }
+    friend ISEN_INLINE Vec max(Vec a, Vec b) { return Vec(_mm_max_ps(a.v, b.v)); }
+};
+
+} // namespace simd_sse42
+
+ISEN_NAMESPACE_END
+
+#include <Isen/SolverCpuSimdImpl.h>
+
+#endif // ISEN_SIMD_SSE42
+
+ISEN_NAMESPACE_BEGIN
+
+template <class T>
+const SolverCpuKernels<T>* solverCpuKernelsSSE42() noexcept
+{
+#ifdef ISEN_SIMD_SSE42
+    return simd_sse42::kernelTable<T>();
+#else
+    return nullptr;
+#endif
+}
+
+template const SolverCpuKernels<double>* solverCpuKernelsSSE42<double>() noexcept;
+template const SolverCpuKernels<float>* solverCpuKernelsSSE42<float>() noexcept;
+
+ISEN_NAMESPACE_END
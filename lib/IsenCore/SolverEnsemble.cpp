@@ -0,0 +1,727 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#include <Isen/FastMath.h>
+#include <Isen/Logger.h>
+#include <Isen/Numa.h>
+#include <Isen/Progressbar.h>
+#include <Isen/SolverCpuKernel.h>
+#include <Isen/SolverCpuSimd.h>
+#include <Isen/SolverEnsemble.h>
+#include <Isen/TimeControl.h>
+#include <Isen/Timer.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <exception>
+
+#ifdef ISEN_PYTHON
+#include <boost/python.hpp>
+#endif
+
+ISEN_NAMESPACE_BEGIN
+
+/// @brief Member of an ensemble
+///
+/// A reference Solver which creates the initial conditions and the output of the member. The ensemble accesses its
+/// fields directly. The fields of the grid only exist while the member is initialized, written to the output or
+/// accessed through SolverEnsemble::getMember, the state of the member is kept in the interleaved fields of the
+/// ensemble otherwise.
+class SolverEnsemble::Member : public Solver
+{
+public:
+    friend class SolverEnsemble;
+
+    Member(const std::shared_ptr<NameList>& namelist, Output::ArchiveType archiveType) : Solver(namelist, archiveType)
+    {
+        // The microphysics of the members are computed by the ensemble
+        kessler_.reset();
+        releaseFields();
+    }
+
+    /// @brief Allocate the (zero initialized) fields of the grid if they have been released (see Solver::Solver)
+    ///
+    /// @throw IsenException if out of memory
+    void allocateFields()
+    {
+        SOLVER_DECLARE_ALL_ALIASES
+
+        if(hasFields())
+            return;
+
+        try
+        {
+            Numa::allocate(zhtold_, nxb, nz1, ld_);
+            Numa::allocate(zhtnow_, nxb, nz1, ld_);
+
+            Numa::allocate(uold_, nxb1, nz, ld_);
+            Numa::allocate(unow_, nxb1, nz, ld_);
+            Numa::allocate(unew_, nxb1, nz, ld_);
+
+            Numa::allocate(sold_, nxb, nz, ld_);
+            Numa::allocate(snow_, nxb, nz, ld_);
+            Numa::allocate(snew_, nxb, nz, ld_);
+
+            Numa::allocate(mtg_, nxb, nz, ld_);
+            Numa::allocate(mtgnew_, nxb, nz, ld_);
+            Numa::allocate(exn_, nxb, nz1, ld_);
+            Numa::allocate(prs_, nxb, nz1, ld_);
+
+            if(imoist)
+            {
+                Numa::allocate(qold_, Tracer::count(imicrophys), nxb, nz, ld_);
+                Numa::allocate(qnow_, Tracer::count(imicrophys), nxb, nz, ld_);
+                Numa::allocate(qnew_, Tracer::count(imicrophys), nxb, nz, ld_);
+                Numa::allocate(temp_, nxb, nz1, ld_);
+
+                if(idthdt)
+                    Numa::allocate(dthetadt_, nxb, nz1, ld_);
+            }
+        }
+        catch(std::bad_alloc&)
+        {
+            releaseFields();
+            throw IsenException("out of memory");
+        }
+    }
+
+    /// Free the fields of the grid (the profiles, the boundary values and the output are kept)
+    void releaseFields() noexcept
+    {
+        for(FieldXf* field : {&zhtold_, &zhtnow_, &uold_, &unow_, &unew_, &sold_, &snow_, &snew_, &mtg_, &mtgnew_,
+                              &exn_, &prs_, &temp_, &dthetadt_})
+            field->resize(0, 0, 0);
+
+        for(TracerXf* tracers : {&qold_, &qnow_, &qnew_})
+            tracers->resize(tracers->size(), 0, 0, 0);
+    }
+
+    /// Check if the fields of the grid are allocated
+    bool hasFields() const noexcept { return unow_.size() != 0; }
+};
+
+/// @brief Check that @c member shares the grid, the time stepping and the physics switches with @c first
+///
+/// @throw IsenException if the NameLists differ in any of these variables
+static void checkCompatible(const NameList& member, const NameList& first, int m)
+{
+#define ISEN_ENSEMBLE_CHECK(var)                                                                                       \
+    if(member.var != first.var)                                                                                        \
+        throw IsenException("ensemble member %i differs from the first member in '%s' (the members have to share the " \
+                            "grid and the time stepping)",                                                             \
+                            m, #var);
+
+    ISEN_ENSEMBLE_CHECK(nx)
+    ISEN_ENSEMBLE_CHECK(nz)
+    ISEN_ENSEMBLE_CHECK(nb)
+    ISEN_ENSEMBLE_CHECK(dx)
+    ISEN_ENSEMBLE_CHECK(dth)
+    ISEN_ENSEMBLE_CHECK(time)
+    ISEN_ENSEMBLE_CHECK(dt)
+    ISEN_ENSEMBLE_CHECK(nts)
+    ISEN_ENSEMBLE_CHECK(iout)
+    ISEN_ENSEMBLE_CHECK(iiniout)
+    ISEN_ENSEMBLE_CHECK(iadapt)
+    ISEN_ENSEMBLE_CHECK(cfl_target)
+    ISEN_ENSEMBLE_CHECK(dt_grow)
+    ISEN_ENSEMBLE_CHECK(dt_shrink)
+    ISEN_ENSEMBLE_CHECK(dt_max)
+    ISEN_ENSEMBLE_CHECK(irelax)
+    ISEN_ENSEMBLE_CHECK(imoist)
+    ISEN_ENSEMBLE_CHECK(imoist_diff)
+    ISEN_ENSEMBLE_CHECK(imicrophys)
+    ISEN_ENSEMBLE_CHECK(idthdt)
+    ISEN_ENSEMBLE_CHECK(iern)
+    ISEN_ENSEMBLE_CHECK(sediment_on)
+    ISEN_ENSEMBLE_CHECK(imath)
+
+#undef ISEN_ENSEMBLE_CHECK
+}
+
+SolverEnsemble::SolverEnsemble(const std::vector<std::shared_ptr<NameList>>& namelists,
+                               Output::ArchiveType archiveType)
+    : size_(static_cast<int>(namelists.size()))
+{
+    if(namelists.empty())
+        throw IsenException("ensemble without members");
+
+    for(const auto& namelist : namelists)
+        if(namelist->icheckpoint > 0)
+            throw IsenException("ensembles don't support checkpoints (icheckpoint)");
+
+    // Copy the NameLists
+    std::vector<std::shared_ptr<NameList>> copies;
+    for(int m = 0; m < size_; ++m)
+    {
+        copies.push_back(std::make_shared<NameList>(*namelists[m]));
+        checkCompatible(*copies[m], *copies.front(), m);
+    }
+
+    for(int m = 0; m < size_; ++m)
+    {
+        const std::string runName = namelists[m]->run_name;
+        if(std::count_if(namelists.begin(), namelists.end(),
+                         [&](const std::shared_ptr<NameList>& namelist) { return namelist->run_name == runName; })
+           > 1)
+            copies[m]->run_name = runName + "_" + std::to_string(m);
+    }
+
+    namelist_ = copies.front();
+    SOLVER_DECLARE_ALL_ALIASES
+
+    // Create the members (without logging the allocation of every member)
+    const bool logIsDisabled = LOG().isDisabled();
+    LOG() << logger::disable;
+    try
+    {
+        for(int m = 0; m < size_; ++m)
+            members_.push_back(std::make_shared<Member>(copies[m], archiveType));
+    }
+    catch(...)
+    {
+        if(!logIsDisabled)
+            LOG() << logger::enable;
+        throw;
+    }
+    if(!logIsDisabled)
+        LOG() << logger::enable;
+
+    Timer t;
+    LOG() << "Allocating memory of " << size_ << " members ... " << logger::flush;
+
+    try
+    {
+        const int M = size_;
+
+        // Leading dimension of the interleaved fields
+        ld_ = FieldXf::leadingDimension(nxb1 * M);
+
+        topo_ = VectorXf::Zero(nxb * M);
+
+        Numa::allocate(zhtold_, nxb * M, nz1, ld_);
+        Numa::allocate(zhtnow_, nxb * M, nz1, ld_);
+
+        Numa::allocate(uold_, nxb1 * M, nz, ld_);
+        Numa::allocate(unow_, nxb1 * M, nz, ld_);
+        Numa::allocate(unew_, nxb1 * M, nz, ld_);
+
+        Numa::allocate(sold_, nxb * M, nz, ld_);
+        Numa::allocate(snow_, nxb * M, nz, ld_);
+        Numa::allocate(snew_, nxb * M, nz, ld_);
+
+        Numa::allocate(mtg_, nxb * M, nz, ld_);
+        Numa::allocate(exn_, nxb * M, nz1, ld_);
+        Numa::allocate(prs_, nxb * M, nz1, ld_);
+        prs0_ = VectorXf::Zero(nz1 * M);
+
+        tau_ = VectorXf::Zero(nz * M);
+        tauSel_ = VectorXf::Zero(nz * M);
+        th0_ = VectorXf::Zero(nz1 * M);
+
+        sbnd1_ = sbnd2_ = VectorXf::Zero(nz * M);
+        ubnd1_ = ubnd2_ = VectorXf::Zero(nz * M);
+
+        if(imoist)
+        {
+            prec_ = VectorXf::Zero(nxb * M);
+            tot_prec_ = VectorXf::Zero(nxb * M);
+
+            Numa::allocate(qold_, Tracer::count(imicrophys), nxb * M, nz, ld_);
+            Numa::allocate(qnow_, Tracer::count(imicrophys), nxb * M, nz, ld_);
+            Numa::allocate(qnew_, Tracer::count(imicrophys), nxb * M, nz, ld_);
+
+            Numa::allocate(temp_, nxb * M, nz1, ld_);
+
+            qbnd1_ = qbnd2_ = MatrixXf::Zero(nz * M, Tracer::count(imicrophys));
+
+            if(imicrophys == 1)
+                kessler_ = std::make_shared<KesslerEnsemble>(copies);
+        }
+        else
+        {
+            qold_.resize(Tracer::count(imicrophys), 0, 0);
+            qnow_.resize(Tracer::count(imicrophys), 0, 0);
+            qnew_.resize(Tracer::count(imicrophys), 0, 0);
+        }
+
+        topotim_ = VectorXf::Zero(M);
+        topofact_ = VectorXf::Ones(M);
+        for(int m = 0; m < M; ++m)
+            topotim_(m) = copies[m]->topotim;
+
+        dtdx_ = dt / dx;
+    }
+    catch(std::bad_alloc&)
+    {
+        LOG() << logger::failed;
+        throw IsenException("out of memory");
+    }
+    LOG_SUCCESS(t);
+}
+
+SolverEnsemble::~SolverEnsemble()
+{
+}
+
+const Solver& SolverEnsemble::getMember(int m) const
+{
+    if(m < 0 || m >= size_)
+        throw IsenException("no member %i in ensemble of %i members", m, size_);
+
+    members_[m]->allocateFields();
+    scatterMember(m);
+    return *members_[m];
+}
+
+//
+// Interleaving
+//
+
+/// Copy the field @c src of member @c m into the interleaved field @c dst of @c M members
+static void gather(FieldXf& dst, const FieldXf& src, int m, int M) noexcept
+{
+    for(int k = 0; k < src.cols(); ++k)
+        for(int i = 0; i < src.rows(); ++i)
+            dst.data()[k * dst.ld() + i * M + m] = src(i, k);
+}
+
+/// Copy the vector @c src of member @c m into the interleaved vector @c dst of @c M members
+template <class Src>
+static void gather(double* dst, const Src& src, int m, int M) noexcept
+{
+    for(int j = 0; j < src.size(); ++j)
+        dst[j * M + m] = src(j);
+}
+
+/// Copy member @c m of the interleaved field @c src of @c M members into the field @c dst
+static void scatter(const FieldXf& src, FieldXf& dst, int m, int M) noexcept
+{
+    for(int k = 0; k < dst.cols(); ++k)
+        for(int i = 0; i < dst.rows(); ++i)
+            dst(i, k) = src.data()[k * src.ld() + i * M + m];
+}
+
+/// Copy member @c m of the interleaved vector @c src of @c M members into the vector @c dst
+static void scatter(const double* src, VectorXf& dst, int m, int M) noexcept
+{
+    for(int j = 0; j < dst.size(); ++j)
+        dst(j) = src[j * M + m];
+}
+
+void SolverEnsemble::gatherMember(int m) noexcept
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    Member& member = *members_[m];
+
+    gather(topo_.data(), member.topo_, m, size_);
+    gather(zhtold_, member.zhtold_, m, size_);
+    gather(zhtnow_, member.zhtnow_, m, size_);
+    gather(uold_, member.uold_, m, size_);
+    gather(unow_, member.unow_, m, size_);
+    gather(sold_, member.sold_, m, size_);
+    gather(snow_, member.snow_, m, size_);
+    gather(mtg_, member.mtg_, m, size_);
+    gather(exn_, member.exn_, m, size_);
+    gather(prs_, member.prs_, m, size_);
+    gather(prs0_.data(), member.prs0_, m, size_);
+    gather(tau_.data(), member.tau_, m, size_);
+    VectorXf tauSel = (member.tau_.array() > 0.0).cast<double>();
+    gather(tauSel_.data(), tauSel, m, size_);
+    gather(th0_.data(), member.th0_, m, size_);
+    gather(sbnd1_.data(), member.sbnd1_, m, size_);
+    gather(sbnd2_.data(), member.sbnd2_, m, size_);
+    gather(ubnd1_.data(), member.ubnd1_, m, size_);
+    gather(ubnd2_.data(), member.ubnd2_, m, size_);
+
+    if(imoist)
+    {
+        gather(prec_.data(), member.prec_, m, size_);
+        gather(tot_prec_.data(), member.tot_prec_, m, size_);
+        gather(temp_, member.temp_, m, size_);
+
+        for(int t = 0; t < qnow_.size(); ++t)
+        {
+            gather(qold_[t], member.qold_[t], m, size_);
+            gather(qnow_[t], member.qnow_[t], m, size_);
+            gather(qbnd1_.col(t).data(), member.qbnd1_.col(t), m, size_);
+            gather(qbnd2_.col(t).data(), member.qbnd2_.col(t), m, size_);
+        }
+    }
+}
+
+void SolverEnsemble::scatterMember(int m) const noexcept
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    Member& member = *members_[m];
+    assert(member.hasFields());
+
+    scatter(zhtold_, member.zhtold_, m, size_);
+    scatter(zhtnow_, member.zhtnow_, m, size_);
+    scatter(uold_, member.uold_, m, size_);
+    scatter(unow_, member.unow_, m, size_);
+    scatter(sold_, member.sold_, m, size_);
+    scatter(snow_, member.snow_, m, size_);
+    scatter(mtg_, member.mtg_, m, size_);
+    scatter(exn_, member.exn_, m, size_);
+    scatter(prs_, member.prs_, m, size_);
+
+    if(imoist)
+    {
+        scatter(prec_.data(), member.prec_, m, size_);
+        scatter(tot_prec_.data(), member.tot_prec_, m, size_);
+        scatter(temp_, member.temp_, m, size_);
+
+        for(int t = 0; t < qnow_.size(); ++t)
+        {
+            scatter(qold_[t], member.qold_[t], m, size_);
+            scatter(qnow_[t], member.qnow_[t], m, size_);
+        }
+    }
+}
+
+void SolverEnsemble::init()
+{
+    // The members are initialized one after another, only one of them holds its fields at a time
+    Timer t;
+    const bool logIsDisabled = LOG().isDisabled();
+    LOG() << logger::disable;
+    try
+    {
+        for(int m = 0; m < size_; ++m)
+        {
+            members_[m]->allocateFields();
+            members_[m]->init();
+            gatherMember(m);
+            members_[m]->releaseFields();
+        }
+    }
+    catch(...)
+    {
+        if(!logIsDisabled)
+            LOG() << logger::enable << "Initializing and interleaving " << size_ << " members ... " << logger::failed;
+        throw;
+    }
+    if(!logIsDisabled)
+        LOG() << logger::enable;
+
+    LOG() << "Initializing and interleaving " << size_ << " members ... " << logger::flush;
+    LOG_SUCCESS(t);
+}
+
+//
+// Kernels
+//
+// The kernels of the interleaved fields are part of the SolverCpuKernels table (see SolverCpuKernel.h), except for
+// the Exner function which is always computed by the scalar kernel below.
+//
+
+/// Health metrics of all members reduced by a thread (see FieldReduction)
+struct EnsembleReduction
+{
+    std::vector<double> umax;
+    std::vector<double> smass;
+    std::vector<double> check;
+
+    /// Reset to the neutral element
+    void reset(int M)
+    {
+        umax.assign(M, 0.0);
+        smass.assign(M, 0.0);
+        check.assign(M, 0.0);
+    }
+};
+
+/// Pressure, Exner function, Montgomery potential and geometric height of all members, a column at a time, and the
+/// health metrics of the column (see Solver::diagPressure, Solver::diagMontgomery, Solver::geometricHeight and
+/// Solver::computeCFL)
+template <class Math>
+static void kernel_diagEnsemble(const Math& math,
+                                const SolverCpuKernels<double>& kernels,
+                                const int nx,
+                                const int nz,
+                                const int nb,
+                                const int M,
+                                const int ld,
+                                double* ISEN_RESTRICT prs,
+                                double* ISEN_RESTRICT exn,
+                                double* ISEN_RESTRICT mtg,
+                                double* ISEN_RESTRICT zhtnow,
+                                const double* ISEN_RESTRICT snow,
+                                const double* ISEN_RESTRICT unow,
+                                const double* ISEN_RESTRICT topo,
+                                const double* ISEN_RESTRICT th0,
+                                const double* ISEN_RESTRICT prs0,
+                                const double* ISEN_RESTRICT topofact,
+                                const double g,
+                                const double dth,
+                                const double cp,
+                                const double pref,
+                                const double rdcp,
+                                const double rcpg05,
+                                EnsembleReduction& reduction)
+{
+    const int nxb = nx + 2 * nb;
+    const int nz1 = nz + 1;
+
+    // A column of all members stays in the cache between the downward and the upward integration
+    #pragma omp for schedule(static) nowait
+    for(int i = 0; i < nxb; ++i)
+    {
+        kernels.diagPressureEnsemble(i, i + 1, nz, M, ld, prs, snow, prs0, g * dth);
+
+        for(int k = 0; k < nz1; ++k)
+            for(int j = k * ld + i * M; j < k * ld + (i + 1) * M; ++j)
+                exn[j] = cp * math.pow(prs[j] / pref, rdcp);
+
+        kernels.geometricHeightEnsemble(i, i + 1, nx, nz, nb, M, ld, mtg, zhtnow, exn, prs, unow, snow, topo, th0,
+                                        topofact, g, dth, rcpg05, reduction.umax.data(), reduction.smass.data(),
+                                        reduction.check.data());
+    }
+}
+
+//
+// Time loop
+//
+
+void SolverEnsemble::checkHealth(const std::vector<StepHealth>& health)
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    int fastest = 0;
+    for(int m = 0; m < size_; ++m)
+    {
+        members_[m]->health_ = health[m];
+        if(health[m].umax > health[fastest].umax)
+            fastest = m;
+    }
+
+    if(iprtcfl)
+        std::printf("CFL max: %f U max: %f m/s (member %i) \n", health[fastest].umax * dtdx_, health[fastest].umax,
+                    fastest);
+
+    for(int m = 0; m < size_; ++m)
+    {
+        const double cflmax = health[m].umax * dtdx_;
+        if(cflmax > 1)
+            warning("isen", (boost::format("CFL condition violated in member %i (CFL max %f)") % m % cflmax).str());
+        if(!health[m].finite)
+            error("isen", (boost::format("ensemble member %i encountered NaN or Inf values") % m).str());
+    }
+}
+
+void SolverEnsemble::run()
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    const int M = size_;
+    const bool kessler = imoist && imicrophys == 1;
+    const int ntr = imoist ? qnow_.size() : 0;
+    const MathTier tier = FastMath::toTier(imath);
+    const SolverCpuKernels<double>& kernels = solverCpuKernels<double>();
+
+    Timer t;
+
+    Progressbar pbar(nts);
+    const bool logIsDisabled = LOG().isDisabled();
+    Progressbar::disableProgressbar = logIsDisabled;
+
+    TimeControl timeControl(*namelist_);
+    EnsembleReduction reduction;
+    std::vector<StepHealth> health(M);
+
+    // Exceptions must not leave the parallel region (see SolverCpu::run)
+    std::exception_ptr exception;
+    bool abort = false;
+    bool running = timeControl.running();
+
+    // Loop over all time steps
+    //------------------------------------------------------------
+#pragma omp parallel
+    while(running)
+    {
+        #pragma omp single
+        {
+            timeControl.advance();
+
+            if(!iprtcfl)
+                pbar.advanceTo(timeControl.progress());
+
+            for(int m = 0; m < M; ++m)
+                topofact_(m) = std::min(1., timeControl.time() / topotim_(m));
+
+            // Special treatment of first time step and of changes of the (adaptive) time step
+            dtdx_ = timeControl.dtdx();
+            if(timeControl.oldLevelRatio() != 1.0 && kessler_)
+                kessler_->setTimeStep(timeControl.dt());
+
+            reduction.reset(M);
+        }
+
+        if(timeControl.oldLevelRatio() != 1.0)
+        {
+            // See Solver::rescaleOldTimeLevel
+            const double ratio = timeControl.oldLevelRatio();
+
+            #pragma omp for schedule(static)
+            for(int k = 0; k < nz; ++k)
+            {
+                uold_.col(k) = unow_.col(k) - ratio * (unow_.col(k) - uold_.col(k));
+                sold_.col(k) = snow_.col(k) - ratio * (snow_.col(k) - sold_.col(k));
+
+                for(int t = 0; t < ntr; ++t)
+                    qold_[t].col(k) = qnow_[t].col(k) - ratio * (qnow_[t].col(k) - qold_[t].col(k));
+            }
+        }
+
+        // Prognostic step, boundaries, diffusion and clipping (see SolverCpuKernel.h)
+        //--------------------------------------------------------
+        kernels.progEnsemble(nx, nz, nb, M, ld_, ntr, qnow_.stride(), uold_.data(), unow_.data(), unew_.data(),
+                             sold_.data(), snow_.data(), snew_.data(), qold_.data(), qnow_.data(), qnew_.data(),
+                             mtg_.data(), tau_.data(), tauSel_.data(), ubnd1_.data(), ubnd2_.data(),
+                             irelax ? sbnd1_.data() : nullptr, sbnd2_.data(), qbnd1_.data(), qbnd2_.data(),
+                             imoist_diff, dtdx_);
+
+        #pragma omp barrier
+
+        // The diffused new time level is stored in the buffer of the old time level
+        #pragma omp single
+        {
+            uold_.swap(unow_);
+            sold_.swap(snow_);
+            qold_.swap(qnow_);
+
+            zhtnow_.swap(zhtold_);
+        }
+
+        // Diagnostic step, the health metrics of the step are reduced on the fly
+        //--------------------------------------------------------
+        EnsembleReduction reductionThread;
+        reductionThread.reset(M);
+
+        switch(tier)
+        {
+            case MathTier::Polynomial:
+                kernel_diagEnsemble(MathPolynomial<double>(), kernels, nx, nz, nb, M, ld_, prs_.data(), exn_.data(),
+                                    mtg_.data(), zhtnow_.data(), snow_.data(), unow_.data(), topo_.data(), th0_.data(),
+                                    prs0_.data(), topofact_.data(), g, dth, cp, pref, rdcp, 0.5 * r / cp / g,
+                                    reductionThread);
+                break;
+            case MathTier::Table:
+                kernel_diagEnsemble(MathTable<double>(), kernels, nx, nz, nb, M, ld_, prs_.data(), exn_.data(),
+                                    mtg_.data(), zhtnow_.data(), snow_.data(), unow_.data(), topo_.data(), th0_.data(),
+                                    prs0_.data(), topofact_.data(), g, dth, cp, pref, rdcp, 0.5 * r / cp / g,
+                                    reductionThread);
+                break;
+            default:
+                kernel_diagEnsemble(MathExact<double>(), kernels, nx, nz, nb, M, ld_, prs_.data(), exn_.data(),
+                                    mtg_.data(), zhtnow_.data(), snow_.data(), unow_.data(), topo_.data(), th0_.data(),
+                                    prs0_.data(), topofact_.data(), g, dth, cp, pref, rdcp, 0.5 * r / cp / g,
+                                    reductionThread);
+        }
+
+        #pragma omp critical(SolverEnsembleReduction)
+        for(int m = 0; m < M; ++m)
+        {
+            reduction.umax[m] = std::max(reduction.umax[m], reductionThread.umax[m]);
+            reduction.smass[m] += reductionThread.smass[m];
+            reduction.check[m] += reductionThread.check[m];
+        }
+
+        #pragma omp barrier
+
+        // Microphysics
+        //---------------------------------------------------------
+        if(kessler)
+            kessler_->applyTeam(
+                // Output
+                temp_, qnew_[Tracer::QV], qnew_[Tracer::QC], qnew_[Tracer::QR], tot_prec_, prec_,
+
+                // Input
+                th0_, prs_, snow_, qnow_[Tracer::QV], qnow_[Tracer::QC], qnow_[Tracer::QR], exn_, zhtnow_);
+
+        #pragma omp barrier
+
+        // CFL condition, output and signals are handled by the master thread (see SolverCpu::run)
+        //--------------------------------------------------------
+        #pragma omp master
+        {
+            try
+            {
+                qnow_.swap(qnew_);
+
+                for(int m = 0; m < M; ++m)
+                {
+                    health[m].umax = reduction.umax[m];
+                    health[m].mass = dx * dth * reduction.smass[m];
+                    health[m].finite = reduction.check[m] == 0.0;
+                }
+
+                checkHealth(health);
+                if(timeControl.isAdaptive())
+                    timeControl.adapt(*std::max_element(reduction.umax.begin(), reduction.umax.end()),
+                                      TimeControl::waveSpeed(zhtnow_, nz1, g));
+
+                // The fields of a member only exist while its output is written
+                if(timeControl.isOutputStep())
+                    for(int m = 0; m < M; ++m)
+                    {
+                        Member& member = *members_[m];
+                        member.allocateFields();
+                        scatterMember(m);
+                        member.getOutput()->makeOutput(&member);
+                        member.releaseFields();
+                    }
+
+                running = timeControl.running();
+
+#ifdef ISEN_PYTHON
+                if(PyErr_CheckSignals() == -1)
+                    throw IsenException("PySolver::run : signal caught");
+#endif
+            }
+            catch(...)
+            {
+                exception = std::current_exception();
+                abort = true;
+            }
+        }
+
+        #pragma omp barrier
+
+        if(abort)
+            break;
+    }
+
+    if(exception)
+        std::rethrow_exception(exception);
+
+    pbar.pause();
+    if(!logIsDisabled)
+        Progressbar::printBar('=');
+
+    if(logIsDisabled && itime)
+        std::printf("Elapsed time: %s\n", timeString(t.stop()).c_str());
+
+    LOG() << "Finished time loop ...";
+    LOG_SUCCESS(t);
+}
+
+void SolverEnsemble::write()
+{
+    for(auto& member : members_)
+        member->write();
+}
+
+ISEN_NAMESPACE_END
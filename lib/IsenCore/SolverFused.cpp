@@ -0,0 +1,175 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#include <Isen/Boundary.h>
+#include <Isen/SolverFused.h>
+
+ISEN_NAMESPACE_BEGIN
+
+SolverFused::SolverFused(std::shared_ptr<NameList> namelist, Output::ArchiveType archiveType)
+    : Base(namelist, archiveType)
+{}
+
+// -------------------------------------------------- diffusion (single level) -----------------------------------------
+static ISEN_INLINE void level_horizontalDiffusion(const int begin,
+                                                  const int end,
+                                                  double* ISEN_RESTRICT phinew,
+                                                  const double* ISEN_RESTRICT phinow,
+                                                  const double tau,
+                                                  const double tau025)
+{
+    if(tau > 0.0)
+        for(int i = begin; i < end; ++i)
+            phinew[i] = phinow[i] + tau025 * (phinow[i - 1] - 2 * phinow[i] + phinow[i + 1]);
+    else
+        for(int i = begin; i < end; ++i)
+            phinew[i] = phinow[i];
+}
+
+// -------------------------------------------------- prognosticStep ---------------------------------------------------
+//
+// For every level k:
+//
+//  1. The prognostic step writes the new time level into the 'new' fields.
+//  2. The boundaries of the 'new' fields are exchanged (periodic) or relaxed.
+//  3. The diffused fields are written into the 'old' fields (which are no longer needed once the level has been
+//     advanced), followed by the periodic exchange and the clipping of the moisture variables.
+//
+// This reproduces the rotation of the fields in Solver::prognosticStep without touching the level a second time.
+//
+ISEN_NO_INLINE void kernel_fusedStep(const int nx,
+                                     const int nz,
+                                     const int nb,
+                                     const int ld,
+                                     double* ISEN_RESTRICT unew,
+                                     double* ISEN_RESTRICT uold,
+                                     const double* ISEN_RESTRICT unow,
+                                     double* ISEN_RESTRICT snew,
+                                     double* ISEN_RESTRICT sold,
+                                     const double* ISEN_RESTRICT snow,
+                                     double* ISEN_RESTRICT qnew,
+                                     double* ISEN_RESTRICT qold,
+                                     const double* ISEN_RESTRICT qnow,
+                                     const int ntr,
+                                     const int stride,
+                                     const double* ISEN_RESTRICT mtg,
+                                     const double* ISEN_RESTRICT tau,
+                                     const double* ISEN_RESTRICT ubnd1,
+                                     const double* ISEN_RESTRICT ubnd2,
+                                     const double* ISEN_RESTRICT sbnd1,
+                                     const double* ISEN_RESTRICT sbnd2,
+                                     const double* ISEN_RESTRICT qbnd1,
+                                     const double* ISEN_RESTRICT qbnd2,
+                                     const double dtdx,
+                                     const bool irelax)
+{
+    const int nxb = nx + 2 * nb;
+    const int nxnb = nx + nb;
+    const int nx1nb = nx + nb + 1;
+
+    const double dtdx05 = 0.5 * dtdx;
+    const double dtdx2 = 2 * dtdx;
+
+#pragma omp parallel for
+    for(int k = 0; k < nz; ++k)
+    {
+        const double tau025 = 0.25 * tau[k];
+
+        const double* ISEN_RESTRICT unowk = unow + k * ld;
+        double* ISEN_RESTRICT unewk = unew + k * ld;
+        double* ISEN_RESTRICT uoldk = uold + k * ld;
+
+        const double* ISEN_RESTRICT snowk = snow + k * ld;
+        double* ISEN_RESTRICT snewk = snew + k * ld;
+        double* ISEN_RESTRICT soldk = sold + k * ld;
+
+        const double* ISEN_RESTRICT mtgk = mtg + k * ld;
+
+        // Isentropic density
+        for(int i = nb; i < nxnb; ++i)
+        {
+            double snow_iplus1 = snowk[i + 1] * (unowk[i + 2] + unowk[i + 1]);
+            double snow_iminus1 = snowk[i - 1] * (unowk[i] + unowk[i - 1]);
+            snewk[i] = soldk[i] - dtdx05 * (snow_iplus1 - snow_iminus1);
+        }
+
+        // Velocity
+        for(int i = nb; i < nx1nb; ++i)
+        {
+            double unow_delta = unowk[i] * (unowk[i + 1] - unowk[i - 1]);
+            double mtg_dtdx2 = dtdx2 * (mtgk[i] - mtgk[i - 1]);
+            unewk[i] = uoldk[i] - dtdx * unow_delta - mtg_dtdx2;
+        }
+
+        if(irelax)
+        {
+            Boundary::relaxLevel(snewk, nx, nb, sbnd1[k], sbnd2[k]);
+            Boundary::relaxLevel(unewk, nx + 1, nb, ubnd1[k], ubnd2[k]);
+        }
+        else
+        {
+            Boundary::periodicLevel(snewk, nx, nb);
+            Boundary::periodicLevel(unewk, nx + 1, nb);
+        }
+
+        level_horizontalDiffusion(nb, nxnb, soldk, snewk, tau[k], tau025);
+        level_horizontalDiffusion(nb, nx1nb, uoldk, unewk, tau[k], tau025);
+
+        if(!irelax)
+        {
+            Boundary::periodicLevel(soldk, nx, nb);
+            Boundary::periodicLevel(uoldk, nx + 1, nb);
+        }
+
+        // Moisture scalars
+        for(int t = 0; t < ntr; ++t)
+        {
+            const double* ISEN_RESTRICT qnowk = qnow + t * stride + k * ld;
+            double* ISEN_RESTRICT qnewk = qnew + t * stride + k * ld;
+            double* ISEN_RESTRICT qoldk = qold + t * stride + k * ld;
+
+            for(int i = nb; i < nxnb; ++i)
+                qnewk[i] = qoldk[i] - dtdx05 * (unowk[i] + unowk[i + 1]) * (qnowk[i + 1] - qnowk[i - 1]);
+
+            if(irelax)
+                Boundary::relaxLevel(qnewk, nx, nb, qbnd1[t * nz + k], qbnd2[t * nz + k]);
+            else
+                Boundary::periodicLevel(qnewk, nx, nb);
+
+            level_horizontalDiffusion(nb, nxnb, qoldk, qnewk, tau[k], tau025);
+
+            if(!irelax)
+                Boundary::periodicLevel(qoldk, nx, nb);
+
+            for(int i = 0; i < nxb; ++i)
+                qoldk[i] = qoldk[i] < 0.0 ? 0.0 : qoldk[i];
+        }
+    }
+}
+
+void SolverFused::prognosticStep() noexcept
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    kernel_fusedStep(nx, nz, nb, ld_, unew_.data(), uold_.data(), unow_.data(), snew_.data(), sold_.data(),
+                     snow_.data(), qnew_.data(), qold_.data(), qnow_.data(), imoist ? qnow_.size() : 0, qnow_.stride(),
+                     mtg_.data(), tau_.data(), ubnd1_.data(), ubnd2_.data(), sbnd1_.data(), sbnd2_.data(),
+                     qbnd1_.data(), qbnd2_.data(), dtdx_, irelax);
+
+    // The diffused fields reside in the 'old' fields, the non-diffused ones in the 'new' fields
+    uold_.swap(unow_);
+    sold_.swap(snow_);
+    qold_.swap(qnow_);
+}
+
+ISEN_NAMESPACE_END
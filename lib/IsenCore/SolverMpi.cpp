@@ -0,0 +1,360 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#include <Isen/SolverMpi.h>
+
+#ifdef ISEN_MPI
+
+#include <Isen/Logger.h>
+#include <Isen/Numa.h>
+#include <Isen/Progressbar.h>
+#include <Isen/SolverCpuKernel.h>
+#include <Isen/SolverCpuSimd.h>
+#include <Isen/TimeControl.h>
+#include <Isen/Timer.h>
+#include <cstdlib>
+
+#ifdef ISEN_PYTHON
+#include <boost/python.hpp>
+#endif
+
+ISEN_NAMESPACE_BEGIN
+
+namespace
+{
+
+/// Initialize MPI if the application hasn't done so, MPI is finalized at exit
+void initMpi()
+{
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+    if(initialized)
+        return;
+
+    // MPI is only called by the master thread
+    int provided;
+    MPI_Init_thread(nullptr, nullptr, MPI_THREAD_FUNNELED, &provided);
+
+    std::atexit([]() {
+        int finalized = 0;
+        MPI_Finalized(&finalized);
+        if(!finalized)
+            MPI_Finalize();
+    });
+}
+
+/// Rank of the calling process in MPI_COMM_WORLD
+int worldRank()
+{
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    return rank;
+}
+}
+
+SolverMpi::SolverMpi(std::shared_ptr<NameList> namelist, Output::ArchiveType archiveType)
+    : Base(namelist, archiveType), ldLocal_(0)
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    initMpi();
+
+    if(worldRank() != 0)
+        output_->discardFrames();
+
+    if(imoist)
+        return;
+
+    decomposition_.reset(new Decomposition(nx, nb, !irelax));
+    ldLocal_ = FieldXf::leadingDimension(decomposition_->rows(Decomposition::Staggered));
+
+    const int nxbLocal = decomposition_->rows(Decomposition::Unstaggered);
+    const int nxb1Local = decomposition_->rows(Decomposition::Staggered);
+
+    try
+    {
+        Numa::allocate(zhtoldLocal_, nxbLocal, nz1, ldLocal_);
+        Numa::allocate(zhtnowLocal_, nxbLocal, nz1, ldLocal_);
+        Numa::allocate(uoldLocal_, nxb1Local, nz, ldLocal_);
+        Numa::allocate(unowLocal_, nxb1Local, nz, ldLocal_);
+        Numa::allocate(unewLocal_, nxb1Local, nz, ldLocal_);
+        Numa::allocate(soldLocal_, nxbLocal, nz, ldLocal_);
+        Numa::allocate(snowLocal_, nxbLocal, nz, ldLocal_);
+        Numa::allocate(snewLocal_, nxbLocal, nz, ldLocal_);
+        Numa::allocate(mtgLocal_, nxbLocal, nz, ldLocal_);
+        Numa::allocate(exnLocal_, nxbLocal, nz1, ldLocal_);
+        Numa::allocate(prsLocal_, nxbLocal, nz1, ldLocal_);
+    }
+    catch(std::bad_alloc&)
+    {
+        throw IsenException("out of memory");
+    }
+}
+
+void SolverMpi::scatterFields()
+{
+    using D = Decomposition;
+    const D& dec = *decomposition_;
+
+    dec.scatter(topo_, topoLocal_);
+    dec.scatter(zhtold_, zhtoldLocal_, D::Unstaggered);
+    dec.scatter(zhtnow_, zhtnowLocal_, D::Unstaggered);
+    dec.scatter(uold_, uoldLocal_, D::Staggered);
+    dec.scatter(unow_, unowLocal_, D::Staggered);
+    dec.scatter(unew_, unewLocal_, D::Staggered);
+    dec.scatter(sold_, soldLocal_, D::Unstaggered);
+    dec.scatter(snow_, snowLocal_, D::Unstaggered);
+    dec.scatter(snew_, snewLocal_, D::Unstaggered);
+    dec.scatter(mtg_, mtgLocal_, D::Unstaggered);
+    dec.scatter(exn_, exnLocal_, D::Unstaggered);
+    dec.scatter(prs_, prsLocal_, D::Unstaggered);
+}
+
+void SolverMpi::gatherFields(bool all)
+{
+    using D = Decomposition;
+    D& dec = *decomposition_;
+
+    dec.gather(zhtoldLocal_, zhtold_, D::Unstaggered, all);
+    dec.gather(zhtnowLocal_, zhtnow_, D::Unstaggered, all);
+    dec.gather(uoldLocal_, uold_, D::Staggered, all);
+    dec.gather(unowLocal_, unow_, D::Staggered, all);
+    dec.gather(unewLocal_, unew_, D::Staggered, all);
+    dec.gather(soldLocal_, sold_, D::Unstaggered, all);
+    dec.gather(snowLocal_, snow_, D::Unstaggered, all);
+    dec.gather(snewLocal_, snew_, D::Unstaggered, all);
+    dec.gather(mtgLocal_, mtg_, D::Unstaggered, all);
+    dec.gather(exnLocal_, exn_, D::Unstaggered, all);
+    dec.gather(prsLocal_, prs_, D::Unstaggered, all);
+}
+
+void SolverMpi::rescaleOldTimeLevelLocal(double ratio) noexcept
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    // Same as SolverCpu::rescaleOldTimeLevelTeam
+#pragma omp parallel for schedule(static)
+    for(int k = 0; k < nz; ++k)
+    {
+        uoldLocal_.col(k) = unowLocal_.col(k) - ratio * (unowLocal_.col(k) - uoldLocal_.col(k));
+        soldLocal_.col(k) = snowLocal_.col(k) - ratio * (snowLocal_.col(k) - soldLocal_.col(k));
+    }
+}
+
+void SolverMpi::write(std::string filename)
+{
+    if(worldRank() == 0)
+        Base::write(filename);
+}
+
+void SolverMpi::run()
+{
+    SOLVER_DECLARE_ALL_ALIASES
+
+    if(imoist)
+    {
+        Base::run();
+        return;
+    }
+
+    using D = Decomposition;
+    D& dec = *decomposition_;
+
+    const auto& kernels = solverCpuKernels<double>();
+    const int nxl = dec.nxLocal();
+    const int ld = ldLocal_;
+    const bool root = dec.rank() == 0;
+
+    scatterFields();
+
+    Timer t;
+
+    Progressbar pbar(nts);
+    const bool logIsDisabled = LOG().isDisabled();
+    Progressbar::disableProgressbar = logIsDisabled || !root;
+
+    TimeControl timeControl = startTimeControl();
+
+    // Diffusion of the local columns [begin, end) (the velocity additionally at 'end', see kernel_horizontalDiffusion)
+    auto diffuse = [&](int begin, int end, FieldReduction<double>& reduction) {
+        const int offset = begin - nb;
+
+#pragma omp parallel
+        {
+            FieldReduction<double> reductionThread;
+            reductionThread.reset();
+
+            kernels.horizontalDiffusion(end - begin, nz, nb, ld, 0, 0, unewLocal_.data() + offset,
+                                        snewLocal_.data() + offset, nullptr, unowLocal_.data() + offset,
+                                        snowLocal_.data() + offset, nullptr, tau_.data(), &reductionThread);
+
+#pragma omp critical(SolverMpiReduction)
+            {
+                reduction.umax = std::max(reduction.umax, reductionThread.umax);
+                reduction.smass += reductionThread.smass;
+                reduction.check += reductionThread.check;
+            }
+        }
+    };
+
+    // Pressure, Exner function, Montgomery potential and geometric height of the local columns [begin, end)
+    auto diagnose = [&](int begin, int end) {
+#pragma omp parallel
+        kernel_diagColumn(end - begin, nz, 0, ld, prsLocal_.data() + begin, exnLocal_.data() + begin,
+                          mtgLocal_.data() + begin, zhtnowLocal_.data() + begin, snowLocal_.data() + begin,
+                          topoLocal_.data() + begin, th0_.data(), g * dth, prs0_(nz), cp, pref, rdcp, dth,
+                          g * topofact_, topofact_, 0.5 * r / cp / g, mathTier_);
+    };
+
+    // Loop over all time steps
+    //------------------------------------------------------------
+    while(timeControl.running())
+    {
+        timeControl.advance();
+
+        if(!iprtcfl)
+            pbar.advanceTo(timeControl.progress());
+
+        topofact_ = std::min(1., timeControl.time() / topotim);
+
+        // Special treatment of first time step and of changes of the (adaptive) time step
+        //--------------------------------------------------------
+        dtdx_ = timeControl.dtdx();
+        if(timeControl.oldLevelRatio() != 1.0)
+            rescaleOldTimeLevelLocal(timeControl.oldLevelRatio());
+
+        // Prognostic step of the owned points
+        //--------------------------------------------------------
+#pragma omp parallel
+        {
+            kernels.progIsendens(nxl, nz, nb, ld, snewLocal_.data(), snowLocal_.data(), soldLocal_.data(),
+                                 unowLocal_.data(), 0.5 * dtdx_);
+            kernels.progVelocity(nxl, nz, nb, ld, unewLocal_.data(), unowLocal_.data(), uoldLocal_.data(),
+                                 mtgLocal_.data(), dtdx_);
+        }
+
+        // Relax the owned points and exchange the halos, the interior of the slab is diffused in the meantime
+        //--------------------------------------------------------
+        if(irelax)
+        {
+            dec.relax(snewLocal_, D::Unstaggered, sbnd1_, sbnd2_);
+            dec.relax(unewLocal_, D::Staggered, ubnd1_, ubnd2_);
+        }
+
+        dec.exchangeBegin(snewLocal_, D::Unstaggered);
+        dec.exchangeBegin(unewLocal_, D::Staggered);
+
+        uoldLocal_.swap(unowLocal_);
+        soldLocal_.swap(snowLocal_);
+
+        unowLocal_.swap(unewLocal_);
+        snowLocal_.swap(snewLocal_);
+
+        FieldReduction<double> reduction;
+        reduction.reset();
+
+        diffuse(nb + 1, nxl + nb - 2, reduction);
+        dec.exchangeEnd();
+        diffuse(nb, nb + 1, reduction);
+        diffuse(nxl + nb - 2, nxl + nb, reduction);
+
+        // Exchange the halos of the diffused fields while the owned columns are diagnosed
+        //--------------------------------------------------------
+        dec.exchangeBegin(unewLocal_, D::Staggered);
+        dec.exchangeBegin(snewLocal_, D::Unstaggered);
+
+        unowLocal_.swap(unewLocal_);
+        snowLocal_.swap(snewLocal_);
+
+        zhtnowLocal_.swap(zhtoldLocal_);
+
+        diagnose(nb, nxl + nb);
+        dec.exchangeEnd();
+        diagnose(0, nb);
+        diagnose(nxl + nb, nxl + 2 * nb);
+
+        // Velocity at the boundary points of the domain (see SolverCpu::reduceVelocityBoundary)
+        const int firstLeft = dec.rank() == 0 ? 0 : nb;
+        const int lastRight = dec.rank() == dec.size() - 1 ? nxl + 2 * nb : nxl + nb + 1;
+
+        auto reducePoint = [&](int i, int k) {
+            reduction.umax = std::max(reduction.umax, std::fabs(unowLocal_(i, k)));
+            reduction.check += unowLocal_(i, k) - unowLocal_(i, k);
+        };
+
+        for(int k = 0; k < nz; ++k)
+        {
+            for(int i = firstLeft; i < nb; ++i)
+                reducePoint(i, k);
+            for(int i = nxl + nb + 1; i < lastRight; ++i)
+                reducePoint(i, k);
+        }
+
+        // Check maximum CFL condition and the health of the step (reported by the first rank)
+        //--------------------------------------------------------
+        reduction.umax = dec.allreduceMax(reduction.umax);
+        reduction.smass = dec.allreduceSum(reduction.smass);
+        reduction.check = dec.allreduceSum(reduction.check);
+
+        // Every rank terminates on NaN values, the others would otherwise block in the next collective operation
+        checkHealth(toStepHealth(reduction, dx * dth), root);
+
+        if(timeControl.isAdaptive())
+            timeControl.adapt(reduction.umax, dec.allreduceMax(TimeControl::waveSpeed(zhtnowLocal_, nz1, g)));
+
+        // Output every 'iout'-th time step (or at the same times with an adaptive time step)
+        //--------------------------------------------------------
+        if(timeControl.isOutputStep())
+        {
+            dec.gather(zhtnowLocal_, zhtnow_, D::Unstaggered, false);
+            dec.gather(unowLocal_, unow_, D::Staggered, false);
+            dec.gather(snowLocal_, snow_, D::Unstaggered, false);
+
+            if(root)
+                output_->makeOutput(this);
+        }
+
+        // Checkpoint of the global fields (written by the first rank)
+        //--------------------------------------------------------
+        if(isCheckpointStep(timeControl))
+        {
+            gatherFields(false);
+            if(root)
+                makeCheckpoint(timeControl);
+        }
+
+#ifdef ISEN_PYTHON
+        // Handle Python signals
+        //--------------------------------------------------------
+        if(PyErr_CheckSignals() == -1)
+            throw IsenException("PySolver::run : signal caught");
+#endif
+    }
+
+    gatherFields(true);
+    finishCheckpoint();
+
+    pbar.pause();
+    if(!logIsDisabled && root)
+        Progressbar::printBar('=');
+
+    if(logIsDisabled && itime && root)
+        std::printf("Elapsed time: %s\n", timeString(t.stop()).c_str());
+
+    LOG() << "Finished time loop ...";
+    LOG_SUCCESS(t);
+}
+
+ISEN_NAMESPACE_END
+
+#endif
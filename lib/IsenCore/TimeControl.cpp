@@ -0,0 +1,128 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#include <Isen/Checkpoint.h>
+#include <Isen/TimeControl.h>
+
+ISEN_NAMESPACE_BEGIN
+
+TimeControl::TimeControl(const NameList& namelist)
+    : adaptive_(namelist.iadapt),
+      nts_(namelist.nts),
+      iout_(namelist.iout),
+      dt0_(namelist.dt),
+      dx_(namelist.dx),
+      timeEnd_(namelist.nts * namelist.dt),
+      cflTarget_(namelist.cfl_target),
+      grow_(namelist.dt_grow),
+      shrink_(namelist.dt_shrink),
+      dtMax_(namelist.dt_max),
+      step_(0),
+      nout_(0),
+      time_(0),
+      dt_(namelist.dt),
+      dtNext_(namelist.dt),
+      ratio_(1),
+      output_(false)
+{
+    if(!adaptive_)
+        return;
+
+    if(!(cflTarget_ > 0 && cflTarget_ <= 1))
+        throw IsenException("invalid target CFL number '%f' (cfl_target has to be in (0, 1])", cflTarget_);
+    if(!(grow_ >= 1))
+        throw IsenException("invalid time step growth '%f' (dt_grow has to be at least 1)", grow_);
+    if(!(shrink_ > 0 && shrink_ <= 1))
+        throw IsenException("invalid time step shrink '%f' (dt_shrink has to be in (0, 1])", shrink_);
+    if(!(dtMax_ >= 0))
+        throw IsenException("invalid maximal time step '%f' (dt_max has to be non-negative)", dtMax_);
+}
+
+void TimeControl::advance() noexcept
+{
+    ++step_;
+
+    if(!adaptive_)
+    {
+        time_ += dt_;
+        output_ = (step_ % iout_) == 0;
+        return;
+    }
+
+    // The next stop is either the next output or the end of the simulation (if it is not an output time)
+    const double dtPrev = dt_;
+    const bool outputAhead = (nout_ + 1) * iout_ <= nts_;
+    const double stop = outputAhead ? (nout_ + 1) * iout_ * dt0_ : timeEnd_;
+    const double remaining = stop - time_;
+
+    if(remaining <= dtNext_)
+    {
+        dt_ = remaining;
+        time_ = stop;
+        output_ = outputAhead;
+        nout_ += output_;
+    }
+    else
+    {
+        // Split the remainder into two equal steps instead of leaving a very short one
+        dt_ = remaining < 2 * dtNext_ ? 0.5 * remaining : dtNext_;
+        time_ += dt_;
+        output_ = false;
+    }
+
+    ratio_ = step_ == 1 ? 1.0 : dt_ / dtPrev;
+}
+
+void TimeControl::adapt(double umax, double cwave) noexcept
+{
+    // NaN values are reported by Solver::checkHealth
+    const double speed = umax + cwave;
+    if(!adaptive_ || !(speed > 0))
+        return;
+
+    double dt = cflTarget_ * dx_ / speed;
+    dt = std::min(std::max(dt, shrink_ * dtNext_), grow_ * dtNext_);
+    if(dtMax_ > 0)
+        dt = std::min(dt, dtMax_);
+
+    dtNext_ = dt;
+}
+
+int TimeControl::progress() const noexcept
+{
+    return adaptive_ ? std::min(nts_, static_cast<int>(time_ / dt0_ + 1e-6)) : step_;
+}
+
+void TimeControl::save(Checkpoint& checkpoint) const
+{
+    checkpoint.add("time.step", step_);
+    checkpoint.add("time.nout", nout_);
+    checkpoint.add("time.time", time_);
+    checkpoint.add("time.dt", dt_);
+    checkpoint.add("time.dtNext", dtNext_);
+    checkpoint.add("time.ratio", ratio_);
+    checkpoint.add("time.output", static_cast<int>(output_));
+}
+
+void TimeControl::load(const Checkpoint& checkpoint)
+{
+    step_ = checkpoint.get<int>("time.step");
+    nout_ = checkpoint.get<int>("time.nout");
+    time_ = checkpoint.get<double>("time.time");
+    dt_ = checkpoint.get<double>("time.dt");
+    dtNext_ = checkpoint.get<double>("time.dtNext");
+    ratio_ = checkpoint.get<double>("time.ratio");
+    output_ = checkpoint.get<int>("time.output") != 0;
+}
+
+ISEN_NAMESPACE_END
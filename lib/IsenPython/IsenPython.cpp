@@ -49,7 +49,10 @@ BOOST_PYTHON_MODULE(IsenPythonCxx)
         .value("Unknown", Isen::Output::Unknown)
         .value("Text", Isen::Output::Text)
         .value("Xml", Isen::Output::Xml)
-        .value("Binary", Isen::Output::Binary);
+        .value("Binary", Isen::Output::Binary)
+        .value("Stream", Isen::Output::Stream)
+        .value("Mapped", Isen::Output::Mapped)
+        .value("Chunked", Isen::Output::Chunked);
 
     // Exception
     register_exception_translator<Isen::IsenException>(&Isen::translateIsenException);
@@ -73,8 +76,32 @@ BOOST_PYTHON_MODULE(IsenPythonCxx)
         .add_property("vt_mult", &Isen::PyNameList::get_vt_mult, &Isen::PyNameList::set_vt_mult)
         .add_property("autoconv_th", &Isen::PyNameList::get_autoconv_th, &Isen::PyNameList::set_autoconv_th)
         .add_property("autoconv_mult", &Isen::PyNameList::get_autoconv_mult, &Isen::PyNameList::set_autoconv_mult)
+        .add_property("cfl_target", &Isen::PyNameList::get_cfl_target, &Isen::PyNameList::set_cfl_target)
+        .add_property("dt_grow", &Isen::PyNameList::get_dt_grow, &Isen::PyNameList::set_dt_grow)
+        .add_property("dt_shrink", &Isen::PyNameList::get_dt_shrink, &Isen::PyNameList::set_dt_shrink)
+        .add_property("dt_max", &Isen::PyNameList::get_dt_max, &Isen::PyNameList::set_dt_max)
+        .add_property("tol_z", &Isen::PyNameList::get_tol_z, &Isen::PyNameList::set_tol_z)
+        .add_property("tol_u", &Isen::PyNameList::get_tol_u, &Isen::PyNameList::set_tol_u)
+        .add_property("tol_s", &Isen::PyNameList::get_tol_s, &Isen::PyNameList::set_tol_s)
+        .add_property("tol_prec", &Isen::PyNameList::get_tol_prec, &Isen::PyNameList::set_tol_prec)
+        .add_property("tol_tot_prec", &Isen::PyNameList::get_tol_tot_prec, &Isen::PyNameList::set_tol_tot_prec)
+        .add_property("tol_qv", &Isen::PyNameList::get_tol_qv, &Isen::PyNameList::set_tol_qv)
+        .add_property("tol_qc", &Isen::PyNameList::get_tol_qc, &Isen::PyNameList::set_tol_qc)
+        .add_property("tol_qr", &Isen::PyNameList::get_tol_qr, &Isen::PyNameList::set_tol_qr)
+        .add_property("tol_nr", &Isen::PyNameList::get_tol_nr, &Isen::PyNameList::set_tol_nr)
+        .add_property("tol_nc", &Isen::PyNameList::get_tol_nc, &Isen::PyNameList::set_tol_nc)
+        .add_property("tol_dthetadt", &Isen::PyNameList::get_tol_dthetadt, &Isen::PyNameList::set_tol_dthetadt)
         // Integer point getter/setters
         .add_property("iout", &Isen::PyNameList::get_iout, &Isen::PyNameList::set_iout)
+        .add_property("icheckpoint", &Isen::PyNameList::get_icheckpoint, &Isen::PyNameList::set_icheckpoint)
+        .add_property("chunk_nt", &Isen::PyNameList::get_chunk_nt, &Isen::PyNameList::set_chunk_nt)
+        .add_property("chunk_nx", &Isen::PyNameList::get_chunk_nx, &Isen::PyNameList::set_chunk_nx)
+        .add_property("out_xmin", &Isen::PyNameList::get_out_xmin, &Isen::PyNameList::set_out_xmin)
+        .add_property("out_xmax", &Isen::PyNameList::get_out_xmax, &Isen::PyNameList::set_out_xmax)
+        .add_property("out_zmin", &Isen::PyNameList::get_out_zmin, &Isen::PyNameList::set_out_zmin)
+        .add_property("out_zmax", &Isen::PyNameList::get_out_zmax, &Isen::PyNameList::set_out_zmax)
+        .add_property("out_xstride", &Isen::PyNameList::get_out_xstride, &Isen::PyNameList::set_out_xstride)
+        .add_property("out_zstride", &Isen::PyNameList::get_out_zstride, &Isen::PyNameList::set_out_zstride)
         .add_property("xl", &Isen::PyNameList::get_xl, &Isen::PyNameList::set_xl)
         .add_property("nx", &Isen::PyNameList::get_nx, &Isen::PyNameList::set_nx)
         .add_property("nz", &Isen::PyNameList::get_nz, &Isen::PyNameList::set_nz)
@@ -86,6 +113,8 @@ BOOST_PYTHON_MODULE(IsenPythonCxx)
         .add_property("nab", &Isen::PyNameList::get_nab, &Isen::PyNameList::set_nab)
         .add_property("nb", &Isen::PyNameList::get_nb, &Isen::PyNameList::set_nb)
         .add_property("imicrophys", &Isen::PyNameList::get_imicrophys, &Isen::PyNameList::set_imicrophys)
+        .add_property("tblock", &Isen::PyNameList::get_tblock, &Isen::PyNameList::set_tblock)
+        .add_property("imath", &Isen::PyNameList::get_imath, &Isen::PyNameList::set_imath)
         // Boolean point getter/setters
         .add_property("iiniout", &Isen::PyNameList::get_iiniout, &Isen::PyNameList::set_iiniout)
         .add_property("ishear", &Isen::PyNameList::get_ishear, &Isen::PyNameList::set_ishear)
@@ -97,14 +126,24 @@ BOOST_PYTHON_MODULE(IsenPythonCxx)
         .add_property("idthdt", &Isen::PyNameList::get_idthdt, &Isen::PyNameList::set_idthdt)
         .add_property("iern", &Isen::PyNameList::get_iern, &Isen::PyNameList::set_iern)
         .add_property("sediment_on", &Isen::PyNameList::get_sediment_on, &Isen::PyNameList::set_sediment_on)
+        .add_property("imixprec", &Isen::PyNameList::get_imixprec, &Isen::PyNameList::set_imixprec)
+        .add_property("sediment_col", &Isen::PyNameList::get_sediment_col, &Isen::PyNameList::set_sediment_col)
+        .add_property("iadapt", &Isen::PyNameList::get_iadapt, &Isen::PyNameList::set_iadapt)
         // String point getter/setters
-        .add_property("run_name", &Isen::PyNameList::get_run_name, &Isen::PyNameList::set_run_name);
+        .add_property("run_name", &Isen::PyNameList::get_run_name, &Isen::PyNameList::set_run_name)
+        .add_property("compression", &Isen::PyNameList::get_compression, &Isen::PyNameList::set_compression)
+        .add_property("encoding", &Isen::PyNameList::get_encoding, &Isen::PyNameList::set_encoding)
+        .add_property("out_fields", &Isen::PyNameList::get_out_fields, &Isen::PyNameList::set_out_fields);
 
     // PyOutput
     class_<Isen::PyOutput>("Output")
         .def(init<boost::python::optional<const char*>>())
         .def("read", &Isen::PyOutput::read)
         .def("getNameList", &Isen::PyOutput::getNameList)
+        .def("numFrames", &Isen::PyOutput::numFrames)
+        .def("time", &Isen::PyOutput::time)
+        .def("frame", &Isen::PyOutput::frame)
+        .def("errorBound", &Isen::PyOutput::errorBound)
         .def("z", &Isen::PyOutput::z)
         .def("u", &Isen::PyOutput::u)
         .def("s", &Isen::PyOutput::s)
@@ -123,6 +162,7 @@ BOOST_PYTHON_MODULE(IsenPythonCxx)
         .def(init<boost::python::optional<const char*>>())
         .def("init", &Isen::PySolver::initWithFile, PySolver_overload_init())
         .def("init", &Isen::PySolver::initWithNameList)
+        .def("restart", &Isen::PySolver::restart)
         .def("run", &Isen::PySolver::run)
         .def("getField", &Isen::PySolver::getField)
         .def("getOutput", &Isen::PySolver::getOutput)
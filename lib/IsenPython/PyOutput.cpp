@@ -41,4 +41,54 @@ void PyOutput::read(const char* file)
     namelist_ = std::make_shared<NameList>(*output_->getNameList());
 }
 
+int PyOutput::numFrames() const
+{
+    if(!output_)
+        throw IsenException("Output: not initialized");
+    return output_->numFrames();
+}
+
+double PyOutput::time(int n) const
+{
+    if(!output_)
+        throw IsenException("Output: not initialized");
+    return output_->time(n);
+}
+
+double PyOutput::errorBound(const char* name) const
+{
+    if(!output_)
+        throw IsenException("Output: not initialized");
+    return output_->errorBound(name);
+}
+
+boost::python::object PyOutput::frame(const char* name, int n) const
+{
+    if(!output_)
+        throw IsenException("Output: not initialized");
+
+    const int nx = output_->frameNx();
+    const int nz = output_->frameNz(name);
+    if(nz == 0)
+        return internal::toNumpyArrayImpl(output_->frame(name, n), nx);
+    return internal::toNumpyArrayImpl(output_->frame(name, n), nx, nz);
+}
+
+boost::python::object PyOutput::field(const char* name,
+                                      const std::vector<double>& (Output::*getter)() const) const
+{
+    if(!output_)
+        throw IsenException("Output: not initialized");
+
+    if(!output_->has(name))
+        throw IsenException("Output: %s is not available", name);
+
+    const std::vector<double>& data = (output_.get()->*getter)();
+    const int nx = output_->frameNx();
+    const int nz = output_->frameNz(name);
+    if(nz == 0)
+        return internal::toNumpyArrayImpl(data.data(), output_->numFrames(), nx);
+    return internal::toNumpyArrayImpl(data.data(), output_->numFrames(), nx, nz);
+}
+
 ISEN_NAMESPACE_END
@@ -11,6 +11,7 @@
  *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
  */
 
+#include <Isen/Checkpoint.h>
 #include <Isen/Parse.h>
 #include <Isen/Python/PySolver.h>
 #include <Isen/SolverFactory.h>
@@ -64,6 +65,30 @@ void PySolver::initWithFile(const char* filename)
     isInitialized_ = true;
 }
 
+void PySolver::restart(const char* filename)
+{
+    std::shared_ptr<Checkpoint> checkpoint;
+    try
+    {
+        checkpoint = std::make_shared<Checkpoint>(filename);
+        namelist_ = checkpoint->getNameList();
+    }
+    catch(const IsenException& err)
+    {
+        throw IsenException("Solver: %s", err.what());
+    }
+
+    if(solver_)
+        solver_.reset();
+
+    // Construct Solver
+    solver_ = SolverFactory::create(name_, namelist_);
+
+    solver_->init();
+    solver_->restart(*checkpoint);
+    isInitialized_ = true;
+}
+
 void PySolver::run()
 {
     if(!isInitialized_)
@@ -11,18 +11,47 @@
  *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
  */
 
+#include <Isen/Checkpoint.h>
 #include <Isen/CommandLine.h>
 #include <Isen/Common.h>
+#include <Isen/Deviation.h>
 #include <Isen/Logger.h>
 #include <Isen/NameList.h>
+#include <Isen/Numa.h>
 #include <Isen/Parse.h>
 #include <Isen/Progressbar.h>
+#include <Isen/Simd.h>
+#include <Isen/SolverEnsemble.h>
 #include <Isen/SolverFactory.h>
 #include <Isen/Terminal.h>
 #include <Isen/Timer.h>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <list>
+#include <map>
+#include <set>
+#include <thread>
+
+#if defined(ISEN_PLATFORM_LINUX) || defined(ISEN_PLATFORM_APPLE)
+#define ISEN_BATCH 1
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef ISEN_PLATFORM_LINUX
+#include <sched.h>
+#endif
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace Isen;
 
@@ -41,6 +70,114 @@ void tokenizeFiles(Container& files)
     swap(files, newFiles);
 }
 
+/// Result of a simulation of the batch mode
+struct BatchRun
+{
+    std::string file;    ///< Input file
+    std::string output;  ///< Output file (empty if no output is written)
+    std::string status;  ///< "ok", "failed" (exit with an error) or "crashed" (killed by a signal)
+    std::string message; ///< Error message of a failed or crashed simulation
+    double time = 0;     ///< Runtime in ms
+};
+
+/// CPUs the process is allowed to run on
+static std::vector<int> availableCpus()
+{
+    std::vector<int> cpus;
+#ifdef ISEN_PLATFORM_LINUX
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(sched_getaffinity(0, sizeof(set), &set) == 0)
+        for(int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            if(CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+#endif
+    if(cpus.empty())
+        for(int cpu = 0; cpu < static_cast<int>(std::max(1u, std::thread::hardware_concurrency())); ++cpu)
+            cpus.push_back(cpu);
+    return cpus;
+}
+
+/// Write the summary of the batch as tab separated values (one line per input file)
+static void printSummary(std::ostream& os, const std::vector<BatchRun>& runs)
+{
+    os << "file\tstatus\ttime [s]\toutput\tmessage\n";
+    for(const auto& run : runs)
+        os << run.file << "\t" << run.status << "\t" << boost::format("%.3f") % (run.time / 1000) << "\t"
+           << (run.output.empty() ? "-" : run.output) << "\t" << run.message << "\n";
+    os.flush();
+}
+
+#ifdef ISEN_BATCH
+
+/// Last error message in the log of a simulation (see error())
+static std::string lastErrorMessage(std::FILE* log)
+{
+    std::string message, line;
+    std::array<char, 512> buffer;
+
+    std::rewind(log);
+    while(std::fgets(buffer.data(), buffer.size(), log))
+    {
+        line += buffer.data();
+        if(line.back() != '\n' && !std::feof(log))
+            continue;
+
+        auto pos = line.find(": error: ");
+        if(pos != std::string::npos)
+        {
+            message = line.substr(pos + 9);
+            while(!message.empty() && std::isspace(message.back()))
+                message.pop_back();
+        }
+        line.clear();
+    }
+    return message;
+}
+
+/// @brief Run the simulation of @c namelist in the child process of a batch job and exit
+///
+/// The child is bound to @c cpus and uses as many OpenMP threads. The simulation is written to the reserved file
+/// @c output (if @c writeOutput is true, the streamed frames are written to it regardless). Errors terminate the
+/// process (see error()).
+static ISEN_NORETURN void runBatchJob(const std::shared_ptr<NameList>& namelist, const std::string& solverName,
+                                      Output::ArchiveType archiveType, const std::string& output, bool writeOutput,
+                                      const std::vector<int>& cpus)
+{
+#ifdef ISEN_PLATFORM_LINUX
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(int cpu : cpus)
+        CPU_SET(cpu, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+#endif
+#ifdef _OPENMP
+    omp_set_num_threads(static_cast<int>(cpus.size()));
+#endif
+
+    // The terminal output is redirected to the log of the job
+    LOG() << logger::disable;
+    Progressbar::disableProgressbar = true;
+
+    try
+    {
+        auto solver = SolverFactory::create(solverName, namelist, archiveType);
+        solver->setOutputFilename(output);
+        solver->init();
+        solver->run();
+        if(writeOutput)
+            solver->write();
+    }
+    catch(const std::exception& e)
+    {
+        error("isen", e.what());
+    }
+
+    std::exit(EXIT_SUCCESS);
+}
+
+#endif
+
 /// Main entry-point
 int main(int argc, char* argv[])
 {
@@ -63,6 +200,12 @@ int main(int argc, char* argv[])
             archiveType = Output::Text;
         else if(archiveStr == "xml")
             archiveType = Output::Xml;
+        else if(archiveStr == "stream")
+            archiveType = Output::Stream;
+        else if(archiveStr == "mapped")
+            archiveType = Output::Mapped;
+        else if(archiveStr == "chunked")
+            archiveType = Output::Chunked;
         else
             archiveType = Output::Binary;
     }
@@ -82,9 +225,36 @@ int main(int argc, char* argv[])
     if((Progressbar::disableProgressbar = cl.has("quiet")))
         LOG() << Isen::logger::disable;
 
-    if(!cl.has("file"))
+    if(cl.has("simd"))
+    {
+        try
+        {
+            Simd::set(Simd::fromString(cl.as<std::string>("simd")));
+        }
+        catch(const std::exception& e)
+        {
+            fatalError(e.what());
+        }
+    }
+
+    if(cl.has("numa"))
+    {
+        try
+        {
+            Numa::setPolicy(Numa::fromString(cl.as<std::string>("numa")));
+        }
+        catch(const std::exception& e)
+        {
+            fatalError(e.what());
+        }
+    }
+
+    if(cl.has("restart") && cl.has("file"))
+        fatalError("--restart can't be combined with input files");
+
+    if(!cl.has("file") && !cl.has("restart"))
         fatalError("no input files");
-    auto files = cl.as<std::vector<std::string>>("file");
+    auto files = cl.has("file") ? cl.as<std::vector<std::string>>("file") : std::vector<std::string>();
     tokenizeFiles(files);
 
     std::vector<std::string> namelistJit;
@@ -98,34 +268,284 @@ int main(int argc, char* argv[])
     std::shared_ptr<NameList> namelist;
     std::shared_ptr<Solver> solver;
 
-    for(const auto& file : files)
+    // Parse the input file and apply the namelist overrides
+    auto parseNameList = [&](const std::string& file) {
+        parser.setStyle(parsingStyle);
+        namelist = parser.parse(file);
+
+        if(cl.has("print-namelist"))
+            namelist->print(std::cout);
+
+        if(!namelistJit.empty())
+            for(const auto& line : namelistJit)
+                parser.parseSingleLine(namelist, line);
+    };
+
+    if(cl.has("ensemble") && cl.has("jobs"))
+        fatalError("--ensemble can't be combined with --jobs");
+
+    if(cl.has("restart") && (cl.has("ensemble") || cl.has("jobs")))
+        fatalError("--restart can't be combined with --ensemble or --jobs");
+
+    if(cl.has("ensemble"))
     {
-        // Parse the input file and create solver
+        std::vector<std::shared_ptr<NameList>> namelists;
+        std::shared_ptr<SolverEnsemble> ensemble;
+
         try
         {
-            parser.setStyle(parsingStyle);
-            namelist = parser.parse(file);
+            for(const auto& file : files)
+            {
+                parseNameList(file);
+                namelists.push_back(namelist);
+            }
+            ensemble = std::make_shared<SolverEnsemble>(namelists, archiveType);
+        }
+        catch(const std::exception& e)
+        {
+            fatalError(e.what());
+        }
 
-            if(cl.has("print-namelist"))
-                namelist->print(std::cout);
+        // Run simulation of all members
+        ensemble->init();
+        ensemble->run();
 
-            if(!namelistJit.empty())
-                for(const auto& line : namelistJit)
-                    parser.parseSingleLine(namelist, line);
-            
-            if(cl.has("solver"))
-                solver =  SolverFactory::create(cl.as<std::string>("solver"), namelist, archiveType);            
+        // Report the deviation of each member from the double precision cpu implementation
+        if(cl.has("verify"))
+        {
+            try
+            {
+                for(int m = 0; m < ensemble->size(); ++m)
+                {
+                    auto reference = SolverFactory::create("cpu", namelists[m]);
+                    reference->init();
+                    reference->run();
+                    std::cout << "Member " << m << " (" << files[m] << "):\n";
+                    Deviation::print(std::cout, Deviation::compute(ensemble->getMember(m), *reference));
+                }
+            }
+            catch(const std::exception& e)
+            {
+                fatalError(e.what());
+            }
+        }
+
+        // Write the simulation of each member to its outputfile
+        try
+        {
+            if(!cl.has("no-output"))
+                ensemble->write();
+        }
+        catch(const std::exception& e)
+        {
+            fatalError(e.what());
+        }
+
+        return 0;
+    }
+
+    const std::string solverName = cl.has("solver") ? cl.as<std::string>("solver") : "cpu";
+
+    if(cl.has("jobs"))
+    {
+#ifdef ISEN_BATCH
+        if(cl.has("verify"))
+            fatalError("--jobs can't be combined with --verify");
+
+        // Partition the cores among the jobs, each job gets a slot of (at least one) cores
+        const int jobs = cl.as<int>("jobs");
+        const std::vector<int> cpus = availableCpus();
+        const int numCpus = static_cast<int>(cpus.size());
+        const int threadsPerJob = std::max(1, numCpus / jobs);
+
+        std::vector<std::vector<int>> slotCpus(jobs);
+        for(int slot = 0; slot < jobs; ++slot)
+            for(int t = 0; t < threadsPerJob; ++t)
+                slotCpus[slot].push_back(cpus[(slot * threadsPerJob + t) % numCpus]);
+
+        std::vector<int> freeSlots;
+        for(int slot = jobs - 1; slot >= 0; --slot)
+            freeSlots.push_back(slot);
+
+        struct Job
+        {
+            int run;
+            int slot;
+            std::FILE* log;
+            Timer timer;
+        };
+        std::map<pid_t, Job> running;
+
+        const int numRuns = static_cast<int>(files.size());
+        std::vector<BatchRun> runs(numRuns);
+        std::set<std::string> outputs;
+        bool success = true;
+
+        LOG() << "Running " << numRuns << " simulations with " << jobs << " jobs (" << threadsPerJob
+              << (threadsPerJob == 1 ? " thread" : " threads") << " each) ..." << logger::endl;
+
+        Progressbar pbar(numRuns);
+        int numFinished = 0;
+
+        auto finish = [&](BatchRun& run) {
+            success &= run.status == "ok";
+            pbar.advanceTo(++numFinished);
+        };
+
+        int next = 0;
+        while(next < numRuns || !running.empty())
+        {
+            // Launch the next simulation if a slot is free
+            if(next < numRuns && !freeSlots.empty())
+            {
+                BatchRun& run = runs[next];
+                const int runIdx = next++;
+                run.file = files[runIdx];
+                Timer timer;
+
+                // Parse the input file and reserve an unique output file (the frames of the stream and chunked
+                // archives are written to it during the simulation, even without output)
+                std::string output;
+                try
+                {
+                    parseNameList(run.file);
+
+                    const std::string ext = Output::extension(archiveType);
+                    output = namelist->run_name;
+                    for(int n = 1; outputs.count(output + ext) || boost::filesystem::exists(output + ext); ++n)
+                        output = namelist->run_name + "-" + std::to_string(n);
+                    output += ext;
+                    outputs.insert(output);
+
+                    if(!cl.has("no-output"))
+                        run.output = output;
+                }
+                catch(const std::exception& e)
+                {
+                    run.status = "failed";
+                    run.message = e.what();
+                    run.time = timer.stop();
+                    finish(run);
+                    continue;
+                }
+
+                std::FILE* log = std::tmpfile();
+                if(!log)
+                    fatalError("failed to create temporary file");
+
+                std::fflush(nullptr);
+                const pid_t pid = fork();
+                if(pid < 0)
+                    fatalError(std::string("fork failed: ") + std::strerror(errno));
+
+                if(pid == 0)
+                {
+                    // Child: redirect the terminal output to the log
+                    dup2(fileno(log), STDOUT_FILENO);
+                    dup2(fileno(log), STDERR_FILENO);
+                    runBatchJob(namelist, solverName, archiveType, output, !cl.has("no-output"),
+                                slotCpus[freeSlots.back()]);
+                }
+
+                running[pid] = Job{runIdx, freeSlots.back(), log, timer};
+                freeSlots.pop_back();
+                continue;
+            }
+
+            // Wait for any simulation to finish
+            int status = 0;
+            const pid_t pid = waitpid(-1, &status, 0);
+            if(pid < 0)
+                fatalError(std::string("waitpid failed: ") + std::strerror(errno));
+
+            auto it = running.find(pid);
+            if(it == running.end())
+                continue;
+
+            Job& job = it->second;
+            BatchRun& run = runs[job.run];
+            run.time = job.timer.stop();
+
+            if(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS)
+                run.status = "ok";
+            else if(WIFSIGNALED(status))
+            {
+                run.status = "crashed";
+                run.message = (boost::format("killed by signal %i (%s)") % WTERMSIG(status)
+                               % strsignal(WTERMSIG(status))).str();
+            }
             else
-                solver =  SolverFactory::create("cpu", namelist, archiveType);
+            {
+                run.status = "failed";
+                run.message = lastErrorMessage(job.log);
+            }
+
+            if(run.status != "ok")
+                run.output.clear();
+
+            std::fclose(job.log);
+            freeSlots.push_back(job.slot);
+            running.erase(it);
+            finish(run);
+        }
+
+        pbar.pause();
+        if(!LOG().isDisabled())
+            Progressbar::printBar('=');
+
+        // Summary of the batch
+        if(cl.has("summary"))
+        {
+            std::ofstream fout(cl.as<std::string>("summary"));
+            if(!fout.is_open())
+                fatalError("failed to open file: " + cl.as<std::string>("summary"));
+            printSummary(fout, runs);
+        }
+        else
+            printSummary(std::cout, runs);
+
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+#else
+        fatalError("--jobs is not supported on this platform");
+#endif
+    }
+
+    // Run the simulation of the NameList (continued from the checkpoint if given), verify it and write the output
+    auto simulate = [&](const Checkpoint* checkpoint) {
+        try
+        {
+            solver = SolverFactory::create(solverName, namelist, archiveType);
+            solver->init();
+            if(checkpoint)
+                solver->restart(*checkpoint);
+
+            // Run simulation
+            solver->run();
         }
         catch(const std::exception& e)
         {
             fatalError(e.what());
         }
 
-        // Run simulation
-        solver->init();
-        solver->run();
+        // Report the deviation from the double precision cpu implementation
+        if(cl.has("verify"))
+        {
+            try
+            {
+                // The reference doesn't overwrite the checkpoints nor the streamed output of the simulation
+                auto referenceNameList = std::make_shared<NameList>(*namelist);
+                referenceNameList->icheckpoint = 0;
+
+                auto reference = SolverFactory::create("cpu", referenceNameList);
+                reference->init();
+                reference->run();
+                Deviation::print(std::cout, Deviation::compute(*solver, *reference));
+            }
+            catch(const std::exception& e)
+            {
+                fatalError(e.what());
+            }
+        }
 
         // Write simulation to outputfile
         try
@@ -137,6 +557,45 @@ int main(int argc, char* argv[])
         {
             fatalError(e.what());
         }
+    };
+
+    if(cl.has("restart"))
+    {
+        // Read the checkpoint and apply the namelist overrides to its NameList (e.g to extend the integration time)
+        std::shared_ptr<Checkpoint> checkpoint;
+        try
+        {
+            checkpoint = std::make_shared<Checkpoint>(cl.as<std::string>("restart"));
+            namelist = checkpoint->getNameList();
+
+            if(cl.has("print-namelist"))
+                namelist->print(std::cout);
+
+            for(const auto& line : namelistJit)
+                parser.parseSingleLine(namelist, line);
+        }
+        catch(const std::exception& e)
+        {
+            fatalError(e.what());
+        }
+
+        simulate(checkpoint.get());
+        return 0;
+    }
+
+    for(const auto& file : files)
+    {
+        // Parse the input file
+        try
+        {
+            parseNameList(file);
+        }
+        catch(const std::exception& e)
+        {
+            fatalError(e.what());
+        }
+
+        simulate(nullptr);
     }
 
     return 0;
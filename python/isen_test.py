@@ -109,6 +109,33 @@ class TestSolver(unittest.TestCase):
         finally:
             os.remove(tfile)  
 
+    def test_restart(self):
+        """Test restarting from a checkpoint"""
+        namelist = IsenPython.NameList()
+        namelist.nx = 20
+        namelist.nz = 10
+        namelist.time = 300
+        namelist.icheckpoint = 20
+        namelist.run_name = "__temporary_checkpoint__"
+        
+        self.solver.init(namelist)
+        self.solver.run()
+        
+        tfile = namelist.run_name + ".ckpt"
+        try:
+            solver = IsenPython.Solver()
+            solver.restart(tfile)
+            solver.run()
+            self.assertTrue(np.array_equal(solver.getField("unow"), self.solver.getField("unow")))
+            self.assertTrue(np.array_equal(solver.getField("snow"), self.solver.getField("snow")))
+        except RuntimeError as e:
+            self.fail("IsenException caught: \"{0}\"".format(e.message))
+        finally:
+            os.remove(tfile)
+            
+        with self.assertRaises(RuntimeError):
+            self.solver.restart("not-a-checkpoint")
+
 ## Output
 class TestOutput(unittest.TestCase):
     """Test PyOutput"""
@@ -150,24 +177,53 @@ class TestOutput(unittest.TestCase):
         """Test serialization/deserialization"""
         for archive in [IsenPython.ArchiveType.Text, 
                         IsenPython.ArchiveType.Xml, 
-                        IsenPython.ArchiveType.Binary]:
+                        IsenPython.ArchiveType.Binary,
+                        IsenPython.ArchiveType.Mapped,
+                        IsenPython.ArchiveType.Chunked]:
             tfile = "__temporary_output_file__"
             try:
                 if archive == IsenPython.ArchiveType.Text:
                     tfile += ".txt"
                 elif archive == IsenPython.ArchiveType.Xml:
                     tfile += ".xml"
+                elif archive == IsenPython.ArchiveType.Mapped:
+                    tfile += ".imap"
+                elif archive == IsenPython.ArchiveType.Chunked:
+                    tfile += ".ichk"
                 else:
                     tfile += ".bin"        
             
                 self.solver.write(archive, tfile)
                 output = IsenPython.Output()
                 output.read(tfile)
+                self.assertTrue(output.frame("z", 0).shape == (self.namelist.nx, self.namelist.nz + 1))
+                self.assertEqual(output.errorBound("u"), 0.0)
             except RuntimeError as e:
                 self.fail("IsenException caught: \"{0}\"".format(e.message))
             finally:
                 os.remove(tfile)   
 
+    def test_selection(self):
+        """Test output of the selected fields within the output window"""
+        namelist = IsenPython.NameList()
+        namelist.nx = 5
+        namelist.nz = 5
+        namelist.out_fields = "u:s"
+        namelist.out_xmin = 1
+        namelist.out_xstride = 2
+        namelist.out_zmax = 3
+        try:
+            solver = IsenPython.Solver()
+            solver.init(namelist)
+            output = solver.getOutput()
+            self.assertTrue(output.u().shape[1:] == (2, 3))
+            self.assertTrue(output.s().shape[1:] == (2, 3))
+        except RuntimeError as e:
+            self.fail("IsenException caught: \"{0}\"".format(e.message))
+
+        with self.assertRaises(RuntimeError):
+            output.z()
+
 ## NameList
 class TestNameList(unittest.TestCase):
     """Test PyNameList"""
@@ -206,6 +262,11 @@ class TestNameList(unittest.TestCase):
         self.assertTrue(hasattr(namelist, 'time'))
         self.assertTrue(hasattr(namelist, 'dt'))
         self.assertTrue(hasattr(namelist, 'diff'))
+        self.assertTrue(hasattr(namelist, 'iadapt'))
+        self.assertTrue(hasattr(namelist, 'cfl_target'))
+        self.assertTrue(hasattr(namelist, 'dt_grow'))
+        self.assertTrue(hasattr(namelist, 'dt_shrink'))
+        self.assertTrue(hasattr(namelist, 'dt_max'))
         self.assertTrue(hasattr(namelist, 'topomx'))
         self.assertTrue(hasattr(namelist, 'topowd'))
         self.assertTrue(hasattr(namelist, 'topotim'))
@@ -231,6 +292,10 @@ class TestNameList(unittest.TestCase):
         self.assertTrue(hasattr(namelist, 'autoconv_th'))
         self.assertTrue(hasattr(namelist, 'autoconv_mult'))
         self.assertTrue(hasattr(namelist, 'sediment_on'))
+        self.assertTrue(hasattr(namelist, 'sediment_col'))
+        self.assertTrue(hasattr(namelist, 'tblock'))
+        self.assertTrue(hasattr(namelist, 'imixprec'))
+        self.assertTrue(hasattr(namelist, 'imath'))
 
 if __name__ == "__main__":
     IsenPython.Logger().disable()
@@ -0,0 +1,38 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_TEST_NAMELIST_FACTORY_H
+#define ISEN_TEST_NAMELIST_FACTORY_H
+
+#include <Isen/Common.h>
+#include <Isen/NameList.h>
+#include <memory>
+
+ISEN_NAMESPACE_BEGIN
+
+/// NameList used for the cross verification (moist simulation with Kessler microphysics)
+inline std::shared_ptr<NameList> crossVerificationNameList()
+{
+    auto namelist = std::make_shared<NameList>();
+    namelist->setByName("time", 1500.0); // 10 timesteps
+    namelist->setByName("imoist", true);
+    namelist->setByName("imoist_diff", true);
+    namelist->setByName("imicrophys", 1); // Kessler
+    namelist->setByName("iprtcfl", false);
+    return namelist;
+}
+
+ISEN_NAMESPACE_END
+
+#endif
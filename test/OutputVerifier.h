@@ -0,0 +1,56 @@
+/**
+ *                       _________ _______   __
+ *                      /  _/ ___// ____/ | / /
+ *                      / / \__ \/ __/ /  |/ /
+ *                    _/ / ___/ / /___/ /|  /
+ *                   /___//____/_____/_/ |_/
+ *
+ *  Isentropic model - ETH Zurich
+ *  Copyright (C) 2016  Fabian Thuering (thfabian@student.ethz.ch)
+ *
+ *  This file is distributed under the MIT Open Source License. See LICENSE.TXT for details.
+ */
+
+#pragma once
+#ifndef ISEN_TEST_OUTPUT_VERIFIER_H
+#define ISEN_TEST_OUTPUT_VERIFIER_H
+
+#include <Isen/Common.h>
+#include <Isen/Output.h>
+#include <iostream>
+#include <vector>
+
+ISEN_NAMESPACE_BEGIN
+
+class OutputVerifier
+{
+public:
+    /// Check that all fields of @c test are equal to the fields of the reference output @c ref
+    static bool verify(const Output& test, const Output& ref, const bool verbose = true)
+    {
+        bool passed = true;
+        auto verifyField = [&](const char* name, const std::vector<double>& testField,
+                               const std::vector<double>& refField) {
+            if(testField == refField)
+                return;
+            passed = false;
+            if(verbose)
+                std::cerr << "\nThe output field '" << name << "' differs from the reference field." << std::endl;
+        };
+
+        verifyField("t", test.t(), ref.t());
+        verifyField("z", test.z(), ref.z());
+        verifyField("u", test.u(), ref.u());
+        verifyField("s", test.s(), ref.s());
+        verifyField("prec", test.prec(), ref.prec());
+        verifyField("tot_prec", test.tot_prec(), ref.tot_prec());
+        verifyField("qv", test.qv(), ref.qv());
+        verifyField("qc", test.qc(), ref.qc());
+        verifyField("qr", test.qr(), ref.qr());
+        return passed;
+    }
+};
+
+ISEN_NAMESPACE_END
+
+#endif
@@ -13,16 +13,30 @@
 
 #include "Test.h"
 #include "FileProxy.h"
+#include "NameListFactory.h"
+#include "OutputVerifier.h"
+#include <Isen/Checkpoint.h>
+#include <Isen/Compression.h>
+#include <Isen/Encoding.h>
+#include <Isen/Logger.h>
 #include <Isen/Output.h>
+#include <Isen/SolverFactory.h>
 #include <boost/archive/binary_iarchive.hpp>
 #include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/xml_iarchive.hpp>
 #include <boost/archive/xml_oarchive.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/serialization/shared_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <iterator>
+#include <limits>
+#include <map>
 
 ISEN_NAMESPACE_BEGIN
 
@@ -215,4 +229,543 @@ TEST_CASE("Namelist serialize/unserialize", "[Output]")
     }
 }
 
+TEST_CASE("Lossy encoding", "[Output]")
+{
+    // Smooth chunk of 5 frames of 9 x 7 values (incomplete transform blocks at the boundary)
+    const std::size_t numFrames = 5, rows = 9, cols = 7, n = numFrames * rows * cols;
+    std::vector<double> data(n);
+    for(std::size_t m = 0; m < numFrames; ++m)
+        for(std::size_t i = 0; i < rows; ++i)
+            for(std::size_t k = 0; k < cols; ++k)
+                data[(m * rows + i) * cols + k] = 10.0 * std::sin(0.3 * i + 0.1 * m) * std::exp(-0.2 * k) - 3.0;
+
+    const CompressionCodec codec = Compression::fromString("auto");
+    const double bound = 1e-3;
+
+    std::vector<char> out;
+    Encoding::encode(codec, EncodingMode::Lossless, bound, data.data(), numFrames, rows, cols, out);
+    const std::size_t losslessSize = out.size();
+
+    for(EncodingMode mode : {EncodingMode::Float32, EncodingMode::Float16, EncodingMode::Fixed, EncodingMode::Delta,
+                             EncodingMode::Transform})
+    {
+        INFO("encoding: " << Encoding::toString(mode));
+        CHECK(Encoding::fromString(Encoding::toString(mode)) == mode);
+
+        // Half precision can't represent the values within the bound
+        const EncodingMode used = Encoding::encode(codec, mode, bound, data.data(), numFrames, rows, cols, out);
+        CHECK(used == (mode == EncodingMode::Float16 ? EncodingMode::Lossless : mode));
+
+        std::vector<double> decoded(n);
+        Encoding::decode(codec, used, bound, out.data(), out.size(), decoded.data(), numFrames, rows, cols);
+
+        double maxError = 0.0;
+        for(std::size_t i = 0; i < n; ++i)
+            maxError = std::max(maxError, std::fabs(decoded[i] - data[i]));
+        CHECK(maxError <= bound);
+        if(used != EncodingMode::Lossless && codec != CompressionCodec::None)
+            CHECK(out.size() < losslessSize);
+
+        // Without a bound the values are stored exactly
+        CHECK(Encoding::encode(codec, mode, 0.0, data.data(), numFrames, rows, cols, out) == EncodingMode::Lossless);
+    }
+
+    // Half precision within a larger bound
+    CHECK(Encoding::encode(codec, EncodingMode::Float16, 0.01, data.data(), numFrames, rows, cols, out)
+          == EncodingMode::Float16);
+
+    // Values which can't be quantized are stored losslessly
+    data[7] = std::numeric_limits<double>::quiet_NaN();
+    CHECK(Encoding::encode(codec, EncodingMode::Fixed, bound, data.data(), numFrames, rows, cols, out)
+          == EncodingMode::Lossless);
+    data[7] = 1e300;
+    CHECK(Encoding::encode(codec, EncodingMode::Transform, bound, data.data(), numFrames, rows, cols, out)
+          == EncodingMode::Lossless);
+    CHECK(Encoding::encode(codec, EncodingMode::Float32, bound, data.data(), numFrames, rows, cols, out)
+          == EncodingMode::Lossless);
+
+    std::vector<double> decoded(n);
+    Encoding::decode(codec, EncodingMode::Lossless, bound, out.data(), out.size(), decoded.data(), numFrames, rows,
+                     cols);
+    CHECK(decoded == data);
+
+    CHECK_THROWS_AS(Encoding::fromString("zfp"), IsenException);
+}
+
+TEST_CASE("Stream output", "[Output]")
+{
+    auto namelist = crossVerificationNameList();
+    namelist->setByName("iout", 25);
+    namelist->setByName("run_name", std::string("__stream__"));
+    boost::filesystem::remove("__stream__.isen");
+
+    LOG() << logger::disable;
+    std::shared_ptr<Solver> solverRef = SolverFactory::create("cpu", namelist);
+    solverRef->init();
+    solverRef->run();
+    const Output& outputRef = *solverRef->getOutput();
+
+    // The frames are written during the simulation and not kept in memory
+    auto namelistStream = std::make_shared<NameList>(*namelist);
+    namelistStream->setByName("icheckpoint", 60);
+    std::shared_ptr<Solver> solver = SolverFactory::create("cpu", namelistStream, Output::Stream);
+    solver->init();
+    solver->run();
+    CHECK(solver->getOutput()->z().empty());
+
+    // The file can be read before it is closed (a frame in flight is skipped)
+    {
+        Output output;
+        output.read("__stream__.isen");
+        REQUIRE(output.t().size() <= outputRef.t().size());
+        CHECK(std::equal(output.t().begin(), output.t().end(), outputRef.t().begin()));
+        CHECK(std::equal(output.z().begin(), output.z().end(), outputRef.z().begin()));
+    }
+
+    solver->write();
+    {
+        Output output;
+        output.read("__stream__.isen");
+        CHECK(output.getNameList()->nx == namelist->nx);
+        CHECK(OutputVerifier::verify(output, outputRef));
+    }
+
+    // A restarted simulation truncates the stream to the frames of the checkpoint and continues it
+    Checkpoint checkpoint("__stream__.ckpt");
+    boost::filesystem::remove("__stream__.ckpt");
+    std::shared_ptr<Solver> solverRestart = SolverFactory::create("cpu", checkpoint.getNameList(), Output::Stream);
+    solverRestart->init();
+    solverRestart->restart(checkpoint);
+    solverRestart->run();
+    solverRestart->write();
+    boost::filesystem::remove("__stream__.ckpt");
+    {
+        // The stream opened by the initial output of the restarted simulation is discarded
+        int numStreams = 0;
+        for(boost::filesystem::directory_iterator it("."), end; it != end; ++it)
+            numStreams += it->path().filename().string().compare(0, 10, "__stream__") == 0;
+        CHECK(numStreams == 1);
+    }
+    {
+        Output output;
+        output.read("__stream__.isen");
+        CHECK(OutputVerifier::verify(output, outputRef));
+    }
+
+    // Streamed and in-memory output can't be mixed
+    std::shared_ptr<Solver> solverText = SolverFactory::create("cpu", checkpoint.getNameList());
+    solverText->init();
+    CHECK_THROWS_AS(solverText->restart(checkpoint), IsenException);
+
+    // In-memory output converted to a stream archive
+    solverRef->getOutput()->setArchiveType(Output::Stream);
+    solverRef->write("__stream_ref__.isen");
+    {
+        Output output;
+        output.read("__stream_ref__.isen");
+        CHECK(OutputVerifier::verify(output, outputRef));
+    }
+
+    boost::filesystem::remove("__stream__.isen");
+    boost::filesystem::remove("__stream_ref__.isen");
+    CHECK_THROWS_AS(Output().read("__stream__.isen"), IsenException);
+    LOG() << logger::enable;
+}
+
+TEST_CASE("Mapped output", "[Output]")
+{
+    auto namelist = crossVerificationNameList();
+    namelist->setByName("iout", 25);
+
+    LOG() << logger::disable;
+    std::shared_ptr<Solver> solver = SolverFactory::create("cpu", namelist);
+    solver->init();
+    solver->run();
+    const Output& outputRef = *solver->getOutput();
+
+    solver->getOutput()->setArchiveType(Output::Mapped);
+    solver->write("__mapped__.imap");
+
+    Output output;
+    output.read("__mapped__.imap");
+    REQUIRE(output.numFrames() == outputRef.numFrames());
+    CHECK(output.getNameList()->nx == namelist->nx);
+
+    // Single frames are accessed in place
+    const int nx = namelist->nx, nz = namelist->nz;
+    for(int n = 0; n < output.numFrames(); ++n)
+    {
+        CHECK(output.time(n) == outputRef.time(n));
+        for(const char* name : {"z", "u", "s", "prec", "qv", "qr"})
+        {
+            const std::size_t size = output.frameSize(name);
+            INFO("field: " << name << ", frame: " << n);
+            CHECK(size == outputRef.frameSize(name));
+            CHECK(std::equal(output.frame(name, n), output.frame(name, n) + size, outputRef.frame(name, n)));
+        }
+    }
+    CHECK(output.frameSize("u") == std::size_t(nx * nz));
+    CHECK(reinterpret_cast<std::uintptr_t>(output.frame("u", 1)) % 64 == 0);
+    CHECK_THROWS_AS(output.frame("w", 0), IsenException);
+    CHECK_THROWS_AS(output.frame("u", output.numFrames()), IsenException);
+
+    // Whole fields are copied on first access
+    CHECK(output.t() == outputRef.t());
+    CHECK(output.z() == outputRef.z());
+    CHECK(output.u() == outputRef.u());
+    CHECK(output.s() == outputRef.s());
+    CHECK(output.tot_prec() == outputRef.tot_prec());
+    CHECK(output.qc() == outputRef.qc());
+
+    // Conversion to another archive
+    output.setArchiveType(Output::Binary);
+    output.write("__mapped__.bin");
+    Output outputBinary;
+    outputBinary.read("__mapped__.bin");
+    CHECK(outputBinary.qv() == outputRef.qv());
+    boost::filesystem::remove("__mapped__.bin");
+
+    boost::filesystem::rename("__mapped__.imap", "__mapped__.isen");
+    CHECK_THROWS_AS(Output().read("__mapped__.isen"), IsenException);
+    boost::filesystem::rename("__mapped__.isen", "__mapped__.imap");
+    {
+        std::ofstream fout("__mapped__.imap", std::ios::binary);
+        fout << "ISENIMAP";
+    }
+    CHECK_THROWS_AS(Output().read("__mapped__.imap"), IsenException);
+    boost::filesystem::remove("__mapped__.imap");
+    CHECK_THROWS_AS(Output().read("__mapped__.imap"), IsenException);
+    LOG() << logger::enable;
+}
+
+TEST_CASE("Chunked output", "[Output]")
+{
+    auto namelist = crossVerificationNameList();
+    namelist->setByName("iout", 25);
+    namelist->setByName("run_name", std::string("__chunked__"));
+    namelist->setByName("chunk_nt", 3);
+    namelist->setByName("chunk_nx", 16);
+    boost::filesystem::remove("__chunked__.ichk");
+
+    LOG() << logger::disable;
+    std::shared_ptr<Solver> solverRef = SolverFactory::create("cpu", namelist);
+    solverRef->init();
+    solverRef->run();
+    const Output& outputRef = *solverRef->getOutput();
+
+    // The chunks are compressed during the simulation, all codecs are lossless
+    for(CompressionCodec codec :
+        {CompressionCodec::None, CompressionCodec::Zlib, CompressionCodec::Lz4, CompressionCodec::Zstd})
+    {
+        const std::string codecName = Compression::toString(codec);
+        INFO("codec: " << codecName);
+        if(!Compression::isAvailable(codec))
+        {
+            CHECK_THROWS_AS(Compression::fromString(codecName), IsenException);
+            continue;
+        }
+
+        auto namelistChunked = std::make_shared<NameList>(*namelist);
+        namelistChunked->setByName("compression", codecName);
+        std::shared_ptr<Solver> solver = SolverFactory::create("cpu", namelistChunked, Output::Chunked);
+        solver->init();
+        solver->run();
+        CHECK(solver->getOutput()->z().empty());
+
+        // The chunks written so far can be read before the file is closed
+        {
+            Output output;
+            output.read("__chunked__.ichk");
+            REQUIRE(output.numFrames() <= outputRef.numFrames());
+            if(output.numFrames() > 0)
+                CHECK(std::equal(output.frame("u", 0), output.frame("u", 0) + output.frameSize("u"),
+                                 outputRef.frame("u", 0)));
+        }
+
+        solver->write();
+
+        OutputStoreReader reader("__chunked__.ichk");
+        CHECK(reader.codec() == codec);
+        CHECK(reader.chunks().size() > std::size_t(outputRef.numFrames() / 3));
+
+        std::size_t rawSize = outputRef.numFrames() * sizeof(double);
+        for(const char* name : {"z", "u", "s", "prec", "tot_prec", "qv", "qc", "qr"})
+            rawSize += outputRef.frameSize(name) * outputRef.numFrames() * sizeof(double);
+        if(codec != CompressionCodec::None)
+            CHECK(boost::filesystem::file_size("__chunked__.ichk") < rawSize);
+
+        Output output;
+        output.read("__chunked__.ichk");
+        REQUIRE(output.numFrames() == outputRef.numFrames());
+        CHECK(output.getNameList()->nx == namelist->nx);
+
+        // Single frames are decompressed chunk by chunk
+        for(int n = output.numFrames() - 1; n >= 0; --n)
+        {
+            CHECK(output.time(n) == outputRef.time(n));
+            for(const char* name : {"z", "u", "s", "tot_prec", "qv"})
+            {
+                const std::size_t size = output.frameSize(name);
+                INFO("field: " << name << ", frame: " << n);
+                REQUIRE(size == outputRef.frameSize(name));
+                CHECK(std::equal(output.frame(name, n), output.frame(name, n) + size, outputRef.frame(name, n)));
+            }
+        }
+        CHECK_THROWS_AS(output.frame("w", 0), IsenException);
+        CHECK_THROWS_AS(output.frame("u", output.numFrames()), IsenException);
+        CHECK(OutputVerifier::verify(output, outputRef));
+        boost::filesystem::remove("__chunked__.ichk");
+    }
+
+    // A restarted simulation truncates the archive to the chunks of the checkpoint and continues it
+    auto namelistChunked = std::make_shared<NameList>(*namelist);
+    namelistChunked->setByName("icheckpoint", 60);
+    std::shared_ptr<Solver> solver = SolverFactory::create("cpu", namelistChunked, Output::Chunked);
+    solver->init();
+    solver->run();
+    solver->write();
+
+    Checkpoint checkpoint("__chunked__.ckpt");
+    boost::filesystem::remove("__chunked__.ckpt");
+    std::shared_ptr<Solver> solverRestart = SolverFactory::create("cpu", checkpoint.getNameList(), Output::Chunked);
+    solverRestart->init();
+    solverRestart->restart(checkpoint);
+    solverRestart->run();
+    solverRestart->write();
+    boost::filesystem::remove("__chunked__.ckpt");
+    {
+        Output output;
+        output.read("__chunked__.ichk");
+        CHECK(OutputVerifier::verify(output, outputRef));
+    }
+
+    // The checkpoint refers to a chunked archive
+    std::shared_ptr<Solver> solverStream = SolverFactory::create("cpu", checkpoint.getNameList(), Output::Stream);
+    solverStream->init();
+    CHECK_THROWS_AS(solverStream->restart(checkpoint), IsenException);
+
+    // In-memory output converted to a chunked archive
+    solverRef->getOutput()->setArchiveType(Output::Chunked);
+    solverRef->write("__chunked_ref__.ichk");
+    {
+        Output output;
+        output.read("__chunked_ref__.ichk");
+        CHECK(OutputVerifier::verify(output, outputRef));
+    }
+
+    namelistChunked->setByName("compression", std::string("gzip"));
+    CHECK_THROWS_AS(SolverFactory::create("cpu", namelistChunked, Output::Chunked), IsenException);
+
+    boost::filesystem::remove("__chunked__.ichk");
+    boost::filesystem::remove("__chunked_ref__.ichk");
+    {
+        std::ofstream fout("__chunked__.ichk", std::ios::binary);
+        fout << "ISENCHNK";
+    }
+    CHECK_THROWS_AS(Output().read("__chunked__.ichk"), IsenException);
+    boost::filesystem::remove("__chunked__.ichk");
+    CHECK_THROWS_AS(Output().read("__chunked__.ichk"), IsenException);
+    LOG() << logger::enable;
+}
+
+TEST_CASE("Lossy output", "[Output]")
+{
+    auto namelist = crossVerificationNameList();
+    namelist->setByName("iout", 25);
+    namelist->setByName("run_name", std::string("__lossy__"));
+    boost::filesystem::remove("__lossy__.ichk");
+
+    LOG() << logger::disable;
+    std::shared_ptr<Solver> solverRef = SolverFactory::create("cpu", namelist);
+    solverRef->init();
+    solverRef->run();
+    const Output& outputRef = *solverRef->getOutput();
+
+    // Error bounds relative to the magnitude of the fields
+    auto maxAbs = [](const std::vector<double>& field) {
+        double value = 0.0;
+        for(double x : field)
+            value = std::max(value, std::fabs(x));
+        return value;
+    };
+    std::map<std::string, double> tolerances{{"z", 1e-4 * maxAbs(outputRef.z())},
+                                             {"u", 1e-4 * maxAbs(outputRef.u())},
+                                             {"s", 1e-4 * maxAbs(outputRef.s())},
+                                             {"qv", 1e-4 * maxAbs(outputRef.qv())}};
+    for(const auto& tolerance : tolerances)
+        namelist->setByName("tol_" + tolerance.first, tolerance.second);
+
+    std::uintmax_t losslessSize = 0;
+    for(const char* encoding : {"lossless", "float32", "float16", "fixed", "delta", "transform"})
+    {
+        INFO("encoding: " << encoding);
+        auto namelistLossy = std::make_shared<NameList>(*namelist);
+        namelistLossy->setByName("encoding", std::string(encoding));
+        std::shared_ptr<Solver> solver = SolverFactory::create("cpu", namelistLossy, Output::Chunked);
+        solver->init();
+        solver->run();
+        solver->write();
+
+        const std::uintmax_t size = boost::filesystem::file_size("__lossy__.ichk");
+        if(std::strcmp(encoding, "lossless") == 0)
+            losslessSize = size;
+        else if(std::strcmp(encoding, "float16") != 0 && Compression::fromString("auto") != CompressionCodec::None)
+            CHECK(size < losslessSize);
+
+        // The reader reports the guaranteed bound, which holds for every value
+        Output output;
+        output.read("__lossy__.ichk");
+        REQUIRE(output.numFrames() == outputRef.numFrames());
+        for(const char* name : {"z", "u", "s", "qv", "qc", "tot_prec"})
+        {
+            INFO("field: " << name);
+            const double bound = output.errorBound(name);
+            if(std::strcmp(encoding, "lossless") == 0 || !tolerances.count(name))
+                CHECK(bound == 0.0);
+            else
+                CHECK(bound == tolerances[name]);
+
+            const std::size_t frameSize = output.frameSize(name);
+            double maxError = 0.0;
+            for(int n = 0; n < output.numFrames(); ++n)
+                for(std::size_t i = 0; i < frameSize; ++i)
+                    maxError = std::max(maxError, std::fabs(output.frame(name, n)[i] - outputRef.frame(name, n)[i]));
+            CHECK(maxError <= bound);
+        }
+        CHECK(output.t() == outputRef.t());
+        CHECK(outputRef.errorBound("u") == 0.0);
+        boost::filesystem::remove("__lossy__.ichk");
+    }
+
+    namelist->setByName("encoding", std::string("zfp"));
+    CHECK_THROWS_AS(SolverFactory::create("cpu", namelist, Output::Chunked), IsenException);
+    LOG() << logger::enable;
+}
+
+TEST_CASE("Selective output", "[Output]")
+{
+    auto namelist = crossVerificationNameList();
+    namelist->setByName("iout", 5);
+    namelist->setByName("run_name", std::string("__selective__"));
+
+    LOG() << logger::disable;
+    std::shared_ptr<Solver> solverRef = SolverFactory::create("cpu", namelist);
+    solverRef->init();
+    solverRef->run();
+    const Output& outputRef = *solverRef->getOutput();
+
+    // The last frame holds the fields of the solver (transposed, the velocity averaged to the cell centers)
+    const int nx = namelist->nx;
+    const int nz = namelist->nz;
+    const int nb = namelist->nb;
+    const int last = outputRef.numFrames() - 1;
+    for(int i = 0; i < nx; ++i)
+    {
+        for(int k = 0; k < nz; ++k)
+        {
+            REQUIRE(outputRef.frame("z", last)[i * (nz + 1) + k] == solverRef->getMat("zhtnow")(i + nb, k));
+            REQUIRE(outputRef.frame("u", last)[i * nz + k]
+                    == 0.5 * (solverRef->getMat("unow")(i, k) + solverRef->getMat("unow")(i + 1, k)));
+            REQUIRE(outputRef.frame("s", last)[i * nz + k] == solverRef->getMat("snow")(i + nb, k));
+            REQUIRE(outputRef.frame("qr", last)[i * nz + k] == solverRef->getMat("qrnow")(i + nb, k));
+        }
+        REQUIRE(outputRef.frame("z", last)[i * (nz + 1) + nz] == solverRef->getMat("zhtnow")(i + nb, nz));
+        REQUIRE(outputRef.frame("prec", last)[i] == solverRef->getVec("prec")(i + nb));
+    }
+
+    // Every second column of [10, nx - 5) and every third level of [2, nz - 1)
+    const int xmin = 10, xstride = 2, zmin = 2, zstride = 3;
+    auto namelistSel = std::make_shared<NameList>(*namelist);
+    namelistSel->setByName("out_fields", std::string("z:u,tot_prec"));
+    namelistSel->setByName("out_xmin", xmin);
+    namelistSel->setByName("out_xmax", nx - 5);
+    namelistSel->setByName("out_xstride", xstride);
+    namelistSel->setByName("out_zmin", zmin);
+    namelistSel->setByName("out_zmax", nz - 1);
+    namelistSel->setByName("out_zstride", zstride);
+
+    const int nxOut = (nx - 5 - xmin + xstride - 1) / xstride;
+    const int nzOut = (nz - 1 - zmin + zstride - 1) / zstride;
+
+    for(Output::ArchiveType archiveType : {Output::Binary, Output::Stream, Output::Chunked})
+    {
+        const std::string filename = "__selective__" + Output::extension(archiveType);
+        INFO("archive: " << filename);
+        boost::filesystem::remove(filename);
+
+        std::shared_ptr<Solver> solver = SolverFactory::create("cpu", namelistSel, archiveType);
+        solver->init();
+        solver->run();
+
+        // Buffers are only allocated for the selected fields
+        if(archiveType == Output::Binary)
+        {
+            CHECK(solver->getOutput()->u().size() == std::size_t(outputRef.numFrames() * nxOut * nzOut));
+            CHECK(solver->getOutput()->s().empty());
+            CHECK(solver->getOutput()->qv().empty());
+        }
+        solver->write(filename);
+
+        Output output;
+        output.read(filename);
+        REQUIRE(output.numFrames() == outputRef.numFrames());
+        CHECK(output.t() == outputRef.t());
+        CHECK(output.has("z"));
+        CHECK(output.has("u"));
+        CHECK(output.has("tot_prec"));
+        CHECK_FALSE(output.has("s"));
+        CHECK_FALSE(output.has("prec"));
+        CHECK(output.s().empty());
+        CHECK_THROWS_AS(output.frame("qv", 0), IsenException);
+
+        CHECK(output.frameNx() == nxOut);
+        CHECK(output.frameNz("u") == nzOut);
+        CHECK(output.frameNz("z") == nzOut + 1);
+        CHECK(output.frameNz("tot_prec") == 0);
+
+        for(int n = 0; n < output.numFrames(); ++n)
+        {
+            for(const char* name : {"z", "u"})
+            {
+                const int levels = output.frameNz(name);
+                const int levelsRef = outputRef.frameNz(name);
+                const double* frame = output.frame(name, n);
+                const double* frameRef = outputRef.frame(name, n);
+                for(int i = 0; i < nxOut; ++i)
+                    for(int k = 0; k < levels; ++k)
+                        REQUIRE(frame[i * levels + k]
+                                == frameRef[(xmin + i * xstride) * levelsRef + zmin + k * zstride]);
+            }
+
+            const double* frame = output.frame("tot_prec", n);
+            const double* frameRef = outputRef.frame("tot_prec", n);
+            for(int i = 0; i < nxOut; ++i)
+                REQUIRE(frame[i] == frameRef[xmin + i * xstride]);
+        }
+        boost::filesystem::remove(filename);
+    }
+
+    // Invalid selections are rejected before the simulation
+    auto checkInvalid = [&](const std::string& name, int value) {
+        INFO(name << " = " << value);
+        auto namelistInvalid = std::make_shared<NameList>(*namelist);
+        namelistInvalid->setByName(name, value);
+        CHECK_THROWS_AS(SolverFactory::create("cpu", namelistInvalid), IsenException);
+    };
+    checkInvalid("out_xmax", nx + 1);
+    checkInvalid("out_xmin", -1);
+    checkInvalid("out_zmin", nz);
+    checkInvalid("out_xstride", 0);
+    checkInvalid("out_zstride", -2);
+
+    for(const char* fields : {"w", "u:nr", ":"})
+    {
+        INFO("out_fields = " << fields);
+        auto namelistInvalid = std::make_shared<NameList>(*namelist);
+        namelistInvalid->setByName("out_fields", std::string(fields));
+        CHECK_THROWS_AS(SolverFactory::create("cpu", namelistInvalid), IsenException);
+    }
+    LOG() << logger::enable;
+}
+
 ISEN_NAMESPACE_END
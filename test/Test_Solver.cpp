@@ -13,14 +13,32 @@
 
 #include "FieldLoader.h"
 #include "FieldVerifier.h"
+#include "NameListFactory.h"
 #include "Test.h"
+#include <Isen/Boundary.h>
+#include <Isen/Checkpoint.h>
 #include <Isen/Common.h>
+#include <Isen/Decomposition.h>
+#include <Isen/Deviation.h>
+#include <Isen/FastMath.h>
+#include <Isen/KesslerColumn.h>
 #include <Isen/Logger.h>
+#include <Isen/MeteoUtils.h>
+#include <Isen/Numa.h>
 #include <Isen/Parse.h>
 #include <Isen/Progressbar.h>
+#include <Isen/Simd.h>
+#include <Isen/SolverCpuKernel.h>
+#include <Isen/SolverEnsemble.h>
 #include <Isen/SolverFactory.h>
 #include <Isen/Terminal.h>
+#include <Isen/TimeControl.h>
+#include <algorithm>
 #include <boost/filesystem.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 
 ISEN_NAMESPACE_BEGIN
 
@@ -200,58 +218,1283 @@ TEST_CASE("MATLAB verification (Solver)", "[Solver]")
 
 #define CHECK_FIELD_CPU(field) CHECK_FIELD_IMPL(field, solverOpt)
 
-TEST_CASE("Cross verification (SolverCpu)", "[Solver]")
-{    
-    Timer t;         
+/// Run the refrence implementation and the Solver given by @c name and compare the resulting fields
+static void crossVerify(const std::string& name, const std::string& className, std::shared_ptr<NameList> namelist)
+{
+    Timer t;
     LOG() << logger::disable;
-    
-    Progressbar::disableProgressbar = false;        
+
+    Progressbar::disableProgressbar = false;
     Progressbar::printBar('-');
-    std::cout << Terminal::Color(Terminal::Color::getFileColor()) << "SolverCpu verification";
+    std::cout << Terminal::Color(Terminal::Color::getFileColor()) << className << " verification";
     std::cout << " with Solver" << std::endl;
     Progressbar::printBar('-');
-    
-    auto namelist = std::make_shared<NameList>();
-    namelist->setByName("time", 1500.0); // 10 timesteps
-    namelist->setByName("imoist", true);    
-    namelist->setByName("imoist_diff", true);    
-    namelist->setByName("imicrophys", 1); // Kessler    
-    namelist->setByName("iprtcfl", false);    
-    
+
     std::shared_ptr<Solver> solverRef = SolverFactory::create("ref", namelist);
-    std::shared_ptr<Solver> solverOpt = SolverFactory::create("cpu", namelist);
-    
+    std::shared_ptr<Solver> solverOpt = SolverFactory::create(name, namelist);
+
     solverRef->init();
     solverOpt->init();
- 
+
     solverRef->run();
-    solverOpt->run();    
-    LOG() << logger::enable;    
+    solverOpt->run();
+    LOG() << logger::enable;
 
     CHECK_FIELD_CPU(zhtnow);
     CHECK_FIELD_CPU(unow);
     CHECK_FIELD_CPU(snow);
     CHECK_FIELD_CPU(mtg);
-    
+
     if(namelist->imoist)
     {
         CHECK_FIELD_CPU(qvnow);
         CHECK_FIELD_CPU(qcnow);
         CHECK_FIELD_CPU(qrnow);
-        
+
         if(namelist->imicrophys > 0)
         {
             CHECK_FIELD_CPU(prec);
             CHECK_FIELD_CPU(tot_prec);
         }
     }
-    
+
     CHECK_FIELD_CPU(exn);
     CHECK_FIELD_CPU(prs);
 
     CHECK_FIELD_CPU(tau);
 }
 
+TEST_CASE("Cross verification (SolverCpu)", "[Solver]")
+{
+    crossVerify("cpu", "SolverCpu", crossVerificationNameList());
+}
+
+TEST_CASE("Cross verification (SolverFused)", "[Solver]")
+{
+    auto namelist = crossVerificationNameList();
+    crossVerify("fused", "SolverFused", namelist);
+
+    // Relaxation boundaries
+    namelist->setByName("irelax", true);
+    crossVerify("fused", "SolverFused", namelist);
+}
+
+TEST_CASE("Cross verification (SolverBlocked)", "[Solver]")
+{
+    // Temporal blocking only applies to the dry dynamics
+    auto namelist = std::make_shared<NameList>();
+    namelist->setByName("time", 4500.0); // 30 timesteps
+    namelist->setByName("iout", 4);
+    namelist->setByName("iprtcfl", false);
+
+    for(int tblock : {1, 3, 8})
+    {
+        namelist->setByName("tblock", tblock);
+        crossVerify("blocked", "SolverBlocked", namelist);
+    }
+
+    // Moist simulations fall back to SolverCpu
+    crossVerify("blocked", "SolverBlocked", crossVerificationNameList());
+}
+
+TEST_CASE("Cross verification (SolverCpuF32)", "[Solver]")
+{
+    // The single precision results are compared against the double precision SolverCpu (relative to the maximum of
+    // each field)
+    constexpr double maxRelDeviation = 5e-3;
+
+    for(bool irelax : {false, true})
+    {
+        auto namelist = crossVerificationNameList();
+        namelist->setByName("irelax", irelax);
+
+        LOG() << logger::disable;
+        std::shared_ptr<Solver> solverRef = SolverFactory::create("cpu", namelist);
+        std::shared_ptr<Solver> solverF32 = SolverFactory::create("cpu-f32", namelist);
+
+        solverRef->init();
+        solverF32->init();
+
+        solverRef->run();
+        solverF32->run();
+        LOG() << logger::enable;
+
+        auto deviations = Deviation::compute(*solverF32, *solverRef);
+        CHECK(deviations.size() == 11);
+
+        for(const auto& deviation : deviations)
+        {
+            INFO("field: " << deviation.name << ", max rel deviation: " << deviation.maxRel);
+            CHECK(deviation.maxRel < maxRelDeviation);
+            CHECK(deviation.maxAbs > 0.0);
+        }
+    }
+}
+
+TEST_CASE("Cross verification (SolverCpuMixed)", "[Solver]")
+{
+    // Only the old time levels and the Kessler scratch arrays are stored in single precision, the deviation to the
+    // double precision SolverCpu is thus much smaller than the one of SolverCpuF32 (the rounding of the old time levels
+    // yields a maximal relative deviation of 1.1e-5 in the precipitation, see SolverCpuMixed)
+    constexpr double maxRelDeviation = 2e-5;
+
+    for(bool irelax : {false, true})
+    {
+        auto namelist = crossVerificationNameList();
+        namelist->setByName("irelax", irelax);
+
+        LOG() << logger::disable;
+        std::shared_ptr<Solver> solverRef = SolverFactory::create("cpu", namelist);
+
+        // The "cpu" solver switches to mixed precision if requested by the namelist
+        namelist->setByName("imixprec", true);
+        std::shared_ptr<Solver> solverMixed = SolverFactory::create("cpu", namelist);
+        CHECK(std::dynamic_pointer_cast<SolverCpuMixed>(solverMixed) != nullptr);
+
+        solverRef->init();
+        solverMixed->init();
+
+        solverRef->run();
+        solverMixed->run();
+        LOG() << logger::enable;
+
+        auto deviations = Deviation::compute(*solverMixed, *solverRef);
+        CHECK(deviations.size() == 11);
+
+        for(const auto& deviation : deviations)
+        {
+            INFO("field: " << deviation.name << ", max rel deviation: " << deviation.maxRel);
+            CHECK(deviation.maxRel < maxRelDeviation);
+            CHECK(deviation.maxAbs > 0.0);
+        }
+    }
+}
+
+TEST_CASE("Cross verification (SIMD)", "[Solver]")
+{
+    // All instruction sets have to produce bitwise identical results to the scalar kernels
+    const SimdInstructionSet defaultIsa = Simd::get();
+
+    for(bool irelax : {false, true})
+    {
+        auto namelist = crossVerificationNameList();
+        namelist->setByName("irelax", irelax);
+
+        for(const char* name : {"cpu", "cpu-f32"})
+        {
+            LOG() << logger::disable;
+            Simd::set(SimdInstructionSet::Scalar);
+            std::shared_ptr<Solver> solverScalar = SolverFactory::create(name, namelist);
+            solverScalar->init();
+            solverScalar->run();
+
+            for(auto isa : {SimdInstructionSet::SSE42, SimdInstructionSet::AVX2, SimdInstructionSet::AVX512})
+            {
+                if(!Simd::isAvailable(isa))
+                {
+                    CHECK_THROWS_AS(Simd::set(isa), IsenException);
+                    continue;
+                }
+
+                Simd::set(isa);
+                std::shared_ptr<Solver> solverSimd = SolverFactory::create(name, namelist);
+                solverSimd->init();
+                solverSimd->run();
+
+                for(const auto& deviation : Deviation::compute(*solverSimd, *solverScalar))
+                {
+                    INFO("solver: " << name << ", isa: " << Simd::toString(isa) << ", field: " << deviation.name);
+                    CHECK(deviation.maxAbs == 0.0);
+                }
+            }
+            LOG() << logger::enable;
+        }
+    }
+
+    Simd::set(defaultIsa);
+    CHECK(Simd::fromString(Simd::toString(defaultIsa)) == defaultIsa);
+    CHECK_THROWS_AS(Simd::fromString("neon"), IsenException);
+}
+
+TEST_CASE("Cross verification (persistent parallel region)", "[Solver]")
+{
+    // SolverCpu::run executes the same kernels as Solver::run (one parallel region per kernel) within a single
+    // parallel region, the results have to be bitwise identical
+    for(bool imoist : {false, true})
+        for(bool irelax : {false, true})
+        {
+            auto namelist = crossVerificationNameList();
+            namelist->setByName("imoist", imoist);
+            namelist->setByName("irelax", irelax);
+
+            LOG() << logger::disable;
+            std::shared_ptr<Solver> solverForkJoin = SolverFactory::create("cpu", namelist);
+            std::shared_ptr<Solver> solverPersistent = SolverFactory::create("cpu", namelist);
+
+            solverForkJoin->init();
+            solverPersistent->init();
+
+            solverForkJoin->Solver::run();
+            solverPersistent->run();
+            LOG() << logger::enable;
+
+            for(const auto& deviation : Deviation::compute(*solverPersistent, *solverForkJoin))
+            {
+                INFO("imoist: " << imoist << ", irelax: " << irelax << ", field: " << deviation.name);
+                CHECK(deviation.maxAbs == 0.0);
+            }
+        }
+}
+
+TEST_CASE("NUMA placement", "[Solver]")
+{
+    // The placement policy must not change the results
+    const NumaPolicy defaultPolicy = Numa::getPolicy();
+    auto namelist = crossVerificationNameList();
+
+    LOG() << logger::disable;
+    Numa::setPolicy(NumaPolicy::FirstTouch);
+    std::shared_ptr<Solver> solverRef = SolverFactory::create("cpu", namelist);
+    solverRef->init();
+    solverRef->run();
+
+    for(auto policy : {NumaPolicy::Interleave, NumaPolicy::Bind})
+    {
+        if(!Numa::isAvailable(policy))
+        {
+            CHECK_THROWS_AS(Numa::setPolicy(policy), IsenException);
+            continue;
+        }
+
+        Numa::setPolicy(policy);
+        std::shared_ptr<Solver> solver = SolverFactory::create("cpu", namelist);
+        solver->init();
+        solver->run();
+
+        for(const auto& deviation : Deviation::compute(*solver, *solverRef))
+        {
+            INFO("policy: " << Numa::toString(policy) << ", field: " << deviation.name);
+            CHECK(deviation.maxAbs == 0.0);
+        }
+
+        const auto& unow = solver->getMat("unow");
+        CHECK(Numa::describe(unow.data(), sizeof(double) * unow.size()).find(Numa::toString(policy)) == 0);
+    }
+    LOG() << logger::enable;
+
+    // Fields are zero initialized
+    MatrixXf mat;
+    Numa::allocate(mat, 17, 5);
+    CHECK(mat.rows() == 17);
+    CHECK(mat.cols() == 5);
+    CHECK(mat.isZero(0.0));
+
+    Numa::setPolicy(defaultPolicy);
+    CHECK(Numa::fromString(Numa::toString(defaultPolicy)) == defaultPolicy);
+    CHECK_THROWS_AS(Numa::fromString("scatter"), IsenException);
+}
+
+TEST_CASE("Padded fields", "[Solver]")
+{
+    // The leading dimension is an odd number of cache lines
+    for(int rows : {1, 7, 8, 9, 64, 65, 104, 105, 128, 129, 256, 257, 1024})
+    {
+        INFO("rows: " << rows);
+        const int ld = FieldXf::leadingDimension(rows);
+        CHECK(ld >= rows);
+        CHECK(ld % FieldXf::Lanes == 0);
+        CHECK((ld / FieldXf::Lanes) % 2 == 1);
+        CHECK(Field<float>::leadingDimension(rows) % Field<float>::Lanes == 0);
+    }
+
+    // Levels are aligned and zero initialized (including the padding)
+    FieldXf field;
+    Numa::allocate(field, 64, 5);
+    CHECK(field.rows() == 64);
+    CHECK(field.cols() == 5);
+    CHECK(field.ld() == 72);
+    for(int k = 0; k < field.cols(); ++k)
+    {
+        CHECK(reinterpret_cast<std::uintptr_t>(field.data() + k * field.ld()) % FieldXf::Alignment == 0);
+        CHECK(std::all_of(field.data() + k * field.ld(), field.data() + (k + 1) * field.ld(),
+                          [](double value) { return value == 0.0; }));
+    }
+
+    // Element access respects the leading dimension
+    MatrixXf mat = MatrixXf::Random(64, 5);
+    field = mat;
+    CHECK(field == mat);
+    CHECK(field.data()[3 * field.ld() + 7] == mat(7, 3));
+
+    // Swapping exchanges the buffers
+    FieldXf other(17, 2);
+    const double* data = field.data();
+    field.swap(other);
+    CHECK(other.data() == data);
+    CHECK(other == mat);
+    CHECK(field.rows() == 17);
+    CHECK(field.cols() == 2);
+
+    // Boundary conditions of the fields and the matrices coincide
+    const int nx = 60, nb = 2;
+    mat = MatrixXf::Random(nx + 2 * nb, 5);
+    field.resize(nx + 2 * nb, 5);
+    field = mat;
+    Boundary::periodic(mat, nx, nb);
+    Boundary::periodic(field, nx, nb);
+    CHECK(field == mat);
+
+    const VectorXf phi1 = VectorXf::Random(5), phi2 = VectorXf::Random(5);
+    Boundary::relax(mat, nx, nb, phi1, phi2);
+    Boundary::relax(field, nx, nb, phi1, phi2);
+    CHECK(field == mat);
+
+    // Staggered and unstaggered fields share the leading dimension, a power-of-two 'nxb' must not change the results
+    auto namelist = crossVerificationNameList();
+    namelist->setByName("nx", 60);
+    crossVerify("cpu", "SolverCpu", namelist);
+
+    LOG() << logger::disable;
+    std::shared_ptr<Solver> solver = SolverFactory::create("cpu", namelist);
+    solver->init();
+    LOG() << logger::enable;
+    CHECK(solver->getMat("unow").ld() == solver->getMat("snow").ld());
+    CHECK(solver->getMat("zhtnow").ld() == solver->getMat("snow").ld());
+    CHECK(solver->getField("unow").outerStride() == solver->getMat("unow").ld());
+}
+
+TEST_CASE("Tracer field", "[Solver]")
+{
+    // The tracers are blocked, each block is an aligned and zero initialized padded field
+    TracerXf tracers;
+    Numa::allocate(tracers, 5, 64, 3);
+    CHECK(tracers.size() == 5);
+    CHECK(tracers.stride() == 3 * FieldXf::leadingDimension(64));
+    CHECK(tracers.capacity() == std::size_t(5 * tracers.stride()));
+    for(int t = 0; t < tracers.size(); ++t)
+    {
+        CHECK(tracers[t].rows() == 64);
+        CHECK(tracers[t].cols() == 3);
+        CHECK(!tracers[t].isOwner());
+        CHECK(tracers[t].data() == tracers.data() + t * tracers.stride());
+        CHECK(reinterpret_cast<std::uintptr_t>(tracers[t].data()) % FieldXf::Alignment == 0);
+    }
+    CHECK(std::all_of(tracers.data(), tracers.data() + tracers.capacity(), [](double value) { return value == 0.0; }));
+
+    // Swapping exchanges the data but keeps the Fields in place
+    TracerXf other;
+    Numa::allocate(other, 5, 64, 3);
+    const MatrixXf mat = MatrixXf::Random(64, 3);
+    tracers[Tracer::QR] = mat;
+
+    const FieldXf* qr = &tracers[Tracer::QR];
+    const double* data = tracers.data();
+    tracers.swap(other);
+    CHECK(&tracers[Tracer::QR] == qr);
+    CHECK(other.data() == data);
+    CHECK(other[Tracer::QR] == mat);
+    CHECK(tracers[Tracer::QR].isZero());
+
+    // All tracers of the two-moment scheme are advanced by the fused kernel of SolverCpu::run, the results have to be
+    // bitwise identical to Solver::run (one kernel per tracer and method)
+    for(bool irelax : {false, true})
+    {
+        auto namelist = crossVerificationNameList();
+        namelist->setByName("imicrophys", 2);
+        namelist->setByName("irelax", irelax);
+
+        LOG() << logger::disable;
+        std::shared_ptr<Solver> solverForkJoin = SolverFactory::create("cpu", namelist);
+        std::shared_ptr<Solver> solverFused = SolverFactory::create("cpu", namelist);
+
+        solverForkJoin->init();
+        solverFused->init();
+
+        solverForkJoin->Solver::run();
+        solverFused->run();
+        LOG() << logger::enable;
+
+        for(const std::string name : {"qvnow", "qcnow", "qrnow", "ncnow", "nrnow", "ncbnd1", "nrbnd2"})
+        {
+            INFO("irelax: " << irelax << ", field: " << name);
+            CHECK(MatrixXf(solverFused->getField(name)) == MatrixXf(solverForkJoin->getField(name)));
+        }
+        CHECK_THROWS_AS(solverFused->getField("xxbnd1"), IsenException);
+    }
+}
+
+TEST_CASE("Fused column diagnostics", "[Solver]")
+{
+    // kernel_diagColumn has to reproduce the separate diagnostic kernels bitwise for any partitioning of the columns
+    const int nz = 60, nb = 2;
+    const double cp = 1004.0, pref = 100000.0, rdcp = 287.0 / 1004.0, dth = 5.0;
+
+    for(int nx : {1, 13, 60, 301})
+        for(int numThreads : {1, 3})
+        {
+            INFO("nx: " << nx << ", threads: " << numThreads);
+            const int nxb = nx + 2 * nb;
+
+            FieldXf snow(nxb, nz), zht(nxb, nz + 1), zhtFused(nxb, nz + 1);
+            FieldXf prs(nxb, nz + 1), exn(nxb, nz + 1), mtg(nxb, nz);
+            FieldXf prsFused(nxb, nz + 1), exnFused(nxb, nz + 1), mtgFused(nxb, nz);
+            snow = (MatrixXf::Random(nxb, nz).array() + 2.0).matrix();
+
+            const VectorXf topo = 100.0 * (VectorXf::Random(nxb).array() + 1.0).matrix();
+            const VectorXf th0 = VectorXf::LinSpaced(nz + 1, 280.0, 280.0 + nz * dth);
+
+#pragma omp parallel num_threads(numThreads)
+            {
+                kernel_diagPressure<double>(nxb, nz, prs.ld(), prs.data(), snow.data(), 9.81 * dth, 1e4);
+#pragma omp barrier
+                kernel_diagMontgomery_Exner<double>(nx, nz, nb, exn.ld(), exn.data(), prs.data(), cp, pref, rdcp,
+                                                    MathTier::Exact);
+#pragma omp barrier
+                kernel_diagMontgomery_Montgomery<double>(nx, nz, nb, mtg.ld(), mtg.data(), topo.data(), exn.data(),
+                                                         th0(0), cp, dth, 9.81 * 0.5);
+                kernel_geometricHeight<double>(nx, nz, nb, zht.ld(), zht.data(), topo.data(), th0.data(), exn.data(),
+                                               prs.data(), 0.5, 0.5 * 287.0 / cp / 9.81);
+#pragma omp barrier
+                kernel_diagColumn<double>(nx, nz, nb, prsFused.ld(), prsFused.data(), exnFused.data(),
+                                          mtgFused.data(), zhtFused.data(), snow.data(), topo.data(), th0.data(),
+                                          9.81 * dth, 1e4, cp, pref, rdcp, dth, 9.81 * 0.5, 0.5,
+                                          0.5 * 287.0 / cp / 9.81, MathTier::Exact);
+            }
+
+            CHECK(prsFused == prs);
+            CHECK(exnFused == exn);
+            CHECK(mtgFused == mtg);
+            CHECK(zhtFused == zht);
+        }
+}
+
+/// Maximum relative error of @c Math for pow(x, y) on a logarithmic grid of x in [1e-8, 1e6]
+template <class T, class Math>
+static double maxRelErrorPow(const Math& math, double y)
+{
+    double maxErr = 0.0;
+    for(int j = 0; j <= 14000; ++j)
+    {
+        const double x = std::pow(10.0, -8.0 + j * 1e-3);
+        const double ref = std::pow(x, y);
+        maxErr = std::max(maxErr, std::fabs(double(math.pow(T(x), T(y))) - ref) / ref);
+    }
+    return maxErr;
+}
+
+/// Maximum relative error of @c Math for exp10(x) with x in [-10, 10] and of MeteoUtils::eswat1 within [200K, 330K]
+template <class T, class Math>
+static void maxRelErrorExp10(const Math& math, double& exp10Err, double& eswatErr)
+{
+    exp10Err = eswatErr = 0.0;
+    for(int j = 0; j <= 20000; ++j)
+    {
+        const double x = -10.0 + j * 1e-3;
+        const double ref = std::pow(10.0, x);
+        exp10Err = std::max(exp10Err, std::fabs(double(math.exp10(T(x))) - ref) / ref);
+    }
+    for(int j = 0; j <= 13000; ++j)
+    {
+        const double temp = 200.0 + j * 1e-2;
+        const double ref = MeteoUtils::eswat1<double>(temp);
+        eswatErr = std::max(eswatErr, std::fabs(double(MeteoUtils::eswat1<T>(T(temp), math)) - ref) / ref);
+    }
+}
+
+TEST_CASE("Fast math", "[Solver]")
+{
+    // Exponents of the Exner function and the fall speed of rain
+    for(double y : {0.1364, 0.2046, 0.2857, 0.525, 0.875})
+    {
+        INFO("y: " << y);
+        CHECK(maxRelErrorPow<double>(MathExact<double>(), y) < 1e-15);
+        CHECK(maxRelErrorPow<double>(MathPolynomial<double>(), y) < 1e-14);
+        CHECK(maxRelErrorPow<double>(MathTable<double>(), y) < 2e-7);
+        CHECK(maxRelErrorPow<float>(MathPolynomial<float>(), y) < 2e-6);
+        CHECK(maxRelErrorPow<float>(MathTable<float>(), y) < 2e-6);
+    }
+
+    // The errors of exp10 grow with the magnitude of the argument (rounding of x * log2(10) in single precision)
+    double exp10Err, eswatErr;
+    maxRelErrorExp10<double>(MathPolynomial<double>(), exp10Err, eswatErr);
+    CHECK(exp10Err < 1e-14);
+    CHECK(eswatErr < 1e-14);
+    maxRelErrorExp10<double>(MathTable<double>(), exp10Err, eswatErr);
+    CHECK(exp10Err < 2e-7);
+    CHECK(eswatErr < 1e-6);
+    maxRelErrorExp10<float>(MathPolynomial<float>(), exp10Err, eswatErr);
+    CHECK(exp10Err < 5e-6);
+    CHECK(eswatErr < 5e-6);
+    maxRelErrorExp10<float>(MathTable<float>(), exp10Err, eswatErr);
+    CHECK(exp10Err < 5e-6);
+    CHECK(eswatErr < 5e-6);
+
+    // Rain water is clipped at zero before computing the fall speed
+    CHECK(MathPolynomial<double>().pow(0.0, 0.1364) == 0.0);
+    CHECK(MathTable<double>().pow(0.0, 0.1364) == 0.0);
+    CHECK(MathPolynomial<float>().pow(0.0f, 0.1364f) == 0.0f);
+    CHECK(MathTable<float>().pow(0.0f, 0.1364f) == 0.0f);
+
+    CHECK(FastMath::toTier(2) == MathTier::Table);
+    CHECK_THROWS_AS(FastMath::toTier(3), IsenException);
+    CHECK_THROWS_AS(SolverFactory::create("cpu", [] {
+                        auto namelist = std::make_shared<NameList>();
+                        namelist->setByName("imath", -1);
+                        return namelist;
+                    }()),
+                    IsenException);
+}
+
+TEST_CASE("MATLAB verification (math tiers)", "[Solver]")
+{
+    // The fast tiers are checked against the MATLAB results relative to the maximum of each field. The polynomial tier
+    // stays within the deviation of the exact tier (1e-6), the one of the table lookup is dominated by the Exner
+    // function.
+    const double maxRelDeviation[] = {1e-6, 1e-4};
+
+    boost::filesystem::path dir;
+    if(boost::filesystem::exists("data/namelist.m"))
+        dir = "data";
+    else if(boost::filesystem::exists("../data/namelist.m"))
+        dir = "../data";
+
+    if(dir.empty())
+    {
+        Progressbar::disableProgressbar = false;
+        Progressbar::printBar('-');
+        std::cout << Terminal::Color(Terminal::Color::getFileColor()) << "Math tier verification";
+        std::cout << " with MATLAB: No test data found -  Skipping" << std::endl;
+        Progressbar::printBar('-');
+        return;
+    }
+
+    for(int imath : {1, 2})
+    {
+        LOG() << logger::disable;
+        Parser parser;
+        auto namelist = parser.parse((dir / "namelist.m").string());
+        namelist->iprtcfl = false;
+        namelist->setByName("iout", namelist->nout * 2);
+        namelist->setByName("imath", imath);
+
+        std::shared_ptr<Solver> solver = SolverFactory::create("cpu", namelist);
+        solver->init();
+        solver->run();
+        LOG() << logger::enable;
+
+        const std::string nout = std::to_string(namelist->nts);
+        for(const char* name : {"zhtnow", "unow", "snow", "qvnow", "qcnow", "qrnow", "prec", "tot_prec", "mtg", "exn",
+                                "prs"})
+        {
+            MatrixXf ref = FieldLoader::load((dir / (std::string(name) + "-" + nout + ".dat")).string());
+            MatrixXf field(solver->getField(name));
+            REQUIRE(field.rows() == ref.rows());
+            REQUIRE(field.cols() == ref.cols());
+
+            const double maxRel = (field - ref).cwiseAbs().maxCoeff() / std::max(ref.cwiseAbs().maxCoeff(), 1e-300);
+            INFO("tier: " << FastMath::toString(MathTier(imath)) << ", field: " << name
+                          << ", max rel deviation: " << maxRel);
+            CHECK(maxRel < maxRelDeviation[imath - 1]);
+        }
+    }
+}
+
+/// Apply KesslerT and KesslerColumnT to a synthetic moist state with strong rain (several sedimentation sub-steps) and
+/// check that the outputs are bitwise identical or, if @c maxRelDeviation is positive, that the deviation of the rain
+/// relative to its maximum is below @c maxRelDeviation. If @c rainColumn is non-negative, it rains only in this column.
+template <class T, class S>
+static void verifyKesslerColumn(std::shared_ptr<NameList> namelist, int rainColumn = -1, double maxRelDeviation = 0.0)
+{
+    const int nxb = namelist->nxb, nz = namelist->nz;
+    const double dth = namelist->dth, cp = namelist->cp;
+
+    // Layers of 20 to 60 m and an exponentially decaying density and pressure
+    MatrixXf zht(nxb, nz + 1);
+    zht.col(0) = 250.0 * (VectorXf::Random(nxb).array() + 1.0).matrix();
+    for(int k = 0; k < nz; ++k)
+        zht.col(k + 1) = zht.col(k) + (40.0 + 20.0 * VectorXf::Random(nxb).array()).matrix();
+
+    const MatrixXf prs = 1e5 * (-zht.array() / 8000.0).exp();
+    const MatrixXf exn = cp * (prs.array() / namelist->pref).pow(namelist->rdcp);
+    const VectorXf th0 = VectorXf::LinSpaced(nz + 1, 280.0, 280.0 + nz * dth);
+
+    MatrixXf snow(nxb, nz);
+    for(int k = 0; k < nz; ++k)
+        snow.col(k) = 1.2 * (-zht.col(k).array() / 8000.0).exp() * (zht.col(k + 1) - zht.col(k)).array() / dth;
+
+    // Rain is present in about half of the grid points, some of which are slightly negative
+    const MatrixXf qv = 0.008 * (1.0 + 0.5 * MatrixXf::Random(nxb, nz).array());
+    const MatrixXf qc = 1e-3 * MatrixXf::Random(nxb, nz).array().max(0.0);
+    MatrixXf qr = 1e-2 * MatrixXf::Random(nxb, nz).array().max(-1e-10);
+    if(rainColumn >= 0)
+        for(int i = 0; i < nxb; ++i)
+            if(i != rainColumn)
+                qr.row(i).setZero();
+
+    Field<T> tempRef(nxb, nz + 1), qvRef(nxb, nz), qcRef(nxb, nz), qrRef(nxb, nz);
+    Field<T> temp(nxb, nz + 1), qvnew(nxb, nz), qcnew(nxb, nz), qrnew(nxb, nz);
+    Field<T> prsT(nxb, nz + 1), exnT(nxb, nz + 1), zhtT(nxb, nz + 1), snowT(nxb, nz), qvT(nxb, nz), qcT(nxb, nz),
+        qrT(nxb, nz);
+    tempRef.setZero();
+    temp.setZero();
+    prsT = prs.cast<T>();
+    exnT = exn.cast<T>();
+    zhtT = zht.cast<T>();
+    snowT = snow.cast<T>();
+    qvT = qv.cast<T>();
+    qcT = qc.cast<T>();
+    qrT = qr.cast<T>();
+
+    const VectorX<T> th0T = th0.cast<T>();
+    VectorX<T> totPrecRef = VectorX<T>::Constant(nxb, 1.0), precRef = VectorX<T>::Zero(nxb);
+
+    KesslerT<T, S> kessler(namelist);
+    kessler.apply(tempRef, qvRef, qcRef, qrRef, totPrecRef, precRef, th0T, prsT, snowT, qvT, qcT, qrT, exnT, zhtT);
+
+    KesslerColumnT<T, S> kesslerColumn(namelist);
+    Field<T> qrFirst;
+    VectorX<T> precFirst;
+    for(int numThreads : {1, 3})
+    {
+        INFO("threads: " << numThreads);
+        VectorX<T> totPrec = VectorX<T>::Constant(nxb, 1.0), prec = VectorX<T>::Constant(nxb, -1.0);
+
+#pragma omp parallel num_threads(numThreads)
+        kesslerColumn.applyTeam(temp, qvnew, qcnew, qrnew, totPrec, prec, th0T, prsT, snowT, qvT, qcT, qrT, exnT,
+                                zhtT);
+
+        if(maxRelDeviation == 0.0)
+        {
+            CHECK(temp == tempRef);
+            CHECK(qvnew == qvRef);
+            CHECK(qcnew == qcRef);
+            CHECK(qrnew == qrRef);
+            CHECK(totPrec == totPrecRef);
+            CHECK(prec == precRef);
+        }
+        else
+        {
+            // The results must not depend on the number of threads
+            if(numThreads == 1)
+            {
+                qrFirst = qrnew;
+                precFirst = prec;
+            }
+            CHECK(qrnew == qrFirst);
+            CHECK(prec == precFirst);
+
+            const double qrDeviation = (qrnew - qrRef).cwiseAbs().maxCoeff() / qrRef.cwiseAbs().maxCoeff();
+            const double precDeviation = (prec - precRef).cwiseAbs().maxCoeff() / precRef.cwiseAbs().maxCoeff();
+            INFO("qr deviation: " << qrDeviation << ", prec deviation: " << precDeviation);
+            CHECK(qrDeviation < maxRelDeviation);
+            CHECK(precDeviation < maxRelDeviation);
+        }
+    }
+
+    if(namelist->sediment_on)
+        CHECK(precRef.maxCoeff() > 0.0);
+}
+
+TEST_CASE("Kessler column", "[Solver]")
+{
+    auto namelist = crossVerificationNameList();
+    namelist->setByName("nx", 37); // Partial block of columns
+
+    for(bool iern : {false, true})
+        for(bool sedimentOn : {true, false})
+        {
+            INFO("iern: " << iern << ", sediment_on: " << sedimentOn);
+            namelist->setByName("iern", iern);
+            namelist->setByName("sediment_on", sedimentOn);
+
+            verifyKesslerColumn<double, double>(namelist);
+            verifyKesslerColumn<float, float>(namelist);
+            verifyKesslerColumn<double, float>(namelist);
+        }
+
+    namelist->setByName("imath", 2);
+    verifyKesslerColumn<double, double>(namelist);
+}
+
+TEST_CASE("Kessler column (per-column sedimentation)", "[Solver]")
+{
+    auto namelist = crossVerificationNameList();
+    namelist->setByName("nx", 37);
+    namelist->setByName("sediment_col", true);
+
+    // A single raining column takes the same sub-steps as the whole grid
+    for(int rainColumn : {0, 20, 40})
+    {
+        INFO("rain column: " << rainColumn);
+        verifyKesslerColumn<double, double>(namelist, rainColumn);
+        verifyKesslerColumn<float, float>(namelist, rainColumn);
+        verifyKesslerColumn<double, float>(namelist, rainColumn);
+    }
+
+    // Columns with less rain take fewer (and thus longer) sub-steps than the whole grid, which changes the rain by up to
+    // 10% of its maximum
+    verifyKesslerColumn<double, double>(namelist, -1, 0.2);
+}
+
+TEST_CASE("Fused health metrics", "[Solver]")
+{
+    // The reductions of the diffusion kernels have to match the separate sweeps over the written points (the maximum
+    // bitwise) and flag NaN and Inf values in any lane
+    const SimdInstructionSet defaultIsa = Simd::get();
+    const int nx = 37, nz = 7, nb = 2;
+    const int nxnb = nx + nb, nxnb1 = nx + nb + 1;
+
+    FieldXf unow, snow, unew, snew;
+    Numa::allocate(unow, nx + 2 * nb + 1, nz);
+    Numa::allocate(snow, nx + 2 * nb, nz);
+    Numa::allocate(unew, nx + 2 * nb + 1, nz);
+    Numa::allocate(snew, nx + 2 * nb, nz);
+    const int ld = unow.outerStride();
+
+    unow = MatrixXf::Random(unow.rows(), nz) * 20.0;
+    snow = MatrixXf::Random(snow.rows(), nz).array() + 2.0;
+    VectorXf tau = VectorXf::LinSpaced(nz, -0.1, 0.2);
+
+    for(auto isa : {SimdInstructionSet::Scalar, SimdInstructionSet::SSE42, SimdInstructionSet::AVX2,
+                    SimdInstructionSet::AVX512})
+    {
+        if(!Simd::isAvailable(isa))
+            continue;
+        Simd::set(isa);
+        INFO("isa: " << Simd::toString(isa));
+
+        auto reduce = [&]() {
+            FieldReduction<double> reduction;
+            reduction.reset();
+            solverCpuKernels<double>().horizontalDiffusion(nx, nz, nb, ld, 0, 0, unew.data(), snew.data(), nullptr,
+                                                           unow.data(), snow.data(), nullptr, tau.data(), &reduction);
+            return reduction;
+        };
+
+        FieldReduction<double> reduction = reduce();
+        CHECK(reduction.umax == unew.block(nb, 0, nxnb1 - nb, nz).cwiseAbs().maxCoeff());
+        CHECK(reduction.smass == Approx(snew.block(nb, 0, nxnb - nb, nz).sum()).epsilon(1e-12));
+        CHECK(reduction.check == 0.0);
+
+        for(int k : {0, nz - 1})
+            for(int i : {nb, nxnb - 1})
+            {
+                INFO("i: " << i << ", k: " << k);
+                const double u = unow(i, k), s = snow(i, k);
+
+                unow(i, k) = std::numeric_limits<double>::quiet_NaN();
+                CHECK(std::isnan(reduce().check));
+                unow(i, k) = u;
+
+                snow(i, k) = std::numeric_limits<double>::infinity();
+                CHECK(std::isnan(reduce().check));
+                snow(i, k) = s;
+            }
+    }
+    Simd::set(defaultIsa);
+
+    // The health metrics of the last time step have to agree with Solver::computeCFL and the sum of sigma
+    for(bool irelax : {false, true})
+        for(const char* name : {"cpu", "cpu-f32"})
+        {
+            INFO("solver: " << name << ", irelax: " << irelax);
+            auto namelist = crossVerificationNameList();
+            namelist->setByName("irelax", irelax);
+
+            LOG() << logger::disable;
+            std::shared_ptr<Solver> solver = SolverFactory::create(name, namelist);
+            solver->init();
+            solver->run();
+            LOG() << logger::enable;
+
+            const StepHealth& health = solver->getHealth();
+            const double mass = solver->getMat("snow").block(namelist->nb, 0, namelist->nx, namelist->nz).sum() * namelist->dx
+                                * namelist->dth;
+
+            CHECK(health.finite);
+            CHECK(health.umax == solver->computeCFL());
+            CHECK(health.mass == Approx(mass).epsilon(std::strcmp(name, "cpu") == 0 ? 1e-12 : 1e-5));
+        }
+}
+
+TEST_CASE("Adaptive time step", "[Solver]")
+{
+    NameList namelist;
+    namelist.setByName("time", 1500.0);
+    namelist.setByName("iout", 40);
+
+    // A fixed time step reproduces the time loop of NameList::nts steps
+    {
+        TimeControl timeControl(namelist);
+        while(timeControl.running())
+        {
+            timeControl.advance();
+            timeControl.adapt(100.0, 300.0);
+            CHECK(timeControl.dt() == namelist.dt);
+            CHECK(timeControl.oldLevelRatio() == 1.0);
+            CHECK(timeControl.isOutputStep() == (timeControl.step() % namelist.iout == 0));
+            CHECK(timeControl.progress() == timeControl.step());
+        }
+        CHECK(timeControl.step() == namelist.nts);
+    }
+
+    // The adaptive time step follows the signal speed within the growth and shrink rates and lands exactly on the
+    // output times and the end of the simulation
+    namelist.setByName("iadapt", true);
+    {
+        TimeControl timeControl(namelist);
+        std::vector<double> outputs;
+        double dtPrev = namelist.dt, speed = 0.0;
+
+        while(timeControl.running())
+        {
+            timeControl.advance();
+            INFO("step: " << timeControl.step() << ", time: " << timeControl.time());
+
+            const double dt = timeControl.dt();
+            CHECK(dt > 0.0);
+            CHECK(timeControl.oldLevelRatio() == (timeControl.step() == 1 ? 1.0 : dt / dtPrev));
+            if(timeControl.isOutputStep())
+                outputs.push_back(timeControl.time());
+            else if(speed > 0.0)
+            {
+                // The proposed time step is bounded by the rates (unless it is shortened to reach an output)
+                const double dtCfl = namelist.cfl_target * namelist.dx / speed;
+                CHECK(dt <= std::max(dtPrev * namelist.dt_grow, dtCfl) * (1 + 1e-12));
+            }
+
+            // Speed up from 15 to 300 m/s and back
+            speed = 15.0 + 285.0 * std::sin(3.14159 * timeControl.time() / 1500.0);
+            timeControl.adapt(speed, 0.0);
+            dtPrev = dt;
+        }
+
+        CHECK(timeControl.time() == namelist.nts * namelist.dt);
+        REQUIRE(outputs.size() == std::size_t(namelist.nts / namelist.iout));
+        for(std::size_t n = 0; n < outputs.size(); ++n)
+            CHECK(outputs[n] == (n + 1) * namelist.iout * namelist.dt);
+        CHECK(timeControl.progress() == namelist.nts);
+    }
+
+    // Invalid parameters
+    for(const char* name : {"cfl_target", "dt_grow", "dt_shrink", "dt_max"})
+    {
+        NameList invalid = namelist;
+        invalid.setByName(name, -1.0);
+        CHECK_THROWS_AS(TimeControl timeControl(invalid), IsenException);
+    }
+
+    // The persistent parallel region and the single precision solvers extrapolate the old time levels the same way as
+    // Solver::run (the adaptive time steps only depend on the maximum velocity and the depth of the atmosphere)
+    auto moist = crossVerificationNameList();
+    moist->setByName("iadapt", true);
+    moist->setByName("cfl_target", 0.9);
+    moist->setByName("time", 3000.0);
+
+    LOG() << logger::disable;
+    std::shared_ptr<Solver> solverRef = SolverFactory::create("cpu", moist);
+    solverRef->init();
+    solverRef->Solver::run();
+
+    for(const char* name : {"cpu", "cpu-f32", "cpu-mixed"})
+    {
+        std::shared_ptr<Solver> solver = SolverFactory::create(name, moist);
+        solver->init();
+        solver->run();
+
+        CHECK(solver->getHealth().finite);
+        for(const auto& deviation : Deviation::compute(*solver, *solverRef))
+        {
+            INFO("solver: " << name << ", field: " << deviation.name);
+            CHECK(deviation.maxRel < (std::strcmp(name, "cpu") == 0 ? 1e-10 : 5e-3));
+        }
+    }
+
+    // The adaptive time step converges to the solution of the fixed time step
+    moist->setByName("iadapt", false);
+    std::shared_ptr<Solver> solverFixed = SolverFactory::create("cpu", moist);
+    solverFixed->init();
+    solverFixed->run();
+    LOG() << logger::enable;
+
+    for(const auto& deviation : Deviation::compute(*solverRef, *solverFixed))
+    {
+        INFO("field: " << deviation.name << ", deviation: " << deviation.maxRel);
+        CHECK(deviation.maxRel < 0.05);
+    }
+}
+
+TEST_CASE("Restart", "[Solver]")
+{
+    // A simulation restarted from the last checkpoint is bitwise identical to the uninterrupted simulation (and the
+    // checkpoints don't alter the simulation)
+    auto verify = [](const char* name, std::shared_ptr<NameList> namelist) {
+        const std::string filename = namelist->run_name + ".ckpt";
+
+        LOG() << logger::disable;
+        std::shared_ptr<Solver> solverRef = SolverFactory::create(name, namelist);
+        solverRef->init();
+        solverRef->run();
+
+        auto namelistCheckpoint = std::make_shared<NameList>(*namelist);
+        namelistCheckpoint->setByName("icheckpoint", 60);
+        std::shared_ptr<Solver> solver = SolverFactory::create(name, namelistCheckpoint);
+        solver->init();
+        solver->run();
+
+        Checkpoint checkpoint(filename);
+        boost::filesystem::remove(filename);
+        CHECK(checkpoint.get<int>("time.step") % 60 == 0);
+
+        std::shared_ptr<Solver> solverRestart = SolverFactory::create(name, checkpoint.getNameList());
+        solverRestart->init();
+        const MatrixXf unowInit(solverRestart->getField("unow"));
+        solverRestart->restart(checkpoint);
+        CHECK(MatrixXf(solverRestart->getField("unow")) != unowInit);
+        solverRestart->run();
+        LOG() << logger::enable;
+
+        for(const Solver* s : {solver.get(), solverRestart.get()})
+        {
+            for(const auto& deviation : Deviation::compute(*s, *solverRef))
+            {
+                INFO("solver: " << name << ", iadapt: " << namelist->iadapt << ", field: " << deviation.name);
+                CHECK(deviation.maxAbs == 0.0);
+            }
+
+            const Output& output = *s->getOutput();
+            const Output& outputRef = *solverRef->getOutput();
+            INFO("solver: " << name << ", iadapt: " << namelist->iadapt);
+            CHECK(output.z() == outputRef.z());
+            CHECK(output.u() == outputRef.u());
+            CHECK(output.s() == outputRef.s());
+            CHECK(output.t() == outputRef.t());
+            CHECK(output.qr() == outputRef.qr());
+            CHECK(output.tot_prec() == outputRef.tot_prec());
+        }
+    };
+
+    // 150 time steps, the last checkpoint is written after 120 steps
+    auto namelist = crossVerificationNameList();
+    namelist->setByName("iout", 25);
+    namelist->setByName("run_name", std::string("__restart__"));
+
+    for(const char* name : {"ref", "cpu", "cpu-f32", "cpu-mixed", "fused"})
+        verify(name, namelist);
+
+    // Dry simulation with relaxation boundaries
+    auto dry = std::make_shared<NameList>(*namelist);
+    dry->setByName("imoist", false);
+    dry->setByName("irelax", true);
+    verify("cpu", dry);
+
+    // Adaptive time step
+    namelist->setByName("iadapt", true);
+    namelist->setByName("cfl_target", 0.9);
+    for(const char* name : {"ref", "cpu"})
+        verify(name, namelist);
+
+    // The checkpoint has to match the domain of the solver
+    namelist->setByName("icheckpoint", 10);
+    std::shared_ptr<Solver> solver = SolverFactory::create("cpu", namelist);
+    solver->init();
+    LOG() << logger::disable;
+    solver->run();
+    LOG() << logger::enable;
+
+    Checkpoint checkpoint("__restart__.ckpt");
+    boost::filesystem::remove("__restart__.ckpt");
+
+    auto namelistOther = checkpoint.getNameList();
+    namelistOther->setByName("nx", 120);
+    std::shared_ptr<Solver> solverOther = SolverFactory::create("cpu", namelistOther);
+    solverOther->init();
+    CHECK_THROWS_AS(solverOther->restart(checkpoint), IsenException);
+
+    CHECK_THROWS_AS(Checkpoint("__not_a_checkpoint__.ckpt"), IsenException);
+
+    // A truncated checkpoint is rejected before its records are allocated
+    checkpoint.write("__truncated__.ckpt");
+    boost::filesystem::resize_file("__truncated__.ckpt", boost::filesystem::file_size("__truncated__.ckpt") / 2);
+    CHECK_THROWS_AS(Checkpoint("__truncated__.ckpt"), IsenException);
+    boost::filesystem::remove("__truncated__.ckpt");
+}
+
+TEST_CASE("Ensemble", "[Solver]")
+{
+    // Members differing in the atmosphere, the topography, the diffusion and the Kessler parameters
+    auto createMembers = [](bool irelax) {
+        std::vector<std::shared_ptr<NameList>> namelists;
+        for(int m = 0; m < 5; ++m)
+        {
+            auto namelist = crossVerificationNameList();
+            namelist->setByName("irelax", irelax);
+            namelist->setByName("u00", 15.0 + 5.0 * m);
+            namelist->setByName("bv00", 0.01 + 0.002 * m);
+            namelist->setByName("topomx", 500 + 200 * m);
+            namelist->setByName("diff", 0.02 * (m % 3));
+            namelist->setByName("vt_mult", 1.0 + 0.5 * m);
+            namelist->setByName("autoconv_th", 0.0001 * (m + 1));
+            namelists.push_back(namelist);
+        }
+        return namelists;
+    };
+
+    LOG() << logger::disable;
+    for(bool irelax : {false, true})
+    {
+        auto namelists = createMembers(irelax);
+
+        SolverEnsemble ensemble(namelists);
+        REQUIRE(ensemble.size() == int(namelists.size()));
+        ensemble.init();
+        ensemble.run();
+
+        // Every member matches the reference solution of its NameList
+        for(int m = 0; m < ensemble.size(); ++m)
+        {
+            std::shared_ptr<Solver> solverRef = SolverFactory::create("ref", namelists[m]);
+            solverRef->init();
+            solverRef->run();
+
+            const Solver& member = ensemble.getMember(m);
+            CHECK(member.getHealth().finite);
+
+            for(const auto& deviation : Deviation::compute(member, *solverRef))
+            {
+                INFO("irelax: " << irelax << ", member: " << m << ", field: " << deviation.name);
+                CHECK(deviation.maxRel < 1e-10);
+            }
+        }
+        CHECK_THROWS_AS(ensemble.getMember(ensemble.size()), IsenException);
+    }
+
+    // The kernels of all instruction sets produce bitwise identical members
+    const SimdInstructionSet defaultIsa = Simd::get();
+    for(bool irelax : {false, true})
+    {
+        auto namelists = createMembers(irelax);
+
+        Simd::set(SimdInstructionSet::Scalar);
+        SolverEnsemble ensembleScalar(namelists);
+        ensembleScalar.init();
+        ensembleScalar.run();
+
+        for(auto isa : {SimdInstructionSet::SSE42, SimdInstructionSet::AVX2, SimdInstructionSet::AVX512})
+        {
+            if(!Simd::isAvailable(isa))
+                continue;
+
+            Simd::set(isa);
+            SolverEnsemble ensembleSimd(namelists);
+            ensembleSimd.init();
+            ensembleSimd.run();
+
+            for(int m = 0; m < ensembleSimd.size(); ++m)
+                for(const auto& deviation : Deviation::compute(ensembleSimd.getMember(m), ensembleScalar.getMember(m)))
+                {
+                    INFO("irelax: " << irelax << ", isa: " << Simd::toString(isa) << ", member: " << m
+                                    << ", field: " << deviation.name);
+                    CHECK(deviation.maxAbs == 0.0);
+                }
+        }
+    }
+    Simd::set(defaultIsa);
+    LOG() << logger::enable;
+
+    // The members have to share the grid
+    auto namelists = createMembers(false);
+    namelists.back()->setByName("nx", 120);
+    CHECK_THROWS_AS(SolverEnsemble ensemble(namelists), IsenException);
+    CHECK_THROWS_AS(SolverEnsemble ensemble({}), IsenException);
+}
+
+#ifdef ISEN_MPI
+
+/// @brief Cross verification of the distributed memory solver with SolverCpu (bitwise identical)
+///
+/// Runs with any number of ranks, e.g 'mpirun -np 4 isen_test "[MPI]"'.
+TEST_CASE("Cross verification (SolverMpi)", "[Solver][MPI]")
+{
+    auto verify = [](std::shared_ptr<NameList> namelist) {
+        LOG() << logger::disable;
+        std::shared_ptr<Solver> solverRef = SolverFactory::create("cpu", namelist);
+        std::shared_ptr<Solver> solverMpi = SolverFactory::create("mpi", namelist);
+
+        solverRef->init();
+        solverMpi->init();
+
+        solverRef->run();
+        solverMpi->run();
+        LOG() << logger::enable;
+
+        // The global fields are assembled on all ranks
+        for(const auto& deviation : Deviation::compute(*solverMpi, *solverRef))
+        {
+            INFO("irelax: " << namelist->irelax << ", iadapt: " << namelist->iadapt << ", imoist: "
+                            << namelist->imoist << ", field: " << deviation.name);
+            CHECK(deviation.maxAbs == 0.0);
+        }
+
+        // The output is assembled on the first rank
+        int rank;
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        if(rank == 0)
+        {
+            CHECK(solverMpi->getOutput()->z() == solverRef->getOutput()->z());
+            CHECK(solverMpi->getOutput()->u() == solverRef->getOutput()->u());
+            CHECK(solverMpi->getOutput()->s() == solverRef->getOutput()->s());
+        }
+    };
+
+    // Dry simulation with periodic boundaries
+    auto namelist = std::make_shared<NameList>();
+    namelist->setByName("time", 4500.0); // 30 timesteps
+    namelist->setByName("iout", 4);
+    namelist->setByName("iprtcfl", false);
+    verify(namelist);
+
+    // Relaxation boundaries
+    namelist->setByName("irelax", true);
+    verify(namelist);
+
+    // Adaptive time step
+    namelist->setByName("irelax", false);
+    namelist->setByName("iadapt", true);
+    verify(namelist);
+
+    // Moist simulations fall back to SolverCpu
+    verify(crossVerificationNameList());
+
+    // A rank needs at least 2 * nb points
+    int size;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    CHECK_THROWS_AS(Decomposition(4 * size - 1, 2, true), IsenException);
+}
+
+#endif
+
+TEST_CASE("Parallel region overhead", "[!hide][Benchmark]")
+{
+    // Time per step of Solver::run (fork-join of a parallel region per kernel) and SolverCpu::run (single parallel
+    // region) for small grids where the overhead of creating the parallel regions dominates. The best of 5 runs is
+    // reported.
+    for(int nx : {20, 40, 80})
+        for(bool imoist : {false, true})
+        {
+            auto namelist = crossVerificationNameList();
+            namelist->setByName("nx", nx);
+            namelist->setByName("imoist", imoist);
+            namelist->setByName("time", 15000.0); // 100 timesteps
+            namelist->setByName("iout", 1000000);
+            namelist->setByName("itime", false);
+
+            double elapsed[2] = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+            for(int run = 0; run < 5; ++run)
+                for(int persistent = 0; persistent < 2; ++persistent)
+                {
+                    LOG() << logger::disable;
+                    std::shared_ptr<Solver> solver = SolverFactory::create("cpu", namelist);
+                    solver->init();
+
+                    Timer t;
+                    if(persistent)
+                        solver->run();
+                    else
+                        solver->Solver::run();
+                    elapsed[persistent] = std::min(elapsed[persistent], 1e3 * t.stop() / namelist->nts);
+                    LOG() << logger::enable;
+                }
+
+            std::printf("nx = %4i, imoist = %i : fork-join %8.2f us/step, persistent %8.2f us/step (%.2fx)\n", nx,
+                        imoist, elapsed[0], elapsed[1], elapsed[0] / elapsed[1]);
+        }
+}
+
+TEST_CASE("Output transpose", "[!hide][Benchmark]")
+{
+    // Time per output step of Output::makeOutput (tiled copy by OpenMP tasks) and of the scalar loops over the fields
+    // returned by Solver::getMat it replaces, for all fields of a moist simulation. The best of 10 steps is reported.
+    for(std::pair<int, int> grid : {std::make_pair(160, 60), std::make_pair(1000, 60), std::make_pair(5000, 60),
+                                    std::make_pair(1000, 1000)})
+    {
+        const int nx = grid.first;
+        auto namelist = crossVerificationNameList();
+        namelist->setByName("nx", nx);
+        namelist->setByName("nz", grid.second);
+        namelist->setByName("iout", 1000000);
+        namelist->setByName("iiniout", false);
+
+        LOG() << logger::disable;
+        std::shared_ptr<Solver> solver = SolverFactory::create("cpu", namelist);
+        solver->init();
+
+        auto namelistOut = std::make_shared<NameList>(*namelist);
+        namelistOut->setByName("iout", 1);
+        namelistOut->setByName("time", 10 * namelist->dt); // 10 frames
+        Output output(namelistOut, Output::Binary);
+        LOG() << logger::enable;
+
+        const int nz = namelist->nz;
+        const int nz1 = namelist->nz1;
+        const int nb = namelist->nb;
+        // The loops write to the frames of buffers of the same size as the buffers of the Output
+        const int numSteps = 10;
+        std::vector<double> z(numSteps * nx * nz1), u(numSteps * nx * nz), s(numSteps * nx * nz),
+            prec(numSteps * nx), tot_prec(numSteps * nx), qv(numSteps * nx * nz), qc(numSteps * nx * nz),
+            qr(numSteps * nx * nz);
+
+        double elapsed[2] = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+        for(int step = 0; step < numSteps; ++step)
+        {
+            Timer t;
+            const auto& zhtnow = solver->getMat("zhtnow");
+            double* it_z = z.data() + step * nx * nz1;
+            for(int i = nb; i < (nx + nb); ++i)
+                for(int k = 0; k < nz1; ++k, ++it_z)
+                    *it_z = zhtnow(i, k);
+            const auto& unow = solver->getMat("unow");
+            double* it_u = u.data() + step * nx * nz;
+            for(int i = 0; i < nx; ++i)
+                for(int k = 0; k < nz; ++k, ++it_u)
+                    *it_u = 0.5 * (unow(i, k) + unow(i + 1, k));
+            const auto& snow = solver->getMat("snow");
+            double* it_s = s.data() + step * nx * nz;
+            for(int i = nb; i < (nx + nb); ++i)
+                for(int k = 0; k < nz; ++k, ++it_s)
+                    *it_s = snow(i, k);
+            const auto& precVec = solver->getVec("prec");
+            double* it_prec = prec.data() + step * nx;
+            for(int i = nb; i < (nx + nb); ++i, ++it_prec)
+                *it_prec = precVec(i);
+            const auto& totPrecVec = solver->getVec("tot_prec");
+            double* it_tot_prec = tot_prec.data() + step * nx;
+            for(int i = nb; i < (nx + nb); ++i, ++it_tot_prec)
+                *it_tot_prec = totPrecVec(i);
+            for(auto tracer : {std::make_pair("qvnow", &qv), std::make_pair("qcnow", &qc), std::make_pair("qrnow", &qr)})
+            {
+                const auto& qnow = solver->getMat(tracer.first);
+                double* it_q = tracer.second->data() + step * nx * nz;
+                for(int i = nb; i < (nx + nb); ++i)
+                    for(int k = 0; k < nz; ++k, ++it_q)
+                        *it_q = qnow(i, k);
+            }
+            elapsed[0] = std::min(elapsed[0], t.stop());
+
+            t.start();
+            output.makeOutput(solver.get());
+            elapsed[1] = std::min(elapsed[1], t.stop());
+        }
+
+        CHECK(std::equal(z.begin(), z.end(), output.z().begin()));
+        CHECK(std::equal(u.begin(), u.end(), output.u().begin()));
+        CHECK(std::equal(qr.begin(), qr.end(), output.qr().begin()));
+
+        std::printf("nx = %4i, nz = %4i : loop %8.3f ms/step, makeOutput %8.3f ms/step (%.2fx)\n", nx, nz, elapsed[0],
+                    elapsed[1], elapsed[0] / elapsed[1]);
+    }
+}
+
 TEST_CASE("Getter", "[Solver]")
 {
     LOG() << logger::disable;